@@ -63,6 +63,7 @@ def run():
     gem.set_adc_gain_error(gain_error)
     gem.set_adc_offset_error(offset_error)
     gem.enable_adc_error_correction()
+    gem.commit_settings()
     print("\n✓ Saved to device NVM\n")
 
     post_zero_code = gem.read_adc_average(ZERO_CODE_CHANNEL)
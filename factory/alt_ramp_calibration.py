@@ -169,11 +169,17 @@ def run(save):
         print("Sending ramp table values to device...")
 
         checksum = 0
-        for n, timer_period in enumerate(castor_calibration.keys()):
+        entries = []
+        for timer_period in castor_calibration.keys():
             castor_code = castor_calibration[timer_period]
             pollux_code = pollux_calibration[timer_period]
             checksum ^= castor_code
-            gem.write_lut_entry(n, timer_period, castor_code, pollux_code)
+            entries.append((castor_code, pollux_code))
+
+        gem.write_lut_table(entries)
+
+        if gem.read_lut_table() != entries:
+            raise RuntimeError("Ramp table read back from device doesn't match!")
 
         gem.write_lut()
 
@@ -0,0 +1,28 @@
+# Copyright (c) 2023 Alethea Katherine Flowers.
+# Published under the standard MIT License.
+# Full text available at: https://opensource.org/licenses/MIT
+
+"""Shows how long each phase of the firmware's start-up took.
+
+Power cycle the device before running this to see its cold boot time.
+"""
+
+from libgemini import gemini
+
+
+def main():
+    gem = gemini.Gemini.get()
+    profile = gem.read_boot_profile()
+
+    previous = 0
+    for phase, time_us in profile.items():
+        print(f"{phase.name.lower():<14} {time_us / 1000:8.2f} ms  (+{(time_us - previous) / 1000:.2f} ms)")
+        previous = time_us
+
+    outputs = profile.get(gemini.BootPhase.FIRST_UPDATE)
+    if outputs:
+        print(f"\nOutputs running {outputs / 1000:.2f} ms after power-on.")
+
+
+if __name__ == "__main__":
+    main()
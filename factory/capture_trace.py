@@ -0,0 +1,57 @@
+# Copyright (c) 2023 Alethea Katherine Flowers.
+# Published under the standard MIT License.
+# Full text available at: https://opensource.org/licenses/MIT
+
+"""Captures an MTB instruction trace of one of the firmware's hot paths.
+
+The device must be running normally, not in calibration mode, so that the
+main loop runs the traced region. For example:
+
+    $ python3 capture_trace.py oscillator trace.json
+    $ python3 ../firmware/scripts/trace_profile.py ../firmware/build/gemini-firmware.elf trace.json
+"""
+
+import argparse
+import json
+import pathlib
+import sys
+
+from libgemini import gemini
+
+
+def main():
+    regions = [region.name.lower() for region in gemini.TraceRegion if region]
+
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter
+    )
+    parser.add_argument("region", choices=regions)
+    parser.add_argument("output", type=pathlib.Path)
+    parser.add_argument("--timeout", type=float, default=1.0)
+    args = parser.parse_args()
+
+    region = gemini.TraceRegion[args.region.upper()]
+
+    gem = gemini.Gemini.get()
+    gem.arm_trace(region)
+    packets = gem.read_trace(timeout=args.timeout)
+
+    if packets is None:
+        gem.arm_trace(gemini.TraceRegion.NONE)
+        print(f"The {args.region} region didn't run, is the device in calibration mode?")
+        sys.exit(1)
+
+    args.output.write_text(
+        json.dumps(
+            dict(
+                region=args.region,
+                full=len(packets) >= gemini.TRACE_BUFFER_PACKETS,
+                packets=packets,
+            )
+        )
+    )
+    print(f"Captured {len(packets)} packets to {args.output}")
+
+
+if __name__ == "__main__":
+    main()
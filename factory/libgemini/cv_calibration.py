@@ -19,6 +19,9 @@ V_RANGE = abs(V_MIN) + abs(V_MAX)
 CHANNEL = gemini.Gemini.ADC.CV_A
 NUM_CALIBRATION_POINTS = 50
 SAMPLE_COUNT = 64
+# All of the samples are taken on the device in quick succession, so give the
+# input filter time to settle after changing the voltage.
+SETTLE_US = 20000
 ZERO_VOLT_MARGIN = 20  # About 32 mV
 
 
@@ -183,9 +186,8 @@ def _measure_range(gem, hubble, calibration_points, post_measure=lambda x: x):
             print(f"expected:      {expected_code}")
 
             hubble.VOUT1B.voltage = voltage
-            # time.sleep(0.02)
 
-            result = gem.read_adc_average(CHANNEL, SAMPLE_COUNT)
+            result = gem.read_adc_average(CHANNEL, SAMPLE_COUNT, SETTLE_US)
             result = post_measure(result)
             results[voltage] = result
 
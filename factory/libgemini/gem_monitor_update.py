@@ -9,9 +9,9 @@ import structy
 
 @dataclass
 class GemMonitorUpdate(structy.Struct):
-    _PACK_STRING : ClassVar[str] = "B?HHHHHHHHBiHIHHHHHHHiBiHIHHHH"
+    _PACK_STRING : ClassVar[str] = "B?HHHHHHHHBiHIHHHHHHHiBiHIHHHHIIHIIH"
 
-    PACKED_SIZE : ClassVar[int] = 66
+    PACKED_SIZE : ClassVar[int] = 86
     """The total size of the struct once packed."""
 
     mode: int = 0
@@ -73,3 +73,15 @@ class GemMonitorUpdate(structy.Struct):
     animation_time: int = 0
 
     sample_time: int = 0
+
+    dac_skipped_writes: int = 0
+
+    dac_partial_writes: int = 0
+
+    midi_rx_peak_depth: int = 0
+
+    midi_rx_dropped: int = 0
+
+    midi_tx_dropped: int = 0
+
+    midi_latency: int = 0
@@ -9,9 +9,9 @@ import structy
 
 @dataclass
 class GemSettings(structy.Struct):
-    _PACK_STRING : ClassVar[str] = "HhHiiiiiiiiiiH??iiiBBiiHI??"
+    _PACK_STRING : ClassVar[str] = "HhHiiiiiiiiiiH??iiiBBiiHI??BBB?H???ii"
 
-    PACKED_SIZE : ClassVar[int] = 80
+    PACKED_SIZE : ClassVar[int] = 97
     """The total size of the struct once packed."""
 
     adc_gain_corr: int = 2048
@@ -115,3 +115,60 @@ class GemSettings(structy.Struct):
     """
         Enables or disables quantization when Castor is in "Coarse" mode
         """
+
+    castor_midi_channel: int = 0
+    """
+        The USB MIDI channel (1 to 16) whose notes and pitch bend control Castor's
+        pitch, or 0 to ignore MIDI.
+        """
+
+    pollux_midi_channel: int = 0
+    """
+        The USB MIDI channel (1 to 16) whose notes and pitch bend control Pollux's
+        pitch, or 0 to ignore MIDI.
+        """
+
+    midi_pitch_bend_range: int = 2
+    """
+        Full-scale MIDI pitch bend in semitones.
+        """
+
+    midi_replaces_cv: bool = True
+    """
+        If enabled, held MIDI notes replace the pitch CV. Otherwise they
+        transpose the pitch relative to C4.
+        """
+
+    quantizer_scale: int = 4095
+    """
+        The notes used for quantization, one bit per semitone starting with C in
+        the lowest bit. For example, 4095 (0xFFF) is chromatic and 2741 (0xAB5)
+        is C major.
+        """
+
+    fine_quantization_enabled: bool = False
+    """
+        Enables or disables quantizing the pitch CV when in "Fine" mode
+        """
+
+    castor_pitch_smoothing: bool = False
+    """
+        Enables or disables smoothing Castor's pitch CV
+        """
+
+    pollux_pitch_smoothing: bool = False
+    """
+        Enables or disables smoothing Pollux's pitch CV
+        """
+
+    pitch_smoothing_min_cutoff: structy.Fix16 = 10.0
+    """
+        The pitch CV smoothing filter's cutoff (in Hz) when the CV is steady.
+        Lower values remove more jitter.
+        """
+
+    pitch_smoothing_sensitivity: structy.Fix16 = 10.0
+    """
+        How much the pitch CV smoothing filter's cutoff rises (in Hz) for each
+        volt per second that the CV changes. Higher values reduce lag.
+        """
@@ -4,13 +4,120 @@
 
 # Interface for Gemini's MIDI SysEx command set
 
+import collections
 import enum
-import statistics
+import os
 import struct
+import time
+import zlib
 
 from wintertools import midi, teeth
 
-from libgemini import gem_monitor_update, gem_settings
+from libgemini import gem_monitor_update, gem_settings, transport
+
+
+ADCStats = collections.namedtuple("ADCStats", ["mean", "min", "max", "variance"])
+
+_ADC_STATS_FORMAT = ">iHHi"
+_ADC_STATS_SIZE = struct.calcsize(_ADC_STATS_FORMAT)
+
+
+def _decode_adc_stats(buf):
+    mean, min_, max_, variance = struct.unpack(_ADC_STATS_FORMAT, buf)
+    return ADCStats(mean / 65536.0, min_, max_, variance / 65536.0)
+
+
+MemoryUsage = collections.namedtuple(
+    "MemoryUsage", ["ram_size", "static_size", "stack_size", "stack_high_water"]
+)
+
+
+# Must match GemTraceRegion and GemTraceState in gem_trace.h
+class TraceRegion(enum.IntEnum):
+    NONE = 0
+    ANALOG_INPUT = 1
+    OSCILLATOR = 2
+    LED_ANIMATION = 3
+
+
+class TraceState(enum.IntEnum):
+    IDLE = 0
+    ARMED = 1
+    CAPTURING = 2
+    DONE = 3
+
+
+# Must match GemBootPhase in gem_boot_profile.h
+class BootPhase(enum.IntEnum):
+    MAIN = 0
+    SETTINGS = 1
+    RAMP_TABLE = 2
+    DAC = 3
+    ADC = 4
+    OUTPUTS = 5
+    USB = 6
+    LEDS = 7
+    SYSEX = 8
+    FIRST_UPDATE = 9
+
+
+# Must match WNTR_MTB_SIZE / 2 in firmware/configure.py
+TRACE_BUFFER_PACKETS = 128
+
+
+# Must match GEM_RAMP_TABLE_CHUNK_MAX_ENTRIES in gem_ramp_table_transfer.h
+LUT_CHUNK_MAX_ENTRIES = 16
+
+
+class LUTChunkError(Exception):
+    pass
+
+
+def _pack_lut_chunk(start, entries):
+    buf = struct.pack(">BB", start, len(entries))
+    for castor, pollux in entries:
+        buf += struct.pack(">HH", castor, pollux)
+    return buf + struct.pack(">I", zlib.crc32(buf))
+
+
+def _unpack_lut_chunk(buf):
+    buf = bytes(buf)
+    start, count = struct.unpack(">BB", buf[:2])
+    if len(buf) != 2 + count * 4 + 4:
+        raise LUTChunkError(f"Chunk has the wrong length: {len(buf)}")
+    (crc,) = struct.unpack(">I", buf[-4:])
+    if crc != zlib.crc32(buf[:-4]):
+        raise LUTChunkError(f"Chunk at {start} has a bad CRC")
+    entries = [struct.unpack(">HH", buf[2 + n * 4 : 6 + n * 4]) for n in range(count)]
+    return start, entries
+
+
+# Must match GEM_FW_UPDATE_CHUNK_MAX_DATA in gem_fw_update.h
+FW_CHUNK_MAX_DATA = 64
+
+# How many times a chunk that arrives corrupted is re-sent.
+FW_CHUNK_RETRIES = 3
+
+
+class FirmwareUpdateError(Exception):
+    pass
+
+
+class FirmwareUpdateResult(enum.IntEnum):
+    # Must match enum GemFwUpdateResult in gem_fw_update.h
+    OK = 0
+    ERR_LENGTH = 1
+    ERR_CRC = 2
+    ERR_RANGE = 3
+    ERR_OFFSET = 4
+    ERR_STATE = 5
+    ERR_IMAGE_CRC = 6
+    ERR_VECTOR_TABLE = 7
+
+
+def _pack_fw_chunk(offset, data):
+    buf = struct.pack(">I", offset) + bytes(data)
+    return buf + struct.pack(">I", zlib.crc32(buf))
 
 
 def _encode_fix16(val):
@@ -37,10 +144,23 @@ class SysExCommands(enum.IntEnum):
     SOFT_RESET = 0x11
     ENTER_CALIBRATION = 0x12
     RESET_INTO_BOOTLOADER = 0x13
+    READ_ADC_STATS = 0x14
+    READ_ADC_STATS_MULTI = 0x15
+    WRITE_LUT_CHUNK = 0x16
+    READ_LUT_CHUNK = 0x17
     READ_SETTINGS = 0x18
     WRITE_SETTINGS = 0x19
+    READ_MEMORY_USAGE = 0x1A
+    ARM_TRACE = 0x1B
+    READ_TRACE = 0x1C
+    READ_BOOT_PROFILE = 0x1D
+    BEGIN_FW_UPDATE = 0x1E
+    WRITE_FW_CHUNK = 0x1F
     SET_FREQ = 0x20
     SET_OSC8M_FREQ = 0x21
+    FINISH_FW_UPDATE = 0x22
+    APPLY_FW_UPDATE = 0x23
+    COMMIT_SETTINGS = 0x24
 
 
 class Gemini(midi.MIDIDevice):
@@ -58,11 +178,44 @@ class Gemini(midi.MIDIDevice):
         CV_A = 7
         CV_B = 8
 
-    def __init__(self):
-        super().__init__()
+    # Set this to the simulator's address, for example "localhost:7777", to
+    # use the simulator instead of a real device.
+    SIMULATOR_ENV_VAR = "GEMINI_SIM"
+
+    def __init__(self, transport=None):
+        # Without a transport this talks to the real device over USB MIDI.
+        if transport is None:
+            super().__init__()
+        self._transport = transport
         self.version = None
         self.serial_number = None
 
+    @classmethod
+    def get(cls):
+        address = os.environ.get(cls.SIMULATOR_ENV_VAR)
+        if address:
+            return cls(transport=transport.SocketTransport(address))
+        return super().get()
+
+    def sysex(self, command, data=None, encode=False, response=False, decode=False):
+        if self._transport is None:
+            return super().sysex(
+                command, data=data, encode=encode, response=response, decode=decode
+            )
+        return self._transport.sysex(
+            self.SYSEX_MARKER,
+            command,
+            data=data,
+            encode=encode,
+            response=response,
+            decode=decode,
+        )
+
+    def wait_for_message(self):
+        if self._transport is None:
+            return super().wait_for_message()
+        return self._transport.wait_for_message()
+
     def get_firmware_version(self):
         resp = self.sysex(SysExCommands.HELLO, response=True)
         self.version = bytearray(resp[3:-1]).decode("ascii")
@@ -81,13 +234,48 @@ class Gemini(midi.MIDIDevice):
         (val,) = struct.unpack(">H", resp)
         return val
 
-    def read_adc_average(self, ch, samples=10):
-        _vals = []
+    def read_adc_stats(self, ch, samples=64, settle_us=0):
+        """Takes `samples` readings on the device and returns their ADCStats."""
+        data = struct.pack(">BHH", ch, samples, settle_us)
+        resp = self.sysex(
+            SysExCommands.READ_ADC_STATS,
+            data=data,
+            encode=True,
+            response=True,
+            decode=True,
+        )
+        if not resp:
+            raise ValueError(f"Invalid ADC channel {ch}")
+        return _decode_adc_stats(resp)
+
+    def read_adc_stats_multi(self, channels, samples=64, settle_us=0):
+        """Like read_adc_stats, but for several channels in one request.
+        Returns a dict of channel to ADCStats."""
+        channels = sorted(set(channels))
+        mask = 0
+        for ch in channels:
+            mask |= 1 << ch
+
+        data = struct.pack(">HHH", mask, samples, settle_us)
+        resp = self.sysex(
+            SysExCommands.READ_ADC_STATS_MULTI,
+            data=data,
+            encode=True,
+            response=True,
+            decode=True,
+        )
+        if not resp:
+            raise ValueError(f"Invalid ADC channels {channels}")
 
-        for _ in range(samples):
-            _vals.append(self.read_adc(ch))
+        return {
+            ch: _decode_adc_stats(
+                resp[n * _ADC_STATS_SIZE : (n + 1) * _ADC_STATS_SIZE]
+            )
+            for n, ch in enumerate(channels)
+        }
 
-        return statistics.mean(_vals)
+    def read_adc_average(self, ch, samples=10, settle_us=0):
+        return self.read_adc_stats(ch, samples, settle_us).mean
 
     def set_dac(self, a, b, c, d):
         data = struct.pack(">HHHH", a, b, c, d)
@@ -118,6 +306,12 @@ class Gemini(midi.MIDIDevice):
     def reset_settings(self):
         self.sysex(SysExCommands.RESET_SETTINGS)
 
+    def commit_settings(self):
+        """Saves settings changed by commands like set_adc_gain_error to NVM,
+        returns True if anything had changed."""
+        resp = self.sysex(SysExCommands.COMMIT_SETTINGS, response=True)
+        return resp[3] == 1
+
     def read_settings(self):
         settings_buf = self.sysex(
             SysExCommands.READ_SETTINGS, response=True, decode=True
@@ -126,15 +320,100 @@ class Gemini(midi.MIDIDevice):
         return settings
 
     def save_settings(self, settings):
+        """Saves the settings, returns True if the firmware applied them
+        without needing a reset."""
         settings_buf = settings.pack()
-        self.sysex(
+        resp = self.sysex(
             SysExCommands.WRITE_SETTINGS, settings_buf, encode=True, response=True
         )
+        # Older firmware sends an empty ack.
+        return len(resp) > 4 and resp[3] == 1
+
+    def read_memory_usage(self):
+        """Returns RAM usage, including the stack's high-water mark since boot."""
+        resp = self.sysex(SysExCommands.READ_MEMORY_USAGE, response=True, decode=True)
+        return MemoryUsage(*struct.unpack(">IIII", resp))
+
+    def read_boot_profile(self):
+        """Returns a dict of BootPhase to the number of microseconds after
+        power-on that the phase was reached. Phases that haven't been reached
+        are left out."""
+        resp = self.sysex(SysExCommands.READ_BOOT_PROFILE, response=True, decode=True)
+        count = resp[0]
+        times = struct.unpack(f">{count}I", bytes(resp[1 : 1 + count * 4]))
+        return {
+            BootPhase(n): time_us
+            for n, time_us in enumerate(times)
+            if time_us and n < len(BootPhase)
+        }
+
+    def arm_trace(self, region):
+        """Captures an MTB trace the next time the firmware runs `region`."""
+        resp = self.sysex(SysExCommands.ARM_TRACE, data=[region], response=True)
+        return resp[3] == region
+
+    def read_trace(self, timeout=1.0):
+        """Waits for an armed trace to finish and returns its packets as a list
+        of (source, destination) addresses. Returns None if the region didn't
+        run before the timeout."""
+        deadline = time.monotonic() + timeout
+        packets = []
+        while True:
+            resp = self.sysex(
+                SysExCommands.READ_TRACE,
+                data=struct.pack(">H", len(packets)),
+                encode=True,
+                response=True,
+                decode=True,
+            )
+            state, _, packet_count, _, count = struct.unpack(">BBHHB", resp[:7])
+
+            if state != TraceState.DONE:
+                if time.monotonic() > deadline:
+                    return None
+                time.sleep(0.01)
+                continue
+
+            packets.extend(struct.iter_unpack(">II", resp[7 : 7 + count * 8]))
+            if count == 0 or len(packets) >= packet_count:
+                return packets
 
     def write_lut_entry(self, entry, period, castor, pollux):
         data = struct.pack(">BIHH", entry, period, castor, pollux)
         self.sysex(SysExCommands.WRITE_LUT_ENTRY, data=data, encode=True, response=True)
 
+    def write_lut_table(self, entries):
+        """Sends the whole ramp table, a list of (castor, pollux) codes, in
+        CRC-checked chunks. Call write_lut() afterwards to save it to NVM."""
+        for start in range(0, len(entries), LUT_CHUNK_MAX_ENTRIES):
+            chunk = _pack_lut_chunk(
+                start, entries[start : start + LUT_CHUNK_MAX_ENTRIES]
+            )
+            resp = self.sysex(
+                SysExCommands.WRITE_LUT_CHUNK, data=chunk, encode=True, response=True
+            )
+            if resp[3] != 0:
+                raise LUTChunkError(
+                    f"Device rejected chunk at {start}, error code {resp[3]}"
+                )
+
+    def read_lut_table(self):
+        """Reads back the ramp table in RAM as a list of (castor, pollux) codes."""
+        entries = []
+        while True:
+            data = struct.pack(">BB", len(entries), LUT_CHUNK_MAX_ENTRIES)
+            resp = self.sysex(
+                SysExCommands.READ_LUT_CHUNK,
+                data=data,
+                encode=True,
+                response=True,
+                decode=True,
+            )
+            _, chunk_entries = _unpack_lut_chunk(resp)
+            entries.extend(chunk_entries)
+            if len(chunk_entries) < LUT_CHUNK_MAX_ENTRIES:
+                return entries
+
     def write_lut(self):
         self.sysex(SysExCommands.WRITE_LUT)
 
@@ -163,6 +442,50 @@ class Gemini(midi.MIDIDevice):
     def reset_into_bootloader(self):
         self.sysex(SysExCommands.RESET_INTO_BOOTLOADER)
 
+    def update_firmware(self, image, progress=None):
+        """Streams a firmware image, the contents of gemini-firmware.bin, into
+        the device's staging flash region and applies it once the device has
+        verified it. The device resets into the new firmware afterwards.
+
+        progress is called with the number of bytes sent so far and the total.
+        """
+        image = bytes(image)
+
+        self._fw_update_command(
+            SysExCommands.BEGIN_FW_UPDATE,
+            struct.pack(">II", len(image), zlib.crc32(image)),
+        )
+
+        for offset in range(0, len(image), FW_CHUNK_MAX_DATA):
+            data = image[offset : offset + FW_CHUNK_MAX_DATA]
+            chunk = _pack_fw_chunk(offset, data)
+            for attempt in range(FW_CHUNK_RETRIES + 1):
+                resp = self.sysex(
+                    SysExCommands.WRITE_FW_CHUNK, data=chunk, encode=True, response=True
+                )
+                if resp[3] != FirmwareUpdateResult.ERR_CRC:
+                    break
+            if resp[3] != FirmwareUpdateResult.OK:
+                result = FirmwareUpdateResult(resp[3])
+                raise FirmwareUpdateError(
+                    f"Device rejected chunk at {offset}: {result.name}"
+                )
+            if progress is not None:
+                progress(min(offset + FW_CHUNK_MAX_DATA, len(image)), len(image))
+
+        self._fw_update_command(SysExCommands.FINISH_FW_UPDATE)
+
+        # There's no response unless the update couldn't be applied, the
+        # device just resets.
+        self.sysex(SysExCommands.APPLY_FW_UPDATE)
+
+    def _fw_update_command(self, command, data=None):
+        resp = self.sysex(command, data=data, encode=data is not None, response=True)
+        if resp[3] != FirmwareUpdateResult.OK:
+            raise FirmwareUpdateError(
+                f"{command.name} failed: {FirmwareUpdateResult(resp[3]).name}"
+            )
+
     def set_osc8m_freq(self, freq: int):
         data = struct.pack(">I", freq)
         self.sysex(SysExCommands.SET_OSC8M_FREQ, data=data, encode=True)
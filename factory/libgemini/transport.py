@@ -0,0 +1,75 @@
+# Copyright (c) 2023 Alethea Katherine Flowers.
+# Published under the standard MIT License.
+# Full text available at: https://opensource.org/licenses/MIT
+
+# Transports for talking to Gemini without USB MIDI.
+#
+# Gemini normally talks over USB MIDI using wintertools.midi.MIDIDevice. A
+# transport can be given to Gemini() instead to send the same SysEx messages
+# somewhere else, such as to the host build of the firmware in /firmware/sim.
+
+import socket
+
+from wintertools import teeth
+
+
+class SocketTransport:
+    """Sends SysEx messages over a TCP socket, as used by the simulator.
+
+    Messages on the socket are plain SysEx: 0xF0, the message, and 0xF7.
+    """
+
+    def __init__(self, address, timeout=5.0):
+        host, _, port = address.rpartition(":")
+        self._socket = socket.create_connection(
+            (host or "localhost", int(port)), timeout=timeout
+        )
+        self._socket.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self._buf = bytearray()
+
+    def close(self):
+        self._socket.close()
+
+    def send(self, message):
+        self._socket.sendall(bytes(message))
+
+    def wait_for_message(self):
+        """Returns the next complete SysEx message, including 0xF0 and 0xF7."""
+        while True:
+            start = self._buf.find(0xF0)
+            if start >= 0:
+                end = self._buf.find(0xF7, start)
+                if end >= 0:
+                    message = bytes(self._buf[start : end + 1])
+                    del self._buf[: end + 1]
+                    return message
+
+            chunk = self._socket.recv(4096)
+            if not chunk:
+                raise ConnectionError("Simulator closed the connection")
+            self._buf.extend(chunk)
+
+    def sysex(
+        self, marker, command, data=None, encode=False, response=False, decode=False
+    ):
+        """Same as wintertools.midi.MIDIDevice.sysex()."""
+        data = bytes(data or [])
+        if encode:
+            data = teeth.teeth_encode(data)
+
+        self.send(bytes([0xF0, marker, command]) + data + bytes([0xF7]))
+
+        if not response:
+            return None
+
+        # Skip anything else the device sends, such as monitor updates, while
+        # waiting for the response.
+        while True:
+            message = self.wait_for_message()
+            if len(message) >= 3 and message[1] == marker and message[2] == command:
+                break
+
+        if decode:
+            return teeth.teeth_decode(message[3:-1])
+
+        return message
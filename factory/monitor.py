@@ -20,7 +20,7 @@ COLOR_U12 = tui.rgb(230, 193, 253)
 COLOR_U32 = tui.rgb(228, 255, 154)
 COLOR_F16 = tui.rgb(144, 255, 203)
 BEHAVIORS = ["Coarse", "Multiply", "Follow", "Fine"]
-MODES = ["Normal", "LFO PWM", "LFO FM", "Hard Sync"]
+MODES = ["Normal", "LFO PWM", "LFO FM", "Hard Sync", "Audio FM"]
 KNOB_CHARS = "🕖🕗🕘🕙🕚🕛🕐🕑🕒🕓🕔"
 GRAPH_CHARS = "▁▂▃▄▅▆▇█"
 SPINNER_CHARS = "🌑🌒🌓🌔🌕🌖🌗🌘"
@@ -341,6 +341,78 @@ def _draw(update, test_status: _TestStatus):
         tui.reset,
         "┃",
     )
+    COLUMNS.draw(
+        "┃",
+        tui.bold,
+        "DAC skipped",
+        tui.reset,
+        tui.italic,
+        COLOR_U32,
+        update.dac_skipped_writes,
+        "",
+        tui.reset,
+        "┃",
+    )
+    COLUMNS.draw(
+        "┃",
+        tui.bold,
+        "DAC partial",
+        tui.reset,
+        tui.italic,
+        COLOR_U32,
+        update.dac_partial_writes,
+        "",
+        tui.reset,
+        "┃",
+    )
+    COLUMNS.draw(
+        "┃",
+        tui.bold,
+        "MIDI in queue",
+        tui.reset,
+        tui.italic,
+        COLOR_U32,
+        update.midi_rx_peak_depth,
+        "",
+        tui.reset,
+        "┃",
+    )
+    COLUMNS.draw(
+        "┃",
+        tui.bold,
+        "MIDI in drops",
+        tui.reset,
+        tui.italic,
+        COLOR_U32,
+        update.midi_rx_dropped,
+        "",
+        tui.reset,
+        "┃",
+    )
+    COLUMNS.draw(
+        "┃",
+        tui.bold,
+        "MIDI out drops",
+        tui.reset,
+        tui.italic,
+        COLOR_U32,
+        update.midi_tx_dropped,
+        "",
+        tui.reset,
+        "┃",
+    )
+    COLUMNS.draw(
+        "┃",
+        tui.bold,
+        "MIDI latency",
+        tui.reset,
+        tui.italic,
+        COLOR_U32,
+        update.midi_latency,
+        "us",
+        tui.reset,
+        "┃",
+    )
     print("┗", "━" * 47, "┛", sep="")
     print(
         f"  {'[green]✓' if test_status.pitch_knob_a_sweep() else 'x'}  pitch knob a sweep"
@@ -0,0 +1,56 @@
+# Copyright (c) 2023 Alethea Katherine Flowers.
+# Published under the standard MIT License.
+# Full text available at: https://opensource.org/licenses/MIT
+
+"""Measures how long common SysEx requests take.
+
+Works with a real device or with the simulator, for example:
+
+    $ GEMINI_SIM=localhost:7777 python3 sysex_benchmark.py
+"""
+
+import argparse
+import statistics
+import time
+
+from libgemini import gemini
+
+
+def benchmark(name, func, iterations):
+    times = []
+    for _ in range(iterations):
+        start = time.perf_counter()
+        func()
+        times.append(time.perf_counter() - start)
+
+    mean_ms = statistics.mean(times) * 1000
+    max_ms = max(times) * 1000
+    print(f"{name:<24} mean: {mean_ms:8.2f} ms  max: {max_ms:8.2f} ms")
+    return mean_ms
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--iterations", type=int, default=20)
+    args = parser.parse_args()
+
+    gem = gemini.Gemini.get()
+    gem.enter_calibration_mode()
+
+    print(f"Firmware: {gem.get_firmware_version()}")
+
+    benchmark("hello", gem.get_firmware_version, args.iterations)
+    benchmark("read adc", lambda: gem.read_adc(gem.ADC.CV_A), args.iterations)
+    benchmark(
+        "read adc stats (64)",
+        lambda: gem.read_adc_stats(gem.ADC.CV_A, samples=64),
+        args.iterations,
+    )
+    benchmark("read settings", gem.read_settings, args.iterations)
+    benchmark("read lut table", gem.read_lut_table, args.iterations)
+
+    gem.soft_reset()
+
+
+if __name__ == "__main__":
+    main()
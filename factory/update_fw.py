@@ -2,8 +2,15 @@
 # Published under the standard MIT License.
 # Full text available at: https://opensource.org/licenses/MIT
 
-"""Update firmware on programmed C&P boards"""
+"""Update firmware on programmed C&P boards
 
+By default the new firmware is streamed over SysEx and the device applies it
+itself, so no drive has to show up. Firmware from before SysEx updates were
+added doesn't understand that, so use --uf2 to go through the bootloader's
+drive instead.
+"""
+
+import argparse
 import pathlib
 import sys
 import time
@@ -12,6 +19,9 @@ from wintertools import fs, git, tui
 
 from libgemini import gemini
 
+FIRMWARE_BIN = pathlib.Path("../firmware/build/gemini-firmware.bin")
+
+
 def _check_firmware_version(gem):
     latest_release = git.latest_tag()
     build_id = gem.get_firmware_version()
@@ -26,6 +36,26 @@ def _check_firmware_version(gem):
 def _update_firmware(gem):
     print("Updating firmware..")
 
+    image = FIRMWARE_BIN.read_bytes()
+
+    def progress(sent, total):
+        print(f"\r{sent} / {total} bytes", end="")
+
+    gem.update_firmware(image, progress=progress)
+    print()
+
+    # Give the device time to copy the new firmware into place and reconnect.
+    time.sleep(3)
+
+    print("[green]Firmware updated![/]")
+
+    build_id = gem.get_firmware_version()
+    print(f"Firmware build ID: {build_id}")
+
+
+def _update_firmware_uf2(gem):
+    print("Updating firmware using the bootloader..")
+
     gem.reset_into_bootloader()
 
     path = pathlib.Path(fs.wait_for_drive("GEMINIBOOT", timeout=60 * 5))
@@ -42,8 +72,19 @@ def _update_firmware(gem):
 
 
 def main(stats=False):
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter
+    )
+    parser.add_argument(
+        "--uf2", action="store_true", help="Update using the UF2 bootloader."
+    )
+    args = parser.parse_args()
+
     gem = gemini.Gemini.get()
-    _update_firmware(gem)
+    if args.uf2:
+        _update_firmware_uf2(gem)
+    else:
+        _update_firmware(gem)
 
 
 if __name__ == "__main__":
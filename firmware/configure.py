@@ -55,9 +55,12 @@ SRCS = [
     "third_party/libwinter/wntr_colorspace.c",
     "third_party/libwinter/wntr_error_correction.c",
     "third_party/libwinter/wntr_midi_core.c",
+    "third_party/libwinter/wntr_midi_tx.c",
     "third_party/libwinter/wntr_midi_sysex_dispatcher.c",
+    "third_party/libwinter/wntr_nvm_write.c",
     "third_party/libwinter/wntr_periodic_waveform.c",
     "third_party/libwinter/wntr_random.c",
+    "third_party/libwinter/wntr_sysex_stream.c",
     "third_party/libwinter/wntr_ticks.c",
     # Tiny printf
     "third_party/printf/*.c",
@@ -92,6 +95,8 @@ DEFINES.update(
         # Defines for wntr:
         # - Enable the ARM Microtrace Buffer which can help with debugging.
         WNTR_ENABLE_MTB=1,
+        # - Give the MTB enough room to hold a traced hot path, see gem_trace.h.
+        WNTR_MTB_SIZE=256,
         # Set the MIDI SysEx identifier
         WNTR_MIDI_SYSEX_IDENTIFIER=0x77,
         # Defines for libfixmath:
@@ -133,6 +138,9 @@ LINK_FLAGS = buildgen.SAMD21.ld_flags() + [
     # The linker script expects a __stack_size__ symbol to know how much space
     # to set aside for the stack.
     f"-Wl,--defsym=__stack_size__={STACK_SIZE}",
+    # The link map is used by scripts/ram_report.py to show how much RAM each
+    # module uses.
+    f"-Wl,-Map=build/{PROGRAM}.map",
 ]
 
 DEBUG_DEFINES = dict(DEBUG=1)
@@ -214,6 +222,12 @@ def generate_build(configuration, run_generators, enable_tidy, enable_format):
             "src/generated/gem_ramp_table_data.c",
         )
 
+        buildgen.py_generated_file_build(
+            writer,
+            "scripts/generate_led_animation_tables.py",
+            "src/generated/gem_led_animation_tables.c",
+        )
+
     # Formatting and linting
     if enable_format:
         format_files = list(pathlib.Path(".").glob("src/**/*.[c,h]"))
@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+
+# Copyright (c) 2023 Alethea Katherine Flowers.
+# Published under the standard MIT License.
+# Full text available at: https://opensource.org/licenses/MIT
+
+"""Decodes Gemini's tokenized log (see ../src/lib/gem_log.h) back into text.
+
+The log is read from RTT channel 1, for example using J-Link's RTT logger:
+
+    $ JLinkRTTLogger -Device ATSAMD21G18 -If SWD -Speed 4000 -RTTChannel 1 log.bin
+    $ python3 scripts/gem_log_decode.py build/gemini-firmware.elf log.bin
+
+The format strings come from the firmware's ELF file, so use the same ELF
+that's running on the device. Use --table to write out the string table as
+JSON instead.
+"""
+
+import argparse
+import json
+import pathlib
+import re
+import struct
+import sys
+
+# Must match gem_log.h
+RECORD_HEADER_SIZE = 3
+DROPPED_ID = 0xFFFF
+
+SHT_SYMTAB = 2
+SHT_NOBITS = 8
+SHF_ALLOC = 0x2
+STT_FUNC = 2
+
+FORMAT_SPEC = re.compile(r"%[-+ #0]*\d*(?:\.\d+)?(?:hh|h|ll|l|z)?([diuxXcsp%])")
+
+
+class ELFFile:
+    """Just enough of an ELF32 little-endian reader to find the log strings
+    and function symbols."""
+
+    def __init__(self, path):
+        self.data = pathlib.Path(path).read_bytes()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1 or self.data[5] != 1:
+            raise ValueError(f"{path} is not a 32-bit little-endian ELF file")
+
+        (shoff,) = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", self.data, 0x2E)
+
+        self.sections = []
+        for n in range(shnum):
+            fields = struct.unpack_from("<IIIIIIIIII", self.data, shoff + n * shentsize)
+            self.sections.append(
+                dict(
+                    name_offset=fields[0],
+                    type=fields[1],
+                    flags=fields[2],
+                    addr=fields[3],
+                    offset=fields[4],
+                    size=fields[5],
+                    link=fields[6],
+                    entsize=fields[9],
+                )
+            )
+
+        names = self.sections[shstrndx]
+        for section in self.sections:
+            start = names["offset"] + section["name_offset"]
+            section["name"] = self.data[start : self.data.index(b"\0", start)].decode()
+
+    def section_data(self, name):
+        for section in self.sections:
+            if section["name"] == name:
+                return self.data[section["offset"] : section["offset"] + section["size"]]
+        raise ValueError(f"No {name} section, is this firmware built with gem_log?")
+
+    def string_at(self, address):
+        """Reads a string from the device's flash, used for %s arguments."""
+        for section in self.sections:
+            if not section["flags"] & SHF_ALLOC or section["type"] == SHT_NOBITS:
+                continue
+            if section["addr"] <= address < section["addr"] + section["size"]:
+                start = section["offset"] + address - section["addr"]
+                return self.data[start : self.data.index(b"\0", start)].decode()
+        return f"<string at 0x{address:08x}>"
+
+    def functions(self):
+        """Returns a list of (address, size, name) for every function, sorted
+        by address. The Thumb bit is cleared from the addresses."""
+        functions = []
+        for section in self.sections:
+            if section["type"] != SHT_SYMTAB:
+                continue
+            strings = self.sections[section["link"]]["offset"]
+            for offset in range(section["offset"], section["offset"] + section["size"], section["entsize"]):
+                name_offset, value, size, info = struct.unpack_from("<IIIB", self.data, offset)
+                if info & 0xF != STT_FUNC or not size:
+                    continue
+                start = strings + name_offset
+                name = self.data[start : self.data.index(b"\0", start)].decode()
+                functions.append((value & ~1, size, name))
+        return sorted(functions)
+
+
+def string_table(elf):
+    """Returns a dict of message ID to format string."""
+    data = elf.section_data(".gem_log")
+    table = {}
+    start = 0
+    while start < len(data):
+        end = data.index(b"\0", start)
+        table[start] = data[start:end].decode()
+        # Skip the string's terminator and any alignment padding.
+        start = end + 1
+        while start < len(data) and data[start] == 0:
+            start += 1
+    return table
+
+
+def format_message(elf, fmt, args):
+    args = iter(args)
+
+    def replace(match):
+        conversion = match.group(1)
+        if conversion == "%":
+            return "%"
+
+        value = next(args)
+        spec = re.sub(r"(hh|h|ll|l|z)", "", match.group(0))
+
+        if conversion in "di":
+            value = value - (1 << 32) if value & 0x80000000 else value
+        elif conversion == "s":
+            value = elf.string_at(value)
+        elif conversion == "p":
+            return f"0x{value:08x}"
+
+        return spec % value
+
+    return FORMAT_SPEC.sub(replace, fmt)
+
+
+def decode(elf, table, data):
+    """Yields the text of each record in `data`."""
+    offset = 0
+    while offset + RECORD_HEADER_SIZE <= len(data):
+        message_id, argc = struct.unpack_from("<HB", data, offset)
+        offset += RECORD_HEADER_SIZE
+
+        if offset + argc * 4 > len(data):
+            break
+
+        args = struct.unpack_from(f"<{argc}I", data, offset)
+        offset += argc * 4
+
+        if message_id == DROPPED_ID:
+            yield f"<dropped {args[0]} messages>\n"
+        elif message_id in table:
+            yield format_message(elf, table[message_id], args)
+        else:
+            yield f"<unknown message 0x{message_id:04x}: {args}>\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter
+    )
+    parser.add_argument("elf", type=pathlib.Path)
+    parser.add_argument("log", type=pathlib.Path, nargs="?")
+    parser.add_argument("--table", action="store_true", help="Output the string table as JSON")
+    args = parser.parse_args()
+
+    elf = ELFFile(args.elf)
+    table = string_table(elf)
+
+    if args.table:
+        json.dump({f"0x{id:04x}": fmt for id, fmt in table.items()}, sys.stdout, indent=2)
+        return
+
+    data = args.log.read_bytes() if args.log else sys.stdin.buffer.read()
+    for text in decode(elf, table, data):
+        sys.stdout.write(text)
+
+
+if __name__ == "__main__":
+    main()
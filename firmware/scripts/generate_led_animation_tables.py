@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+
+# Copyright (c) 2023 Alethea Katherine Flowers.
+# Published under the standard MIT License.
+# Full text available at: https://opensource.org/licenses/MIT
+
+"""Generates the look-up tables at ../src/generated/gem_led_animation_tables.c
+used by ../src/gem_led_animation.c. See ../src/gem_led_animation_tables.h."""
+
+import argparse
+import math
+import pathlib
+import textwrap
+
+QUARTER_SINE_LEN = 64
+HUE_TABLE_LEN = 256
+
+
+def hue_to_rgb(hue):
+    """The hexcone from wntr_colorspace_hsv_to_rgb() with full saturation
+    and value."""
+    hue = (hue * 1530 + 32768) // 65536
+
+    if hue < 255:
+        return 255, hue, 0
+    if hue < 510:
+        return 510 - hue, 255, 0
+    if hue < 765:
+        return 0, 255, hue - 510
+    if hue < 1020:
+        return 0, 1020 - hue, 255
+    if hue < 1275:
+        return hue - 1020, 0, 255
+    if hue < 1530:
+        return 255, 0, 1530 - hue
+    return 255, 0, 0
+
+
+def main(output_file):
+    with output_file.open("w") as fh:
+        fh.write(
+            textwrap.dedent(
+                """\
+        /* This file is generated by scripts/generate_led_animation_tables.py. Do not edit directly. */
+        /* clang-format off */
+
+        #include "gem_led_animation_tables.h"
+
+        const uint16_t gem_led_quarter_sine_table[GEM_LED_QUARTER_SINE_LEN + 1] = {
+        """
+            )
+        )
+
+        for n in range(QUARTER_SINE_LEN + 1):
+            value = round(math.sin(n / QUARTER_SINE_LEN * math.pi / 2) * 65535)
+            fh.write(f"  {value},\n")
+
+        fh.write(
+            textwrap.dedent(
+                """\
+        };
+
+        const uint8_t gem_led_hue_table[GEM_LED_HUE_TABLE_LEN][3] = {
+        """
+            )
+        )
+
+        for n in range(HUE_TABLE_LEN):
+            r, g, b = hue_to_rgb(n * 65536 // HUE_TABLE_LEN)
+            fh.write(f"  {{{r}, {g}, {b}}},\n")
+
+        fh.write(
+            textwrap.dedent(
+                """\
+        };
+
+        /* clang-format on */
+        """
+            )
+        )
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        formatter_class=argparse.ArgumentDefaultsHelpFormatter
+    )
+    parser.add_argument(
+        "output_file",
+        type=pathlib.Path,
+    )
+
+    args = parser.parse_args()
+
+    main(args.output_file)
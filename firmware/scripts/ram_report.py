@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+
+# Copyright (c) 2023 Alethea Katherine Flowers.
+# Published under the standard MIT License.
+# Full text available at: https://opensource.org/licenses/MIT
+
+"""Reports how much static RAM each module uses, based on the link map.
+
+    $ python3 scripts/ram_report.py build/gemini-firmware.map
+
+This counts everything the linker places in .relocate (initialized
+variables) and .bss (zeroed variables). Use the SysEx memory usage command
+(0x1A) to see how much of the stack is actually used at runtime.
+"""
+
+import argparse
+import collections
+import pathlib
+import re
+
+# Output sections that take up RAM, see scripts/samd21g18a.ld.
+RAM_SECTIONS = (".relocate", ".bss", ".stack")
+
+OUTPUT_SECTION = re.compile(r"^(\.\S+)\s+0x[0-9a-f]+\s+0x[0-9a-f]+", re.IGNORECASE)
+INPUT_SECTION = re.compile(
+    r"^ (\S+)?\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$", re.IGNORECASE
+)
+
+
+def parse_map(path, sections):
+    """Returns a dict of (output section, object file) to size in bytes."""
+    sizes = collections.Counter()
+    lines = pathlib.Path(path).read_text().splitlines()
+
+    # Only look at the memory map, not the archive members or discarded
+    # sections listed before it.
+    start = next(n for n, line in enumerate(lines) if line.startswith("Linker script and memory map"))
+
+    current_section = None
+    pending_name = None
+
+    for line in lines[start:]:
+        output = OUTPUT_SECTION.match(line)
+        if output or (line.startswith(".") and not line.startswith(" ")):
+            name = line.split()[0]
+            current_section = name if name in sections else None
+            pending_name = None
+            continue
+
+        if current_section is None:
+            continue
+
+        # Long input section names are on their own line, with the address,
+        # size, and object file on the next line.
+        if re.match(r"^ \S+$", line):
+            pending_name = line.strip()
+            continue
+
+        match = INPUT_SECTION.match(line)
+        if not match or (match.group(1) is None and pending_name is None):
+            pending_name = None
+            continue
+
+        size = int(match.group(3), 16)
+        if size:
+            sizes[(current_section, match.group(4).strip())] += size
+        pending_name = None
+
+    return sizes
+
+
+def module_name(object_file):
+    """Turns paths like build/src/gem_sysex.o or libc_nano.a(lib_a-memcpy.o) into shorter names."""
+    name = object_file.replace("\\\\", "/")
+    name = re.sub(r"^.*/build/", "", name)
+    name = re.sub(r"^build/", "", name)
+    return re.sub(r"\.o$", "", name)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter
+    )
+    parser.add_argument("map", type=pathlib.Path)
+    parser.add_argument("--sections", nargs="+", default=RAM_SECTIONS)
+    args = parser.parse_args()
+
+    sizes = parse_map(args.map, args.sections)
+
+    by_module = collections.defaultdict(collections.Counter)
+    for (section, object_file), size in sizes.items():
+        by_module[module_name(object_file)][section] += size
+
+    totals = collections.Counter()
+    rows = sorted(by_module.items(), key=lambda item: sum(item[1].values()), reverse=True)
+
+    header = "".join(f"{section:>12}" for section in args.sections)
+    print(f"{'module':<60}{header}{'total':>12}")
+
+    for module, section_sizes in rows:
+        totals.update(section_sizes)
+        columns = "".join(f"{section_sizes[section]:>12}" for section in args.sections)
+        print(f"{module:<60}{columns}{sum(section_sizes.values()):>12}")
+
+    columns = "".join(f"{totals[section]:>12}" for section in args.sections)
+    print(f"{'total':<60}{columns}{sum(totals.values()):>12}")
+
+
+if __name__ == "__main__":
+    main()
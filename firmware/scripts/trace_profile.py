@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+
+# Copyright (c) 2023 Alethea Katherine Flowers.
+# Published under the standard MIT License.
+# Full text available at: https://opensource.org/licenses/MIT
+
+"""Turns an MTB trace snapshot (see ../src/gem_trace.h) into a profile.
+
+Capture a trace using ../../factory/capture_trace.py, then:
+
+    $ python3 scripts/trace_profile.py build/gemini-firmware.elf trace.json
+
+Each MTB packet records a taken branch as a (source, destination) pair. The
+code between one packet's destination and the next packet's source ran
+straight through, so that's a basic block. This counts how many times each
+block ran and estimates how many instructions that was, assuming 16-bit
+Thumb instructions. Use the same ELF that's running on the device.
+"""
+
+import argparse
+import bisect
+import collections
+import json
+import pathlib
+
+from gem_log_decode import ELFFile
+
+# Exception returns branch to one of these magic addresses.
+EXC_RETURN_MIN = 0xFFFFFFF0
+
+
+class Symbols:
+    def __init__(self, elf):
+        self.functions = elf.functions()
+        self.addresses = [address for address, _, _ in self.functions]
+
+    def lookup(self, address):
+        n = bisect.bisect_right(self.addresses, address) - 1
+        if n >= 0:
+            start, size, name = self.functions[n]
+            if address < start + size:
+                return name, address - start
+        return None, None
+
+
+def basic_blocks(packets):
+    """Yields (start, end) for each block of code that ran between branches."""
+    for (_, destination), (source, _) in zip(packets, packets[1:]):
+        # Bit 0 of each address is used by the MTB for flags.
+        start = destination & ~1
+        end = source & ~1
+        # Branches to or from exception returns don't bound a block of code.
+        if start >= EXC_RETURN_MIN or end >= EXC_RETURN_MIN or end < start:
+            continue
+        yield start, end
+
+
+def profile(symbols, packets):
+    blocks = collections.Counter(basic_blocks(packets))
+    functions = collections.Counter()
+    rows = []
+
+    for (start, end), count in blocks.items():
+        instructions = (end - start) // 2 + 1
+        name, offset = symbols.lookup(start)
+        name = f"{name}+0x{offset:x}" if name else f"0x{start:08x}"
+        rows.append((count * instructions, count, instructions, start, name))
+        functions[name.split("+")[0]] += count * instructions
+
+    return sorted(rows, reverse=True), functions
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter
+    )
+    parser.add_argument("elf", type=pathlib.Path)
+    parser.add_argument("trace", type=pathlib.Path)
+    parser.add_argument("--top", type=int, default=20, help="Number of blocks to show")
+    args = parser.parse_args()
+
+    symbols = Symbols(ELFFile(args.elf))
+    trace = json.loads(args.trace.read_text())
+    packets = trace["packets"]
+
+    print(f"Region: {trace['region']}, {len(packets)} packets")
+    if trace.get("full"):
+        print("The trace buffer filled up, so this only covers the start of the region.")
+
+    rows, functions = profile(symbols, packets)
+    total = sum(functions.values()) or 1
+
+    print()
+    print(f"{'Instructions':>12} {'Runs':>6} {'Size':>5}  Block")
+    for instructions, count, size, start, name in rows[: args.top]:
+        print(f"{instructions:>12} {count:>6} {size:>5}  {name} (0x{start:08x})")
+
+    print()
+    print(f"{'Instructions':>12} {'%':>6}  Function")
+    for name, instructions in functions.most_common():
+        print(f"{instructions:>12} {instructions * 100 / total:>5.1f}%  {name}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+
+import argparse
+import pathlib
+
+from wintertools import buildgen
+from wintertools.third_party import ninja_syntax
+
+# Check the python version before doing anything else.
+buildgen.check_python_version()
+
+# Make sure we're in the right directory.
+buildgen.ensure_directory()
+
+# Gemini/simulator-specific sources, includes, and defines.
+
+PROGRAM = "gemini-sim"
+
+SRCS = [
+    "../sim/**/*.c",
+    "../src/drivers/gem_mcp4728.c",
+    "../src/gem_fw_update.c",
+    "../src/gem_nvm_journal.c",
+    "../src/gem_oscillator.c",
+    "../src/gem_pitch_smoothing.c",
+    "../src/gem_quantizer.c",
+    "../src/gem_ramp_table_load_save.c",
+    "../src/gem_ramp_table_lookup.c",
+    "../src/gem_ramp_table_transfer.c",
+    "../src/gem_settings_load_save.c",
+    "../src/gem_sysex.c",
+    "../src/gem_trace.c",
+    "../src/generated/gem_monitor_update.c",
+    "../src/generated/gem_ramp_table_data.c",
+    "../src/generated/gem_settings.c",
+    "../src/lib/gem_boot_profile.c",
+    "../src/lib/gem_crc32.c",
+    "../src/lib/gem_log.c",
+    "../src/lib/gem_memory.c",
+    "../src/lib/gem_sample_stats.c",
+    "../third_party/libwinter/teeth.c",
+    "../third_party/libwinter/wntr_assert.c",
+    "../third_party/libwinter/wntr_bezier.c",
+    "../third_party/libwinter/wntr_error_correction.c",
+    "../third_party/libwinter/wntr_midi_sysex_dispatcher.c",
+    "../third_party/libwinter/wntr_nvm_write.c",
+    "../third_party/libwinter/wntr_sysex_stream.c",
+    "../third_party/libfixmath/fix16.c",
+    "../third_party/libfixmath/fix16_exp.c",
+    "../third_party/libfixmath/fix16_str.c",
+    "../third_party/printf/printf.c",
+    "../third_party/structy/structy.c",
+]
+
+INCLUDES = [
+    "../src",
+    "../src/config",
+    "../src/generated",
+    "../src/hw",
+    "../src/drivers",
+    "../src/lib",
+    "../third_party/libwinter/samd",
+    "../third_party/libwinter/samd/samd21",
+    "../third_party/samd21/include",
+    "../third_party/cmsis/include",
+    "../third_party/tinyusb/src",
+]
+
+DEFINES = buildgen.Desktop.defines()
+
+DEFINES.update(
+    dict(
+        DEBUG=1,
+        SAMD21=1,
+        __SAMD21G18A__=1,
+        # Same settings as the firmware build.
+        WNTR_MIDI_SYSEX_IDENTIFIER=0x77,
+        FIXMATH_FAST_SIN=1,
+        FIXMATH_NO_CACHE=1,
+        PRINTF_DISABLE_SUPPORT_FLOAT=1,
+        PRINTF_DISABLE_SUPPORT_EXPONENTIAL=1,
+    )
+)
+
+
+# Toolchain configuration. Wintertools does most of the work here.
+
+# Switch to clang since buildgen defaults to ARM gcc.
+buildgen.GCC = "clang"
+
+COMMON_FLAGS = buildgen.Desktop.common_flags()
+
+COMPILE_FLAGS = buildgen.Desktop.cc_flags()
+
+COMPILE_FLAGS += [
+    "-ggdb3 -Og",
+]
+
+LINK_FLAGS = buildgen.Desktop.ld_flags()
+
+# The settings, ramp table, and firmware update code find their flash regions
+# using symbols from the firmware's linker script. Define them here with the
+# same layout, the simulated NVM in sim/gem_sim_nvm.c covers these ranges.
+NVM_SYMBOLS = dict(
+    _nvm_settings_journal_base_address=0x3F800,
+    _nvm_settings_journal_length=0x400,
+    _nvm_settings_base_address=0x3FC00,
+    _nvm_lut_base_address=0x3FE00,
+    _nvm_lut_length=0x200,
+    _fw_app_base_address=0x2000,
+    _fw_staging_base_address=0x20C00,
+    _fw_staging_length=0x1EC00,
+)
+
+LINK_FLAGS += ["-no-pie"]
+LINK_FLAGS += [f"-Wl,--defsym={name}={value:#x}" for name, value in NVM_SYMBOLS.items()]
+
+COMPILE_FLAGS += ["-fno-pie"]
+
+
+# Buildfile generation
+
+
+def generate_build():
+    srcs = buildgen.expand_srcs(SRCS)
+    INCLUDES.extend(buildgen.includes_from_srcs(srcs))
+
+    compiler_flags = COMMON_FLAGS + COMPILE_FLAGS
+    linker_flags = COMMON_FLAGS + LINK_FLAGS
+
+    buildfile_path = pathlib.Path("./build.ninja")
+    buildfile = buildfile_path.open("w")
+    writer = ninja_syntax.Writer(buildfile)
+
+    # Global variables
+
+    writer.comment("This is generated by configure.py- don't edit it directly!")
+    writer.newline()
+
+    buildgen.toolchain_variables(
+        writer,
+        cc_flags=compiler_flags,
+        linker_flags=linker_flags,
+        includes=INCLUDES,
+        defines=DEFINES,
+    )
+
+    # Use wintertools' common rules for compiling and such.
+    buildgen.common_rules(writer)
+
+    # Builds for compiling, linking, and outputting the program
+    objects = buildgen.compile_build(writer, srcs)
+    buildgen.link_build(writer, PROGRAM, objects, ext="")
+
+    # Builds for generated files
+
+    # Formatting and linting
+    format_files = list(pathlib.Path(".").glob("sim/**/*.[c,h]"))
+    buildgen.clang_format_build(writer, format_files)
+
+    # Special reconfigure build
+    buildgen.reconfigure_build(writer)
+
+    # All done. :)
+    writer.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        formatter_class=argparse.ArgumentDefaultsHelpFormatter
+    )
+
+    args = parser.parse_args()
+
+    generate_build()
+
+    print("Created build.ninja")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,160 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#include "gem_sim_hw.h"
+#include "gem_adc.h"
+#include "gem_config.h"
+#include "gem_fw_swap.h"
+#include "gem_i2c.h"
+#include "gem_led_animation.h"
+#include "gem_pulseout.h"
+#include "wntr_bootloader.h"
+#include "wntr_build_info.h"
+#include "wntr_delay.h"
+#include "wntr_mtb.h"
+#include "wntr_serial_number.h"
+#include "wntr_ticks.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* The ADC is modeled as a fixed code per channel plus a little noise. */
+#define ADC_NOISE 3
+
+static uint16_t adc_codes_[GEM_IN_COUNT] = {2048, 2048, 2048, 2048, 2048, 2048, 2048, 2048, 2048};
+static uint16_t adc_gain_corr_ = 2048;
+static int16_t adc_offset_corr_ = 0;
+static uint8_t adc_selected_ = 0;
+static uint32_t noise_state_ = 1;
+
+/* Forward declarations */
+
+static int32_t noise_();
+
+/* Public functions */
+
+void gem_sim_adc_set(uint8_t channel, uint16_t code) {
+    if (channel < GEM_IN_COUNT) {
+        adc_codes_[channel] = code;
+    }
+}
+
+uint16_t gem_sim_adc_read(uint8_t channel) {
+    int32_t code = (int32_t)(adc_codes_[channel]) + noise_();
+
+    // Same as the ADC's hardware error correction: (code - offset) * gain.
+    code = ((code - adc_offset_corr_) * adc_gain_corr_) / 2048;
+
+    if (code < 0) {
+        return 0;
+    }
+    if (code > 4095) {
+        return 4095;
+    }
+    return (uint16_t)(code);
+}
+
+/* Simulated ADC */
+
+void gem_adc_set_error_correction(uint16_t gain, uint16_t offset) {
+    adc_gain_corr_ = gain;
+    adc_offset_corr_ = (int16_t)(offset);
+}
+
+uint16_t gem_adc_read_sync(const struct GemADCInput* input) {
+    gem_adc_select_input_sync(input);
+    return gem_adc_sample_sync();
+}
+
+void gem_adc_select_input_sync(const struct GemADCInput* input) {
+    // The simulator's ADC inputs table is the real one, so the channel
+    // number is the input's index in it.
+    adc_selected_ = 0;
+    for (uint8_t channel = 0; channel < GEM_IN_COUNT; channel++) {
+        if (input->ain == GEM_II_ADC_INPUTS[channel].ain) {
+            adc_selected_ = channel;
+            break;
+        }
+    }
+}
+
+uint16_t gem_adc_sample_sync() { return gem_sim_adc_read(adc_selected_); }
+
+void gem_adc_stop_scanning() {}
+void gem_adc_resume_scanning() {}
+
+/* Simulated peripherals */
+
+enum GemI2CResult gem_i2c_write(const struct GemI2CConfig* i2c, uint8_t address, uint8_t* data, size_t len) {
+    (void)i2c;
+    (void)address;
+    (void)data;
+    (void)len;
+    return GEM_I2C_RESULT_SUCCESS;
+}
+
+void gem_pulseout_set_period(const struct GemPulseOutConfig* po, uint8_t channel, uint32_t period) {
+    (void)po;
+    printf("Pulse output %u period set to %u\n", channel, period);
+}
+
+void gem_led_animation_set_mode(enum GemMode mode) { printf("Mode set to %u\n", mode); }
+
+/* Simulated libwinter hardware functions */
+
+uint32_t wntr_ticks() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+void wntr_delay_us(uint32_t microseconds) { usleep(microseconds); }
+
+void wntr_serial_number(uint8_t dst[WNTR_SERIAL_NUMBER_LEN]) {
+    for (size_t i = 0; i < WNTR_SERIAL_NUMBER_LEN; i++) { dst[i] = (uint8_t)(0xA0 + i); }
+}
+
+const char* wntr_build_info_string() { return "gemini-sim"; }
+
+void wntr_reset_into_bootloader() {
+    // There's no bootloader to reset into, so act like the device went away.
+    printf("Reset into bootloader requested, exiting.\n");
+    exit(0);
+}
+
+void gem_fw_swap_and_reset(uint32_t staging_base, uint32_t app_base, size_t len) {
+    // There's no application to replace, so act like the device went away
+    // to start the new firmware.
+    printf("Applying %zu byte firmware update from 0x%08x to 0x%08x, exiting.\n", len, staging_base, app_base);
+    exit(0);
+}
+
+/* There's no trace hardware, so traces always come back empty. */
+void wntr_mtb_init() {}
+
+void wntr_mtb_capture_start() {}
+
+size_t wntr_mtb_capture_stop() { return 0; }
+
+const uint32_t* wntr_mtb_buffer() {
+    static const uint32_t empty_[2] = {0, 0};
+    return empty_;
+}
+
+/* Output for the tiny printf library used by the firmware. */
+void _putchar(char character) { putchar(character); }
+
+/* Private functions */
+
+static int32_t noise_() {
+    // xorshift32, good enough for a bit of noise.
+    noise_state_ ^= noise_state_ << 13;
+    noise_state_ ^= noise_state_ >> 17;
+    noise_state_ ^= noise_state_ << 5;
+    return (int32_t)(noise_state_ % (2 * ADC_NOISE + 1)) - ADC_NOISE;
+}
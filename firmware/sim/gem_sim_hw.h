@@ -0,0 +1,21 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+/*
+    Simulated hardware for the simulator. This replaces the SAM D21's ADC,
+    I2C, ticks, and other peripherals used by the SysEx commands with simple
+    host implementations.
+*/
+
+#include <stdint.h>
+
+/* Sets the code that the simulated ADC reads for the given channel (before error correction). */
+void gem_sim_adc_set(uint8_t channel, uint16_t code);
+
+/* Reads the given channel the same way the hardware would, including noise and error correction. */
+uint16_t gem_sim_adc_read(uint8_t channel);
@@ -0,0 +1,90 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#include "gem_sim_nvm.h"
+#include "wntr_assert.h"
+#include <stdio.h>
+#include <string.h>
+
+static uint8_t flash_[GEM_SIM_NVM_SIZE];
+static uint8_t staging_[GEM_SIM_STAGING_SIZE];
+static const char* path_ = NULL;
+static bool dirty_ = false;
+
+/* Forward declarations */
+
+static uint8_t* memory_(uint32_t addr, size_t len);
+
+/* Public functions */
+
+void gem_sim_nvm_load(const char* path) {
+    path_ = path;
+    memset(flash_, 0xFF, sizeof(flash_));
+    memset(staging_, 0xFF, sizeof(staging_));
+
+    FILE* fh = fopen(path, "rb");
+    if (fh == NULL) {
+        printf("NVM file %s doesn't exist, starting with erased NVM.\n", path);
+        return;
+    }
+
+    size_t read = fread(flash_, 1, sizeof(flash_), fh);
+    fclose(fh);
+
+    if (read != sizeof(flash_)) {
+        printf("NVM file %s is too short, starting with erased NVM.\n", path);
+        memset(flash_, 0xFF, sizeof(flash_));
+    }
+}
+
+bool gem_sim_nvm_save() {
+    if (!dirty_ || path_ == NULL) {
+        return true;
+    }
+
+    FILE* fh = fopen(path_, "wb");
+    if (fh == NULL) {
+        printf("Couldn't open NVM file %s for writing.\n", path_);
+        return false;
+    }
+
+    size_t written = fwrite(flash_, 1, sizeof(flash_), fh);
+    fclose(fh);
+
+    dirty_ = false;
+    return written == sizeof(flash_);
+}
+
+/* Implementations of the hardware-specific wntr_nvm functions. */
+
+void wntr_nvm_read(uint32_t src, uint8_t* buf, size_t len) { memcpy(buf, memory_(src, len), len); }
+
+void wntr_nvm_erase_row(uint32_t addr) {
+    WNTR_ASSERT(addr % WNTR_NVM_ROW_SIZE == 0);
+    memset(memory_(addr, WNTR_NVM_ROW_SIZE), 0xFF, WNTR_NVM_ROW_SIZE);
+    /* Only the NVM block is saved to the file. */
+    dirty_ |= addr >= GEM_SIM_NVM_BASE;
+}
+
+void wntr_nvm_write_page(uint32_t dst, const uint8_t* buf, size_t len) {
+    WNTR_ASSERT(dst % WNTR_NVM_PAGE_SIZE == 0 && len <= WNTR_NVM_PAGE_SIZE);
+    uint8_t* page = memory_(dst, len);
+
+    /* Programming can only change bits from 1 to 0. */
+    for (size_t i = 0; i < len; i++) { page[i] &= buf[i]; }
+    dirty_ |= dst >= GEM_SIM_NVM_BASE;
+}
+
+/* Private functions */
+
+/* Finds the memory backing the given range. */
+static uint8_t* memory_(uint32_t addr, size_t len) {
+    if (addr >= GEM_SIM_STAGING_BASE && addr + len <= GEM_SIM_STAGING_BASE + GEM_SIM_STAGING_SIZE) {
+        return staging_ + (addr - GEM_SIM_STAGING_BASE);
+    }
+    WNTR_ASSERT(addr >= GEM_SIM_NVM_BASE && addr + len <= GEM_SIM_NVM_BASE + GEM_SIM_NVM_SIZE);
+    return flash_ + (addr - GEM_SIM_NVM_BASE);
+}
@@ -0,0 +1,34 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+/*
+    A file-backed model of the SAM D21's NVM block for the simulator.
+
+    It implements the hardware-specific parts of wntr_nvm, so the real
+    settings journal and ramp table code run on top of it unchanged. The
+    contents are kept in a file so that settings and calibration survive
+    restarting the simulator, just like they survive power cycling Gemini.
+
+    The firmware update staging region is modeled too, so that updates can
+    be sent to the simulator. It's only kept in memory.
+*/
+
+#include "wntr_nvm.h"
+#include <stdbool.h>
+
+/* Matches the nvm block in scripts/samd21g18a.ld. */
+#define GEM_SIM_NVM_BASE 0x3F800
+#define GEM_SIM_NVM_SIZE 0x800
+#define GEM_SIM_STAGING_BASE 0x20C00
+#define GEM_SIM_STAGING_SIZE 0x1EC00
+
+/* Loads the NVM contents from `path`. If it doesn't exist the NVM starts out erased. */
+void gem_sim_nvm_load(const char* path);
+
+/* Writes the NVM contents back to the file if they've changed. */
+bool gem_sim_nvm_save();
@@ -0,0 +1,341 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#include "gem_sim_pitch.h"
+#include "gem_config.h"
+#include "gem_oscillator.h"
+#include "gem_pitch_smoothing.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+/* C0, the frequency for 0 V. Same as gem_voct_to_frequency(). */
+#define C0_HZ 16.35159783
+#define OCTAVES 7
+#define CODE_COUNT 4096
+
+/* Pitch smoothing is given this many updates to settle at each code. */
+#define SETTLE_FRAMES 256
+
+/* Must match charge_code_for_frequency() in factory/libgemini/oscillators.py */
+#define CHARGE_SLOPE 0.925
+#define CHARGE_TARGET_VOLTAGE 10.0
+#define CHARGE_MAX_FREQUENCY 5000.0
+#define CHARGE_MAX_DAC_VOLTAGE 3.3
+#define DAC_MAX_CODE 4095.0
+
+#define WAV_SAMPLE_RATE 48000
+#define WAV_NOTE_SAMPLES (WAV_SAMPLE_RATE / 4)
+
+struct Point {
+    uint16_t code;
+    /* The exact pitch for the code, in volts. */
+    double pitch;
+    double ideal_hz;
+    double output_hz;
+    double cents;
+    uint16_t ramp_cv;
+    /* The ramp's amplitude relative to full, or 0 if full amplitude needs
+       more than the DAC can output. */
+    double amplitude;
+};
+
+struct Stats {
+    uint32_t count;
+    double max_abs_cents;
+    double sum_squared_cents;
+    uint16_t worst_code;
+    uint32_t amplitude_count;
+    double min_amplitude;
+    double max_amplitude;
+};
+
+/* Forward declarations */
+
+static void setup_oscillator_(
+    struct GemOscillator* osc,
+    uint8_t number,
+    const struct GemSettings* settings,
+    const struct GemPitchSmoothing* smoothing);
+static bool measure_(
+    struct GemOscillator* osc,
+    const struct GemSettings* settings,
+    const struct GemPulseOutConfig* pulseout,
+    uint16_t code,
+    struct Point* point);
+static void stats_add_(struct Stats* stats, const struct Point* point);
+static void print_stats_(const char* label, const struct Stats* stats);
+static bool write_wav_(const char* path, const struct GemSettings* settings, const struct GemPulseOutConfig* pulseout);
+static void write_u32_le_(FILE* fh, uint32_t value);
+static void write_u16_le_(FILE* fh, uint16_t value);
+
+/* Public functions */
+
+void gem_sim_pitch_report(const struct GemSettings* settings, const char* csv_path, const char* wav_path) {
+    struct GemPulseOutConfig pulseout = GEM_II_PULSE_OUT_CFG;
+    pulseout.gclk_freq = settings->osc8m_freq;
+
+    FILE* csv = NULL;
+    if (csv_path != NULL) {
+        csv = fopen(csv_path, "w");
+        if (csv == NULL) {
+            printf("Couldn't open %s for writing.\n", csv_path);
+            return;
+        }
+        fprintf(csv, "oscillator,code,pitch_v,ideal_hz,output_hz,cents,ramp_cv,amplitude\n");
+    }
+
+    struct GemPitchSmoothing smoothing;
+    GemPitchSmoothing_init(&smoothing, settings->pitch_smoothing_min_cutoff, settings->pitch_smoothing_sensitivity);
+
+    printf(
+        "Pitch tracking with OSC8M at %u Hz, error in cents and ramp amplitude relative to full:\n",
+        pulseout.gclk_freq);
+
+    for (uint8_t number = 0; number < 2; number++) {
+        const char* name = number == 0 ? "Castor" : "Pollux";
+        struct GemOscillator osc;
+        setup_oscillator_(&osc, number, settings, &smoothing);
+
+        struct Stats total = {.min_amplitude = INFINITY};
+        struct Stats octaves[OCTAVES];
+        for (size_t i = 0; i < OCTAVES; i++) { octaves[i] = (struct Stats){.min_amplitude = INFINITY}; }
+        uint32_t out_of_range = 0;
+
+        for (uint32_t code = 0; code < CODE_COUNT; code++) {
+            struct Point point;
+            if (!measure_(&osc, settings, &pulseout, (uint16_t)(code), &point)) {
+                out_of_range++;
+                continue;
+            }
+
+            stats_add_(&total, &point);
+            stats_add_(&octaves[(size_t)(point.pitch) < OCTAVES ? (size_t)(point.pitch) : OCTAVES - 1], &point);
+
+            if (csv != NULL) {
+                fprintf(
+                    csv,
+                    "%s,%u,%.6f,%.6f,%.6f,%.4f,%u,%.6f\n",
+                    name,
+                    point.code,
+                    point.pitch,
+                    point.ideal_hz,
+                    point.output_hz,
+                    point.cents,
+                    point.ramp_cv,
+                    point.amplitude);
+            }
+        }
+
+        printf(
+            "  %-14s %10s %10s %11s %14s %14s\n",
+            name,
+            "max error",
+            "rms error",
+            "worst code",
+            "min amplitude",
+            "max amplitude");
+        for (size_t i = 0; i < OCTAVES; i++) {
+            char label[16];
+            snprintf(label, sizeof(label), "%zu V - %zu V", i, i + 1);
+            print_stats_(label, &octaves[i]);
+        }
+        print_stats_("overall", &total);
+
+        if (total.amplitude_count > 0) {
+            printf(
+                "  Ramp amplitude flatness: %.2f dB peak-to-peak over %u codes, "
+                "%u codes need more than the DAC can output.\n",
+                20.0 * log10(total.max_amplitude / total.min_amplitude),
+                total.amplitude_count,
+                total.count - total.amplitude_count);
+        }
+        printf("  %u codes are outside of the 0 V - %u V pitch range.\n", out_of_range, OCTAVES);
+    }
+
+    if (csv != NULL) {
+        fclose(csv);
+        printf("Wrote the pitch curve to %s.\n", csv_path);
+    }
+
+    if (wav_path != NULL && write_wav_(wav_path, settings, &pulseout)) {
+        printf("Rendered a chromatic scale to %s.\n", wav_path);
+    }
+}
+
+/* Private functions */
+
+/* Same as main.c's apply_settings_(), minus everything that isn't part of tracking. */
+static void setup_oscillator_(
+    struct GemOscillator* osc,
+    uint8_t number,
+    const struct GemSettings* settings,
+    const struct GemPitchSmoothing* smoothing) {
+    gem_oscillator_init(
+        (struct WntrErrorCorrection){.offset = settings->cv_offset_error, .gain = settings->cv_gain_error}, F16(0));
+
+    *osc = (struct GemOscillator){
+        .number = number,
+        .pitch_cv_min = GEM_II_OSC_INPUT_CFG.pitch_cv_min,
+        .pitch_cv_max = GEM_II_OSC_INPUT_CFG.pitch_cv_max,
+        .pitch_offset = settings->base_cv_offset,
+        .pulse_width_bitmask = 0xFFFF,
+        .pitch_smoothing_enabled = number == 0 ? settings->castor_pitch_smoothing : settings->pollux_pitch_smoothing,
+        .pitch_smoothing = smoothing,
+    };
+    GemOscillator_init(osc);
+}
+
+static bool measure_(
+    struct GemOscillator* osc,
+    const struct GemSettings* settings,
+    const struct GemPulseOutConfig* pulseout,
+    uint16_t code,
+    struct Point* point) {
+    // The exact pitch for the code, the same calculation as
+    // gem_oscillator_calc_pitch_cv_() without any rounding.
+    double cv_min = fix16_to_dbl(osc->pitch_cv_min);
+    double cv_max = fix16_to_dbl(osc->pitch_cv_max);
+    double corrected = (code - fix16_to_dbl(settings->cv_offset_error)) * fix16_to_dbl(settings->cv_gain_error);
+    double pitch = cv_min + (4095.0 - corrected) / 4095.0 * (cv_max - cv_min) + fix16_to_dbl(settings->base_cv_offset);
+
+    // The firmware clamps the pitch, there's nothing to track outside of it.
+    if (pitch <= 0.0 || pitch >= OCTAVES) {
+        return false;
+    }
+
+    struct GemOscillatorInputs inputs = {
+        .mode = GEM_MODE_NORMAL,
+        .pitch_cv_code = code,
+        .tweak_pitch_knob_code = UINT16_MAX,
+        .tweak_pulse_knob_code = UINT16_MAX,
+        .tweak_lfo_knob_code = UINT16_MAX,
+    };
+
+    size_t frames = osc->pitch_smoothing_enabled ? SETTLE_FRAMES : 1;
+    for (size_t i = 0; i < frames; i++) { GemOscillator_update(osc, inputs); }
+    GemOscillator_post_update(pulseout, osc);
+
+    point->code = code;
+    point->pitch = pitch;
+    point->ideal_hz = C0_HZ * exp2(pitch);
+    // The timer counts from 0 to the period, so each cycle is period + 1 ticks.
+    point->output_hz = (double)(pulseout->gclk_freq) / (osc->pulseout_period + 1.0);
+    point->cents = 1200.0 * log2(point->output_hz / point->ideal_hz);
+    point->ramp_cv = osc->ramp_cv;
+
+    double full_amplitude_code = CHARGE_SLOPE * CHARGE_TARGET_VOLTAGE * point->output_hz / CHARGE_MAX_FREQUENCY /
+                                 CHARGE_MAX_DAC_VOLTAGE * DAC_MAX_CODE;
+    point->amplitude = full_amplitude_code <= DAC_MAX_CODE ? osc->ramp_cv / full_amplitude_code : 0.0;
+
+    return true;
+}
+
+static void stats_add_(struct Stats* stats, const struct Point* point) {
+    stats->count++;
+    stats->sum_squared_cents += point->cents * point->cents;
+    if (fabs(point->cents) > stats->max_abs_cents) {
+        stats->max_abs_cents = fabs(point->cents);
+        stats->worst_code = point->code;
+    }
+
+    if (point->amplitude > 0.0) {
+        stats->amplitude_count++;
+        stats->min_amplitude = fmin(stats->min_amplitude, point->amplitude);
+        stats->max_amplitude = fmax(stats->max_amplitude, point->amplitude);
+    }
+}
+
+static void print_stats_(const char* label, const struct Stats* stats) {
+    if (stats->count == 0) {
+        printf("  %-14s %10s\n", label, "-");
+        return;
+    }
+
+    printf(
+        "  %-14s %10.3f %10.3f %11u",
+        label,
+        stats->max_abs_cents,
+        sqrt(stats->sum_squared_cents / stats->count),
+        stats->worst_code);
+    if (stats->amplitude_count > 0) {
+        printf(" %14.4f %14.4f", stats->min_amplitude, stats->max_amplitude);
+    }
+    printf("\n");
+}
+
+/*
+    Renders Castor's ramp for each semitone, using the code closest to it, as
+    a naive sawtooth at the modeled output frequency and amplitude. The scale
+    starts a semitone above 0 V and ends a semitone below 7 V since the ends
+    themselves are outside of what measure_() tracks.
+*/
+static bool write_wav_(const char* path, const struct GemSettings* settings, const struct GemPulseOutConfig* pulseout) {
+    FILE* fh = fopen(path, "wb");
+    if (fh == NULL) {
+        printf("Couldn't open %s for writing.\n", path);
+        return false;
+    }
+
+    struct GemPitchSmoothing smoothing;
+    GemPitchSmoothing_init(&smoothing, settings->pitch_smoothing_min_cutoff, settings->pitch_smoothing_sensitivity);
+    struct GemOscillator osc;
+    setup_oscillator_(&osc, 0, settings, &smoothing);
+
+    double cv_min = fix16_to_dbl(osc.pitch_cv_min);
+    double cv_max = fix16_to_dbl(osc.pitch_cv_max);
+    double offset = fix16_to_dbl(settings->base_cv_offset);
+    uint32_t notes = OCTAVES * 12 - 1;
+    uint32_t data_len = notes * WAV_NOTE_SAMPLES * 2;
+
+    // RIFF header and a 16-bit PCM mono format chunk.
+    fwrite("RIFF", 1, 4, fh);
+    write_u32_le_(fh, 36 + data_len);
+    fwrite("WAVEfmt ", 1, 8, fh);
+    write_u32_le_(fh, 16);
+    write_u16_le_(fh, 1);
+    write_u16_le_(fh, 1);
+    write_u32_le_(fh, WAV_SAMPLE_RATE);
+    write_u32_le_(fh, WAV_SAMPLE_RATE * 2);
+    write_u16_le_(fh, 2);
+    write_u16_le_(fh, 16);
+    fwrite("data", 1, 4, fh);
+    write_u32_le_(fh, data_len);
+
+    double phase = 0.0;
+    for (uint32_t note = 0; note < notes; note++) {
+        // Invert the exact pitch calculation in measure_() to find the code.
+        double pitch = (note + 1) / 12.0;
+        double corrected = 4095.0 - (pitch - offset - cv_min) / (cv_max - cv_min) * 4095.0;
+        double code = corrected / fix16_to_dbl(settings->cv_gain_error) + fix16_to_dbl(settings->cv_offset_error);
+        code = fmin(fmax(round(code), 0.0), 4095.0);
+
+        struct Point point = {};
+        measure_(&osc, settings, pulseout, (uint16_t)(code), &point);
+
+        double amplitude = point.amplitude > 0.0 ? fmin(point.amplitude, 1.0) : 1.0;
+        for (uint32_t i = 0; i < WAV_NOTE_SAMPLES; i++) {
+            double sample = point.output_hz > 0.0 ? (2.0 * phase - 1.0) * amplitude * 0.5 : 0.0;
+            write_u16_le_(fh, (uint16_t)((int16_t)(lround(sample * 32767.0))));
+            phase += point.output_hz / WAV_SAMPLE_RATE;
+            phase -= floor(phase);
+        }
+    }
+
+    fclose(fh);
+    return true;
+}
+
+static void write_u32_le_(FILE* fh, uint32_t value) {
+    uint8_t buf[4] = {value & 0xFF, (value >> 8) & 0xFF, (value >> 16) & 0xFF, value >> 24};
+    fwrite(buf, 1, 4, fh);
+}
+
+static void write_u16_le_(FILE* fh, uint16_t value) {
+    uint8_t buf[2] = {value & 0xFF, value >> 8};
+    fwrite(buf, 1, 2, fh);
+}
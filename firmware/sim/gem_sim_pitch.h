@@ -0,0 +1,37 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+/*
+    Measures how accurately the whole signal chain tracks 1 V/octave.
+
+    Every pitch CV ADC code is run through the same code the firmware uses,
+    GemOscillator_update() and GemOscillator_post_update(), with the loaded
+    settings and ramp table. The pulse output's frequency is modeled from
+    the resulting timer period and the OSC8M frequency setting, and is
+    compared against the exact frequency for the voltage the code
+    represents. The knobs, quantization, and modulation are left out since
+    they're not part of tracking, but the ADC error correction, base pitch
+    offset, and pitch smoothing (given time to settle) are included.
+
+    The ramp's amplitude is modeled with the charge model used to generate
+    the default ramp table, charge_code_for_frequency() in
+    factory/libgemini/oscillators.py: the control voltage for full amplitude
+    is proportional to the output frequency, so the relative amplitude is the
+    actual ramp control voltage divided by that.
+*/
+
+#include "gem_settings.h"
+
+/*
+    Prints the pitch error in cents and the ramp amplitude flatness for each
+    octave and overall. If `csv_path` isn't NULL, the full curve for every
+    code is written there. If `wav_path` isn't NULL, a chromatic scale across
+    Castor's range is rendered there as a 48 kHz mono WAV file so it can be
+    listened to or analyzed.
+*/
+void gem_sim_pitch_report(const struct GemSettings* settings, const char* csv_path, const char* wav_path);
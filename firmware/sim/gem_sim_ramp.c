@@ -0,0 +1,130 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#include "gem_sim_ramp.h"
+#include "gem_math.h"
+#include "gem_ramp_table.h"
+#include <stdio.h>
+
+/* How many points to check between each pair of entries. */
+#define REPORT_STEPS 32
+
+/* Forward declarations */
+
+static fix16_t ideal_ramp_cv_(uint8_t osc, fix16_t pitch_cv);
+static uint16_t entry_ramp_cv_(const struct GemRampTableEntry* entry, uint8_t osc);
+static uint32_t lerp_lookup_(uint8_t osc, fix16_t pitch_cv);
+static uint32_t error_bp_(uint8_t osc, fix16_t pitch_cv, uint32_t ramp_cv);
+static void print_bp_(const char* label, uint32_t bp);
+
+/* Public functions */
+
+fix16_t gem_sim_ramp_amplitude(uint8_t osc, fix16_t pitch_cv, uint16_t ramp_cv) {
+    fix16_t ideal = ideal_ramp_cv_(osc, pitch_cv);
+    if (ideal <= 0) {
+        return F16(0);
+    }
+    return fix16_div(fix16_from_int(ramp_cv), ideal);
+}
+
+void gem_sim_ramp_report() {
+    printf("Ramp amplitude error, worst case for each segment and the average overall:\n");
+
+    for (uint8_t osc = 0; osc < 2; osc++) {
+        uint32_t cubic_total = 0;
+        uint32_t lerp_total = 0;
+        uint32_t count = 0;
+
+        for (size_t i = 0; i + 1 < gem_ramp_table_len; i++) {
+            const struct GemRampTableEntry* low = &gem_ramp_table[i];
+            const struct GemRampTableEntry* high = &gem_ramp_table[i + 1];
+            uint32_t cubic_max = 0;
+            uint32_t lerp_max = 0;
+
+            for (int32_t step = 1; step < REPORT_STEPS; step++) {
+                fix16_t pitch_cv = low->pitch_cv + (high->pitch_cv - low->pitch_cv) * step / REPORT_STEPS;
+                uint32_t cubic = error_bp_(osc, pitch_cv, gem_ramp_table_lookup(osc, pitch_cv));
+                uint32_t lerp = error_bp_(osc, pitch_cv, lerp_lookup_(osc, pitch_cv));
+
+                cubic_max = cubic > cubic_max ? cubic : cubic_max;
+                lerp_max = lerp > lerp_max ? lerp : lerp_max;
+                cubic_total += cubic;
+                lerp_total += lerp;
+                count++;
+            }
+
+            printf(
+                "  %s %u.%02u V - %u.%02u V:",
+                osc == 0 ? "Castor" : "Pollux",
+                (unsigned)(low->pitch_cv >> 16),
+                (unsigned)(((low->pitch_cv & 0xFFFF) * 100) >> 16),
+                (unsigned)(high->pitch_cv >> 16),
+                (unsigned)(((high->pitch_cv & 0xFFFF) * 100) >> 16));
+            print_bp_(" cubic", cubic_max);
+            print_bp_(", linear", lerp_max);
+            printf("\n");
+        }
+
+        printf("  %s overall:", osc == 0 ? "Castor" : "Pollux");
+        print_bp_(" cubic", count ? cubic_total / count : 0);
+        print_bp_(", linear", count ? lerp_total / count : 0);
+        printf("\n");
+    }
+}
+
+/* Private functions */
+
+/*
+    The ramp control voltage that gives full amplitude. It follows the
+    frequency, so it's interpolated geometrically between the calibrated
+    entries.
+*/
+static fix16_t ideal_ramp_cv_(uint8_t osc, fix16_t pitch_cv) {
+    size_t i = 0;
+    while (i + 2 < gem_ramp_table_len && gem_ramp_table[i + 1].pitch_cv <= pitch_cv) { i++; }
+
+    const struct GemRampTableEntry* low = &gem_ramp_table[i];
+    const struct GemRampTableEntry* high = &gem_ramp_table[i + 1];
+    fix16_t low_cv = fix16_from_int(entry_ramp_cv_(low, osc));
+    fix16_t high_cv = fix16_from_int(entry_ramp_cv_(high, osc));
+
+    if (low_cv <= 0 || high_cv <= 0 || high->pitch_cv <= low->pitch_cv) {
+        return low_cv;
+    }
+
+    fix16_t t = fix16_div(pitch_cv - low->pitch_cv, high->pitch_cv - low->pitch_cv);
+    fix16_t ratio = fix16_div(high_cv, low_cv);
+    return fix16_mul(low_cv, fix16_exp(fix16_mul(t, fix16_log(ratio))));
+}
+
+static uint16_t entry_ramp_cv_(const struct GemRampTableEntry* entry, uint8_t osc) {
+    return osc == 0 ? entry->castor_ramp_cv : entry->pollux_ramp_cv;
+}
+
+/* The ramp table lookup without the cubic interpolation, for comparison. */
+static uint32_t lerp_lookup_(uint8_t osc, fix16_t pitch_cv) {
+    size_t i = 0;
+    while (i + 1 < gem_ramp_table_len && gem_ramp_table[i + 1].pitch_cv <= pitch_cv) { i++; }
+
+    const struct GemRampTableEntry* low = &gem_ramp_table[i];
+    if (i + 1 == gem_ramp_table_len || pitch_cv <= low->pitch_cv) {
+        return entry_ramp_cv_(low, osc);
+    }
+
+    const struct GemRampTableEntry* high = &gem_ramp_table[i + 1];
+    uint16_t t = gem_f16_norm_dist_u16(low->pitch_cv, high->pitch_cv, pitch_cv);
+    return gem_u32_lerp_u16(entry_ramp_cv_(low, osc), entry_ramp_cv_(high, osc), t);
+}
+
+/* The amplitude's distance from full amplitude in basis points (0.01%). */
+static uint32_t error_bp_(uint8_t osc, fix16_t pitch_cv, uint32_t ramp_cv) {
+    fix16_t error = fix16_abs(gem_sim_ramp_amplitude(osc, pitch_cv, (uint16_t)(ramp_cv)) - F16(1));
+    return (uint32_t)(((int64_t)(error) * 10000 + 0x8000) >> 16);
+}
+
+static void print_bp_(const char* label, uint32_t bp) {
+    printf("%s %u.%02u%%", label, (unsigned)(bp / 100), (unsigned)(bp % 100));
+}
@@ -0,0 +1,34 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+/*
+    A simple model of the ramp cores' amplitude for the simulator.
+
+    Each ramp core charges a capacitor from its ramp control voltage over one
+    period of the oscillator, so the ramp's amplitude is proportional to the
+    control voltage divided by the frequency. Calibration finds the control
+    voltage that gives full amplitude at each ramp table entry. Since the
+    frequency is exponential in the pitch control voltage, the ideal control
+    voltage between two entries is too.
+
+    The model compares gem_ramp_table_lookup() against that ideal curve so
+    that changes to the interpolation can be checked against the current
+    ramp table without any hardware.
+*/
+
+#include "fix16.h"
+#include <stdint.h>
+
+/* The ramp amplitude, relative to full amplitude, for the given control voltages. */
+fix16_t gem_sim_ramp_amplitude(uint8_t osc, fix16_t pitch_cv, uint16_t ramp_cv);
+
+/*
+    Prints the amplitude error for each segment of the ramp table with
+    gem_ramp_table_lookup() and with plain linear interpolation.
+*/
+void gem_sim_ramp_report();
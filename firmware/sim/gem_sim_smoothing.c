@@ -0,0 +1,151 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#include "gem_sim_smoothing.h"
+#include "gem_config.h"
+#include "gem_pitch_smoothing.h"
+#include "gem_sim_hw.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+/* How long to let the filter settle before measuring, and how long to measure for. */
+#define WARMUP_FRAMES (GEM_PITCH_SMOOTHING_RATE / 2)
+#define MEASURE_FRAMES (GEM_PITCH_SMOOTHING_RATE * 2)
+#define STEADY_CODE 2048
+#define CENTS_PER_VOLT 1200
+
+struct Result {
+    uint32_t jitter_rms_millicents;
+    uint32_t jitter_peak_millicents;
+    uint32_t semitone_latency_frames;
+    uint32_t octave_latency_frames;
+};
+
+/* Forward declarations */
+
+static fix16_t code_to_volts_(uint16_t code);
+static fix16_t filter_(struct GemPitchSmoother* smoother, const struct GemPitchSmoothing* smoothing, fix16_t input);
+static struct Result measure_(const struct GemPitchSmoothing* smoothing);
+static uint32_t measure_latency_(const struct GemPitchSmoothing* smoothing, fix16_t from, fix16_t to);
+static void print_result_(const char* label, struct Result result);
+static void print_config_(fix16_t min_cutoff, fix16_t sensitivity, const char* suffix);
+
+/* Public functions */
+
+void gem_sim_smoothing_report(fix16_t min_cutoff, fix16_t sensitivity) {
+    static const fix16_t presets[][2] = {
+        {F16(1.0), F16(0.0)},
+        {F16(1.0), F16(10.0)},
+        {F16(10.0), F16(10.0)},
+        {F16(20.0), F16(10.0)},
+        {F16(20.0), F16(20.0)},
+        {F16(50.0), F16(10.0)},
+    };
+
+    printf("Pitch CV smoothing at %u frames per second:\n", GEM_PITCH_SMOOTHING_RATE);
+    printf("  %-36s %13s %14s %12s %12s\n", "", "jitter (rms)", "jitter (peak)", "semitone", "octave");
+
+    print_result_("off", measure_(NULL));
+
+    struct GemPitchSmoothing smoothing;
+    for (size_t i = 0; i < sizeof(presets) / sizeof(presets[0]); i++) {
+        GemPitchSmoothing_init(&smoothing, presets[i][0], presets[i][1]);
+        print_config_(presets[i][0], presets[i][1], "");
+        print_result_(NULL, measure_(&smoothing));
+    }
+
+    GemPitchSmoothing_init(&smoothing, min_cutoff, sensitivity);
+    print_config_(min_cutoff, sensitivity, " (settings)");
+    print_result_(NULL, measure_(&smoothing));
+}
+
+/* Private functions */
+
+static fix16_t code_to_volts_(uint16_t code) {
+    fix16_t range = fix16_sub(GEM_II_OSC_INPUT_CFG.pitch_cv_max, GEM_II_OSC_INPUT_CFG.pitch_cv_min);
+    return fix16_add(GEM_II_OSC_INPUT_CFG.pitch_cv_min, fix16_mul(range, fix16_from_int(code) / 4096));
+}
+
+static fix16_t filter_(struct GemPitchSmoother* smoother, const struct GemPitchSmoothing* smoothing, fix16_t input) {
+    return smoothing ? GemPitchSmoother_step(smoother, smoothing, input) : input;
+}
+
+static struct Result measure_(const struct GemPitchSmoothing* smoothing) {
+    struct Result result = {};
+    struct GemPitchSmoother smoother;
+    GemPitchSmoother_reset(&smoother);
+
+    gem_sim_adc_set(GEM_IN_CV_A, STEADY_CODE);
+    fix16_t target = code_to_volts_(STEADY_CODE);
+    for (size_t i = 0; i < WARMUP_FRAMES; i++) {
+        filter_(&smoother, smoothing, code_to_volts_(gem_sim_adc_read(GEM_IN_CV_A)));
+    }
+
+    int64_t sum_squares = 0;
+    fix16_t peak = 0;
+    for (size_t i = 0; i < MEASURE_FRAMES; i++) {
+        fix16_t output = filter_(&smoother, smoothing, code_to_volts_(gem_sim_adc_read(GEM_IN_CV_A)));
+        fix16_t error = fix16_abs(fix16_sub(output, target));
+        sum_squares += (int64_t)(error) * error;
+        peak = error > peak ? error : peak;
+    }
+
+    // Square root by bisection, so that this doesn't need the math library.
+    uint64_t mean_square = (uint64_t)(sum_squares) / MEASURE_FRAMES;
+    uint64_t rms = 0;
+    for (uint64_t bit = 1ull << 31; bit; bit >>= 1) {
+        if ((rms | bit) * (rms | bit) <= mean_square) {
+            rms |= bit;
+        }
+    }
+
+    result.jitter_rms_millicents = (uint32_t)((rms * CENTS_PER_VOLT * 1000) >> 16);
+    result.jitter_peak_millicents = (uint32_t)(((uint64_t)(peak) * CENTS_PER_VOLT * 1000) >> 16);
+    result.semitone_latency_frames = measure_latency_(smoothing, F16(2.0), F16(2.0 + 1.0 / 12.0));
+    result.octave_latency_frames = measure_latency_(smoothing, F16(2.0), F16(3.0));
+    return result;
+}
+
+static uint32_t measure_latency_(const struct GemPitchSmoothing* smoothing, fix16_t from, fix16_t to) {
+    struct GemPitchSmoother smoother;
+    GemPitchSmoother_reset(&smoother);
+
+    for (size_t i = 0; i < WARMUP_FRAMES; i++) { filter_(&smoother, smoothing, from); }
+
+    fix16_t cent = F16(1.0 / CENTS_PER_VOLT);
+    for (uint32_t frame = 0; frame < MEASURE_FRAMES; frame++) {
+        if (fix16_abs(fix16_sub(filter_(&smoother, smoothing, to), to)) <= cent) {
+            return frame;
+        }
+    }
+    return MEASURE_FRAMES;
+}
+
+static void print_result_(const char* label, struct Result result) {
+    if (label) {
+        printf("  %-36s", label);
+    }
+    printf(
+        " %7u.%03u ct %8u.%03u ct %8u.%u ms %8u.%u ms\n",
+        (unsigned)(result.jitter_rms_millicents / 1000),
+        (unsigned)(result.jitter_rms_millicents % 1000),
+        (unsigned)(result.jitter_peak_millicents / 1000),
+        (unsigned)(result.jitter_peak_millicents % 1000),
+        (unsigned)(result.semitone_latency_frames * 10000 / GEM_PITCH_SMOOTHING_RATE / 10),
+        (unsigned)(result.semitone_latency_frames * 10000 / GEM_PITCH_SMOOTHING_RATE % 10),
+        (unsigned)(result.octave_latency_frames * 10000 / GEM_PITCH_SMOOTHING_RATE / 10),
+        (unsigned)(result.octave_latency_frames * 10000 / GEM_PITCH_SMOOTHING_RATE % 10));
+}
+
+static void print_config_(fix16_t min_cutoff, fix16_t sensitivity, const char* suffix) {
+    char min_cutoff_str[13];
+    char sensitivity_str[13];
+    char label[64];
+    fix16_to_str(min_cutoff, min_cutoff_str, 2);
+    fix16_to_str(sensitivity, sensitivity_str, 2);
+    snprintf(label, sizeof(label), "%s Hz, %s Hz/(V/s)%s", min_cutoff_str, sensitivity_str, suffix);
+    printf("  %-36s", label);
+}
@@ -0,0 +1,26 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+/*
+    Measures the pitch CV smoothing's trade-off between latency and jitter,
+    see gem_pitch_smoothing.h.
+
+    The pitch CV is simulated at the ADC's frame rate. Jitter is measured
+    by holding a steady CV with the simulated ADC's noise, see
+    gem_sim_adc_read(). Latency is how long the output takes to get within a
+    cent of the new pitch after a clean step, either a semitone or an
+    octave.
+*/
+
+#include "fix16.h"
+
+/*
+    Prints the latency and jitter for a few different smoothing settings,
+    including the given ones, and without smoothing for comparison.
+*/
+void gem_sim_smoothing_report(fix16_t min_cutoff, fix16_t sensitivity);
@@ -0,0 +1,364 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+/*
+    Gemini simulator
+
+    Runs Gemini's SysEx command handlers on the host, with simulated ADC and
+    NVM behind them, and serves them over a local TCP socket. This lets the
+    factory tools in /factory talk to a virtual unit by setting the
+    GEMINI_SIM environment variable, for example:
+
+        $ cd sim && python3 configure.py && ninja
+        $ ./build/gemini-sim --port 7777
+        $ GEMINI_SIM=localhost:7777 python3 shell.py
+
+    Messages on the socket are plain SysEx: 0xF0, the message, and 0xF7.
+
+    Running it with --ramp-report prints how far the ramp amplitude is from
+    ideal across the ramp table, see gem_sim_ramp.h, and exits. Likewise
+    --smoothing-report prints the pitch CV smoothing's latency and jitter,
+    see gem_sim_smoothing.h, and --pitch-report prints how accurately every
+    pitch CV code is tracked, see gem_sim_pitch.h. --pitch-csv FILE and
+    --pitch-wav FILE also write the full curve and a rendered chromatic scale.
+*/
+
+#include "gem_boot_profile.h"
+#include "gem_config.h"
+#include "gem_mcp4728.h"
+#include "gem_ramp_table.h"
+#include "gem_settings_load_save.h"
+#include "gem_sim_hw.h"
+#include "gem_sim_nvm.h"
+#include "gem_sim_pitch.h"
+#include "gem_sim_ramp.h"
+#include "gem_sim_smoothing.h"
+#include "gem_sysex.h"
+#include "wntr_assert.h"
+#include "wntr_midi_core.h"
+#include "wntr_midi_sysex_dispatcher.h"
+#include "wntr_sysex_stream.h"
+#include <arpa/inet.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/* Same as the USB MIDI receive buffer in libwinter's wntr_midi_core.c */
+#define SYSEX_BUF_SIZE 128
+#define OUT_BUF_SIZE 512
+#define DEFAULT_PORT 7777
+#define DEFAULT_NVM_PATH "gemini-sim.nvm"
+
+/* State */
+
+static struct GemPulseOutConfig pulse_cfg_;
+static int client_fd_ = -1;
+static uint8_t sysex_data_[SYSEX_BUF_SIZE];
+static size_t sysex_data_len_ = 0;
+static uint8_t out_data_[OUT_BUF_SIZE];
+static size_t out_data_len_ = 0;
+
+/* Forward declarations */
+
+static int listen_(uint16_t port);
+static void serve_client_();
+static void settings_changed_callback_();
+static void monitor_task_();
+static bool write_packet_(const uint8_t packet[4]);
+
+int main(int argc, char** argv) {
+    uint16_t port = DEFAULT_PORT;
+    const char* nvm_path = DEFAULT_NVM_PATH;
+    bool ramp_report = false;
+    bool smoothing_report = false;
+    bool pitch_report = false;
+    const char* pitch_csv_path = NULL;
+    const char* pitch_wav_path = NULL;
+
+    static const struct option options[] = {
+        {"port", required_argument, NULL, 'p'},
+        {"nvm", required_argument, NULL, 'n'},
+        {"adc", required_argument, NULL, 'a'},
+        {"ramp-report", no_argument, NULL, 'r'},
+        {"smoothing-report", no_argument, NULL, 's'},
+        {"pitch-report", no_argument, NULL, 'c'},
+        {"pitch-csv", required_argument, NULL, 'C'},
+        {"pitch-wav", required_argument, NULL, 'w'},
+        {NULL, 0, NULL, 0},
+    };
+
+    // Output is usually piped into a log, so don't hold onto it.
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "p:n:a:rscC:w:", options, NULL)) != -1) {
+        unsigned int channel;
+        unsigned int code;
+        switch (opt) {
+            case 'p':
+                port = (uint16_t)(atoi(optarg));
+                break;
+            case 'n':
+                nvm_path = optarg;
+                break;
+            case 'a':
+                // --adc CHANNEL=CODE sets what a simulated ADC channel reads.
+                if (sscanf(optarg, "%u=%u", &channel, &code) != 2) {
+                    fprintf(stderr, "Invalid --adc value %s, expected CHANNEL=CODE\n", optarg);
+                    return 1;
+                }
+                gem_sim_adc_set((uint8_t)(channel), (uint16_t)(code));
+                break;
+            case 'r':
+                ramp_report = true;
+                break;
+            case 's':
+                smoothing_report = true;
+                break;
+            case 'c':
+                pitch_report = true;
+                break;
+            case 'C':
+                pitch_report = true;
+                pitch_csv_path = optarg;
+                break;
+            case 'w':
+                pitch_report = true;
+                pitch_wav_path = optarg;
+                break;
+            default:
+                fprintf(
+                    stderr,
+                    "Usage: %s [--port PORT] [--nvm FILE] [--adc CHANNEL=CODE]... [--ramp-report] "
+                    "[--smoothing-report] [--pitch-report] [--pitch-csv FILE] [--pitch-wav FILE]\n",
+                    argv[0]);
+                return 1;
+        }
+    }
+
+    // Same setup as the firmware's init_(), minus everything that isn't
+    // needed by the SysEx commands. The simulator always acts like a C&PII.
+    gem_boot_profile_mark(GEM_BOOT_PHASE_MAIN);
+    gem_sim_nvm_load(nvm_path);
+
+    gem_settings_cache_load();
+    GemSettings_print(&gem_settings_cache);
+    gem_boot_profile_mark(GEM_BOOT_PHASE_SETTINGS);
+    gem_ramp_table_load();
+    gem_boot_profile_mark(GEM_BOOT_PHASE_RAMP_TABLE);
+
+    if (ramp_report) {
+        gem_sim_ramp_report();
+        return 0;
+    }
+
+    if (smoothing_report) {
+        gem_sim_smoothing_report(
+            gem_settings_cache.pitch_smoothing_min_cutoff, gem_settings_cache.pitch_smoothing_sensitivity);
+        return 0;
+    }
+
+    if (pitch_report) {
+        gem_sim_pitch_report(&gem_settings_cache, pitch_csv_path, pitch_wav_path);
+        return 0;
+    }
+
+    pulse_cfg_ = GEM_II_PULSE_OUT_CFG;
+    gem_mcp_4728_init(&GEM_II_I2C_CFG);
+    gem_boot_profile_mark(GEM_BOOT_PHASE_DAC);
+    gem_sysex_init(5, GEM_II_ADC_INPUTS, &GEM_II_I2C_CFG, &pulse_cfg_);
+    gem_sysex_set_settings_callback(settings_changed_callback_);
+    gem_boot_profile_mark(GEM_BOOT_PHASE_SYSEX);
+
+    int server_fd = listen_(port);
+    if (server_fd < 0) {
+        return 1;
+    }
+
+    printf("Gemini simulator listening on localhost:%u\n", port);
+
+    while (1) {
+        client_fd_ = accept(server_fd, NULL, NULL);
+        if (client_fd_ < 0) {
+            perror("accept");
+            continue;
+        }
+
+        int nodelay = 1;
+        setsockopt(client_fd_, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+        printf("Client connected.\n");
+        serve_client_();
+        close(client_fd_);
+        client_fd_ = -1;
+        printf("Client disconnected.\n");
+    }
+
+    return 0;
+}
+
+/* Implementations of the libwinter MIDI functions used by the SysEx dispatcher. */
+
+size_t wntr_midi_sysex_len() { return sysex_data_len_; }
+
+const uint8_t* wntr_midi_sysex_data() { return sysex_data_; }
+
+bool wntr_midi_send_sysex(const uint8_t* data, size_t len) {
+    struct WntrSysExStream stream;
+    WntrSysExStream_start(&stream, write_packet_);
+    WntrSysExStream_write(&stream, data, len);
+    WntrSysExStream_end(&stream);
+    return true;
+}
+
+bool wntr_midi_send_sysex_teeth(const uint8_t* header, size_t header_len, const uint8_t* data, size_t len) {
+    struct WntrSysExStream stream;
+    WntrSysExStream_start(&stream, write_packet_);
+    WntrSysExStream_write(&stream, header, header_len);
+    WntrSysExStream_write_teeth(&stream, data, len);
+    WntrSysExStream_end(&stream);
+    return true;
+}
+
+/* Messages are written to the socket as they end, so there's nothing to flush. */
+void wntr_midi_flush() {}
+
+/* Private functions */
+
+static int listen_(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+
+    if (bind(fd, (struct sockaddr*)(&addr), sizeof(addr)) < 0 || listen(fd, 1) < 0) {
+        perror("bind");
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static void serve_client_() {
+    bool in_sysex = false;
+    bool overflow = false;
+
+    while (1) {
+        // Wake up periodically even without any input so that monitor
+        // updates keep flowing.
+        struct pollfd pfd = {.fd = client_fd_, .events = POLLIN};
+        int ready = poll(&pfd, 1, 10);
+        if (ready < 0) {
+            perror("poll");
+            return;
+        }
+
+        monitor_task_();
+
+        if (ready == 0) {
+            continue;
+        }
+
+        uint8_t buf[256];
+        ssize_t received = read(client_fd_, buf, sizeof(buf));
+        if (received <= 0) {
+            return;
+        }
+
+        for (ssize_t i = 0; i < received; i++) {
+            uint8_t byte = buf[i];
+
+            if (byte == 0xF0) {
+                in_sysex = true;
+                overflow = false;
+                sysex_data_len_ = 0;
+            } else if (byte == 0xF7 && in_sysex) {
+                in_sysex = false;
+                if (overflow) {
+                    printf("Dropped SysEx message larger than %u bytes.\n", SYSEX_BUF_SIZE);
+                    continue;
+                }
+                wntr_midi_dispatch_sysex();
+                gem_sim_nvm_save();
+            } else if (in_sysex) {
+                if (sysex_data_len_ < SYSEX_BUF_SIZE) {
+                    sysex_data_[sysex_data_len_++] = byte;
+                } else {
+                    overflow = true;
+                }
+            }
+        }
+    }
+}
+
+static void settings_changed_callback_() {
+    printf("Settings applied:\n");
+    GemSettings_print(&gem_settings_cache);
+}
+
+static void monitor_task_() {
+    if (!gem_sysex_monitor_enabled()) {
+        return;
+    }
+
+    // The simulator doesn't run the oscillators, so only the inputs are
+    // filled in.
+    struct GemMonitorUpdate update = {
+        .lfo_knob = gem_sim_adc_read(GEM_IN_CHORUS_POT),
+        .castor_pitch_knob = gem_sim_adc_read(GEM_IN_CV_A_POT),
+        .castor_pitch_cv = gem_sim_adc_read(GEM_IN_CV_A),
+        .castor_pulse_knob = gem_sim_adc_read(GEM_IN_DUTY_A_POT),
+        .castor_pulse_cv = gem_sim_adc_read(GEM_IN_DUTY_A),
+        .pollux_pitch_knob = gem_sim_adc_read(GEM_IN_CV_B_POT),
+        .pollux_pitch_cv = gem_sim_adc_read(GEM_IN_CV_B),
+        .pollux_pulse_knob = gem_sim_adc_read(GEM_IN_DUTY_B_POT),
+        .pollux_pulse_cv = gem_sim_adc_read(GEM_IN_DUTY_B),
+    };
+
+    gem_sysex_send_monitor_update(&update);
+}
+
+/*
+    Collects the USB-MIDI packets for an outgoing message, the same ones that
+    the firmware sends over USB, and writes out the message's bytes once it's
+    complete. The whole message is sent in one write, otherwise small
+    messages end up waiting on TCP acknowledgements.
+*/
+static bool write_packet_(const uint8_t packet[4]) {
+    uint8_t code_index = packet[0] & 0xF;
+    size_t count = code_index == MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE ? 3 : code_index - 4;
+
+    WNTR_ASSERT(out_data_len_ + count <= OUT_BUF_SIZE);
+    memcpy(out_data_ + out_data_len_, packet + 1, count);
+    out_data_len_ += count;
+
+    if (code_index == MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE) {
+        return true;
+    }
+
+    if (client_fd_ >= 0 && write(client_fd_, out_data_, out_data_len_) != (ssize_t)(out_data_len_)) {
+        perror("write");
+    }
+    out_data_len_ = 0;
+    return true;
+}
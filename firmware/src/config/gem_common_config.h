@@ -38,6 +38,13 @@ static const struct GemADCConfig GEM_ADC_CFG = {
 
 #define GEM_ANIMATION_INTERVAL 48
 
+/* MIDI constants. */
+
+// The most USB-MIDI packets that the MIDI task handles per main loop
+// iteration. It also stops early once a new set of ADC readings is ready so
+// that the oscillator task always runs on time.
+#define GEM_MIDI_PACKET_BUDGET 32
+
 /* Hard sync button configuration. */
 
 static const struct WntrGPIOPin button_pin_ = WNTR_GPIO_PIN(B, 8);
@@ -49,3 +56,19 @@ static const struct WntrGPIOPin button_pin_ = WNTR_GPIO_PIN(B, 8);
 #define GEM_PULSE_WIDTH_MAX (3100)
 #define GEM_PULSE_WIDTH_MOD_MAX (1920)
 #define GEM_FM_DEADZONE F16(0.06)
+// A fifth of a semitone, see GemQuantizer_quantize_hysteresis().
+#define GEM_QUANTIZER_HYSTERESIS F16(0.2 / 12.0)
+
+/* Pitch CV smoothing constants, see gem_pitch_smoothing.h */
+
+// How often the pitch CV is filtered, once per set of ADC readings. See
+// GEM_ADC_CFG above.
+#define GEM_PITCH_SMOOTHING_RATE 5000
+// The cutoff for smoothing the pitch CV's rate of change, "d_cutoff" in the
+// 1 euro filter paper.
+#define GEM_PITCH_SMOOTHING_RATE_CUTOFF F16(10.0)
+
+/* Audio-rate FM constants, see gem_fm_table.h */
+
+#define GEM_AUDIO_FM_MAX_DEPTH F16(1.0)
+#define GEM_AUDIO_FM_TABLE_LEN 16
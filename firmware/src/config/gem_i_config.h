@@ -56,6 +56,7 @@ static const struct GemPulseOutConfig GEM_I_PULSE_OUT_CFG = {
 static const struct GemI2CConfig GEM_I_I2C_CFG = {
     .gclk = GCLK_CLKCTRL_GEN_GCLK1,
     .gclk_freq = 8000000,
+    .speed = GEM_I2C_SPEED_FAST,
     .baudrate = 400000,
     .rise_time = 30,
     .wait_timeout = 10000,
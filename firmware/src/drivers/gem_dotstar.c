@@ -14,6 +14,8 @@ static const uint8_t start_frame_[4] = {0x00, 0x00, 0x00, 0x00};
 
 void gem_dotstar_init(uint8_t brightness) { brightness_ = brightness; }
 
+void gem_dotstar_set_brightness(uint8_t brightness) { brightness_ = brightness; }
+
 void gem_dotstar_set(size_t n, uint8_t r, uint8_t g, uint8_t b) {
     pixels_[n * 3] = (r * brightness_) >> 8;
     pixels_[n * 3 + 1] = (g * brightness_) >> 8;
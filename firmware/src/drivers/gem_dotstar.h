@@ -18,6 +18,8 @@ struct GemDotstarCfg {
 };
 
 void gem_dotstar_init(uint8_t brightness);
+/* Changes the brightness used for subsequent calls to gem_dotstar_set. */
+void gem_dotstar_set_brightness(uint8_t brightness);
 void gem_dotstar_set(size_t n, uint8_t r, uint8_t g, uint8_t b);
 /* Same as gem_dotstar_set, but take a whole 24-bit integer as the color value. */
 void gem_dotstar_set32(size_t n, uint32_t color);
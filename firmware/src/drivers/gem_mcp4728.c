@@ -6,9 +6,17 @@
 
 #include "gem_mcp4728.h"
 #include "gem_i2c.h"
-#include "printf.h"
+#include "gem_log.h"
+#include <stdbool.h>
 
 #define SINGLE_WRITE_CMD 0b01011000
+#define MULTI_WRITE_CMD 0b01000000
+
+/*
+    If this many channels or fewer changed then they're sent using a multi-write
+    (3 bytes per channel) instead of a fast write (8 bytes for all channels).
+*/
+#define PARTIAL_WRITE_MAX_CHANNELS 2
 
 static const uint8_t i2c_addresses_[] = {
     // MCP4728A0 used for rounds 1 & 2.
@@ -19,32 +27,54 @@ static const uint8_t i2c_addresses_[] = {
 
 static uint8_t address_ = 0;
 
+/* The last values successfully written by gem_mcp_4728_write_channels(). */
+static struct GemMCP4278Channel last_channels_[4];
+static bool last_channels_valid_ = false;
+static struct GemMCP4728Stats stats_ = {};
+
+/* Forward declarations */
+
+static RAMFUNC bool channels_equal_(struct GemMCP4278Channel a, struct GemMCP4278Channel b);
+static RAMFUNC enum GemI2CResult
+write_changed_channels_(const struct GemI2CConfig* i2c, const struct GemMCP4278Channel* channels, uint8_t changed);
+static RAMFUNC enum GemI2CResult
+fast_write_channels_(const struct GemI2CConfig* i2c, const struct GemMCP4278Channel* channels);
+
+/* Public functions */
+
 void gem_mcp_4728_init(const struct GemI2CConfig* i2c) {
+    // Probing the DAC writes to channel 0, so the cached values can't be
+    // trusted until the next full write.
+    last_channels_valid_ = false;
+
+    // Probe using a multi-write since it doesn't program the channel's
+    // EEPROM. The single write command does, which keeps the DAC busy for
+    // ~50ms right when the oscillators are starting up.
+    uint8_t probe[3] = {MULTI_WRITE_CMD, 0, 0};
+
     for (size_t i = 0; i < sizeof(i2c_addresses_) / sizeof(i2c_addresses_[0]); i++) {
         address_ = i2c_addresses_[i];
-        enum GemI2CResult result = gem_mcp_4728_write_channel(
-            i2c,
-            0,
-            (struct GemMCP4278Channel){
-                .value = 0,
-            });
+        enum GemI2CResult result = gem_i2c_write(i2c, address_, probe, sizeof(probe));
 
         if (result == GEM_I2C_RESULT_SUCCESS) {
-            printf("MCP4728 found at 0x%02x.\n", address_);
+            GEM_LOG("MCP4728 found at 0x%02x.\n", address_);
             return;
         }
     }
-    printf("Could not find MCP4728!\n");
+    GEM_LOG("Could not find MCP4728!\n");
 }
 
 enum GemI2CResult
 gem_mcp_4728_write_channel(const struct GemI2CConfig* i2c, uint8_t channel_no, struct GemMCP4278Channel settings) {
     uint8_t data[3] = {
         SINGLE_WRITE_CMD | ((channel_no & 0x3) << 1),
-        (settings.vref << 7) | (settings.pd << 6) | (settings.gain << 4) | ((settings.value >> 8) & 0xF),
+        (settings.vref << 7) | (settings.pd << 5) | (settings.gain << 4) | ((settings.value >> 8) & 0xF),
         (settings.value & 0xFF),
     };
 
+    // This also writes the channel's EEPROM, so don't trust the cache.
+    last_channels_valid_ = false;
+
     return gem_i2c_write(i2c, address_, data, 3);
 }
 
@@ -54,16 +84,83 @@ enum GemI2CResult gem_mcp_4728_write_channels(
     struct GemMCP4278Channel ch_b_settings,
     struct GemMCP4278Channel ch_c_settings,
     struct GemMCP4278Channel ch_d_settings) {
-    uint8_t data[9] = {
-        (ch_a_settings.pd << 4) | ((ch_a_settings.value >> 8) & 0xF),
-        (ch_a_settings.value & 0xFF),
-        (ch_b_settings.pd << 4) | ((ch_b_settings.value >> 8) & 0xF),
-        (ch_b_settings.value & 0xFF),
-        (ch_c_settings.pd << 4) | ((ch_c_settings.value >> 8) & 0xF),
-        (ch_c_settings.value & 0xFF),
-        (ch_d_settings.pd << 4) | ((ch_d_settings.value >> 8) & 0xF),
-        (ch_d_settings.value & 0xFF),
-    };
+    const struct GemMCP4278Channel channels[4] = {ch_a_settings, ch_b_settings, ch_c_settings, ch_d_settings};
+
+    // Most of the time the outputs don't change from one frame to the next,
+    // so skip the I2C transaction entirely or only send the channels that
+    // changed to keep the bus as quiet as possible.
+    uint8_t changed = 0;
+    uint8_t changed_count = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        if (!last_channels_valid_ || !channels_equal_(channels[i], last_channels_[i])) {
+            changed |= 1 << i;
+            changed_count++;
+        }
+    }
+
+    if (changed_count == 0) {
+        stats_.skipped_writes++;
+        return GEM_I2C_RESULT_SUCCESS;
+    }
+
+    enum GemI2CResult result;
+    if (changed_count <= PARTIAL_WRITE_MAX_CHANNELS) {
+        result = write_changed_channels_(i2c, channels, changed);
+        stats_.partial_writes++;
+    } else {
+        result = fast_write_channels_(i2c, channels);
+        stats_.full_writes++;
+    }
+
+    // Only update the cache once the DAC has acknowledged the new values,
+    // otherwise the next write would wrongly be skipped.
+    if (result == GEM_I2C_RESULT_SUCCESS) {
+        for (uint8_t i = 0; i < 4; i++) { last_channels_[i] = channels[i]; }
+        last_channels_valid_ = true;
+    } else {
+        last_channels_valid_ = false;
+    }
+
+    return result;
+}
+
+const struct GemMCP4728Stats* gem_mcp_4728_stats() { return &stats_; }
+
+/* Private functions */
+
+static bool channels_equal_(struct GemMCP4278Channel a, struct GemMCP4278Channel b) {
+    return a.value == b.value && a.pd == b.pd && a.vref == b.vref && a.gain == b.gain;
+}
+
+static enum GemI2CResult
+write_changed_channels_(const struct GemI2CConfig* i2c, const struct GemMCP4278Channel* channels, uint8_t changed) {
+    // The multi-write command only updates the DAC input registers, unlike
+    // the single write command which also programs the channel's EEPROM.
+    // That's slow (~50ms) and wears out the EEPROM, so it's no good for
+    // updating the outputs every frame.
+    uint8_t data[3 * PARTIAL_WRITE_MAX_CHANNELS];
+    size_t len = 0;
+
+    for (uint8_t i = 0; i < 4; i++) {
+        if (!(changed & (1 << i))) {
+            continue;
+        }
+        struct GemMCP4278Channel ch = channels[i];
+        data[len++] = MULTI_WRITE_CMD | (i << 1);
+        data[len++] = (ch.vref << 7) | (ch.pd << 5) | (ch.gain << 4) | ((ch.value >> 8) & 0xF);
+        data[len++] = ch.value & 0xFF;
+    }
+
+    return gem_i2c_write(i2c, address_, data, len);
+}
+
+static enum GemI2CResult fast_write_channels_(const struct GemI2CConfig* i2c, const struct GemMCP4278Channel* channels) {
+    uint8_t data[8];
+
+    for (uint8_t i = 0; i < 4; i++) {
+        data[i * 2] = (channels[i].pd << 4) | ((channels[i].value >> 8) & 0xF);
+        data[i * 2 + 1] = channels[i].value & 0xFF;
+    }
 
-    return gem_i2c_write(i2c, address_, data, 9);
+    return gem_i2c_write(i2c, address_, data, 8);
 }
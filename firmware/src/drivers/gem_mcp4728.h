@@ -33,6 +33,20 @@ struct GemMCP4278Channel {
     uint16_t value : 12;
 };
 
+/*
+    Counters for how gem_mcp_4728_write_channels() updated the DAC. Most of the
+    time the outputs don't change between frames, so most writes should end up
+    skipped.
+*/
+struct GemMCP4728Stats {
+    /* Writes where no channel changed, so no I2C transaction was needed. */
+    uint32_t skipped_writes;
+    /* Writes where only some channels changed and were written individually. */
+    uint32_t partial_writes;
+    /* Writes where every channel was updated using a fast write. */
+    uint32_t full_writes;
+};
+
 void gem_mcp_4728_init(const struct GemI2CConfig* i2c);
 
 RAMFUNC enum GemI2CResult
@@ -43,3 +57,5 @@ RAMFUNC enum GemI2CResult gem_mcp_4728_write_channels(
     struct GemMCP4278Channel ch_b_settings,
     struct GemMCP4278Channel ch_c_settings,
     struct GemMCP4278Channel ch_d_settings);
+
+const struct GemMCP4728Stats* gem_mcp_4728_stats();
@@ -9,6 +9,7 @@
 #include "gem_adc.h"
 #include "gem_config.h"
 #include "gem_dotstar.h"
+#include "gem_fm_table.h"
 #include "gem_i2c.h"
 #include "gem_led_animation.h"
 #include "gem_mcp4728.h"
@@ -0,0 +1,64 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#include "gem_fm_table.h"
+#include "wntr_assert.h"
+
+/* Public functions */
+
+void GemFMTable_init(struct GemFMTable* table, wntr_periodic_waveform_function modulator, size_t len) {
+    WNTR_ASSERT(len > 0 && len <= GEM_FM_TABLE_MAX_LEN);
+
+    table->len = len;
+    table->min_period = 0;
+    table->_carrier_period = 0;
+    table->_depth = F16(0);
+
+    fix16_t phase_step = fix16_div(F16(1), fix16_from_int(len));
+    for (size_t i = 0; i < len; i++) {
+        table->waveform[i] = modulator(fix16_mul(fix16_from_int(i), phase_step));
+        table->periods[i] = 0;
+    }
+}
+
+bool GemFMTable_generate(struct GemFMTable* table, uint32_t carrier_period, fix16_t depth) {
+    if (carrier_period == table->_carrier_period && depth == table->_depth) {
+        return false;
+    }
+
+    table->_carrier_period = carrier_period;
+    table->_depth = depth;
+
+    // A higher pitch is a shorter period, so the exponent is negated:
+    //
+    //   period = carrier_period * e^(-ln(2) * depth * waveform)
+    //
+    fix16_t exponent_scale = fix16_mul(F16(-0.6931471765), depth);
+    uint32_t min_period = GEM_FM_TABLE_MAX_PERIOD;
+
+    for (size_t i = 0; i < table->len; i++) {
+        fix16_t ratio = fix16_exp(fix16_mul(exponent_scale, table->waveform[i]));
+        uint64_t period = ((uint64_t)(carrier_period) * (uint64_t)(ratio)) >> 16;
+
+        if (period > GEM_FM_TABLE_MAX_PERIOD) {
+            period = GEM_FM_TABLE_MAX_PERIOD;
+        }
+        if (period < 1) {
+            period = 1;
+        }
+        if (period < min_period) {
+            min_period = period;
+        }
+
+        // Each entry is a single aligned word, so updating the table while the
+        // DMA controller is streaming it never produces a torn value.
+        table->periods[i] = (uint32_t)(period);
+    }
+
+    table->min_period = min_period;
+
+    return true;
+}
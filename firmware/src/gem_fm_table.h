@@ -0,0 +1,64 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+/*
+    Routines for generating audio-rate frequency modulation tables.
+
+    In audio FM mode the CPU doesn't update Pollux's period every frame.
+    Instead, a short table of TCC period values covering one modulation
+    cycle is generated and the DMA controller streams it into Pollux's timer
+    each time Castor's timer overflows. See gem_pulseout_start_period_stream().
+*/
+
+#include "fix16.h"
+#include "wntr_periodic_waveform.h"
+#include "wntr_ramfunc.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define GEM_FM_TABLE_MAX_LEN 32
+
+/* TCC0 & TCC1 have 24-bit counters. */
+#define GEM_FM_TABLE_MAX_PERIOD 0xFFFFFF
+
+struct GemFMTable {
+    /* Period values streamed into the timer. This must stay word-aligned
+       since the DMA controller transfers it a word at a time. */
+    uint32_t periods[GEM_FM_TABLE_MAX_LEN];
+    size_t len;
+    /* The modulator's waveform (-1.0 -> 1.0) sampled once at init so that
+       generating the table doesn't need to evaluate it. */
+    fix16_t waveform[GEM_FM_TABLE_MAX_LEN];
+    /* The smallest period in the table, used to place the compare value
+       so that every period produces an output pulse. */
+    uint32_t min_period;
+
+    /* Inputs used for the last generated table */
+    uint32_t _carrier_period;
+    fix16_t _depth;
+};
+
+/*
+    Sample the modulator waveform into the table. `len` is the number of
+    timer overflows per modulation cycle. For example, a length of 2 with
+    `wntr_square` alternates Pollux's period on each of Castor's cycles,
+    while longer lengths with `wntr_sine` give a smoother modulator at
+    Castor's frequency divided by `len`.
+*/
+void GemFMTable_init(struct GemFMTable* table, wntr_periodic_waveform_function modulator, size_t len);
+
+/*
+    Regenerate the period table for the given carrier period and modulation
+    depth (in volts/octaves). Returns false without touching the table if
+    neither input changed since the last call.
+
+    Since the periods are related to pitch exponentially, each entry is
+    calculated as `carrier_period * 2^(-depth * waveform)`.
+*/
+bool GemFMTable_generate(struct GemFMTable* table, uint32_t carrier_period, fix16_t depth) RAMFUNC;
@@ -0,0 +1,182 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#include "gem_fw_update.h"
+#include "gem_crc32.h"
+#include "wntr_assert.h"
+#include "wntr_pack.h"
+#include <string.h>
+
+/* The SAM D21G18A's SRAM, see scripts/samd21g18a.ld. */
+#define SRAM_START 0x20000000
+#define SRAM_END (SRAM_START + 0x8000)
+
+/* Forward declarations */
+
+static void program_page_(struct GemFwUpdate* update, uint32_t page_offset);
+static uint32_t read_u32_le_(uint32_t addr);
+
+/* Public functions */
+
+void GemFwUpdate_init(struct GemFwUpdate* update, uint32_t staging_base, size_t staging_len, uint32_t app_base) {
+    WNTR_ASSERT(staging_base % WNTR_NVM_ROW_SIZE == 0);
+    WNTR_ASSERT(staging_len % WNTR_NVM_ROW_SIZE == 0);
+
+    update->staging_base = staging_base;
+    update->staging_len = staging_len;
+    update->app_base = app_base;
+    update->state = GEM_FW_UPDATE_IDLE;
+    update->image_len = 0;
+    update->image_crc = 0;
+    update->received = 0;
+    update->last_chunk_offset = 0;
+    update->last_chunk_crc = 0;
+}
+
+enum GemFwUpdateResult GemFwUpdate_begin(struct GemFwUpdate* update, const uint8_t* buf, size_t len) {
+    update->state = GEM_FW_UPDATE_IDLE;
+
+    if (len != GEM_FW_UPDATE_BEGIN_SIZE) {
+        return GEM_FW_UPDATE_ERR_LENGTH;
+    }
+
+    uint32_t image_len = (uint32_t)(WNTR_UNPACK_32(buf, 0));
+    uint32_t image_crc = (uint32_t)(WNTR_UNPACK_32(buf, 4));
+
+    // The image has to at least hold the initial stack pointer and reset vector.
+    if (image_len < 8 || image_len > update->staging_len) {
+        return GEM_FW_UPDATE_ERR_RANGE;
+    }
+
+    update->state = GEM_FW_UPDATE_RECEIVING;
+    update->image_len = image_len;
+    update->image_crc = image_crc;
+    update->received = 0;
+    update->last_chunk_offset = 0;
+    update->last_chunk_crc = 0;
+    memset(update->page, 0xFF, WNTR_NVM_PAGE_SIZE);
+
+    return GEM_FW_UPDATE_OK;
+}
+
+enum GemFwUpdateResult GemFwUpdate_write_chunk(struct GemFwUpdate* update, const uint8_t* buf, size_t len) {
+    if (update->state != GEM_FW_UPDATE_RECEIVING) {
+        return GEM_FW_UPDATE_ERR_STATE;
+    }
+
+    if (len <= GEM_FW_UPDATE_CHUNK_SIZE(0) || len > GEM_FW_UPDATE_CHUNK_MAX_SIZE) {
+        return GEM_FW_UPDATE_ERR_LENGTH;
+    }
+
+    size_t crc_offset = len - 4;
+    uint32_t expected_crc = (uint32_t)(WNTR_UNPACK_32(buf, crc_offset));
+    if (gem_crc32(0, buf, crc_offset) != expected_crc) {
+        return GEM_FW_UPDATE_ERR_CRC;
+    }
+
+    uint32_t offset = (uint32_t)(WNTR_UNPACK_32(buf, 0));
+    const uint8_t* data = buf + 4;
+    size_t data_len = crc_offset - 4;
+
+    // The host re-sends a chunk if it doesn't get a response, so the chunk
+    // that was just accepted might show up again.
+    if (update->received > 0 && offset == update->last_chunk_offset && expected_crc == update->last_chunk_crc) {
+        return GEM_FW_UPDATE_OK;
+    }
+
+    if (offset != update->received) {
+        return GEM_FW_UPDATE_ERR_OFFSET;
+    }
+
+    if (data_len > update->image_len - update->received) {
+        return GEM_FW_UPDATE_ERR_RANGE;
+    }
+
+    for (size_t i = 0; i < data_len; i++) {
+        update->page[update->received % WNTR_NVM_PAGE_SIZE] = data[i];
+        update->received++;
+        if (update->received % WNTR_NVM_PAGE_SIZE == 0) {
+            program_page_(update, update->received - WNTR_NVM_PAGE_SIZE);
+        }
+    }
+
+    update->last_chunk_offset = offset;
+    update->last_chunk_crc = expected_crc;
+
+    return GEM_FW_UPDATE_OK;
+}
+
+enum GemFwUpdateResult GemFwUpdate_finish(struct GemFwUpdate* update) {
+    if (update->state == GEM_FW_UPDATE_VERIFIED) {
+        return GEM_FW_UPDATE_OK;
+    }
+    if (update->state != GEM_FW_UPDATE_RECEIVING) {
+        return GEM_FW_UPDATE_ERR_STATE;
+    }
+    if (update->received != update->image_len) {
+        return GEM_FW_UPDATE_ERR_LENGTH;
+    }
+
+    // The rest of the last page is already 0xFF, which leaves those bytes
+    // unprogrammed.
+    if (update->received % WNTR_NVM_PAGE_SIZE != 0) {
+        program_page_(update, update->received - update->received % WNTR_NVM_PAGE_SIZE);
+    }
+
+    // Check what's actually in flash rather than what was received, which
+    // also catches pages that didn't program correctly.
+    uint8_t block[WNTR_NVM_PAGE_SIZE];
+    uint32_t crc = 0;
+    for (uint32_t offset = 0; offset < update->image_len; offset += WNTR_NVM_PAGE_SIZE) {
+        size_t count = update->image_len - offset;
+        if (count > WNTR_NVM_PAGE_SIZE) {
+            count = WNTR_NVM_PAGE_SIZE;
+        }
+        wntr_nvm_read(update->staging_base + offset, block, count);
+        crc = gem_crc32(crc, block, count);
+    }
+
+    if (crc != update->image_crc) {
+        update->state = GEM_FW_UPDATE_IDLE;
+        return GEM_FW_UPDATE_ERR_IMAGE_CRC;
+    }
+
+    // A matching CRC doesn't mean the image was built for this device, so
+    // make sure it'll at least start: the initial stack pointer has to be in
+    // SRAM and the reset handler has to be a Thumb address inside the image.
+    uint32_t initial_sp = read_u32_le_(update->staging_base);
+    uint32_t reset_handler = read_u32_le_(update->staging_base + 4);
+
+    if (initial_sp <= SRAM_START || initial_sp > SRAM_END || !(reset_handler & 1) ||
+        reset_handler < update->app_base || reset_handler >= update->app_base + update->image_len) {
+        update->state = GEM_FW_UPDATE_IDLE;
+        return GEM_FW_UPDATE_ERR_VECTOR_TABLE;
+    }
+
+    update->state = GEM_FW_UPDATE_VERIFIED;
+    return GEM_FW_UPDATE_OK;
+}
+
+/* Private functions */
+
+static void program_page_(struct GemFwUpdate* update, uint32_t page_offset) {
+    uint32_t addr = update->staging_base + page_offset;
+
+    // Chunks arrive in order, so each row is erased just before its first
+    // page is programmed.
+    if (addr % WNTR_NVM_ROW_SIZE == 0) {
+        wntr_nvm_erase_row(addr);
+    }
+
+    wntr_nvm_write_page(addr, update->page, WNTR_NVM_PAGE_SIZE);
+    memset(update->page, 0xFF, WNTR_NVM_PAGE_SIZE);
+}
+
+static uint32_t read_u32_le_(uint32_t addr) {
+    uint8_t buf[4];
+    wntr_nvm_read(addr, buf, 4);
+    return (uint32_t)(buf[0]) | (uint32_t)(buf[1]) << 8 | (uint32_t)(buf[2]) << 16 | (uint32_t)(buf[3]) << 24;
+}
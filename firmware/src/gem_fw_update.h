@@ -0,0 +1,97 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+/*
+    Receives a new firmware image over SysEx and writes it into a staging
+    region of flash while the current firmware keeps running.
+
+    An update is a sequence of:
+
+    1.  Begin, which gives the image's length and CRC32:
+
+            SIZE(4) CRC32(4)
+
+    2.  Chunks, in order, each holding up to a page of the image:
+
+            OFFSET(4) DATA(n) CRC32(4)
+
+        The CRC covers the offset and data. A chunk is only accepted if it's
+        entirely valid and starts where the previous one ended, so a
+        corrupted chunk can just be sent again. Re-sending the chunk that was
+        just accepted (for example, if its response was lost) is harmless.
+
+    3.  Finish, which writes out the last partial page, checks the CRC of
+        the whole image as it was read back from flash, and checks that the
+        image's vector table points into the application region.
+
+    Only once an image is verified can it be copied over the application
+    with gem_fw_swap_and_reset(). All values are big-endian.
+*/
+
+#include "wntr_nvm.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* One page per chunk keeps a teeth-encoded chunk within the SysEx receive buffer. */
+#define GEM_FW_UPDATE_CHUNK_MAX_DATA WNTR_NVM_PAGE_SIZE
+#define GEM_FW_UPDATE_CHUNK_SIZE(data_len) (4 + (data_len) + 4)
+#define GEM_FW_UPDATE_CHUNK_MAX_SIZE GEM_FW_UPDATE_CHUNK_SIZE(GEM_FW_UPDATE_CHUNK_MAX_DATA)
+#define GEM_FW_UPDATE_BEGIN_SIZE 8
+
+enum GemFwUpdateResult {
+    GEM_FW_UPDATE_OK = 0,
+    GEM_FW_UPDATE_ERR_LENGTH = 1,
+    GEM_FW_UPDATE_ERR_CRC = 2,
+    GEM_FW_UPDATE_ERR_RANGE = 3,
+    GEM_FW_UPDATE_ERR_OFFSET = 4,
+    GEM_FW_UPDATE_ERR_STATE = 5,
+    GEM_FW_UPDATE_ERR_IMAGE_CRC = 6,
+    GEM_FW_UPDATE_ERR_VECTOR_TABLE = 7,
+};
+
+enum GemFwUpdateState {
+    GEM_FW_UPDATE_IDLE = 0,
+    GEM_FW_UPDATE_RECEIVING = 1,
+    GEM_FW_UPDATE_VERIFIED = 2,
+};
+
+struct GemFwUpdate {
+    /* Row-aligned address and length of the staging region. */
+    uint32_t staging_base;
+    size_t staging_len;
+    /* Where the image will run from, used to check its vector table. */
+    uint32_t app_base;
+
+    /* State */
+    enum GemFwUpdateState state;
+    uint32_t image_len;
+    uint32_t image_crc;
+    uint32_t received;
+    /* Offset and CRC of the last accepted chunk, to recognize re-sends. */
+    uint32_t last_chunk_offset;
+    uint32_t last_chunk_crc;
+    /* Chunks are collected here until there's a whole page to program. */
+    uint8_t page[WNTR_NVM_PAGE_SIZE];
+};
+
+void GemFwUpdate_init(struct GemFwUpdate* update, uint32_t staging_base, size_t staging_len, uint32_t app_base);
+
+/* Starts a new update, abandoning any that's in progress. */
+enum GemFwUpdateResult GemFwUpdate_begin(struct GemFwUpdate* update, const uint8_t* buf, size_t len);
+
+/* Checks the chunk in `buf` and, if it's valid, programs it into the staging region. */
+enum GemFwUpdateResult GemFwUpdate_write_chunk(struct GemFwUpdate* update, const uint8_t* buf, size_t len);
+
+/* Flushes the last page and verifies the staged image. */
+enum GemFwUpdateResult GemFwUpdate_finish(struct GemFwUpdate* update);
+
+/* Returns true if the staged image has been verified and can be applied. */
+inline static bool GemFwUpdate_ready(const struct GemFwUpdate* update) {
+    return update->state == GEM_FW_UPDATE_VERIFIED;
+}
@@ -8,7 +8,7 @@
 #include "fix16.h"
 #include "gem_config.h"
 #include "gem_dotstar.h"
-#include "wntr_colorspace.h"
+#include "gem_led_animation_tables.h"
 #include "wntr_random.h"
 #include "wntr_ticks.h"
 #include "wntr_waveforms.h"
@@ -40,9 +40,22 @@ static uint32_t hue_accum_;
 static uint8_t sparkles_[GEM_MAX_DOTSTAR_COUNT];
 static bool transitioning_ = false;
 
+/* Per-LED values that only change when the configuration or LED count does,
+   see update_led_count_(). */
+static size_t led_count_ = 0;
+static fix16_t phase_offsets_[GEM_MAX_DOTSTAR_COUNT];
+static uint16_t hue_offsets_[GEM_MAX_DOTSTAR_COUNT];
+static fix16_t transition_scale_;
+
 /* Forward declarations. */
 
 static fix16_t noise(fix16_t) RAMFUNC;
+static fix16_t sine_normalized_(fix16_t phase) RAMFUNC;
+static const uint8_t* hue_to_rgb_(uint16_t hue) RAMFUNC;
+static uint32_t apply_sat_val_(const uint8_t* rgb, uint8_t sat, uint8_t val) RAMFUNC;
+static uint32_t hsv_to_rgb_(uint16_t hue, uint8_t sat, uint8_t val) RAMFUNC;
+static uint32_t hue_base_() RAMFUNC;
+static void update_led_count_(size_t count);
 static void animation_step_transition_(const struct GemDotstarCfg* dotstar, uint32_t delta) RAMFUNC;
 static void animation_step_sparkles_(const struct GemDotstarCfg* dotstar, uint32_t delta) RAMFUNC;
 static void animation_step_normal_(const struct GemDotstarCfg* dotstar, uint32_t delta) RAMFUNC;
@@ -54,6 +67,9 @@ static void animation_step_tweak_(const struct GemDotstarCfg* dotstar, uint32_t
 void gem_led_animation_init(const struct GemLEDCfg cfg) {
     cfg_ = cfg;
     last_update_ = wntr_ticks();
+
+    for (size_t i = 0; i < GEM_MAX_DOTSTAR_COUNT; i++) { hue_offsets_[i] = cfg_.hue_offsets[i] % UINT16_MAX; }
+    led_count_ = 0;
 }
 
 void gem_led_animation_set_mode(enum GemMode mode) {
@@ -73,11 +89,16 @@ void gem_led_animation_set_mode(enum GemMode mode) {
         case GEM_MODE_HARD_SYNC:
             hue_accum_ = 52428;
             break;
+        case GEM_MODE_AUDIO_FM:
+            hue_accum_ = 6553;
+            break;
         default:
             break;
     }
 }
 
+bool gem_led_animation_due() { return wntr_ticks() - last_update_ >= GEM_ANIMATION_INTERVAL; }
+
 bool gem_led_animation_step(const struct GemDotstarCfg* dotstar) {
     uint32_t ticks = wntr_ticks();
     uint32_t delta = ticks - last_update_;
@@ -87,6 +108,10 @@ bool gem_led_animation_step(const struct GemDotstarCfg* dotstar) {
 
     last_update_ = ticks;
 
+    if (dotstar->count != led_count_) {
+        update_led_count_(dotstar->count);
+    }
+
     if (transitioning_) {
         animation_step_transition_(dotstar, delta);
     } else if (gem_led_inputs.tweaking) {
@@ -109,6 +134,10 @@ bool gem_led_animation_step(const struct GemDotstarCfg* dotstar) {
                 animation_step_normal_(dotstar, delta);
                 animation_step_sparkles_(dotstar, delta);
                 break;
+            case GEM_MODE_AUDIO_FM:
+                animation_step_normal_(dotstar, delta);
+                animation_step_sparkles_(dotstar, delta);
+                break;
             case GEM_MODE_CALIBRATION:
                 animation_step_calibration_(dotstar, ticks);
                 break;
@@ -128,13 +157,67 @@ static fix16_t noise(fix16_t phase) {
     return fix16_add(wntr_triangle(phase << 2), wntr_triangle(fix16_mul(fix16_pi, phase)));
 }
 
+static fix16_t sine_normalized_(fix16_t phase) {
+    // Only the fractional part of the phase matters. The top two bits of
+    // that pick the quadrant, the next six the table entry, and the rest
+    // interpolate between entries.
+    uint32_t position = (uint32_t)(phase) & 0xFFFF;
+    uint32_t quadrant = position >> 14;
+    uint32_t index = (position >> 8) & (GEM_LED_QUARTER_SINE_LEN - 1);
+    int32_t fraction = position & 0xFF;
+
+    // The second and fourth quadrants run through the table backwards.
+    int32_t a, b;
+    if (quadrant & 1) {
+        a = gem_led_quarter_sine_table[GEM_LED_QUARTER_SINE_LEN - index];
+        b = gem_led_quarter_sine_table[GEM_LED_QUARTER_SINE_LEN - index - 1];
+    } else {
+        a = gem_led_quarter_sine_table[index];
+        b = gem_led_quarter_sine_table[index + 1];
+    }
+    int32_t sine = a + (((b - a) * fraction) >> 8);
+
+    // And the second half of the wave is negative.
+    return quadrant < 2 ? (F16(1.0) + sine) >> 1 : (F16(1.0) - sine) >> 1;
+}
+
+static const uint8_t* hue_to_rgb_(uint16_t hue) {
+    // Round to the nearest entry, the last half step wraps around to red.
+    return gem_led_hue_table[(uint8_t)((hue + 128) >> 8)];
+}
+
+static uint32_t apply_sat_val_(const uint8_t* rgb, uint8_t sat, uint8_t val) {
+    // Same as wntr_colorspace_hsv_to_rgb().
+    uint32_t v1 = 1 + val;
+    uint16_t s1 = 1 + sat;
+    uint8_t s2 = 255 - sat;
+    return ((((((rgb[0] * s1) >> 8) + s2) * v1) & 0xff00) << 8) | (((((rgb[1] * s1) >> 8) + s2) * v1) & 0xff00) |
+           (((((rgb[2] * s1) >> 8) + s2) * v1) >> 8);
+}
+
+static uint32_t hsv_to_rgb_(uint16_t hue, uint8_t sat, uint8_t val) {
+    return apply_sat_val_(hue_to_rgb_(hue), sat, val);
+}
+
+/* hue_accum_ wrapped so that adding an entry from hue_offsets_ and wrapping
+   once more gives (hue_accum_ + cfg_.hue_offsets[i]) % UINT16_MAX. */
+static uint32_t hue_base_() { return hue_accum_ % UINT16_MAX; }
+
+static void update_led_count_(size_t count) {
+    const fix16_t count_f16 = fix16_from_int(count);
+    const fix16_t overlap = F16(0.25);
+    const fix16_t interval = fix16_div(F16(1), count_f16);
+
+    led_count_ = count;
+    transition_scale_ = fix16_div(F16(1), fix16_add(interval, overlap));
+
+    for (size_t i = 0; i < count; i++) { phase_offsets_[i] = fix16_div(fix16_from_int(i), count_f16); }
+}
+
 static void animation_step_transition_(const struct GemDotstarCfg* dotstar, uint32_t delta) {
     const fix16_t duration = F16(1200);
-    const fix16_t dotstar_count_f16 = fix16_from_int(dotstar->count);
     const fix16_t overlap = F16(0.25);
     const fix16_t max_phase = fix16_add(F16(1.1), overlap);
-    const fix16_t interval = fix16_div(F16(1), dotstar_count_f16);
-    const fix16_t scale = fix16_div(F16(1), fix16_add(interval, overlap));
 
     phase_a_ += fix16_div(fix16_from_int(delta), duration);
 
@@ -143,14 +226,15 @@ static void animation_step_transition_(const struct GemDotstarCfg* dotstar, uint
         return;
     }
 
+    // Every LED is the same hue, only the value changes.
+    const uint8_t* rgb = hue_to_rgb_(hue_accum_);
+
     for (size_t i = 0; i < dotstar->count; i++) {
-        size_t i_f16 = fix16_from_int(i);
-        size_t offset = fix16_div(i_f16, dotstar_count_f16);
-        size_t phase_i = fix16_sub(phase_a_, offset);
-        size_t factor = fix16_mul(phase_i, scale);
+        fix16_t phase_i = fix16_sub(phase_a_, phase_offsets_[i]);
+        fix16_t factor = fix16_mul(phase_i, transition_scale_);
 
         uint8_t v = (uint8_t)MINMAX((fix16_to_int(fix16_mul(F16(255), factor))), 0, 255);
-        uint32_t color = wntr_colorspace_hsv_to_rgb(hue_accum_, 255, 255 - v);
+        uint32_t color = apply_sat_val_(rgb, 255, 255 - v);
 
         size_t led_index = cfg_.vertical_pos_index[dotstar->count - 1 - i];
         gem_dotstar_set32(led_index, color);
@@ -167,27 +251,31 @@ static void animation_step_sparkles_(const struct GemDotstarCfg* dotstar, uint32
     const fix16_t flicker_freq = F16(800.0);
 
     uint32_t spawn_rate = 500 - fix16_to_int(fix16_mul(gem_led_inputs.lfo_gain, F16(400)));
+    // Each LED has a 1 in spawn_rate chance of sparkling.
+    uint32_t spawn_threshold = UINT32_MAX / spawn_rate;
+    uint32_t hue_base = hue_base_();
     uint8_t decay_step = (uint8_t)(fix16_to_int(fix16_mul(fix16_from_int(delta), decay_rate)));
 
     phase_sparkle_ += fix16_div(fix16_from_int(delta), flicker_freq);
     fix16_t flicker_amount = noise(phase_sparkle_);
 
     for (size_t i = 0; i < dotstar->count; i++) {
-        if (sparkles_[i] == 0 && wntr_random32() % spawn_rate == 0)
+        if (sparkles_[i] == 0 && wntr_random32() < spawn_threshold)
             sparkles_[i] = 255;
 
         if (sparkles_[i] == 0) {
             continue;
         }
 
-        uint16_t hue = (hue_accum_ + cfg_.hue_offsets[i]) % UINT16_MAX;
+        uint32_t hue = hue_base + hue_offsets_[i];
+        hue = hue >= UINT16_MAX ? hue - UINT16_MAX : hue;
         uint8_t sat = (uint8_t)MINMAX(-base_sat + (255 - sparkles_[i]), 0, 255);
         int32_t val = MIN(sparkles_[i] * val_factor, 255);
 
         val += fix16_to_int(fix16_mul(flicker_amount, flicker_factor));
         val = MINMAX(val, 0, 255);
 
-        uint32_t color = wntr_colorspace_hsv_to_rgb(hue, sat, (uint8_t)val);
+        uint32_t color = hsv_to_rgb_(hue, sat, (uint8_t)val);
 
         gem_dotstar_set32(i, color);
 
@@ -205,12 +293,19 @@ static void animation_step_normal_(const struct GemDotstarCfg* dotstar, uint32_t
 
     hue_accum_ += delta * 5;
 
+    // In hard sync mode every LED is the same hue.
+    bool same_hue = mode_ == GEM_MODE_HARD_SYNC;
+    uint32_t hue_base = same_hue ? (uint16_t)(hue_accum_) : hue_base_();
+
     for (size_t i = 0; i < dotstar->count; i++) {
-        fix16_t phase_offset = fix16_div(fix16_from_int(i), fix16_from_int(dotstar->count));
-        fix16_t sin_a = wntr_sine_normalized(phase_a_ + phase_offset);
+        fix16_t sin_a = sine_normalized_(phase_a_ + phase_offsets_[i]);
         uint8_t value = 20 + fix16_to_int(fix16_mul(sin_a, F16(235)));
-        uint16_t hue = mode_ == GEM_MODE_HARD_SYNC ? hue_accum_ : (hue_accum_ + cfg_.hue_offsets[i]) % UINT16_MAX;
-        uint32_t color = wntr_colorspace_hsv_to_rgb(hue, 255, value);
+        uint32_t hue = hue_base;
+        if (!same_hue) {
+            hue += hue_offsets_[i];
+            hue = hue >= UINT16_MAX ? hue - UINT16_MAX : hue;
+        }
+        uint32_t color = hsv_to_rgb_(hue, 255, value);
         gem_dotstar_set32(i, color);
     }
 
@@ -218,8 +313,8 @@ static void animation_step_normal_(const struct GemDotstarCfg* dotstar, uint32_t
         uint8_t val = 127 + fix16_to_int(fix16_mul(F16(127), gem_led_inputs.lfo_amplitude));
         uint16_t hue_a = (49151 * gem_led_inputs.lfo_mod_a) >> 12;
         uint16_t hue_b = (49151 * gem_led_inputs.lfo_mod_b) >> 12;
-        uint32_t color_a = wntr_colorspace_hsv_to_rgb(hue_a, 255, val);
-        uint32_t color_b = wntr_colorspace_hsv_to_rgb(hue_b, 255, val);
+        uint32_t color_a = hsv_to_rgb_(hue_a, 255, val);
+        uint32_t color_b = hsv_to_rgb_(hue_b, 255, val);
 
         gem_dotstar_set32(mode_ == GEM_MODE_LFO_PWM ? cfg_.pwm_a_led : cfg_.fm_a_led, color_a);
         gem_dotstar_set32(mode_ == GEM_MODE_LFO_PWM ? cfg_.pwm_b_led : cfg_.fm_b_led, color_b);
@@ -228,10 +323,10 @@ static void animation_step_normal_(const struct GemDotstarCfg* dotstar, uint32_t
 
 static void animation_step_calibration_(const struct GemDotstarCfg* dotstar, uint32_t ticks) {
     fix16_t bright_time = fix16_div(fix16_from_int(ticks / 2), F16(2000.0));
-    fix16_t sinv = wntr_sine_normalized(bright_time);
+    fix16_t sinv = sine_normalized_(bright_time);
     uint8_t value = fix16_to_int(fix16_mul(F16(255.0), sinv));
-    uint32_t colora = wntr_colorspace_hsv_to_rgb(50000, 255, value);
-    uint32_t colorb = wntr_colorspace_hsv_to_rgb(10000, 255, 255 - value);
+    uint32_t colora = hsv_to_rgb_(50000, 255, value);
+    uint32_t colorb = hsv_to_rgb_(10000, 255, 255 - value);
 
     for (uint8_t i = 0; i < dotstar->count; i++) {
         if (i % 2 == 0) {
@@ -248,7 +343,7 @@ static void animation_step_tweak_(const struct GemDotstarCfg* dotstar, uint32_t
     for (uint8_t i = 0; i < dotstar->count; i++) { gem_dotstar_set32(i, 0); }
 
     uint8_t lfo_val = 127 + fix16_to_int(fix16_mul(F16(127), gem_led_inputs.lfo_amplitude));
-    gem_dotstar_set32(cfg_.lfo_tweak_led, wntr_colorspace_hsv_to_rgb(49016, 255, lfo_val));
+    gem_dotstar_set32(cfg_.lfo_tweak_led, hsv_to_rgb_(49016, 255, lfo_val));
 
     uint16_t pitch_hue;
     uint8_t pitch_val;
@@ -263,7 +358,7 @@ static void animation_step_tweak_(const struct GemDotstarCfg* dotstar, uint32_t
         pitch_hue = 0;
         pitch_val = (gem_led_inputs.pitch_tweak_a - 2048) >> 3;
     }
-    gem_dotstar_set32(cfg_.pitch_a_tweak_led, wntr_colorspace_hsv_to_rgb(pitch_hue, 255, pitch_val));
+    gem_dotstar_set32(cfg_.pitch_a_tweak_led, hsv_to_rgb_(pitch_hue, 255, pitch_val));
 
     if (gem_led_inputs.pitch_tweak_b == UINT16_MAX) {
         pitch_hue = 0;
@@ -275,5 +370,5 @@ static void animation_step_tweak_(const struct GemDotstarCfg* dotstar, uint32_t
         pitch_hue = 0;
         pitch_val = (gem_led_inputs.pitch_tweak_b - 2048) >> 3;
     }
-    gem_dotstar_set32(cfg_.pitch_b_tweak_led, wntr_colorspace_hsv_to_rgb(pitch_hue, 255, pitch_val));
+    gem_dotstar_set32(cfg_.pitch_b_tweak_led, hsv_to_rgb_(pitch_hue, 255, pitch_val));
 }
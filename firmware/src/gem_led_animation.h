@@ -40,6 +40,8 @@ extern struct GemLEDInputs {
 
 void gem_led_animation_init(const struct GemLEDCfg cfg);
 
+/* Returns true if the next call to gem_led_animation_step() will draw a frame. */
+bool gem_led_animation_due() RAMFUNC;
 bool gem_led_animation_step(const struct GemDotstarCfg* dotstar) RAMFUNC;
 
 void gem_led_animation_set_mode(enum GemMode mode);
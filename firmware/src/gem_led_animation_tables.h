@@ -0,0 +1,26 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+/*
+    Look-up tables used by the LED animations so that drawing a frame doesn't
+    need to call fix16_sin() or convert every LED's color from HSV. These are
+    generated by scripts/generate_led_animation_tables.py.
+*/
+
+#include <stdint.h>
+
+#define GEM_LED_QUARTER_SINE_LEN 64
+#define GEM_LED_HUE_TABLE_LEN 256
+
+/* The first quarter of a sine wave, from 0 to 65535. The extra entry at the
+   end is the peak so that interpolation doesn't need to wrap around. */
+extern const uint16_t gem_led_quarter_sine_table[GEM_LED_QUARTER_SINE_LEN + 1];
+
+/* Fully saturated and bright RGB colors around the color wheel, matching
+   wntr_colorspace_hsv_to_rgb() at every 256th hue. */
+extern const uint8_t gem_led_hue_table[GEM_LED_HUE_TABLE_LEN][3];
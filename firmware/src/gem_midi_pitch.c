@@ -0,0 +1,128 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#include "gem_midi_pitch.h"
+#include <string.h>
+
+#define MIDI_CC_ALL_NOTES_OFF 123
+#define MIDI_NOTE_C0 12
+#define PITCH_BEND_CENTER 8192
+
+/* Forward declarations */
+
+static void note_on_(struct GemMIDIPitch* midi_pitch, uint8_t note);
+static void note_off_(struct GemMIDIPitch* midi_pitch, uint8_t note);
+static void update_volts_(struct GemMIDIPitch* midi_pitch);
+
+/* Public functions */
+
+void GemMIDIPitch_init(struct GemMIDIPitch* midi_pitch, uint8_t channel, uint8_t bend_range) {
+    midi_pitch->channel = channel;
+    midi_pitch->bend_range = bend_range;
+    midi_pitch->note_count = 0;
+    midi_pitch->bend = 0;
+    midi_pitch->changed_at = 0;
+    midi_pitch->volts = F16(0);
+}
+
+bool GemMIDIPitch_handle(struct GemMIDIPitch* midi_pitch, const struct WntrMIDIMessage* msg, uint32_t now) {
+    if (midi_pitch->channel == 0 || (msg->status & 0xF) != midi_pitch->channel - 1) {
+        return false;
+    }
+
+    uint8_t last_note = midi_pitch->note_count ? midi_pitch->notes[midi_pitch->note_count - 1] : 0xFF;
+    int16_t last_bend = midi_pitch->bend;
+
+    switch (msg->code_index) {
+        case MIDI_CODE_INDEX_NOTE_ON:
+            // A note on with zero velocity is a note off.
+            if (msg->data_1 == 0) {
+                note_off_(midi_pitch, msg->data_0);
+            } else {
+                note_on_(midi_pitch, msg->data_0);
+            }
+            break;
+
+        case MIDI_CODE_INDEX_NOTE_OFF:
+            note_off_(midi_pitch, msg->data_0);
+            break;
+
+        case MIDI_CODE_INDEX_PITCH_BEND:
+            midi_pitch->bend = (int16_t)((msg->data_1 << 7) | msg->data_0) - PITCH_BEND_CENTER;
+            break;
+
+        case MIDI_CODE_INDEX_CONTROL_CHANGE:
+            if (msg->data_0 == MIDI_CC_ALL_NOTES_OFF) {
+                midi_pitch->note_count = 0;
+            }
+            break;
+
+        default:
+            return false;
+    }
+
+    uint8_t note = midi_pitch->note_count ? midi_pitch->notes[midi_pitch->note_count - 1] : 0xFF;
+    if (note == last_note && midi_pitch->bend == last_bend) {
+        return false;
+    }
+
+    update_volts_(midi_pitch);
+
+    // Zero means there's nothing waiting to be applied.
+    midi_pitch->changed_at = now ? now : 1;
+    return true;
+}
+
+bool GemMIDIPitch_active(const struct GemMIDIPitch* midi_pitch) {
+    return midi_pitch->channel != 0 && midi_pitch->note_count > 0;
+}
+
+fix16_t GemMIDIPitch_volts(const struct GemMIDIPitch* midi_pitch) { return midi_pitch->volts; }
+
+/* Private functions */
+
+static void note_on_(struct GemMIDIPitch* midi_pitch, uint8_t note) {
+    // If the note is already held it moves to the top, which is the same as
+    // releasing it first.
+    note_off_(midi_pitch, note);
+
+    // Forget the oldest note if there are too many held.
+    if (midi_pitch->note_count == GEM_MIDI_PITCH_MAX_NOTES) {
+        memmove(midi_pitch->notes, midi_pitch->notes + 1, GEM_MIDI_PITCH_MAX_NOTES - 1);
+        midi_pitch->note_count--;
+    }
+
+    midi_pitch->notes[midi_pitch->note_count++] = note;
+}
+
+static void note_off_(struct GemMIDIPitch* midi_pitch, uint8_t note) {
+    for (uint8_t i = 0; i < midi_pitch->note_count; i++) {
+        if (midi_pitch->notes[i] == note) {
+            memmove(midi_pitch->notes + i, midi_pitch->notes + i + 1, midi_pitch->note_count - i - 1);
+            midi_pitch->note_count--;
+            return;
+        }
+    }
+}
+
+/*
+    The oscillator task asks for the pitch every frame but it only changes
+    when a message is received, so the division happens here instead.
+*/
+static void update_volts_(struct GemMIDIPitch* midi_pitch) {
+    if (midi_pitch->note_count == 0) {
+        midi_pitch->volts = F16(0);
+        return;
+    }
+
+    int32_t note = midi_pitch->notes[midi_pitch->note_count - 1] - MIDI_NOTE_C0;
+
+    // Full-scale bend is 8192, so multiplying by F16(1) / 8192 = 8 turns it
+    // into fix16 semitones. Semitones are 1/12 V.
+    fix16_t semitones = fix16_from_int(note);
+    semitones = fix16_add(semitones, (int32_t)(midi_pitch->bend) * midi_pitch->bend_range * 8);
+    midi_pitch->volts = fix16_div(semitones, F16(12));
+}
@@ -0,0 +1,61 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+/*
+    USB MIDI note and pitch bend control of an oscillator's pitch.
+
+    Each oscillator listens on its own MIDI channel and behaves like a
+    monophonic MIDI-to-CV converter: the most recently pressed note that's
+    still held sets the pitch, and pitch bend is added on top. Messages are
+    handled as soon as they're received and the resulting pitch is picked up
+    by the next oscillator update, see GemOscillatorInputs.midi_pitch.
+*/
+
+#include "fix16.h"
+#include "wntr_midi_core.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* How many held notes are remembered for last-note priority. */
+#define GEM_MIDI_PITCH_MAX_NOTES 8
+
+struct GemMIDIPitch {
+    /* Configuration from settings */
+    /* MIDI channel from 1 to 16, or 0 to ignore MIDI. */
+    uint8_t channel;
+    /* Full-scale pitch bend in semitones. */
+    uint8_t bend_range;
+
+    /* State */
+    uint8_t notes[GEM_MIDI_PITCH_MAX_NOTES];
+    uint8_t note_count;
+    /* Pitch bend from -8192 to 8191. */
+    int16_t bend;
+    /* When the pitch last changed, in microseconds, or 0 if that change has
+       already been applied. Used to measure note-to-output latency. */
+    uint32_t changed_at;
+    /* The current pitch, see GemMIDIPitch_volts(). */
+    fix16_t volts;
+};
+
+void GemMIDIPitch_init(struct GemMIDIPitch* midi_pitch, uint8_t channel, uint8_t bend_range);
+
+/*
+    Handles a received MIDI message. `now` is the current time in
+    microseconds. Returns true if the message changed the pitch.
+*/
+bool GemMIDIPitch_handle(struct GemMIDIPitch* midi_pitch, const struct WntrMIDIMessage* msg, uint32_t now);
+
+/* Returns true if a note is being held and MIDI isn't turned off. */
+bool GemMIDIPitch_active(const struct GemMIDIPitch* midi_pitch);
+
+/*
+    The pitch in volts with C0 (MIDI note 12) at 0 V, the same as
+    gem_voct_to_frequency().
+*/
+fix16_t GemMIDIPitch_volts(const struct GemMIDIPitch* midi_pitch);
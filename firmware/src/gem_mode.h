@@ -11,6 +11,7 @@ enum GemMode {
     GEM_MODE_LFO_PWM,
     GEM_MODE_LFO_FM,
     GEM_MODE_HARD_SYNC,
+    GEM_MODE_AUDIO_FM,
     GEM_MODE_COUNT,
     GEM_MODE_CALIBRATION,
 };
@@ -0,0 +1,183 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#include "gem_nvm_journal.h"
+#include "gem_crc32.h"
+#include "gem_log.h"
+#include "wntr_assert.h"
+#include <string.h>
+
+/* Erased flash reads as all ones, so this sequence number is never used. */
+#define BLANK_SEQUENCE 0xFFFFFFFF
+
+/* Forward declarations */
+
+static uint32_t slot_address_(const struct GemNVMJournal* journal, size_t slot);
+static bool read_record_(const struct GemNVMJournal* journal, size_t slot, uint8_t* record, uint32_t* sequence);
+static bool is_blank_(uint32_t addr, size_t len);
+static uint32_t unpack_u32_(const uint8_t* buf);
+static void pack_u32_(uint32_t val, uint8_t* buf);
+
+/* Public functions */
+
+void GemNVMJournal_init(struct GemNVMJournal* journal, uint32_t base, size_t len, size_t record_size) {
+    WNTR_ASSERT(base % WNTR_NVM_ROW_SIZE == 0);
+    WNTR_ASSERT(len % WNTR_NVM_ROW_SIZE == 0 && len >= 2 * WNTR_NVM_ROW_SIZE);
+    WNTR_ASSERT(record_size > GEM_NVM_JOURNAL_RECORD_OVERHEAD && record_size <= GEM_NVM_JOURNAL_MAX_RECORD_SIZE);
+    WNTR_ASSERT(record_size % WNTR_NVM_PAGE_SIZE == 0 && WNTR_NVM_ROW_SIZE % record_size == 0);
+
+    journal->base = base;
+    journal->len = len;
+    journal->record_size = record_size;
+    journal->_slot_count = len / record_size;
+    journal->_newest_slot = 0;
+    journal->_has_newest = false;
+    journal->_next_sequence = 0;
+
+    uint8_t record[GEM_NVM_JOURNAL_MAX_RECORD_SIZE];
+    uint32_t newest_sequence = 0;
+
+    for (size_t slot = 0; slot < journal->_slot_count; slot++) {
+        uint32_t sequence;
+        if (!read_record_(journal, slot, record, &sequence)) {
+            continue;
+        }
+
+        // Compare using the difference so that this keeps working if the
+        // sequence number ever wraps around.
+        if (!journal->_has_newest || (int32_t)(sequence - newest_sequence) > 0) {
+            newest_sequence = sequence;
+            journal->_newest_slot = slot;
+            journal->_has_newest = true;
+        }
+    }
+
+    if (journal->_has_newest) {
+        journal->_next_sequence = newest_sequence + 1;
+        if (journal->_next_sequence == BLANK_SEQUENCE) {
+            journal->_next_sequence = 0;
+        }
+    }
+}
+
+bool GemNVMJournal_read(const struct GemNVMJournal* journal, uint8_t* buf, size_t len) {
+    WNTR_ASSERT(len <= GemNVMJournal_payload_size(journal));
+
+    if (!journal->_has_newest) {
+        return false;
+    }
+
+    wntr_nvm_read(slot_address_(journal, journal->_newest_slot) + 4, buf, len);
+    return true;
+}
+
+bool GemNVMJournal_append(struct GemNVMJournal* journal, const uint8_t* buf, size_t len) {
+    WNTR_ASSERT(len <= GemNVMJournal_payload_size(journal));
+
+    size_t records_per_row = WNTR_NVM_ROW_SIZE / journal->record_size;
+    size_t slot = journal->_has_newest ? (journal->_newest_slot + 1) % journal->_slot_count : 0;
+
+    // The next slot should already be erased unless the journal has wrapped
+    // around to the start of a row. If it isn't erased in the middle of a
+    // row then something, such as a partially written record, is in the way.
+    // Erasing that row could destroy the newest record, so skip ahead to the
+    // next row instead.
+    if (slot % records_per_row != 0 && !is_blank_(slot_address_(journal, slot), journal->record_size)) {
+        slot = (slot + records_per_row - (slot % records_per_row)) % journal->_slot_count;
+    }
+
+    uint32_t addr = slot_address_(journal, slot);
+
+    // This is the only place that the journal erases a row.
+    if (slot % records_per_row == 0 && !is_blank_(addr, WNTR_NVM_ROW_SIZE)) {
+        wntr_nvm_erase_row(addr);
+    }
+
+    uint8_t record[GEM_NVM_JOURNAL_MAX_RECORD_SIZE];
+    size_t crc_offset = journal->record_size - 4;
+
+    memset(record, 0xFF, journal->record_size);
+    pack_u32_(journal->_next_sequence, record);
+    memcpy(record + 4, buf, len);
+    pack_u32_(gem_crc32(0, record, crc_offset), record + crc_offset);
+
+    for (size_t offset = 0; offset < journal->record_size; offset += WNTR_NVM_PAGE_SIZE) {
+        wntr_nvm_write_page(addr + offset, record + offset, WNTR_NVM_PAGE_SIZE);
+    }
+
+    // Read the record back to make sure it was written correctly. The record
+    // buffer is re-used to keep stack usage down.
+    uint32_t sequence;
+    if (!read_record_(journal, slot, record, &sequence) || sequence != journal->_next_sequence) {
+        GEM_LOG("Failed to verify NVM journal record at 0x%08x.\n", addr);
+        return false;
+    }
+
+    journal->_newest_slot = slot;
+    journal->_has_newest = true;
+    journal->_next_sequence++;
+    if (journal->_next_sequence == BLANK_SEQUENCE) {
+        journal->_next_sequence = 0;
+    }
+
+    return true;
+}
+
+void GemNVMJournal_erase(struct GemNVMJournal* journal) {
+    for (uint32_t addr = journal->base; addr < journal->base + journal->len; addr += WNTR_NVM_ROW_SIZE) {
+        if (!is_blank_(addr, WNTR_NVM_ROW_SIZE)) {
+            wntr_nvm_erase_row(addr);
+        }
+    }
+
+    journal->_newest_slot = 0;
+    journal->_has_newest = false;
+    journal->_next_sequence = 0;
+}
+
+/* Private functions */
+
+static uint32_t slot_address_(const struct GemNVMJournal* journal, size_t slot) {
+    return journal->base + slot * journal->record_size;
+}
+
+static bool read_record_(const struct GemNVMJournal* journal, size_t slot, uint8_t* record, uint32_t* sequence) {
+    wntr_nvm_read(slot_address_(journal, slot), record, journal->record_size);
+
+    *sequence = unpack_u32_(record);
+    if (*sequence == BLANK_SEQUENCE) {
+        return false;
+    }
+
+    size_t crc_offset = journal->record_size - 4;
+    return gem_crc32(0, record, crc_offset) == unpack_u32_(record + crc_offset);
+}
+
+static bool is_blank_(uint32_t addr, size_t len) {
+    uint8_t buf[WNTR_NVM_PAGE_SIZE];
+
+    for (size_t offset = 0; offset < len; offset += WNTR_NVM_PAGE_SIZE) {
+        wntr_nvm_read(addr + offset, buf, WNTR_NVM_PAGE_SIZE);
+        for (size_t i = 0; i < WNTR_NVM_PAGE_SIZE; i++) {
+            if (buf[i] != 0xFF) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static uint32_t unpack_u32_(const uint8_t* buf) {
+    return (uint32_t)(buf[0]) | (uint32_t)(buf[1]) << 8 | (uint32_t)(buf[2]) << 16 | (uint32_t)(buf[3]) << 24;
+}
+
+static void pack_u32_(uint32_t val, uint8_t* buf) {
+    buf[0] = val & 0xFF;
+    buf[1] = (val >> 8) & 0xFF;
+    buf[2] = (val >> 16) & 0xFF;
+    buf[3] = (val >> 24) & 0xFF;
+}
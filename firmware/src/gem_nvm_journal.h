@@ -0,0 +1,79 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+/*
+    A wear-leveled, append-only journal of fixed-size records stored in NVM.
+
+    Rewriting a single NVM location means erasing the same row each time,
+    which is slow (several milliseconds) and wears out the flash. Instead, the
+    journal appends each new record after the last one and only erases a row
+    when it wraps back around to it. Loading finds the newest valid record.
+
+    Each record is stored as:
+
+        SEQUENCE(4) PAYLOAD(record_size - 8) CRC32(4)
+
+    The sequence number increases with each record and is used to find the
+    newest one. The CRC covers the sequence number and payload, so a record
+    that was only partially written (for example, if power was lost) is
+    ignored and the previous record is used instead.
+*/
+
+#include "wntr_nvm.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Size of the sequence number and CRC stored with each record. */
+#define GEM_NVM_JOURNAL_RECORD_OVERHEAD 8
+
+/* Records are kept on the stack when being written, so limit their size. */
+#define GEM_NVM_JOURNAL_MAX_RECORD_SIZE WNTR_NVM_ROW_SIZE
+
+struct GemNVMJournal {
+    /* Row-aligned address of the journal's NVM region. */
+    uint32_t base;
+    /* Length of the region, must be at least two rows. */
+    size_t len;
+    /* Size of each record including overhead. This must be a multiple of
+       the NVM page size and evenly divide a row. */
+    size_t record_size;
+
+    /* Found by GemNVMJournal_init() */
+    size_t _slot_count;
+    size_t _newest_slot;
+    bool _has_newest;
+    uint32_t _next_sequence;
+};
+
+/*
+    Setup the journal and find the newest valid record in the given NVM
+    region.
+*/
+void GemNVMJournal_init(struct GemNVMJournal* journal, uint32_t base, size_t len, size_t record_size);
+
+/* The number of payload bytes each record can hold. */
+inline static size_t GemNVMJournal_payload_size(const struct GemNVMJournal* journal) {
+    return journal->record_size - GEM_NVM_JOURNAL_RECORD_OVERHEAD;
+}
+
+/*
+    Reads up to `len` bytes from the newest record's payload into `buf`.
+    Returns false if the journal has no valid records.
+*/
+bool GemNVMJournal_read(const struct GemNVMJournal* journal, uint8_t* buf, size_t len);
+
+/*
+    Appends a new record containing `len` bytes of `buf`. The rest of the
+    payload is filled with 0xFF. Returns false if the record couldn't be
+    verified after writing it.
+*/
+bool GemNVMJournal_append(struct GemNVMJournal* journal, const uint8_t* buf, size_t len);
+
+/* Erases every record in the journal. */
+void GemNVMJournal_erase(struct GemNVMJournal* journal);
@@ -15,34 +15,52 @@
 
 /* Static variables */
 
-static fix16_t pitch_knob_nonlinearity_;
-static struct WntrErrorCorrection pitch_cv_adc_errors_;
+static struct GemOscillatorCalibration calibration_;
 
 /* Forward declarations */
 
-static void GemOscillator_update_pitch_(struct GemOscillator* osc, const struct GemOscillatorInputs inputs) RAMFUNC;
-static fix16_t gem_oscillator_calc_pitch_cv_(fix16_t cv_min, fix16_t cv_max, uint16_t adc_code) RAMFUNC;
+static void GemOscillator_update_pitch_(
+    struct GemOscillator* osc,
+    const struct GemOscillatorInputs* inputs,
+    const struct GemOscillatorCalibration* calibration) RAMFUNC;
+static fix16_t gem_oscillator_calc_pitch_cv_(
+    fix16_t cv_min, fix16_t cv_max, struct WntrErrorCorrection adc_errors, uint16_t adc_code) RAMFUNC;
+static fix16_t GemOscillator_smooth_pitch_cv_(struct GemOscillator* osc, fix16_t pitch_cv) RAMFUNC;
 static fix16_t
 gem_oscillator_calc_pitch_knob_(fix16_t knob_min, fix16_t knob_range, fix16_t nonlinearity, uint16_t adc_code) RAMFUNC;
 static void
-GemOscillator_update_pulse_width_(struct GemOscillator* osc, const struct GemOscillatorInputs inputs) RAMFUNC;
+GemOscillator_update_pulse_width_(struct GemOscillator* osc, const struct GemOscillatorInputs* inputs) RAMFUNC;
 
 /* Public functions */
 
 void gem_oscillator_init(struct WntrErrorCorrection pitch_cv_adc_error_correction, fix16_t pitch_knob_nonlinearity) {
-    pitch_cv_adc_errors_ = pitch_cv_adc_error_correction;
-    pitch_knob_nonlinearity_ = pitch_knob_nonlinearity;
+    calibration_.pitch_cv_adc_errors = pitch_cv_adc_error_correction;
+    calibration_.pitch_knob_nonlinearity = pitch_knob_nonlinearity;
 }
 
 void GemOscillator_init(struct GemOscillator* osc) {
     osc->ramp_cv = 0;
     osc->pitch = F16(0);
+    osc->quantized_pitch = F16(0);
+    GemPitchSmoother_reset(&osc->pitch_smoother);
     osc->pulse_width = 2048;
+    osc->fm_depth = F16(0);
 }
 
 void GemOscillator_update(struct GemOscillator* osc, struct GemOscillatorInputs inputs) {
-    GemOscillator_update_pitch_(osc, inputs);
-    GemOscillator_update_pulse_width_(osc, inputs);
+    GemOscillator_update_pitch_(osc, &inputs, &calibration_);
+    GemOscillator_update_pulse_width_(osc, &inputs);
+}
+
+void GemOscillatorBatch_update(struct GemOscillatorBatch* batch) {
+    struct GemOscillator* oscillators = batch->oscillators;
+    const struct GemOscillatorInputs* inputs = batch->inputs;
+    const struct GemOscillatorCalibration* calibrations = batch->calibrations;
+
+    for (size_t i = 0; i < batch->count; i++) {
+        GemOscillator_update_pitch_(&oscillators[i], &inputs[i], &calibrations[i]);
+    }
+    for (size_t i = 0; i < batch->count; i++) { GemOscillator_update_pulse_width_(&oscillators[i], &inputs[i]); }
 }
 
 void GemOscillator_post_update(const struct GemPulseOutConfig* pulseout, struct GemOscillator* osc) {
@@ -55,28 +73,51 @@ void GemOscillator_post_update(const struct GemPulseOutConfig* pulseout, struct
     osc->ramp_cv = gem_ramp_table_lookup(osc->number, osc->pitch);
 }
 
-static void GemOscillator_update_pitch_(struct GemOscillator* osc, const struct GemOscillatorInputs inputs) {
+static void GemOscillator_update_pitch_(
+    struct GemOscillator* osc,
+    const struct GemOscillatorInputs* inputs,
+    const struct GemOscillatorCalibration* calibration) {
     fix16_t pitch;
     fix16_t fm_amount = F16(0);
     fix16_t base_offset = osc->pitch_offset;
     bool is_castor = osc->number == 0;
     bool is_pollux = osc->number == 1;
-    bool is_hard_sync = inputs.mode == GEM_MODE_HARD_SYNC;
+    bool is_hard_sync = inputs->mode == GEM_MODE_HARD_SYNC;
+
+    bool is_zero =
+        osc->zero_detection_enabled && (UINT12_INVERT(inputs->pitch_cv_code) < osc->zero_detection_threshold);
+    bool midi_replaces_cv = inputs->midi_active && osc->midi_replaces_cv;
+    bool uses_pitch_cv = false;
+
+    // "midi" pitch behavior is used when a MIDI note is held and MIDI is
+    // configured to replace the pitch CV. It's like "fine", but the MIDI note
+    // is the absolute pitch so the base pitch offset isn't added. In hard sync
+    // mode Pollux still multiplies, using the MIDI note in place of the CV.
+    if (midi_replaces_cv && !(is_pollux && is_hard_sync)) {
+        osc->pitch_behavior = GEM_PITCH_MIDI;
 
-    bool is_zero = osc->zero_detection_enabled && (UINT12_INVERT(inputs.pitch_cv_code) < osc->zero_detection_threshold);
+        pitch = fix16_add(
+            inputs->midi_pitch,
+            gem_oscillator_calc_pitch_knob_(
+                osc->pitch_knob_min,
+                osc->pitch_knob_max,
+                calibration->pitch_knob_nonlinearity,
+                inputs->pitch_knob_code));
+        base_offset = F16(0);
+    }
 
     // "coarse" pitch behavior is used when the pitch jack isn't connected to
     // Castor
-    if (is_castor && is_zero) {
+    else if (is_castor && is_zero) {
         osc->pitch_behavior = GEM_PITCH_COARSE;
 
-        pitch = gem_oscillator_calc_pitch_knob_(F16(0), F16(6), 0, inputs.pitch_knob_code);
+        pitch = gem_oscillator_calc_pitch_knob_(F16(0), F16(6), 0, inputs->pitch_knob_code);
 
         // quantize
         if (osc->quantization_enabled) {
-            pitch = fix16_mul(pitch, F16(12));
-            pitch = fix16_floor(fix16_add(pitch, F16(0.5)));
-            pitch = fix16_div(pitch, F16(12));
+            pitch = GemQuantizer_quantize_hysteresis(
+                osc->quantizer, pitch, osc->quantized_pitch, GEM_QUANTIZER_HYSTERESIS);
+            osc->quantized_pitch = pitch;
         }
     }
 
@@ -86,15 +127,21 @@ static void GemOscillator_update_pitch_(struct GemOscillator* osc, const struct
     else if (is_pollux && is_hard_sync) {
         osc->pitch_behavior = GEM_PITCH_MULTIPLY;
 
-        if (is_zero) {
-            pitch = inputs.reference_pitch;
+        if (midi_replaces_cv) {
+            pitch = inputs->midi_pitch;
+            base_offset = F16(0);
+        } else if (is_zero) {
+            pitch = inputs->reference_pitch;
             // Importantly, this does *not* add the base pitch offset.
             base_offset = F16(0);
         } else {
-            pitch = gem_oscillator_calc_pitch_cv_(osc->pitch_cv_min, osc->pitch_cv_max, inputs.pitch_cv_code);
+            pitch = gem_oscillator_calc_pitch_cv_(
+                osc->pitch_cv_min, osc->pitch_cv_max, calibration->pitch_cv_adc_errors, inputs->pitch_cv_code);
+            pitch = GemOscillator_smooth_pitch_cv_(osc, pitch);
+            uses_pitch_cv = true;
         }
 
-        pitch = fix16_add(pitch, gem_oscillator_calc_pitch_knob_(F16(0), F16(3), 0, inputs.pitch_knob_code));
+        pitch = fix16_add(pitch, gem_oscillator_calc_pitch_knob_(F16(0), F16(3), 0, inputs->pitch_knob_code));
     }
 
     // "follow" behavior is used by Pollux when both Castor & Pollux don't have
@@ -103,9 +150,12 @@ static void GemOscillator_update_pitch_(struct GemOscillator* osc, const struct
         osc->pitch_behavior = GEM_PITCH_FOLLOW;
 
         pitch = fix16_add(
-            inputs.reference_pitch,
+            inputs->reference_pitch,
             gem_oscillator_calc_pitch_knob_(
-                osc->pitch_knob_min, osc->pitch_knob_max, pitch_knob_nonlinearity_, inputs.pitch_knob_code));
+                osc->pitch_knob_min,
+                osc->pitch_knob_max,
+                calibration->pitch_knob_nonlinearity,
+                inputs->pitch_knob_code));
         // Importantly, this does *not* add the base pitch offset.
         base_offset = F16(0);
     }
@@ -115,36 +165,74 @@ static void GemOscillator_update_pitch_(struct GemOscillator* osc, const struct
     else {
         osc->pitch_behavior = GEM_PITCH_FINE;
 
-        pitch = gem_oscillator_calc_pitch_cv_(osc->pitch_cv_min, osc->pitch_cv_max, inputs.pitch_cv_code);
+        pitch = gem_oscillator_calc_pitch_cv_(
+            osc->pitch_cv_min, osc->pitch_cv_max, calibration->pitch_cv_adc_errors, inputs->pitch_cv_code);
+        pitch = GemOscillator_smooth_pitch_cv_(osc, pitch);
+        uses_pitch_cv = true;
+
+        // Only the CV is quantized so the knob can still tune the
+        // quantized notes.
+        if (osc->fine_quantization_enabled) {
+            pitch = GemQuantizer_quantize_hysteresis(
+                osc->quantizer, pitch, osc->quantized_pitch, GEM_QUANTIZER_HYSTERESIS);
+            osc->quantized_pitch = pitch;
+        }
+
         pitch = fix16_add(
             pitch,
             gem_oscillator_calc_pitch_knob_(
-                osc->pitch_knob_min, osc->pitch_knob_max, pitch_knob_nonlinearity_, inputs.pitch_knob_code));
+                osc->pitch_knob_min,
+                osc->pitch_knob_max,
+                calibration->pitch_knob_nonlinearity,
+                inputs->pitch_knob_code));
+    }
+
+    // The smoothing filter starts over the next time the pitch CV is used,
+    // so it doesn't glide from wherever the CV was before.
+    if (!uses_pitch_cv) {
+        GemPitchSmoother_reset(&osc->pitch_smoother);
+    }
+
+    // Otherwise, MIDI notes transpose the pitch relative to C4 (4 V).
+    if (inputs->midi_active && !midi_replaces_cv) {
+        pitch = fix16_add(pitch, fix16_sub(inputs->midi_pitch, F16(4)));
     }
 
     // In normal and hard sync modes, use the LFO to modulate only Pollux's
     // pitch with the intensity controlled by the LFO knob.
-    if ((inputs.mode == GEM_MODE_NORMAL || inputs.mode == GEM_MODE_HARD_SYNC) && is_pollux) {
-        fm_amount = UINT12_NORMALIZE(inputs.lfo_knob_code);
+    if ((inputs->mode == GEM_MODE_NORMAL || inputs->mode == GEM_MODE_HARD_SYNC) && is_pollux) {
+        fm_amount = UINT12_NORMALIZE(inputs->lfo_knob_code);
     }
 
     // In LFO FM mode, use the LFO to modulate pitch with the intensity
     // controlled by the pulse width knob.
-    if (inputs.mode == GEM_MODE_LFO_FM) {
-        fm_amount = UINT12_NORMALIZE(inputs.pulse_cv_code + inputs.pulse_knob_code);
+    if (inputs->mode == GEM_MODE_LFO_FM) {
+        fm_amount = UINT12_NORMALIZE(inputs->pulse_cv_code + inputs->pulse_knob_code);
     }
 
     fm_amount = fix16_sub(fm_amount, GEM_FM_DEADZONE);
 
     if (fm_amount > F16(0)) {
-        fix16_t fm = fix16_mul(osc->lfo_pitch_factor, fix16_mul(inputs.lfo_amplitude, fm_amount));
+        fix16_t fm = fix16_mul(osc->lfo_pitch_factor, fix16_mul(inputs->lfo_amplitude, fm_amount));
         pitch = fix16_add(pitch, fm);
     }
 
+    // In audio FM mode, Pollux's pitch is modulated by Castor at audio rate
+    // with the depth controlled by Pollux's pulse width knob and CV. The
+    // modulation itself is handled by the timers, see gem_fm_table.h.
+    osc->fm_depth = F16(0);
+    if (inputs->mode == GEM_MODE_AUDIO_FM && is_pollux) {
+        fix16_t fm_depth =
+            fix16_sub(UINT12_NORMALIZE(inputs->pulse_cv_code + inputs->pulse_knob_code), GEM_FM_DEADZONE);
+        if (fm_depth > F16(0)) {
+            osc->fm_depth = fix16_mul(GEM_AUDIO_FM_MAX_DEPTH, fm_depth);
+        }
+    }
+
     // In all modes, tweak mode's pitch knobs give extra fine tuning of the
     // pitch
-    if (inputs.tweak_pitch_knob_code != UINT16_MAX) {
-        fix16_t fine_tune = gem_oscillator_calc_pitch_knob_(F16(-0.2), F16(0.2), 0, inputs.tweak_pitch_knob_code);
+    if (inputs->tweak_pitch_knob_code != UINT16_MAX) {
+        fix16_t fine_tune = gem_oscillator_calc_pitch_knob_(F16(-0.2), F16(0.2), 0, inputs->tweak_pitch_knob_code);
         pitch = fix16_add(pitch, fine_tune);
     }
 
@@ -155,12 +243,13 @@ static void GemOscillator_update_pitch_(struct GemOscillator* osc, const struct
     // osc->pitch = fix16_add(fix16_mul(pitch, F16(0.9)), fix16_mul(osc->pitch, F16(0.1)));
 }
 
-static fix16_t gem_oscillator_calc_pitch_cv_(fix16_t cv_min, fix16_t cv_max, uint16_t adc_code) {
+static fix16_t gem_oscillator_calc_pitch_cv_(
+    fix16_t cv_min, fix16_t cv_max, struct WntrErrorCorrection adc_errors, uint16_t adc_code) {
     // Error correction must be applied *before* inverting the code because
     // it's calibrated with the uninverted code. See
     // ./factory/libgemini/adc_calibration.py
     fix16_t cv_adc_code_f16 =
-        UINT12_INVERT_F(wntr_apply_error_correction_fix16(fix16_from_int(adc_code), pitch_cv_adc_errors_));
+        UINT12_INVERT_F(wntr_apply_error_correction_fix16(fix16_from_int(adc_code), adc_errors));
 
     fix16_t cv_norm = UINT12_NORMALIZE_F(cv_adc_code_f16);
     fix16_t cv_range = fix16_sub(cv_max, cv_min);
@@ -169,6 +258,14 @@ static fix16_t gem_oscillator_calc_pitch_cv_(fix16_t cv_min, fix16_t cv_max, uin
     return cv;
 }
 
+static fix16_t GemOscillator_smooth_pitch_cv_(struct GemOscillator* osc, fix16_t pitch_cv) {
+    if (!osc->pitch_smoothing_enabled) {
+        GemPitchSmoother_reset(&osc->pitch_smoother);
+        return pitch_cv;
+    }
+    return GemPitchSmoother_step(&osc->pitch_smoother, osc->pitch_smoothing, pitch_cv);
+}
+
 static fix16_t
 gem_oscillator_calc_pitch_knob_(fix16_t knob_min, fix16_t knob_max, fix16_t nonlinearity, uint16_t adc_code) {
     // Read the pitch knob and normalize (0.0 -> 1.0) its value.
@@ -195,31 +292,32 @@ gem_oscillator_calc_pitch_knob_(fix16_t knob_min, fix16_t knob_max, fix16_t nonl
     return knob_value;
 }
 
-static void GemOscillator_update_pulse_width_(struct GemOscillator* osc, struct GemOscillatorInputs inputs) {
+static void GemOscillator_update_pulse_width_(struct GemOscillator* osc, const struct GemOscillatorInputs* inputs) {
     int32_t pulse_width = 2048;
 
     // In normal and hard sync modes, the CV & knob directly control the pulse
     // width.
-    if (inputs.mode == GEM_MODE_NORMAL || inputs.mode == GEM_MODE_HARD_SYNC) {
-        pulse_width = inputs.pulse_knob_code + inputs.pulse_cv_code;
+    if (inputs->mode == GEM_MODE_NORMAL || inputs->mode == GEM_MODE_HARD_SYNC) {
+        pulse_width = inputs->pulse_knob_code + inputs->pulse_cv_code;
     }
 
-    // In LFO FM mode, the tweak mode pulse knob controls the pulse width.
-    else if (inputs.mode == GEM_MODE_LFO_FM) {
-        if (inputs.tweak_pulse_knob_code != UINT16_MAX) {
-            pulse_width = inputs.tweak_pulse_knob_code;
+    // In LFO FM and audio FM modes, the tweak mode pulse knob controls the
+    // pulse width.
+    else if (inputs->mode == GEM_MODE_LFO_FM || inputs->mode == GEM_MODE_AUDIO_FM) {
+        if (inputs->tweak_pulse_knob_code != UINT16_MAX) {
+            pulse_width = inputs->tweak_pulse_knob_code;
         }
     }
 
     // In LFO PWM mode, the pulse width is modulated by the LFO and the knobs
     // and CV control the amount of modulation. The center of the pulse width
     // is set by the tweak knob.
-    else if (inputs.mode == GEM_MODE_LFO_PWM) {
-        fix16_t lfo_factor = UINT12_NORMALIZE(inputs.pulse_knob_code + inputs.pulse_cv_code);
-        if (inputs.tweak_pulse_knob_code != UINT16_MAX) {
-            pulse_width = inputs.tweak_pulse_knob_code;
+    else if (inputs->mode == GEM_MODE_LFO_PWM) {
+        fix16_t lfo_factor = UINT12_NORMALIZE(inputs->pulse_knob_code + inputs->pulse_cv_code);
+        if (inputs->tweak_pulse_knob_code != UINT16_MAX) {
+            pulse_width = inputs->tweak_pulse_knob_code;
         }
-        pulse_width += (fix16_mul(F16(GEM_PULSE_WIDTH_MOD_MAX), fix16_mul(lfo_factor, inputs.lfo_amplitude))) >> 16;
+        pulse_width += (fix16_mul(F16(GEM_PULSE_WIDTH_MOD_MAX), fix16_mul(lfo_factor, inputs->lfo_amplitude))) >> 16;
     }
 
     // Up until this point, pulse width is defined as 0 -> 4095, however, the pulse width's
@@ -9,10 +9,13 @@
 #include "fix16.h"
 #include "gem_adc_channels.h"
 #include "gem_mode.h"
+#include "gem_pitch_smoothing.h"
 #include "gem_pulseout.h"
+#include "gem_quantizer.h"
 #include "wntr_error_correction.h"
 #include "wntr_ramfunc.h"
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /* The core logic for updating Gemini's oscillators based on external input. */
@@ -34,6 +37,9 @@ struct GemOscillatorInputs {
     uint16_t tweak_lfo_knob_code;
     fix16_t reference_pitch;
     fix16_t lfo_amplitude;
+    /* Pitch from USB MIDI notes, see gem_midi_pitch.h. Only used if a note is held. */
+    bool midi_active;
+    fix16_t midi_pitch;
 };
 
 enum GemOscillatorPitchBehavior {
@@ -41,6 +47,7 @@ enum GemOscillatorPitchBehavior {
     GEM_PITCH_MULTIPLY,
     GEM_PITCH_FOLLOW,
     GEM_PITCH_FINE,
+    GEM_PITCH_MIDI,
 };
 
 struct GemOscillator {
@@ -52,6 +59,15 @@ struct GemOscillator {
 
     /* Configuration from settings */
     bool quantization_enabled;
+    /* If true, the pitch CV is also quantized in "fine" mode. */
+    bool fine_quantization_enabled;
+    /* Scale used for quantization, must be set if either kind of quantization
+       is enabled. */
+    const struct GemQuantizer* quantizer;
+    /* If true, the pitch CV is smoothed to reduce jitter. */
+    bool pitch_smoothing_enabled;
+    /* Smoothing filter configuration, must be set if smoothing is enabled. */
+    const struct GemPitchSmoothing* pitch_smoothing;
     fix16_t pitch_offset;
     fix16_t pitch_knob_min;
     fix16_t pitch_knob_max;
@@ -59,6 +75,9 @@ struct GemOscillator {
     uint16_t zero_detection_threshold;
     uint16_t pulse_width_bitmask;
     fix16_t lfo_pitch_factor;
+    /* If true, MIDI notes replace the pitch CV, otherwise they transpose it
+       relative to C4. */
+    bool midi_replaces_cv;
 
     /* State */
     uint32_t pulseout_period;
@@ -66,9 +85,35 @@ struct GemOscillator {
     fix16_t pitch;
     uint16_t pulse_width;
     enum GemOscillatorPitchBehavior pitch_behavior;
+    /* The last quantized note, used for hysteresis. */
+    fix16_t quantized_pitch;
+    struct GemPitchSmoother pitch_smoother;
+    /* Audio-rate FM depth in volts, only used for Pollux in audio FM mode */
+    fix16_t fm_depth;
 };
 
+/* Per-module calibration, shared by Castor & Pollux on a real module. */
+struct GemOscillatorCalibration {
+    struct WntrErrorCorrection pitch_cv_adc_errors;
+    fix16_t pitch_knob_nonlinearity;
+};
+
+/*
+    Updates many oscillators at once, each with its own calibration, inputs,
+    and settings. This is used on the host to simulate lots of modules, for
+    example to see how calibration tolerances affect pitch. The arrays are
+    parallel: entry `i` of each one belongs to the same oscillator.
+*/
+struct GemOscillatorBatch {
+    size_t count;
+    struct GemOscillator* oscillators;
+    const struct GemOscillatorInputs* inputs;
+    const struct GemOscillatorCalibration* calibrations;
+};
+
+/* Sets the calibration used by GemOscillator_update(). */
 void gem_oscillator_init(struct WntrErrorCorrection pitch_cv_adc_error_correction, fix16_t pitch_knob_nonlinearity);
 void GemOscillator_init(struct GemOscillator* osc);
 void GemOscillator_update(struct GemOscillator* osc, struct GemOscillatorInputs inputs) RAMFUNC;
+void GemOscillatorBatch_update(struct GemOscillatorBatch* batch);
 void GemOscillator_post_update(const struct GemPulseOutConfig* pulseout, struct GemOscillator* osc) RAMFUNC;
@@ -0,0 +1,91 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#include "gem_pitch_smoothing.h"
+#include "gem_config.h"
+
+/* Forward declarations */
+
+static fix16_t calculate_alpha_(fix16_t cutoff);
+static int64_t lowpass_(int64_t state, fix16_t alpha, fix16_t input) RAMFUNC;
+
+/* Public functions */
+
+void GemPitchSmoothing_init(struct GemPitchSmoothing* smoothing, fix16_t min_cutoff, fix16_t sensitivity) {
+    for (int32_t i = 0; i <= GEM_PITCH_SMOOTHING_TABLE_LEN; i++) {
+        fix16_t cutoff = fix16_from_int(i * GEM_PITCH_SMOOTHING_MAX_CUTOFF / GEM_PITCH_SMOOTHING_TABLE_LEN);
+        smoothing->alphas[i] = calculate_alpha_(cutoff);
+    }
+
+    smoothing->rate_alpha = calculate_alpha_(GEM_PITCH_SMOOTHING_RATE_CUTOFF);
+
+    // The cutoff is tracked as an index into the table instead of in Hz,
+    // and the rate of change is in volts per frame instead of per second, so
+    // the sensitivity is scaled to match.
+    fix16_t index_per_hz = F16((double)(GEM_PITCH_SMOOTHING_TABLE_LEN) / GEM_PITCH_SMOOTHING_MAX_CUTOFF);
+    fix16_t max_index = fix16_from_int(GEM_PITCH_SMOOTHING_TABLE_LEN);
+
+    smoothing->min_index = fix16_min(fix16_mul(min_cutoff, index_per_hz), max_index);
+    smoothing->sensitivity =
+        fix16_mul(fix16_mul(sensitivity, index_per_hz), fix16_from_int(GEM_PITCH_SMOOTHING_RATE));
+
+    // Faster changes than this would overflow the index, they always use the
+    // end of the table.
+    if (smoothing->sensitivity > 0) {
+        smoothing->max_rate = fix16_div(fix16_sub(max_index, smoothing->min_index), smoothing->sensitivity);
+    } else {
+        smoothing->max_rate = fix16_maximum;
+    }
+}
+
+void GemPitchSmoother_reset(struct GemPitchSmoother* smoother) { smoother->primed = false; }
+
+fix16_t GemPitchSmoother_step(
+    struct GemPitchSmoother* smoother, const struct GemPitchSmoothing* smoothing, fix16_t input) {
+    if (!smoother->primed) {
+        smoother->primed = true;
+        smoother->last_input = input;
+        smoother->value = (int64_t)(input) << 16;
+        smoother->rate = 0;
+        return input;
+    }
+
+    fix16_t delta = fix16_sub(input, smoother->last_input);
+    smoother->last_input = input;
+    smoother->rate = lowpass_(smoother->rate, smoothing->rate_alpha, delta);
+
+    fix16_t rate = fix16_abs((fix16_t)(smoother->rate >> 16));
+    fix16_t alpha;
+    if (rate >= smoothing->max_rate) {
+        alpha = smoothing->alphas[GEM_PITCH_SMOOTHING_TABLE_LEN];
+    } else {
+        fix16_t index = fix16_add(smoothing->min_index, fix16_mul(smoothing->sensitivity, rate));
+        int32_t i = index >> 16;
+        if (i >= GEM_PITCH_SMOOTHING_TABLE_LEN) {
+            alpha = smoothing->alphas[GEM_PITCH_SMOOTHING_TABLE_LEN];
+        } else {
+            fix16_t low = smoothing->alphas[i];
+            alpha = fix16_add(low, fix16_mul(fix16_sub(smoothing->alphas[i + 1], low), index & 0xFFFF));
+        }
+    }
+
+    smoother->value = lowpass_(smoother->value, alpha, input);
+    return (fix16_t)((smoother->value + 0x8000) >> 16);
+}
+
+/* Private functions */
+
+/* The one pole filter coefficient for the given cutoff: 2πfΔt / (2πfΔt + 1). */
+static fix16_t calculate_alpha_(fix16_t cutoff) {
+    fix16_t r = fix16_div(fix16_mul(fix16_pi * 2, cutoff), fix16_from_int(GEM_PITCH_SMOOTHING_RATE));
+    return fix16_div(r, fix16_add(r, F16(1)));
+}
+
+/* Moves the state (a fix16_t with 16 more fractional bits) towards the input. */
+static int64_t lowpass_(int64_t state, fix16_t alpha, fix16_t input) {
+    int64_t error = ((int64_t)(input) << 16) - state;
+    return state + ((error >> 16) * alpha);
+}
@@ -0,0 +1,73 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+/*
+    Adaptive smoothing for the pitch CV inputs.
+
+    Even a perfectly steady pitch CV jitters by a few ADC codes, which is
+    heard as a slight warble. This is a fixed-point take on the 1 euro filter
+    (Casiez, Roussel & Vogel, 2012): a one pole low-pass filter whose cutoff
+    rises with how quickly the input is changing. A steady CV is smoothed
+    heavily while jumps and fast modulation pass through with little lag.
+
+    The pitch CV is filtered once per ADC frame, so the time step is a
+    constant, GEM_PITCH_SMOOTHING_RATE. That means the filter's coefficient
+    only depends on the cutoff, so it's read from a table calculated when
+    the settings are loaded. Each step is just a few multiplications, without
+    any divisions.
+*/
+
+#include "fix16.h"
+#include "wntr_ramfunc.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* The table covers cutoffs from 0 Hz to GEM_PITCH_SMOOTHING_MAX_CUTOFF Hz. */
+#define GEM_PITCH_SMOOTHING_TABLE_LEN 64
+#define GEM_PITCH_SMOOTHING_MAX_CUTOFF 640
+
+/* Filter configuration shared by Castor & Pollux, from the settings. */
+struct GemPitchSmoothing {
+    /* The filter coefficient for each cutoff in the table. */
+    fix16_t alphas[GEM_PITCH_SMOOTHING_TABLE_LEN + 1];
+    /* The coefficient used to smooth the input's rate of change. */
+    fix16_t rate_alpha;
+    /* The minimum cutoff, as an index into alphas. */
+    fix16_t min_index;
+    /* How much the index increases with the input's rate of change, in
+       volts per frame. */
+    fix16_t sensitivity;
+    /* The rate of change where the cutoff reaches the end of the table. */
+    fix16_t max_rate;
+};
+
+/* Filter state, one for each input. */
+struct GemPitchSmoother {
+    bool primed;
+    fix16_t last_input;
+    /* The filter's output and the smoothed rate of change, with 16 more
+       fractional bits than fix16_t. Very low cutoffs only move the output
+       by a tiny fraction of the input each step, which would be lost to
+       rounding otherwise. */
+    int64_t value;
+    int64_t rate;
+};
+
+/*
+    Calculates the coefficient table. `min_cutoff` is the cutoff in Hz for a
+    steady input and `sensitivity` is how much it rises, in Hz per volt per
+    second of change.
+*/
+void GemPitchSmoothing_init(struct GemPitchSmoothing* smoothing, fix16_t min_cutoff, fix16_t sensitivity);
+
+/* Forgets the input's history, the next step passes its input straight through. */
+void GemPitchSmoother_reset(struct GemPitchSmoother* smoother);
+
+/* Filters the next input, in volts, and returns the smoothed value. */
+fix16_t GemPitchSmoother_step(
+    struct GemPitchSmoother* smoother, const struct GemPitchSmoothing* smoothing, fix16_t input) RAMFUNC;
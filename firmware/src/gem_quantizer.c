@@ -0,0 +1,65 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#include "gem_quantizer.h"
+
+/* Public functions */
+
+void GemQuantizer_init(struct GemQuantizer* quantizer, uint16_t scale) {
+    scale &= GEM_QUANTIZER_CHROMATIC;
+    if (scale == 0) {
+        scale = GEM_QUANTIZER_CHROMATIC;
+    }
+
+    for (int32_t step = 0; step < GEM_QUANTIZER_STEPS; step++) {
+        // Distances are measured in quarter-semitones from the center of the
+        // step, which is never exactly between two notes so there's no need
+        // to break ties.
+        int32_t center = step * 2 + 1;
+        int32_t nearest = 0;
+        int32_t nearest_distance = INT32_MAX;
+
+        // Check the octaves above and below too, since the nearest note to
+        // the top of the octave may be the next octave's lowest note.
+        for (int32_t note = -12; note < 24; note++) {
+            if (!(scale & (1 << ((note + 12) % 12)))) {
+                continue;
+            }
+            int32_t distance = note * 4 - center;
+            distance = distance < 0 ? -distance : distance;
+            if (distance < nearest_distance) {
+                nearest = note;
+                nearest_distance = distance;
+            }
+        }
+
+        quantizer->notes[step] = fix16_div(fix16_from_int(nearest), F16(12));
+    }
+}
+
+fix16_t GemQuantizer_quantize(const struct GemQuantizer* quantizer, fix16_t pitch) {
+    // The integer part of the pitch is the octave and the fractional part
+    // selects the step within it.
+    fix16_t octave = (fix16_t)((uint32_t)(pitch) & 0xFFFF0000);
+    uint32_t step = (((uint32_t)(pitch) & 0xFFFF) * GEM_QUANTIZER_STEPS) >> 16;
+    return fix16_add(octave, quantizer->notes[step]);
+}
+
+fix16_t GemQuantizer_quantize_hysteresis(
+    const struct GemQuantizer* quantizer, fix16_t pitch, fix16_t previous, fix16_t hysteresis) {
+    fix16_t quantized = GemQuantizer_quantize(quantizer, pitch);
+    if (quantized == previous) {
+        return quantized;
+    }
+
+    // Only leave the previous note if the pitch still quantizes to a
+    // different note after being pulled back towards it.
+    fix16_t pulled_back = pitch > previous ? fix16_sub(pitch, hysteresis) : fix16_add(pitch, hysteresis);
+    if (GemQuantizer_quantize(quantizer, pulled_back) == previous) {
+        return previous;
+    }
+    return quantized;
+}
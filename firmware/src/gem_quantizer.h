@@ -0,0 +1,52 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+/*
+    Quantizes pitch to the notes of a scale.
+
+    A scale is a 12-bit mask of the notes it contains, one bit per semitone
+    with C in the lowest bit. When the settings are loaded the scale is
+    compiled into a table that maps each half-semitone of an octave to the
+    nearest note in the scale. Since the halfway point between any two notes
+    is always a whole or half semitone, the table gives exactly the same
+    result as searching the scale but quantizing only costs a table read and
+    adding back the octave.
+*/
+
+#include "fix16.h"
+#include "wntr_ramfunc.h"
+#include <stdint.h>
+
+/* Half-semitones per octave, see above. */
+#define GEM_QUANTIZER_STEPS 24
+
+/* Scales, see gem_settings.structy's quantizer_scale. */
+#define GEM_QUANTIZER_CHROMATIC 0xFFF
+#define GEM_QUANTIZER_MAJOR 0xAB5
+
+struct GemQuantizer {
+    /* The nearest note (in volts relative to the octave) for each step. This
+       can be negative or a whole octave when the nearest note is in the
+       octave below or above. */
+    fix16_t notes[GEM_QUANTIZER_STEPS];
+};
+
+/* Compiles the table for the given scale. An empty scale is chromatic. */
+void GemQuantizer_init(struct GemQuantizer* quantizer, uint16_t scale);
+
+/* Returns the note in the scale nearest to the given pitch (in volts). */
+fix16_t GemQuantizer_quantize(const struct GemQuantizer* quantizer, fix16_t pitch) RAMFUNC;
+
+/*
+    Like GemQuantizer_quantize(), but stays on the `previous` note until the
+    pitch is at least `hysteresis` volts past the halfway point to another
+    note. This keeps a noisy CV that sits near the boundary between two notes
+    from chattering between them.
+*/
+fix16_t GemQuantizer_quantize_hysteresis(
+    const struct GemQuantizer* quantizer, fix16_t pitch, fix16_t previous, fix16_t hysteresis) RAMFUNC;
@@ -12,6 +12,12 @@
     The ramp table is used to determine the charge voltage to send into the
     ramp core to compensation for amplitude loss as frequency increases. This
     table is written to NVM during calibration.
+
+    The charge voltage needed is proportional to frequency, so it curves
+    upwards between the table's entries. Lookups use monotone cubic
+    (Fritsch-Carlson) interpolation to follow that curve without overshooting
+    between entries. The interpolation coefficients for each entry are
+    calculated up front by gem_ramp_table_update_interpolation().
 */
 
 #include "fix16.h"
@@ -23,12 +29,22 @@ struct GemRampTableEntry {
     fix16_t pitch_cv;
     uint16_t castor_ramp_cv;
     uint16_t pollux_ramp_cv;
+
+    /* Interpolation from this entry to the next one */
+    /* 2^32 divided by the distance to the next entry's pitch_cv. */
+    uint32_t _inv_width;
+    /* Cubic coefficients (t, t^2, t^3) with t from 0 to 1. */
+    int32_t _castor_coeffs[3];
+    int32_t _pollux_coeffs[3];
 };
 
 extern struct GemRampTableEntry gem_ramp_table[];
 extern size_t gem_ramp_table_len;
 
+/* Loads the table from NVM, if it's been saved, and updates the interpolation. */
 void gem_ramp_table_load();
 void gem_ramp_table_save();
 void gem_ramp_table_erase();
+/* Must be called whenever the table's entries change. */
+void gem_ramp_table_update_interpolation();
 uint32_t gem_ramp_table_lookup(uint8_t osc, fix16_t pitch_cv) RAMFUNC;
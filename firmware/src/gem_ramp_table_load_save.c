@@ -5,7 +5,7 @@
 */
 
 #include "gem_ramp_table.h"
-#include "printf.h"
+#include "gem_log.h"
 #include "wntr_assert.h"
 #include "wntr_nvm.h"
 #include "wntr_pack.h"
@@ -37,7 +37,8 @@ void gem_ramp_table_load() {
 
     // NOLINTNEXTLINE(clang-diagnostic-pointer-to-int-cast)
     if ((uint32_t)(&_nvm_lut_length) != sizeof(param_table_load_buf_) / sizeof(param_table_load_buf_[0])) {
-        printf("NVM LUT length is not equal to the NVM LUT buffer!\r\n");
+        GEM_LOG("NVM LUT length is not equal to the NVM LUT buffer!\r\n");
+        gem_ramp_table_update_interpolation();
         return;
     }
 
@@ -45,7 +46,8 @@ void gem_ramp_table_load() {
     wntr_nvm_read((uint32_t)(&_nvm_lut_base_address), param_table_load_buf_, BUFFER_LEN);
 
     if (param_table_load_buf_[BUFFER_LEN - 1] != VALID_TABLE_MARKER) {
-        printf("No valid LUT table.\r\n");
+        GEM_LOG("No valid LUT table.\r\n");
+        gem_ramp_table_update_interpolation();
         return;
     }
 
@@ -57,7 +59,9 @@ void gem_ramp_table_load() {
         checksum ^= gem_ramp_table[table_idx].castor_ramp_cv;
     }
 
-    printf("LUT table loaded from NVM, checksum: %04x\r\n", checksum);
+    GEM_LOG("LUT table loaded from NVM, checksum: %04x\r\n", checksum);
+
+    gem_ramp_table_update_interpolation();
 }
 
 void gem_ramp_table_save() {
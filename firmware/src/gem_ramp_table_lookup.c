@@ -4,67 +4,176 @@
     Full text available at: https://opensource.org/licenses/MIT
 */
 
-#include "gem_math.h"
-#include "gem_oscillator.h"
 #include "gem_ramp_table.h"
-#include <math.h>
 #include <stdbool.h>
 
 /*
     Uses the ramp look-up table to calculate the ramp control voltage for a
     given pitch control voltage.
+
+    Between two entries the ramp control voltage is a cubic in t, the
+    distance from the lower entry to the higher one:
+
+        ramp_cv = y0 + c1 * t + c2 * t^2 + c3 * t^3
+
+    The coefficients come from the slopes at each entry, which are chosen
+    using Fritsch-Carlson's method so that the curve is monotonic: it never
+    dips or overshoots between entries, which would show up as the ramp's
+    amplitude wobbling as the pitch sweeps. Finding the coefficients takes
+    divisions so it's done once whenever the table changes, leaving just a
+    few multiplications for each lookup.
 */
 
+/* t is a Q15 number from 0 to 1. */
+#define T_BITS 15
+
 /* Forward declarations. */
 
-static void find_nearest_pair_from_ramp_table_(
-    fix16_t pitch_cv, struct GemRampTableEntry** low, struct GemRampTableEntry** high) RAMFUNC;
+static int32_t ramp_cv_(const struct GemRampTableEntry* entry, uint8_t osc);
+static int64_t secant_(size_t idx, uint8_t osc);
+static int64_t tangent_(size_t idx, uint8_t osc);
+static void update_coeffs_(struct GemRampTableEntry* entry, uint8_t osc, int64_t width);
+static const struct GemRampTableEntry* find_low_entry_(fix16_t pitch_cv) RAMFUNC;
 
 /* Public functions. */
 
-uint32_t gem_ramp_table_lookup(uint8_t osc, fix16_t pitch_cv) {
-    struct GemRampTableEntry* low = NULL;
-    struct GemRampTableEntry* high = NULL;
+void gem_ramp_table_update_interpolation() {
+    for (size_t i = 0; i < gem_ramp_table_len; i++) {
+        struct GemRampTableEntry* entry = &gem_ramp_table[i];
 
-    find_nearest_pair_from_ramp_table_(pitch_cv, &low, &high);
+        // The last entry and any entries that aren't in increasing order
+        // are flat.
+        int64_t width = 0;
+        if (i + 1 < gem_ramp_table_len) {
+            width = (int64_t)(gem_ramp_table[i + 1].pitch_cv) - entry->pitch_cv;
+        }
+        if (width < 2) {
+            width = 0;
+        }
+
+        entry->_inv_width = width ? (uint32_t)((1ull << 32) / (uint64_t)(width)) : 0;
+        update_coeffs_(entry, 0, width);
+        update_coeffs_(entry, 1, width);
+    }
+}
 
-    uint16_t low_ramp_cv = 0;
-    uint16_t high_ramp_cv = 0;
+uint32_t gem_ramp_table_lookup(uint8_t osc, fix16_t pitch_cv) {
+    const struct GemRampTableEntry* low = find_low_entry_(pitch_cv);
 
+    int32_t ramp_cv;
+    const int32_t* coeffs;
     if (osc == 0) {
-        low_ramp_cv = low->castor_ramp_cv;
-        high_ramp_cv = high->castor_ramp_cv;
+        ramp_cv = low->castor_ramp_cv;
+        coeffs = low->_castor_coeffs;
     } else {
-        low_ramp_cv = low->pollux_ramp_cv;
-        high_ramp_cv = high->pollux_ramp_cv;
+        ramp_cv = low->pollux_ramp_cv;
+        coeffs = low->_pollux_coeffs;
+    }
+
+    // Below the first entry and past the last one are flat.
+    if (pitch_cv <= low->pitch_cv || low->_inv_width == 0) {
+        return (uint32_t)(ramp_cv);
     }
 
-    uint16_t lerp_amount = gem_f16_norm_dist_u16(low->pitch_cv, high->pitch_cv, pitch_cv);
-    uint16_t lerped_cv = (uint16_t)gem_u32_lerp_u16(low_ramp_cv, high_ramp_cv, lerp_amount);
-    return lerped_cv;
+    // pitch_cv is always less than the next entry's pitch_cv, so this is
+    // less than 2^32 and t is less than 1.
+    int32_t t = (int32_t)(((uint32_t)(pitch_cv - low->pitch_cv) * low->_inv_width) >> (32 - T_BITS));
+
+    // This is done in 64 bits so that nothing is rounded until the end,
+    // otherwise rounding can make the result step backwards.
+    int64_t v = coeffs[2];
+    v = ((int64_t)(coeffs[1]) << T_BITS) + v * t;
+    v = ((int64_t)(coeffs[0]) << (2 * T_BITS)) + v * t;
+    ramp_cv += (int32_t)((v * t + (1ll << (3 * T_BITS - 1))) >> (3 * T_BITS));
+
+    return (uint32_t)(ramp_cv);
 };
 
 /* Private functions. */
 
-static void
-find_nearest_pair_from_ramp_table_(fix16_t pitch_cv, struct GemRampTableEntry** low, struct GemRampTableEntry** high) {
-    (*low) = &gem_ramp_table[0];
-    (*high) = &gem_ramp_table[0];
-    struct GemRampTableEntry* current;
-    bool found = false;
+static int32_t ramp_cv_(const struct GemRampTableEntry* entry, uint8_t osc) {
+    return osc == 0 ? entry->castor_ramp_cv : entry->pollux_ramp_cv;
+}
 
-    for (size_t i = 0; i < gem_ramp_table_len; i++) {
-        current = &gem_ramp_table[i];
-        if (current->pitch_cv <= pitch_cv && current->pitch_cv >= (*low)->pitch_cv) {
-            (*low) = current;
-        }
-        if (current->pitch_cv > pitch_cv) {
-            (*high) = current;
-            found = true;
-            break;
-        }
+/* The slope from the entry at idx to the next one in codes per volt, as a Q16 number. */
+static int64_t secant_(size_t idx, uint8_t osc) {
+    const struct GemRampTableEntry* entry = &gem_ramp_table[idx];
+    const struct GemRampTableEntry* next = &gem_ramp_table[idx + 1];
+
+    int64_t width = (int64_t)(next->pitch_cv) - entry->pitch_cv;
+    if (width < 2) {
+        return 0;
     }
-    if (!found) {
-        (*high) = (*low);
+
+    int64_t delta = ramp_cv_(next, osc) - ramp_cv_(entry, osc);
+    return (delta << 32) / width;
+}
+
+/*
+    The slope at the entry at idx. The end entries use the slope of their
+    only segment, the others use the average of the slopes on either side
+    unless the curve changes direction there, in which case it's flat.
+*/
+static int64_t tangent_(size_t idx, uint8_t osc) {
+    if (gem_ramp_table_len < 2) {
+        return 0;
+    }
+    if (idx == 0) {
+        return secant_(0, osc);
+    }
+    if (idx == gem_ramp_table_len - 1) {
+        return secant_(idx - 1, osc);
     }
+
+    int64_t before = secant_(idx - 1, osc);
+    int64_t after = secant_(idx, osc);
+    if ((before > 0 && after > 0) || (before < 0 && after < 0)) {
+        return (before + after) / 2;
+    }
+    return 0;
+}
+
+static void update_coeffs_(struct GemRampTableEntry* entry, uint8_t osc, int64_t width) {
+    int32_t* coeffs = osc == 0 ? entry->_castor_coeffs : entry->_pollux_coeffs;
+    coeffs[0] = 0;
+    coeffs[1] = 0;
+    coeffs[2] = 0;
+
+    if (width == 0) {
+        return;
+    }
+
+    size_t idx = entry - gem_ramp_table;
+    int64_t delta = ramp_cv_(entry + 1, osc) - ramp_cv_(entry, osc);
+    if (delta == 0) {
+        return;
+    }
+
+    // The change in code over the segment if it followed the tangent at
+    // each end.
+    int64_t a = (tangent_(idx, osc) * width + (1ll << 31)) >> 32;
+    int64_t b = (tangent_(idx + 1, osc) * width + (1ll << 31)) >> 32;
+
+    // Fritsch-Carlson's condition for monotonicity. This uses the simpler
+    // box constraint: each tangent has the same sign as the segment and is
+    // at most three times its slope.
+    int64_t limit = delta > 0 ? 3 * delta : -3 * delta;
+    if (delta > 0) {
+        a = a < 0 ? 0 : (a > limit ? limit : a);
+        b = b < 0 ? 0 : (b > limit ? limit : b);
+    } else {
+        a = a > 0 ? 0 : (a < -limit ? -limit : a);
+        b = b > 0 ? 0 : (b < -limit ? -limit : b);
+    }
+
+    // Hermite basis functions expanded into powers of t.
+    coeffs[0] = (int32_t)(a);
+    coeffs[1] = (int32_t)(3 * delta - 2 * a - b);
+    coeffs[2] = (int32_t)(a + b - 2 * delta);
+}
+
+static const struct GemRampTableEntry* find_low_entry_(fix16_t pitch_cv) {
+    size_t i = 0;
+    while (i + 1 < gem_ramp_table_len && gem_ramp_table[i + 1].pitch_cv <= pitch_cv) { i++; }
+    return &gem_ramp_table[i];
 }
@@ -0,0 +1,70 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#include "gem_ramp_table_transfer.h"
+#include "gem_crc32.h"
+#include "wntr_pack.h"
+
+/* Public functions */
+
+size_t gem_ramp_table_pack_chunk(
+    const struct GemRampTableEntry* table, size_t table_len, uint8_t start, uint8_t count, uint8_t* buf) {
+    if (start >= table_len) {
+        count = 0;
+    } else if (count > table_len - start) {
+        count = table_len - start;
+    }
+    if (count > GEM_RAMP_TABLE_CHUNK_MAX_ENTRIES) {
+        count = GEM_RAMP_TABLE_CHUNK_MAX_ENTRIES;
+    }
+
+    buf[0] = start;
+    buf[1] = count;
+
+    for (size_t i = 0; i < count; i++) {
+        const struct GemRampTableEntry* entry = &table[start + i];
+        WNTR_PACK_16(entry->castor_ramp_cv, buf, 2 + i * 4);
+        WNTR_PACK_16(entry->pollux_ramp_cv, buf, 2 + i * 4 + 2);
+    }
+
+    size_t crc_offset = GEM_RAMP_TABLE_CHUNK_SIZE(count) - 4;
+    uint32_t crc = gem_crc32(0, buf, crc_offset);
+    WNTR_PACK_32(crc, buf, crc_offset);
+
+    return GEM_RAMP_TABLE_CHUNK_SIZE(count);
+}
+
+enum GemRampTableChunkResult
+gem_ramp_table_unpack_chunk(struct GemRampTableEntry* table, size_t table_len, const uint8_t* buf, size_t len) {
+    if (len < GEM_RAMP_TABLE_CHUNK_SIZE(0)) {
+        return GEM_RAMP_TABLE_CHUNK_ERR_LENGTH;
+    }
+
+    size_t start = buf[0];
+    size_t count = buf[1];
+
+    if (count > GEM_RAMP_TABLE_CHUNK_MAX_ENTRIES || len != GEM_RAMP_TABLE_CHUNK_SIZE(count)) {
+        return GEM_RAMP_TABLE_CHUNK_ERR_LENGTH;
+    }
+
+    size_t crc_offset = len - 4;
+    uint32_t expected_crc = (uint32_t)(WNTR_UNPACK_32(buf, crc_offset));
+    if (gem_crc32(0, buf, crc_offset) != expected_crc) {
+        return GEM_RAMP_TABLE_CHUNK_ERR_CRC;
+    }
+
+    if (start + count > table_len) {
+        return GEM_RAMP_TABLE_CHUNK_ERR_RANGE;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        struct GemRampTableEntry* entry = &table[start + i];
+        entry->castor_ramp_cv = WNTR_UNPACK_16(buf, 2 + i * 4);
+        entry->pollux_ramp_cv = WNTR_UNPACK_16(buf, 2 + i * 4 + 2);
+    }
+
+    return GEM_RAMP_TABLE_CHUNK_OK;
+}
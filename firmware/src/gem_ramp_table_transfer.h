@@ -0,0 +1,47 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+/*
+    Packs and unpacks chunks of the ramp table for bulk transfer over SysEx.
+
+    Each chunk is serialized as:
+
+        START(1) COUNT(1) (CASTOR_CODE(2) POLLUX_CODE(2)) * COUNT CRC32(4)
+
+    All values are big-endian and the CRC covers everything before it. A
+    chunk is only applied to the table if it's entirely valid, so a corrupted
+    transfer never leaves the table half-written.
+*/
+
+#include "gem_ramp_table.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/* Keeps a teeth-encoded chunk well within the SysEx receive buffer. */
+#define GEM_RAMP_TABLE_CHUNK_MAX_ENTRIES 16
+#define GEM_RAMP_TABLE_CHUNK_SIZE(count) (2 + (count) * 4 + 4)
+#define GEM_RAMP_TABLE_CHUNK_MAX_SIZE GEM_RAMP_TABLE_CHUNK_SIZE(GEM_RAMP_TABLE_CHUNK_MAX_ENTRIES)
+
+enum GemRampTableChunkResult {
+    GEM_RAMP_TABLE_CHUNK_OK = 0,
+    GEM_RAMP_TABLE_CHUNK_ERR_LENGTH = 1,
+    GEM_RAMP_TABLE_CHUNK_ERR_CRC = 2,
+    GEM_RAMP_TABLE_CHUNK_ERR_RANGE = 3,
+};
+
+/*
+    Packs up to `count` entries starting at `start` into `buf`, which must be
+    at least GEM_RAMP_TABLE_CHUNK_MAX_SIZE bytes. The count is limited to the
+    entries that are actually in the table. Returns the packed length.
+*/
+size_t gem_ramp_table_pack_chunk(
+    const struct GemRampTableEntry* table, size_t table_len, uint8_t start, uint8_t count, uint8_t* buf);
+
+/* Checks the chunk in `buf` and, if it's valid, copies its entries into the table. */
+enum GemRampTableChunkResult
+gem_ramp_table_unpack_chunk(struct GemRampTableEntry* table, size_t table_len, const uint8_t* buf, size_t len);
@@ -6,10 +6,12 @@
 
 #include "gem_settings_load_save.h"
 #include "gem_config.h"
-#include "printf.h"
+#include "gem_log.h"
+#include "gem_nvm_journal.h"
 #include "sam.h"
 #include "wntr_assert.h"
 #include "wntr_nvm.h"
+#include <assert.h>
 #include <stdarg.h>
 
 #define SETTINGS_MARKER_V1 0x65
@@ -17,8 +19,11 @@
 #define SETTINGS_MARKER_V3 0x67
 #define SETTINGS_MARKER_V4 0x68
 #define SETTINGS_MARKER_V5 0x69
+#define SETTINGS_MARKER_V6 0x6A
+#define SETTINGS_MARKER_V7 0x6B
+#define SETTINGS_MARKER_V8 0x6C
 #define SETTINGS_MARKER_MIN SETTINGS_MARKER_V1
-#define SETTINGS_MARKER_MAX SETTINGS_MARKER_V5
+#define SETTINGS_MARKER_MAX SETTINGS_MARKER_V8
 
 #define LIMIT_F16_FIELD(field, min, max)                                                                               \
     if (settings->field < F16(min) || settings->field > F16(max)) {                                                    \
@@ -32,8 +37,29 @@
 
 #define DEFAULT_FIELD(field) settings->field = defaults.field;
 
+/* Each saved copy of the settings takes up two pages in the journal. */
+#define SETTINGS_RECORD_SIZE (WNTR_NVM_PAGE_SIZE * 2)
+#define SETTINGS_DATA_LEN (GEMSETTINGS_PACKED_SIZE + 1)
+
+static_assert(
+    SETTINGS_DATA_LEN <= SETTINGS_RECORD_SIZE - GEM_NVM_JOURNAL_RECORD_OVERHEAD,
+    "Settings no longer fit in a journal record, increase SETTINGS_RECORD_SIZE.");
+
+extern uint8_t _nvm_settings_journal_base_address;
+extern uint8_t _nvm_settings_journal_length;
 extern uint8_t _nvm_settings_base_address;
 
+struct GemSettings gem_settings_cache;
+
+static struct GemNVMJournal journal_;
+static bool journal_ready_ = false;
+static bool cache_dirty_ = false;
+
+/* Forward declarations */
+
+static void setup_journal_();
+static bool load_legacy_(uint8_t* data);
+
 bool GemSettings_check(uint8_t marker, struct GemSettings* settings) {
     /* This can't be fixed. If the ADC stuff is out of whack we gotta fail. */
     if (settings->adc_gain_corr < 512 || settings->adc_gain_corr > 4096) {
@@ -58,14 +84,14 @@ bool GemSettings_check(uint8_t marker, struct GemSettings* settings) {
 
     /* V2 added base_cv_offset field. */
     if (marker < SETTINGS_MARKER_V2) {
-        printf("Upgrading settings from v1 to v2.\n");
+        GEM_LOG("Upgrading settings from v1 to v2.\n");
         DEFAULT_FIELD(base_cv_offset);
     }
     LIMIT_F16_FIELD(base_cv_offset, 0.0, 5.0);
 
     /* V3 added several lfo options. */
     if (marker < SETTINGS_MARKER_V3) {
-        printf("Upgrading settings from v2 to v3.\n");
+        GEM_LOG("Upgrading settings from v2 to v3.\n");
         DEFAULT_FIELD(lfo_2_frequency_ratio)
         DEFAULT_FIELD(lfo_1_waveshape)
         DEFAULT_FIELD(lfo_2_waveshape)
@@ -80,38 +106,74 @@ bool GemSettings_check(uint8_t marker, struct GemSettings* settings) {
 
     /* V4 added pulse width bitmask */
     if (marker < SETTINGS_MARKER_V4) {
-        printf("Upgrading settings from v3 to v4.\n");
+        GEM_LOG("Upgrading settings from v3 to v4.\n");
         DEFAULT_FIELD(pulse_width_bitmask);
     }
 
     /* V5 added osc8m_freq, zero_detection_enabled, and quantization_enabled */
     if (marker < SETTINGS_MARKER_V5) {
-        printf("Upgrading settings from v4 to v5.\n");
+        GEM_LOG("Upgrading settings from v4 to v5.\n");
         DEFAULT_FIELD(osc8m_freq);
         DEFAULT_FIELD(zero_detection_enabled);
         DEFAULT_FIELD(quantization_enabled);
     }
 
+    /* V6 added MIDI pitch control */
+    if (marker < SETTINGS_MARKER_V6) {
+        GEM_LOG("Upgrading settings from v5 to v6.\n");
+        DEFAULT_FIELD(castor_midi_channel);
+        DEFAULT_FIELD(pollux_midi_channel);
+        DEFAULT_FIELD(midi_pitch_bend_range);
+        DEFAULT_FIELD(midi_replaces_cv);
+    }
+    LIMIT_INT_FIELD(castor_midi_channel, 0, 16);
+    LIMIT_INT_FIELD(pollux_midi_channel, 0, 16);
+    LIMIT_INT_FIELD(midi_pitch_bend_range, 0, 24);
+
+    /* V7 added quantizer scales */
+    if (marker < SETTINGS_MARKER_V7) {
+        GEM_LOG("Upgrading settings from v6 to v7.\n");
+        DEFAULT_FIELD(quantizer_scale);
+        DEFAULT_FIELD(fine_quantization_enabled);
+    }
+    LIMIT_INT_FIELD(quantizer_scale, 0, 0xFFF);
+
+    /* V8 added pitch CV smoothing */
+    if (marker < SETTINGS_MARKER_V8) {
+        GEM_LOG("Upgrading settings from v7 to v8.\n");
+        DEFAULT_FIELD(castor_pitch_smoothing);
+        DEFAULT_FIELD(pollux_pitch_smoothing);
+        DEFAULT_FIELD(pitch_smoothing_min_cutoff);
+        DEFAULT_FIELD(pitch_smoothing_sensitivity);
+    }
+    LIMIT_F16_FIELD(pitch_smoothing_min_cutoff, 0.1, 100.0);
+    LIMIT_F16_FIELD(pitch_smoothing_sensitivity, 0.0, 50.0);
+
     return true;
 
 fail:
-    printf("Invalid settings data:\n");
-    GemSettings_print(settings);
-    printf("Resetting to defaults.\n");
+    GEM_LOG("Invalid settings data, resetting to defaults.\n");
     GemSettings_init(settings);
     return false;
 }
 
 bool GemSettings_load(struct GemSettings* settings) {
-    uint8_t data[GEMSETTINGS_PACKED_SIZE + 1];
+    uint8_t data[SETTINGS_DATA_LEN];
 
-    // NOLINTNEXTLINE(clang-diagnostic-pointer-to-int-cast)
-    wntr_nvm_read((uint32_t)(&_nvm_settings_base_address), data, GEMSETTINGS_PACKED_SIZE + 1);
+    setup_journal_();
+
+    if (!GemNVMJournal_read(&journal_, data, SETTINGS_DATA_LEN)) {
+        if (!load_legacy_(data)) {
+            GEM_LOG("No saved settings.\n");
+            goto fail;
+        }
+        GEM_LOG("Loading settings saved by older firmware.\n");
+    }
 
     uint8_t marker = data[0];
 
     if (marker < SETTINGS_MARKER_MIN || marker > SETTINGS_MARKER_MAX) {
-        printf("Invalid settings marker.\n");
+        GEM_LOG("Invalid settings marker.\n");
         goto fail;
     }
 
@@ -121,17 +183,17 @@ bool GemSettings_load(struct GemSettings* settings) {
         return GemSettings_check(marker, settings);
     }
 
-    printf("Failed to load settings.\n");
+    GEM_LOG("Failed to load settings.\n");
 
 fail:
-    printf("Loading default settings.\n");
+    GEM_LOG("Loading default settings.\n");
     GemSettings_init(settings);
     return false;
 }
 
 void GemSettings_save(struct GemSettings* settings) {
-    uint8_t data[GEMSETTINGS_PACKED_SIZE + 1];
-    data[0] = SETTINGS_MARKER_V5;
+    uint8_t data[SETTINGS_DATA_LEN];
+    data[0] = SETTINGS_MARKER_V8;
 
     GemSettings_check(data[0], settings);
 
@@ -140,16 +202,77 @@ void GemSettings_save(struct GemSettings* settings) {
     /* This should basically never happen with structy, but assert it anyway. */
     WNTR_ASSERT(result.status == STRUCTY_RESULT_OKAY);
 
-    // NOLINTNEXTLINE(clang-diagnostic-pointer-to-int-cast)
-    wntr_nvm_write((uint32_t)(&_nvm_settings_base_address), data, GEMSETTINGS_PACKED_SIZE + 1);
+    setup_journal_();
 
-    printf("Saved settings: \n");
-    GemSettings_print(settings);
+    if (!GemNVMJournal_append(&journal_, data, SETTINGS_DATA_LEN)) {
+        GEM_LOG("Failed to save settings!\n");
+        return;
+    }
+
+    GEM_LOG("Saved settings.\n");
 }
 
 void GemSettings_erase() {
-    /* Just erase the marker byte. */
+    setup_journal_();
+    GemNVMJournal_erase(&journal_);
+
+    /* Also erase the legacy marker byte, otherwise the old settings would be
+       loaded again. */
     uint8_t data[1] = {0xFF};
     // NOLINTNEXTLINE(clang-diagnostic-pointer-to-int-cast)
     wntr_nvm_write((uint32_t)(&_nvm_settings_base_address), data, 1);
 }
+
+void gem_settings_cache_load() {
+    GemSettings_load(&gem_settings_cache);
+    cache_dirty_ = false;
+}
+
+void gem_settings_cache_mark_dirty() { cache_dirty_ = true; }
+
+bool gem_settings_cache_dirty() { return cache_dirty_; }
+
+bool gem_settings_cache_commit() {
+    if (!cache_dirty_) {
+        return false;
+    }
+
+    GemSettings_save(&gem_settings_cache);
+    cache_dirty_ = false;
+    return true;
+}
+
+void gem_settings_cache_erase() {
+    GemSettings_erase();
+    GemSettings_init(&gem_settings_cache);
+    cache_dirty_ = false;
+}
+
+/* Private functions */
+
+static void setup_journal_() {
+    if (journal_ready_) {
+        return;
+    }
+
+    GemNVMJournal_init(
+        &journal_,
+        // NOLINTNEXTLINE(clang-diagnostic-pointer-to-int-cast)
+        (uint32_t)(&_nvm_settings_journal_base_address),
+        // NOLINTNEXTLINE(clang-diagnostic-pointer-to-int-cast)
+        (size_t)(&_nvm_settings_journal_length),
+        SETTINGS_RECORD_SIZE);
+
+    journal_ready_ = true;
+}
+
+/*
+    Firmware before the settings journal was added stored a single copy of the
+    settings at a fixed location. It's only read if the journal is empty, the
+    next save moves the settings into the journal.
+*/
+static bool load_legacy_(uint8_t* data) {
+    // NOLINTNEXTLINE(clang-diagnostic-pointer-to-int-cast)
+    wntr_nvm_read((uint32_t)(&_nvm_settings_base_address), data, SETTINGS_DATA_LEN);
+    return data[0] != 0xFF;
+}
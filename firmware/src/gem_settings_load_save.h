@@ -16,3 +16,22 @@
 bool GemSettings_load(struct GemSettings* settings);
 void GemSettings_save(struct GemSettings* settings);
 void GemSettings_erase();
+
+/*
+    The in-RAM copy of the settings shared by main.c and the SysEx commands.
+
+    It's loaded from NVM once at startup and only written back by
+    gem_settings_cache_commit(), so commands that read or tweak individual
+    settings don't have to load, check, and save the whole thing each time.
+    Anything that changes it must call gem_settings_cache_mark_dirty().
+*/
+extern struct GemSettings gem_settings_cache;
+
+/* Loads the cache from NVM, discarding uncommitted changes. */
+void gem_settings_cache_load();
+void gem_settings_cache_mark_dirty();
+bool gem_settings_cache_dirty();
+/* Saves the cache to NVM if it's changed. Returns true if it was saved. */
+bool gem_settings_cache_commit();
+/* Erases the settings in NVM and resets the cache to the defaults. */
+void gem_settings_cache_erase();
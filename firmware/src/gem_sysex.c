@@ -6,19 +6,27 @@
 
 #include "gem_sysex.h"
 #include "gem_adc.h"
+#include "gem_boot_profile.h"
 #include "gem_config.h"
+#include "gem_fw_swap.h"
+#include "gem_fw_update.h"
 #include "gem_led_animation.h"
+#include "gem_log.h"
 #include "gem_math.h"
 #include "gem_mcp4728.h"
+#include "gem_memory.h"
 #include "gem_pulseout.h"
 #include "gem_ramp_table.h"
+#include "gem_ramp_table_transfer.h"
+#include "gem_sample_stats.h"
 #include "gem_settings.h"
 #include "gem_settings_load_save.h"
-#include "printf.h"
+#include "gem_trace.h"
 #include "teeth.h"
 #include "wntr_assert.h"
 #include "wntr_bootloader.h"
 #include "wntr_build_info.h"
+#include "wntr_delay.h"
 #include "wntr_midi_core.h"
 #include "wntr_midi_sysex_dispatcher.h"
 #include "wntr_pack.h"
@@ -30,17 +38,18 @@
 /* Macros & defs */
 
 #ifdef DEBUG
-#define debug_printf(...) printf(__VA_ARGS__)
+#define debug_log(...) GEM_LOG(__VA_ARGS__)
 #else
-#define debug_printf(...)
+#define debug_log(...)
 #endif
 
 #define SETTINGS_ENCODED_LEN TEETH_ENCODED_LENGTH(GEMSETTINGS_PACKED_SIZE)
+#define ADC_STATS_PACKED_SIZE 12
 #define ARRAY_LEN(array) (sizeof(array) / sizeof(array[0]))
 
 #define DECODE_TEETH_REQUEST(size)                                                                                     \
     WNTR_ASSERT(len == TEETH_ENCODED_LENGTH(size));                                                                    \
-    uint8_t request[size];                                                                                             \
+    uint8_t request[TEETH_DECODED_LENGTH(TEETH_ENCODED_LENGTH(size))];                                                 \
     teeth_decode(data, TEETH_ENCODED_LENGTH(size), request);
 
 #define RESPONSE_0(command) wntr_midi_send_sysex((uint8_t[2]){WNTR_MIDI_SYSEX_IDENTIFIER, command}, 2);
@@ -59,14 +68,25 @@
     WNTR_ASSERT(len + 2 <= ARRAY_LEN(_full_response));                                                                 \
     wntr_midi_send_sysex(_full_response, len + 2);
 
+/* Teeth encodes the response as it's sent, so it doesn't need an encoded copy. */
+#define SEND_TEETH_RESPONSE(command, data, len)                                                                        \
+    wntr_midi_send_sysex_teeth((uint8_t[2]){WNTR_MIDI_SYSEX_IDENTIFIER, command}, 2, data, len);
+
 /* Static variables. */
 
 static uint8_t hw_ver_;
 const struct GemADCInput* adc_inputs_;
 const struct GemI2CConfig* i2c_;
 struct GemPulseOutConfig* pulse_;
+static gem_sysex_settings_callback settings_callback_ = NULL;
 static bool monitor_enabled_ = false;
 static uint32_t last_monitor_update_ = 0;
+static struct GemFwUpdate fw_update_;
+
+/* Defined in the linker script, see scripts/samd21g18a.ld */
+extern uint8_t _fw_app_base_address;
+extern uint8_t _fw_staging_base_address;
+extern uint8_t _fw_staging_length;
 
 /* Forward declarations. */
 
@@ -86,10 +106,24 @@ static void cmd_0x10_monitor_(const uint8_t* data, size_t len);
 static void cmd_0x11_soft_reset_(const uint8_t* data, size_t len);
 static void cmd_0x12_enter_calibration_mode_(const uint8_t* data, size_t len);
 static void cmd_0x13_reset_into_bootloader_(const uint8_t* data, size_t len);
+static void cmd_0x14_read_adc_stats_(const uint8_t* data, size_t len);
+static void cmd_0x15_read_adc_stats_multi_(const uint8_t* data, size_t len);
+static void cmd_0x16_write_lut_chunk_(const uint8_t* data, size_t len);
+static void cmd_0x17_read_lut_chunk_(const uint8_t* data, size_t len);
 static void cmd_0x18_read_settings_(const uint8_t* data, size_t len);
 static void cmd_0x19_write_settings_(const uint8_t* data, size_t len);
+static void cmd_0x1A_read_memory_usage_(const uint8_t* data, size_t len);
+static void cmd_0x1B_arm_trace_(const uint8_t* data, size_t len);
+static void cmd_0x1C_read_trace_(const uint8_t* data, size_t len);
+static void cmd_0x1D_read_boot_profile_(const uint8_t* data, size_t len);
+static void cmd_0x1E_begin_fw_update_(const uint8_t* data, size_t len);
+static void cmd_0x1F_write_fw_chunk_(const uint8_t* data, size_t len);
 static void cmd_0x20_set_frequency_(const uint8_t* data, size_t len);
 static void cmd_0x21_set_osc8m_freq_(const uint8_t* data, size_t len);
+static void cmd_0x22_finish_fw_update_(const uint8_t* data, size_t len);
+static void cmd_0x23_apply_fw_update_(const uint8_t* data, size_t len);
+static void cmd_0x24_commit_settings_(const uint8_t* data, size_t len);
+static void measure_adc_stats_(uint8_t channel, uint16_t samples, uint16_t settle_us, uint8_t* out);
 
 /* Public functions. */
 
@@ -104,6 +138,12 @@ void gem_sysex_init(
     i2c_ = i2c;
     pulse_ = pulse;
 
+    GemFwUpdate_init(
+        &fw_update_,
+        (uint32_t)(&_fw_staging_base_address),
+        (size_t)(&_fw_staging_length),
+        (uint32_t)(&_fw_app_base_address));
+
     wntr_midi_register_sysex_command(0x01, cmd_0x01_hello_);
     wntr_midi_register_sysex_command(0x02, cmd_0x02_write_adc_gain_);
     wntr_midi_register_sysex_command(0x03, cmd_0x03_write_adc_offset_);
@@ -120,12 +160,27 @@ void gem_sysex_init(
     wntr_midi_register_sysex_command(0x11, cmd_0x11_soft_reset_);
     wntr_midi_register_sysex_command(0x12, cmd_0x12_enter_calibration_mode_);
     wntr_midi_register_sysex_command(0x13, cmd_0x13_reset_into_bootloader_);
+    wntr_midi_register_sysex_command(0x14, cmd_0x14_read_adc_stats_);
+    wntr_midi_register_sysex_command(0x15, cmd_0x15_read_adc_stats_multi_);
+    wntr_midi_register_sysex_command(0x16, cmd_0x16_write_lut_chunk_);
+    wntr_midi_register_sysex_command(0x17, cmd_0x17_read_lut_chunk_);
     wntr_midi_register_sysex_command(0x18, cmd_0x18_read_settings_);
     wntr_midi_register_sysex_command(0x19, cmd_0x19_write_settings_);
+    wntr_midi_register_sysex_command(0x1A, cmd_0x1A_read_memory_usage_);
+    wntr_midi_register_sysex_command(0x1B, cmd_0x1B_arm_trace_);
+    wntr_midi_register_sysex_command(0x1C, cmd_0x1C_read_trace_);
+    wntr_midi_register_sysex_command(0x1D, cmd_0x1D_read_boot_profile_);
+    wntr_midi_register_sysex_command(0x1E, cmd_0x1E_begin_fw_update_);
+    wntr_midi_register_sysex_command(0x1F, cmd_0x1F_write_fw_chunk_);
     wntr_midi_register_sysex_command(0x20, cmd_0x20_set_frequency_);
     wntr_midi_register_sysex_command(0x21, cmd_0x21_set_osc8m_freq_);
+    wntr_midi_register_sysex_command(0x22, cmd_0x22_finish_fw_update_);
+    wntr_midi_register_sysex_command(0x23, cmd_0x23_apply_fw_update_);
+    wntr_midi_register_sysex_command(0x24, cmd_0x24_commit_settings_);
 };
 
+void gem_sysex_set_settings_callback(gem_sysex_settings_callback callback) { settings_callback_ = callback; }
+
 bool gem_sysex_monitor_enabled() { return monitor_enabled_; }
 
 void gem_sysex_send_monitor_update(struct GemMonitorUpdate* update) {
@@ -143,9 +198,7 @@ void gem_sysex_send_monitor_update(struct GemMonitorUpdate* update) {
     uint8_t update_buf[GEMMONITORUPDATE_PACKED_SIZE];
     GemMonitorUpdate_pack(update, update_buf);
 
-    PREPARE_RESPONSE(0x10, TEETH_ENCODED_LENGTH(ARRAY_LEN(update_buf)));
-    teeth_encode(update_buf, ARRAY_LEN(update_buf), response);
-    SEND_RESPONSE();
+    SEND_TEETH_RESPONSE(0x10, update_buf, ARRAY_LEN(update_buf));
 }
 
 /* Private functions. */
@@ -170,35 +223,27 @@ static void cmd_0x01_hello_(const uint8_t* data, size_t len) {
     memccpy(response, build_info, 0, build_info_len);
     SEND_RESPONSE_LEN(build_info_len);
 
-    debug_printf("SysEx 0x01: Hello! Build info length: %u\n", build_info_len);
+    debug_log("SysEx 0x01: Hello! Build info length: %u\n", build_info_len);
 }
 
 static void cmd_0x02_write_adc_gain_(const uint8_t* data, size_t len) {
     /* Request (teeth): GAIN(2) */
     DECODE_TEETH_REQUEST(2);
 
-    struct GemSettings settings;
-    GemSettings_load(&settings);
+    gem_settings_cache.adc_gain_corr = WNTR_UNPACK_16(request, 0);
+    gem_settings_cache_mark_dirty();
 
-    settings.adc_gain_corr = WNTR_UNPACK_16(request, 0);
-
-    GemSettings_save(&settings);
-
-    debug_printf("SysEx 0x02: Set ADC gain to %u\n", settings.adc_gain_corr);
+    debug_log("SysEx 0x02: Set ADC gain to %u\n", gem_settings_cache.adc_gain_corr);
 }
 
 static void cmd_0x03_write_adc_offset_(const uint8_t* data, size_t len) {
     /* Request (teeth): OFFSET(2) */
     DECODE_TEETH_REQUEST(2);
 
-    struct GemSettings settings;
-    GemSettings_load(&settings);
-
-    settings.adc_offset_corr = WNTR_UNPACK_16(request, 0);
+    gem_settings_cache.adc_offset_corr = WNTR_UNPACK_16(request, 0);
+    gem_settings_cache_mark_dirty();
 
-    GemSettings_save(&settings);
-
-    debug_printf("SysEx 0x03: Set ADC offset to %u\n", settings.adc_offset_corr);
+    debug_log("SysEx 0x03: Set ADC offset to %u\n", gem_settings_cache.adc_offset_corr);
 }
 
 static void cmd_0x04_read_adc_(const uint8_t* data, size_t len) {
@@ -209,15 +254,11 @@ static void cmd_0x04_read_adc_(const uint8_t* data, size_t len) {
     uint8_t channel = data[0];
     uint16_t result = gem_adc_read_sync(&adc_inputs_[channel]);
 
-    PREPARE_RESPONSE(0x04, TEETH_ENCODED_LENGTH(2));
-
     uint8_t unencoded_response[2];
     WNTR_PACK_16(result, unencoded_response, 0);
-    teeth_encode(unencoded_response, 2, response);
-
-    SEND_RESPONSE();
+    SEND_TEETH_RESPONSE(0x04, unencoded_response, 2);
 
-    debug_printf("SysEx 0x04: Read ADC channel %u, value %u\n", channel, result);
+    debug_log("SysEx 0x04: Read ADC channel %u, value %u\n", channel, result);
 }
 
 static void cmd_0x05_set_dac_(const uint8_t* data, size_t len) {
@@ -244,16 +285,16 @@ static void cmd_0x05_set_dac_(const uint8_t* data, size_t len) {
             .value = d,
         });
 
-    debug_printf("SysEx 0x04: Set DACs to %u, %u, %u, %u. Result: %u\n", a, b, c, d, res);
+    debug_log("SysEx 0x04: Set DACs to %u, %u, %u, %u. Result: %u\n", a, b, c, d, res);
 }
 
 static void cmd_0x07_erase_settings_(const uint8_t* data, size_t len) {
     (void)(data);
     (void)(len);
 
-    GemSettings_erase();
+    gem_settings_cache_erase();
 
-    debug_printf("SysEx 0x07: Erased settings\n");
+    debug_log("SysEx 0x07: Erased settings\n");
 }
 
 static void cmd_0x18_read_settings_(const uint8_t* data, size_t len) {
@@ -261,16 +302,12 @@ static void cmd_0x18_read_settings_(const uint8_t* data, size_t len) {
     (void)(data);
     (void)(len);
 
-    struct GemSettings settings;
     uint8_t settings_buf[GEMSETTINGS_PACKED_SIZE];
-    GemSettings_load(&settings);
-    GemSettings_pack(&settings, settings_buf);
+    GemSettings_pack(&gem_settings_cache, settings_buf);
 
-    PREPARE_RESPONSE(0x18, TEETH_ENCODED_LENGTH(GEMSETTINGS_PACKED_SIZE));
-    teeth_encode(settings_buf, GEMSETTINGS_PACKED_SIZE, response);
-    SEND_RESPONSE();
+    SEND_TEETH_RESPONSE(0x18, settings_buf, GEMSETTINGS_PACKED_SIZE);
 
-    debug_printf(
+    debug_log(
         "SysEx 0x18: Read settings, packed size: %u, encoded size: %u\n",
         GEMSETTINGS_PACKED_SIZE,
         TEETH_ENCODED_LENGTH(GEMSETTINGS_PACKED_SIZE));
@@ -280,18 +317,31 @@ static void cmd_0x19_write_settings_(const uint8_t* data, size_t len) {
     /* Request (teeth): serialized settings */
     DECODE_TEETH_REQUEST(GEMSETTINGS_PACKED_SIZE);
 
+    /* Response: APPLIED(1) */
     struct GemSettings settings;
+    bool applied = false;
 
     if (GemSettings_unpack(&settings, request).status == STRUCTY_RESULT_OKAY) {
-        GemSettings_save(&settings);
+        // The editor expects these to be saved right away, so this commits
+        // along with any other uncommitted changes.
+        gem_settings_cache = settings;
+        gem_settings_cache_mark_dirty();
+        gem_settings_cache_commit();
+
+        // Let the main loop pick up the new settings so the editor doesn't
+        // have to reset the module.
+        if (settings_callback_ != NULL) {
+            settings_callback_();
+            applied = true;
+        }
     } else {
-        debug_printf("Failed to save settings, unable to deserialize.\n");
+        debug_log("Failed to save settings, unable to deserialize.\n");
     }
 
-    /* Ack the data. */
-    RESPONSE_0(0x19);
+    /* Ack the data. Older firmware sent an empty ack and needed a reset. */
+    RESPONSE_1(0x19, applied ? 1 : 0);
 
-    debug_printf("SysEx 0x19: Wrote settings\n");
+    debug_log("SysEx 0x19: Wrote settings\n");
 }
 
 static void cmd_0x0A_write_lut_entry_(const uint8_t* data, size_t len) {
@@ -308,11 +358,12 @@ static void cmd_0x0A_write_lut_entry_(const uint8_t* data, size_t len) {
 
     gem_ramp_table[entry].castor_ramp_cv = castor_code;
     gem_ramp_table[entry].pollux_ramp_cv = pollux_code;
+    gem_ramp_table_update_interpolation();
 
     /* Acknowledge the message. */
     RESPONSE_0(0x0A);
 
-    debug_printf(
+    debug_log(
         "SysEX 0x0A: Set LUT entry %u to pitch_cv=UNUSED, castor_ramp_cv=%u, pollux_ramp_cv=%u\n",
         entry,
         castor_code,
@@ -325,7 +376,7 @@ static void cmd_0x0B_write_lut_(const uint8_t* data, size_t len) {
 
     gem_ramp_table_save();
 
-    debug_printf("SysEx 0x0B: Saved LUT table to NVRAM\n");
+    debug_log("SysEx 0x0B: Saved LUT table to NVRAM\n");
 }
 
 static void cmd_0x0C_erase_lut_(const uint8_t* data, size_t len) {
@@ -334,7 +385,7 @@ static void cmd_0x0C_erase_lut_(const uint8_t* data, size_t len) {
 
     gem_ramp_table_erase();
 
-    debug_printf("SysEx 0x0B: Erased LUT table from NVRAM\n");
+    debug_log("SysEx 0x0B: Erased LUT table from NVRAM\n");
 }
 
 static void cmd_0x0D_disable_adc_corr_(const uint8_t* data, size_t len) {
@@ -343,18 +394,16 @@ static void cmd_0x0D_disable_adc_corr_(const uint8_t* data, size_t len) {
 
     gem_adc_set_error_correction(2048, 0);
 
-    debug_printf("SysEx 0x0D: ADC hardware error correction disabled.\n");
+    debug_log("SysEx 0x0D: ADC hardware error correction disabled.\n");
 }
 
 static void cmd_0x0E_enable_adc_corr_(const uint8_t* data, size_t len) {
     (void)(data);
     (void)(len);
 
-    struct GemSettings settings;
-    GemSettings_load(&settings);
-    gem_adc_set_error_correction(settings.adc_gain_corr, settings.adc_offset_corr);
+    gem_adc_set_error_correction(gem_settings_cache.adc_gain_corr, gem_settings_cache.adc_offset_corr);
 
-    debug_printf("SysEx 0x0e: ADC hardware error correction enabled.\n");
+    debug_log("SysEx 0x0e: ADC hardware error correction enabled.\n");
 }
 
 static void cmd_0x0F_get_serial_no_(const uint8_t* data, size_t len) {
@@ -364,18 +413,14 @@ static void cmd_0x0F_get_serial_no_(const uint8_t* data, size_t len) {
 
     const size_t raw_response_len = WNTR_SERIAL_NUMBER_LEN + 1;
 
-    PREPARE_RESPONSE(0x0F, TEETH_ENCODED_LENGTH(raw_response_len));
-
     uint8_t serial_no[raw_response_len];
     wntr_serial_number(serial_no);
 
     serial_no[raw_response_len - 1] = hw_ver_;
 
-    teeth_encode(serial_no, raw_response_len, response);
-
-    SEND_RESPONSE();
+    SEND_TEETH_RESPONSE(0x0F, serial_no, raw_response_len);
 
-    debug_printf("SysEx 0x0F: Get serial number.\n");
+    debug_log("SysEx 0x0F: Get serial number.\n");
 }
 
 static void cmd_0x10_monitor_(const uint8_t* data, size_t len) {
@@ -389,16 +434,21 @@ static void cmd_0x10_monitor_(const uint8_t* data, size_t len) {
         monitor_enabled_ = false;
     }
 
-    debug_printf("SysEx 0x10: Enter monitor mode.\n");
+    debug_log("SysEx 0x10: Enter monitor mode.\n");
 }
 
 static void cmd_0x11_soft_reset_(const uint8_t* data, size_t len) {
     (void)data;
     (void)len;
 
-    debug_printf("SysEx 0x11: Soft reset.\n");
+    debug_log("SysEx 0x11: Soft reset.\n");
 
+    // Don't lose settings that were changed but not committed.
+    gem_settings_cache_commit();
+
+#ifdef __arm__
     NVIC_SystemReset();
+#endif
 }
 
 static void cmd_0x12_enter_calibration_mode_(const uint8_t* data, size_t len) {
@@ -408,18 +458,238 @@ static void cmd_0x12_enter_calibration_mode_(const uint8_t* data, size_t len) {
     gem_adc_stop_scanning();
     gem_led_animation_set_mode(GEM_MODE_CALIBRATION);
 
-    debug_printf("SysEx 0x12: Enter calibration mode.\n");
+    debug_log("SysEx 0x12: Enter calibration mode.\n");
 }
 
 static void cmd_0x13_reset_into_bootloader_(const uint8_t* data, size_t len) {
     (void)data;
     (void)len;
 
-    debug_printf("SysEx 0x13: Reset into bootloader.\n");
+    debug_log("SysEx 0x13: Reset into bootloader.\n");
+
+    gem_settings_cache_commit();
 
     wntr_reset_into_bootloader();
 }
 
+static void cmd_0x14_read_adc_stats_(const uint8_t* data, size_t len) {
+    /* Request (teeth): CHANNEL(1) SAMPLES(2) SETTLE_US(2) */
+    /* Response (teeth): MEAN(4) MIN(2) MAX(2) VARIANCE(4), empty if the channel is invalid */
+    DECODE_TEETH_REQUEST(5);
+
+    uint8_t channel = request[0];
+    uint16_t samples = WNTR_UNPACK_16(request, 1);
+    uint16_t settle_us = WNTR_UNPACK_16(request, 3);
+
+    if (channel >= GEM_IN_COUNT) {
+        RESPONSE_0(0x14);
+        debug_log("SysEx 0x14: Invalid ADC channel %u\n", channel);
+        return;
+    }
+
+    uint8_t unencoded_response[ADC_STATS_PACKED_SIZE];
+    measure_adc_stats_(channel, samples, settle_us, unencoded_response);
+
+    SEND_TEETH_RESPONSE(0x14, unencoded_response, ADC_STATS_PACKED_SIZE);
+
+    debug_log("SysEx 0x14: Read ADC channel %u stats, %u samples\n", channel, samples);
+}
+
+static void cmd_0x15_read_adc_stats_multi_(const uint8_t* data, size_t len) {
+    /* Request (teeth): CHANNEL_MASK(2) SAMPLES(2) SETTLE_US(2) */
+    /* Response (teeth): (MEAN(4) MIN(2) MAX(2) VARIANCE(4)) for each channel in the mask, lowest first */
+    /* The response is empty if the mask has any invalid channels. */
+    DECODE_TEETH_REQUEST(6);
+
+    uint16_t channel_mask = WNTR_UNPACK_16(request, 0);
+    uint16_t samples = WNTR_UNPACK_16(request, 2);
+    uint16_t settle_us = WNTR_UNPACK_16(request, 4);
+
+    if (channel_mask >> GEM_IN_COUNT) {
+        RESPONSE_0(0x15);
+        debug_log("SysEx 0x15: Invalid ADC channel mask 0x%04x\n", channel_mask);
+        return;
+    }
+
+    uint8_t unencoded_response[ADC_STATS_PACKED_SIZE * GEM_IN_COUNT];
+    size_t unencoded_len = 0;
+
+    for (uint8_t channel = 0; channel < GEM_IN_COUNT; channel++) {
+        if (channel_mask & (1 << channel)) {
+            measure_adc_stats_(channel, samples, settle_us, unencoded_response + unencoded_len);
+            unencoded_len += ADC_STATS_PACKED_SIZE;
+        }
+    }
+
+    SEND_TEETH_RESPONSE(0x15, unencoded_response, unencoded_len);
+
+    debug_log("SysEx 0x15: Read ADC stats for channels 0x%04x, %u samples\n", channel_mask, samples);
+}
+
+static void cmd_0x16_write_lut_chunk_(const uint8_t* data, size_t len) {
+    /* Request (teeth): START(1) COUNT(1) (CASTOR_CODE(2) POLLUX_CODE(2)) * COUNT CRC32(4) */
+    /* Response: RESULT(1) */
+
+    // Chunks are variable length, so this can't use DECODE_TEETH_REQUEST.
+    // Like 0x1F, the data is checked so that it can't overflow the buffer.
+    if (len > TEETH_ENCODED_LENGTH(GEM_RAMP_TABLE_CHUNK_MAX_SIZE) || !teeth_valid(data, len)) {
+        RESPONSE_1(0x16, GEM_RAMP_TABLE_CHUNK_ERR_LENGTH);
+        return;
+    }
+
+    // teeth_decode() always writes whole groups of four bytes.
+    uint8_t request[TEETH_DECODED_LENGTH(TEETH_ENCODED_LENGTH(GEM_RAMP_TABLE_CHUNK_MAX_SIZE))];
+    size_t request_len = teeth_decode(data, len, request);
+
+    enum GemRampTableChunkResult result =
+        gem_ramp_table_unpack_chunk(gem_ramp_table, gem_ramp_table_len, request, request_len);
+    if (result == GEM_RAMP_TABLE_CHUNK_OK) {
+        gem_ramp_table_update_interpolation();
+    }
+
+    /* The table is only written to NVM by 0x0B, after all chunks are sent. */
+    RESPONSE_1(0x16, result);
+
+    debug_log("SysEx 0x16: Write LUT chunk, result: %u\n", result);
+}
+
+static void cmd_0x17_read_lut_chunk_(const uint8_t* data, size_t len) {
+    /* Request (teeth): START(1) COUNT(1) */
+    /* Response (teeth): START(1) COUNT(1) (CASTOR_CODE(2) POLLUX_CODE(2)) * COUNT CRC32(4) */
+    DECODE_TEETH_REQUEST(2);
+
+    uint8_t chunk[GEM_RAMP_TABLE_CHUNK_MAX_SIZE];
+    size_t chunk_len = gem_ramp_table_pack_chunk(gem_ramp_table, gem_ramp_table_len, request[0], request[1], chunk);
+
+    SEND_TEETH_RESPONSE(0x17, chunk, chunk_len);
+
+    debug_log("SysEx 0x17: Read LUT entries %u to %u\n", chunk[0], chunk[0] + chunk[1]);
+}
+
+static void cmd_0x1A_read_memory_usage_(const uint8_t* data, size_t len) {
+    /* Response (teeth): RAM_SIZE(4) STATIC_SIZE(4) STACK_SIZE(4) STACK_HIGH_WATER(4) */
+    (void)(data);
+    (void)(len);
+
+    struct GemMemoryUsage usage;
+    gem_memory_usage(&usage);
+
+    uint8_t unencoded_response[16];
+    WNTR_PACK_32(usage.ram_size, unencoded_response, 0);
+    WNTR_PACK_32(usage.static_size, unencoded_response, 4);
+    WNTR_PACK_32(usage.stack_size, unencoded_response, 8);
+    WNTR_PACK_32(usage.stack_high_water, unencoded_response, 12);
+
+    SEND_TEETH_RESPONSE(0x1A, unencoded_response, 16);
+
+    debug_log(
+        "SysEx 0x1A: Read memory usage, stack high water: %lu of %lu bytes\n",
+        usage.stack_high_water,
+        usage.stack_size);
+}
+
+static void cmd_0x1B_arm_trace_(const uint8_t* data, size_t len) {
+    /* Request: REGION(1) */
+    /* Response: REGION(1), or 0 if the region is invalid */
+    uint8_t region = len > 0 ? data[0] : GEM_TRACE_REGION_NONE;
+    if (region >= GEM_TRACE_REGION_COUNT) {
+        region = GEM_TRACE_REGION_NONE;
+    }
+
+    gem_trace_arm(region);
+
+    RESPONSE_1(0x1B, region);
+
+    debug_log("SysEx 0x1B: Armed trace for region %u\n", region);
+}
+
+static void cmd_0x1C_read_trace_(const uint8_t* data, size_t len) {
+    /* Request (teeth): START(2) */
+    /* Response (teeth): STATE(1) REGION(1) PACKET_COUNT(2) START(2) COUNT(1) (SOURCE(4) DESTINATION(4)) * COUNT */
+    DECODE_TEETH_REQUEST(2);
+
+    uint16_t start = WNTR_UNPACK_16(request, 0);
+    uint16_t packet_count = 0;
+    uint8_t count = 0;
+
+    enum GemTraceState state = gem_trace_state();
+    if (state == GEM_TRACE_STATE_DONE) {
+        packet_count = gem_trace_packet_count();
+        if (start < packet_count) {
+            count = packet_count - start < GEM_TRACE_CHUNK_PACKETS ? packet_count - start : GEM_TRACE_CHUNK_PACKETS;
+        }
+    }
+
+    uint8_t unencoded_response[7 + GEM_TRACE_CHUNK_PACKETS * 8];
+    unencoded_response[0] = state;
+    unencoded_response[1] = gem_trace_region();
+    WNTR_PACK_16(packet_count, unencoded_response, 2);
+    WNTR_PACK_16(start, unencoded_response, 4);
+    unencoded_response[6] = count;
+
+    const uint32_t* packets = gem_trace_packets();
+    for (size_t i = 0; i < count; i++) {
+        uint32_t source = packets[(start + i) * 2];
+        uint32_t destination = packets[(start + i) * 2 + 1];
+        WNTR_PACK_32(source, unencoded_response, 7 + i * 8);
+        WNTR_PACK_32(destination, unencoded_response, 7 + i * 8 + 4);
+    }
+
+    SEND_TEETH_RESPONSE(0x1C, unencoded_response, 7 + count * 8);
+
+    debug_log("SysEx 0x1C: Read %u trace packets starting at %u\n", count, start);
+}
+
+static void cmd_0x1D_read_boot_profile_(const uint8_t* data, size_t len) {
+    /* Request: empty */
+    /* Response (teeth): COUNT(1) TIME_US(4) * COUNT */
+    (void)data;
+    (void)len;
+
+    uint8_t unencoded_response[1 + GEM_BOOT_PHASE_COUNT * 4];
+    unencoded_response[0] = GEM_BOOT_PHASE_COUNT;
+    for (size_t i = 0; i < GEM_BOOT_PHASE_COUNT; i++) {
+        WNTR_PACK_32(gem_boot_profile_time(i), unencoded_response, 1 + i * 4);
+    }
+
+    SEND_TEETH_RESPONSE(0x1D, unencoded_response, sizeof(unencoded_response));
+
+    debug_log("SysEx 0x1D: Read boot profile\n");
+}
+
+static void cmd_0x1E_begin_fw_update_(const uint8_t* data, size_t len) {
+    /* Request (teeth): SIZE(4) CRC32(4) */
+    /* Response: RESULT(1) */
+    DECODE_TEETH_REQUEST(GEM_FW_UPDATE_BEGIN_SIZE);
+
+    enum GemFwUpdateResult result = GemFwUpdate_begin(&fw_update_, request, GEM_FW_UPDATE_BEGIN_SIZE);
+
+    RESPONSE_1(0x1E, result);
+
+    debug_log("SysEx 0x1E: Begin firmware update, %lu bytes, result: %u\n", fw_update_.image_len, result);
+}
+
+static void cmd_0x1F_write_fw_chunk_(const uint8_t* data, size_t len) {
+    /* Request (teeth): OFFSET(4) DATA(n) CRC32(4) */
+    /* Response: RESULT(1) */
+
+    // Chunks are variable length, so this can't use DECODE_TEETH_REQUEST.
+    // The data is checked before decoding so that bad group headers can't
+    // make teeth_decode() write past the end of the request buffer.
+    if (len > TEETH_ENCODED_LENGTH(GEM_FW_UPDATE_CHUNK_MAX_SIZE) || !teeth_valid(data, len)) {
+        RESPONSE_1(0x1F, GEM_FW_UPDATE_ERR_LENGTH);
+        return;
+    }
+
+    // teeth_decode() always writes whole groups of four bytes.
+    uint8_t request[TEETH_DECODED_LENGTH(TEETH_ENCODED_LENGTH(GEM_FW_UPDATE_CHUNK_MAX_SIZE))];
+    size_t request_len = teeth_decode(data, len, request);
+
+    enum GemFwUpdateResult result = GemFwUpdate_write_chunk(&fw_update_, request, request_len);
+
+    RESPONSE_1(0x1F, result);
+}
+
 static void cmd_0x20_set_frequency_(const uint8_t* data, size_t len) {
     /* Request (teeth): CHANNEL(1) FREQUENCY(4) */
     (void)(len);
@@ -431,7 +701,7 @@ static void cmd_0x20_set_frequency_(const uint8_t* data, size_t len) {
     uint64_t freq_millihz = gem_frequency_to_millihertz_f16_u64(freq_hz);
     gem_pulseout_set_frequency(pulse_, channel, freq_millihz);
 
-    debug_printf("SysEx 0x20: Set period for osc %u to %u milliHertz\n", channel, freq_millihz);
+    debug_log("SysEx 0x20: Set period for osc %u to %lu milliHertz\n", channel, (uint32_t)(freq_millihz));
 }
 
 static void cmd_0x21_set_osc8m_freq_(const uint8_t* data, size_t len) {
@@ -441,5 +711,85 @@ static void cmd_0x21_set_osc8m_freq_(const uint8_t* data, size_t len) {
 
     pulse_->gclk_freq = WNTR_UNPACK_32(request, 0);
 
-    debug_printf("SysEx 0x21: Set pulseout osc8m frequency to %u Hz\n", pulse_->gclk_freq);
+    debug_log("SysEx 0x21: Set pulseout osc8m frequency to %u Hz\n", pulse_->gclk_freq);
+}
+
+static void cmd_0x22_finish_fw_update_(const uint8_t* data, size_t len) {
+    /* Request: empty */
+    /* Response: RESULT(1) */
+    (void)data;
+    (void)len;
+
+    enum GemFwUpdateResult result = GemFwUpdate_finish(&fw_update_);
+
+    RESPONSE_1(0x22, result);
+
+    debug_log("SysEx 0x22: Finish firmware update, result: %u\n", result);
+}
+
+static void cmd_0x23_apply_fw_update_(const uint8_t* data, size_t len) {
+    /* Request: empty */
+    /* Response: RESULT(1), only if the update can't be applied. */
+    (void)data;
+    (void)len;
+
+    if (!GemFwUpdate_ready(&fw_update_)) {
+        RESPONSE_1(0x23, GEM_FW_UPDATE_ERR_STATE);
+        return;
+    }
+
+    debug_log("SysEx 0x23: Apply firmware update and reset.\n");
+
+    gem_settings_cache_commit();
+
+    // The device disconnects from USB when it resets, so there's no response.
+    // The host can check the new version once it reconnects.
+    gem_fw_swap_and_reset(fw_update_.staging_base, fw_update_.app_base, fw_update_.image_len);
+}
+
+static void cmd_0x24_commit_settings_(const uint8_t* data, size_t len) {
+    /* Response: SAVED(1), 0 if nothing had changed. */
+    (void)data;
+    (void)len;
+
+    bool saved = gem_settings_cache_commit();
+
+    RESPONSE_1(0x24, saved ? 1 : 0);
+
+    debug_log("SysEx 0x24: Commit settings, saved: %u\n", saved);
+}
+
+/*
+    Takes `samples` readings from the given ADC channel and packs their
+    statistics into `out` as MEAN(4) MIN(2) MAX(2) VARIANCE(4). Like
+    cmd_0x04_read_adc_, this leaves channel scanning stopped.
+*/
+static void measure_adc_stats_(uint8_t channel, uint16_t samples, uint16_t settle_us, uint8_t* out) {
+    WNTR_ASSERT(channel < GEM_IN_COUNT);
+
+    if (samples == 0) {
+        samples = 1;
+    }
+    if (samples > GEM_SAMPLE_STATS_MAX_COUNT) {
+        samples = GEM_SAMPLE_STATS_MAX_COUNT;
+    }
+
+    gem_adc_select_input_sync(&adc_inputs_[channel]);
+
+    // Give the input time to settle after switching the mux, for example,
+    // when the calibration fixture has just changed its output voltage.
+    if (settle_us > 0) {
+        wntr_delay_us(settle_us);
+    }
+
+    struct GemSampleStats stats;
+    GemSampleStats_init(&stats);
+    for (uint16_t i = 0; i < samples; i++) { GemSampleStats_add(&stats, gem_adc_sample_sync()); }
+
+    fix16_t mean = GemSampleStats_mean(&stats);
+    fix16_t variance = GemSampleStats_variance(&stats);
+    WNTR_PACK_32(mean, out, 0);
+    WNTR_PACK_16(stats.min, out, 4);
+    WNTR_PACK_16(stats.max, out, 6);
+    WNTR_PACK_32(variance, out, 8);
 }
@@ -22,5 +22,14 @@ void gem_sysex_init(
     const struct GemI2CConfig* i2c,
     struct GemPulseOutConfig* pulse);
 
+/*
+    Called after new settings are written over SysEx so that they can be
+    applied without resetting the module. The new settings are in
+    gem_settings_cache.
+*/
+typedef void (*gem_sysex_settings_callback)();
+
+void gem_sysex_set_settings_callback(gem_sysex_settings_callback callback);
+
 bool gem_sysex_monitor_enabled();
 void gem_sysex_send_monitor_update(struct GemMonitorUpdate* update);
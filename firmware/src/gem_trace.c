@@ -0,0 +1,81 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#include "gem_trace.h"
+#include "wntr_assert.h"
+#include "wntr_mtb.h"
+#include <string.h>
+
+/* Static variables */
+
+static enum GemTraceState state_ = GEM_TRACE_STATE_IDLE;
+static enum GemTraceRegion region_ = GEM_TRACE_REGION_NONE;
+static size_t packet_count_ = 0;
+/* The capture is copied out of the MTB's buffer so that the MTB can go back
+   to continuous tracing while the host downloads it. */
+static uint32_t packets_[WNTR_MTB_SIZE];
+
+/* Forward declarations */
+
+static void stop_capture_();
+
+/* Public functions */
+
+void gem_trace_arm(enum GemTraceRegion region) {
+    WNTR_ASSERT(region < GEM_TRACE_REGION_COUNT);
+
+    if (state_ == GEM_TRACE_STATE_CAPTURING) {
+        stop_capture_();
+    }
+
+    region_ = region;
+    packet_count_ = 0;
+    state_ = region == GEM_TRACE_REGION_NONE ? GEM_TRACE_STATE_IDLE : GEM_TRACE_STATE_ARMED;
+}
+
+void gem_trace_begin(enum GemTraceRegion region) {
+    if (state_ != GEM_TRACE_STATE_ARMED || region != region_) {
+        return;
+    }
+
+    state_ = GEM_TRACE_STATE_CAPTURING;
+    wntr_mtb_capture_start();
+}
+
+void gem_trace_end(enum GemTraceRegion region) {
+    if (state_ != GEM_TRACE_STATE_CAPTURING || region != region_) {
+        return;
+    }
+
+    packet_count_ = wntr_mtb_capture_stop();
+    memcpy(packets_, wntr_mtb_buffer(), packet_count_ * 2 * sizeof(uint32_t));
+    wntr_mtb_init();
+    state_ = GEM_TRACE_STATE_DONE;
+}
+
+void gem_trace_discard(enum GemTraceRegion region) {
+    if (state_ != GEM_TRACE_STATE_CAPTURING || region != region_) {
+        return;
+    }
+
+    stop_capture_();
+    state_ = GEM_TRACE_STATE_ARMED;
+}
+
+enum GemTraceState gem_trace_state() { return state_; }
+
+enum GemTraceRegion gem_trace_region() { return region_; }
+
+size_t gem_trace_packet_count() { return packet_count_; }
+
+const uint32_t* gem_trace_packets() { return packets_; }
+
+/* Private functions */
+
+static void stop_capture_() {
+    wntr_mtb_capture_stop();
+    wntr_mtb_init();
+}
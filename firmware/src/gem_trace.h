@@ -0,0 +1,60 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+/*
+    Instruction trace snapshots using the Micro Trace Buffer (MTB).
+
+    The host arms a trace for one of the regions below over SysEx. The next
+    time the main loop runs that region, the MTB records every branch taken
+    until the region ends or the buffer fills up. The host then downloads the
+    packets and reconstructs which basic blocks ran using the firmware's ELF
+    file, see factory/trace_profile.py.
+
+    The MTB also records branches into and out of interrupt handlers that run
+    during the region.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum GemTraceRegion {
+    GEM_TRACE_REGION_NONE = 0,
+    GEM_TRACE_REGION_ANALOG_INPUT = 1,
+    GEM_TRACE_REGION_OSCILLATOR = 2,
+    GEM_TRACE_REGION_LED_ANIMATION = 3,
+    GEM_TRACE_REGION_COUNT,
+};
+
+enum GemTraceState {
+    GEM_TRACE_STATE_IDLE = 0,
+    GEM_TRACE_STATE_ARMED = 1,
+    GEM_TRACE_STATE_CAPTURING = 2,
+    GEM_TRACE_STATE_DONE = 3,
+};
+
+/* Number of packets sent in each SysEx response. */
+#define GEM_TRACE_CHUNK_PACKETS 8
+
+/* Arms a trace for the next time `region` runs, discarding any previous capture. */
+void gem_trace_arm(enum GemTraceRegion region);
+
+/* Called by the main loop around each region. These do nothing unless a trace is armed for `region`. */
+void gem_trace_begin(enum GemTraceRegion region);
+void gem_trace_end(enum GemTraceRegion region);
+
+/* Throws away the capture for `region` and waits for it to run again, for regions that sometimes do nothing. */
+void gem_trace_discard(enum GemTraceRegion region);
+
+enum GemTraceState gem_trace_state();
+enum GemTraceRegion gem_trace_region();
+
+/* Number of packets captured. Only valid once the state is GEM_TRACE_STATE_DONE. */
+size_t gem_trace_packet_count();
+
+/* Returns the captured packets, each is a source address followed by a destination address. */
+const uint32_t* gem_trace_packets();
@@ -5,7 +5,7 @@
 
 #include "gem_monitor_update.h"
 
-#define _PACK_STRING "B?HHHHHHHHBiHIHHHHHHHiBiHIHHHH"
+#define _PACK_STRING "B?HHHHHHHHBiHIHHHHHHHiBiHIHHHHIIHIIH"
 
 void GemMonitorUpdate_init(struct GemMonitorUpdate* inst) {
     inst->mode = 0;
@@ -38,6 +38,12 @@ void GemMonitorUpdate_init(struct GemMonitorUpdate* inst) {
     inst->loop_time = 0;
     inst->animation_time = 0;
     inst->sample_time = 0;
+    inst->dac_skipped_writes = 0;
+    inst->dac_partial_writes = 0;
+    inst->midi_rx_peak_depth = 0;
+    inst->midi_rx_dropped = 0;
+    inst->midi_tx_dropped = 0;
+    inst->midi_latency = 0;
 }
 
 struct StructyResult GemMonitorUpdate_pack(const struct GemMonitorUpdate* inst, uint8_t* buf) {
@@ -74,7 +80,13 @@ struct StructyResult GemMonitorUpdate_pack(const struct GemMonitorUpdate* inst,
         inst->pollux_ramp,
         inst->loop_time,
         inst->animation_time,
-        inst->sample_time);
+        inst->sample_time,
+        inst->dac_skipped_writes,
+        inst->dac_partial_writes,
+        inst->midi_rx_peak_depth,
+        inst->midi_rx_dropped,
+        inst->midi_tx_dropped,
+        inst->midi_latency);
 }
 
 struct StructyResult GemMonitorUpdate_unpack(struct GemMonitorUpdate* inst, const uint8_t* buf) {
@@ -111,7 +123,13 @@ struct StructyResult GemMonitorUpdate_unpack(struct GemMonitorUpdate* inst, cons
         &inst->pollux_ramp,
         &inst->loop_time,
         &inst->animation_time,
-        &inst->sample_time);
+        &inst->sample_time,
+        &inst->dac_skipped_writes,
+        &inst->dac_partial_writes,
+        &inst->midi_rx_peak_depth,
+        &inst->midi_rx_dropped,
+        &inst->midi_tx_dropped,
+        &inst->midi_latency);
 }
 
 void GemMonitorUpdate_print(const struct GemMonitorUpdate* inst) {
@@ -159,4 +177,10 @@ void GemMonitorUpdate_print(const struct GemMonitorUpdate* inst) {
     STRUCTY_PRINTF("- loop_time: %u\n", inst->loop_time);
     STRUCTY_PRINTF("- animation_time: %u\n", inst->animation_time);
     STRUCTY_PRINTF("- sample_time: %u\n", inst->sample_time);
+    STRUCTY_PRINTF("- dac_skipped_writes: %u\n", inst->dac_skipped_writes);
+    STRUCTY_PRINTF("- dac_partial_writes: %u\n", inst->dac_partial_writes);
+    STRUCTY_PRINTF("- midi_rx_peak_depth: %u\n", inst->midi_rx_peak_depth);
+    STRUCTY_PRINTF("- midi_rx_dropped: %u\n", inst->midi_rx_dropped);
+    STRUCTY_PRINTF("- midi_tx_dropped: %u\n", inst->midi_tx_dropped);
+    STRUCTY_PRINTF("- midi_latency: %u\n", inst->midi_latency);
 }
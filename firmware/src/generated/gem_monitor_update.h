@@ -9,7 +9,7 @@
 
 #include "fix16.h"
 
-#define GEMMONITORUPDATE_PACKED_SIZE 66
+#define GEMMONITORUPDATE_PACKED_SIZE 86
 
 struct GemMonitorUpdate {
     uint8_t mode;
@@ -42,6 +42,12 @@ struct GemMonitorUpdate {
     uint16_t loop_time;
     uint16_t animation_time;
     uint16_t sample_time;
+    uint32_t dac_skipped_writes;
+    uint32_t dac_partial_writes;
+    uint16_t midi_rx_peak_depth;
+    uint32_t midi_rx_dropped;
+    uint32_t midi_tx_dropped;
+    uint16_t midi_latency;
 };
 
 void GemMonitorUpdate_init(struct GemMonitorUpdate* inst);
@@ -5,7 +5,7 @@
 
 #include "gem_settings.h"
 
-#define _PACK_STRING "HhHiiiiiiiiiiH??iiiBBiiHI??"
+#define _PACK_STRING "HhHiiiiiiiiiiH??iiiBBiiHI??BBB?H???ii"
 
 void GemSettings_init(struct GemSettings* inst) {
     inst->adc_gain_corr = 2048;
@@ -35,6 +35,16 @@ void GemSettings_init(struct GemSettings* inst) {
     inst->osc8m_freq = 8000000;
     inst->zero_detection_enabled = true;
     inst->quantization_enabled = true;
+    inst->castor_midi_channel = 0;
+    inst->pollux_midi_channel = 0;
+    inst->midi_pitch_bend_range = 2;
+    inst->midi_replaces_cv = true;
+    inst->quantizer_scale = 4095;
+    inst->fine_quantization_enabled = false;
+    inst->castor_pitch_smoothing = false;
+    inst->pollux_pitch_smoothing = false;
+    inst->pitch_smoothing_min_cutoff = F16(10);
+    inst->pitch_smoothing_sensitivity = F16(10);
 }
 
 struct StructyResult GemSettings_pack(const struct GemSettings* inst, uint8_t* buf) {
@@ -68,7 +78,17 @@ struct StructyResult GemSettings_pack(const struct GemSettings* inst, uint8_t* b
         inst->pulse_width_bitmask,
         inst->osc8m_freq,
         inst->zero_detection_enabled,
-        inst->quantization_enabled);
+        inst->quantization_enabled,
+        inst->castor_midi_channel,
+        inst->pollux_midi_channel,
+        inst->midi_pitch_bend_range,
+        inst->midi_replaces_cv,
+        inst->quantizer_scale,
+        inst->fine_quantization_enabled,
+        inst->castor_pitch_smoothing,
+        inst->pollux_pitch_smoothing,
+        inst->pitch_smoothing_min_cutoff,
+        inst->pitch_smoothing_sensitivity);
 }
 
 struct StructyResult GemSettings_unpack(struct GemSettings* inst, const uint8_t* buf) {
@@ -102,7 +122,17 @@ struct StructyResult GemSettings_unpack(struct GemSettings* inst, const uint8_t*
         &inst->pulse_width_bitmask,
         &inst->osc8m_freq,
         &inst->zero_detection_enabled,
-        &inst->quantization_enabled);
+        &inst->quantization_enabled,
+        &inst->castor_midi_channel,
+        &inst->pollux_midi_channel,
+        &inst->midi_pitch_bend_range,
+        &inst->midi_replaces_cv,
+        &inst->quantizer_scale,
+        &inst->fine_quantization_enabled,
+        &inst->castor_pitch_smoothing,
+        &inst->pollux_pitch_smoothing,
+        &inst->pitch_smoothing_min_cutoff,
+        &inst->pitch_smoothing_sensitivity);
 }
 
 void GemSettings_print(const struct GemSettings* inst) {
@@ -195,4 +225,22 @@ void GemSettings_print(const struct GemSettings* inst) {
     STRUCTY_PRINTF("- osc8m_freq: %u\n", inst->osc8m_freq);
     STRUCTY_PRINTF("- zero_detection_enabled: %u\n", inst->zero_detection_enabled);
     STRUCTY_PRINTF("- quantization_enabled: %u\n", inst->quantization_enabled);
+    STRUCTY_PRINTF("- castor_midi_channel: %u\n", inst->castor_midi_channel);
+    STRUCTY_PRINTF("- pollux_midi_channel: %u\n", inst->pollux_midi_channel);
+    STRUCTY_PRINTF("- midi_pitch_bend_range: %u\n", inst->midi_pitch_bend_range);
+    STRUCTY_PRINTF("- midi_replaces_cv: %u\n", inst->midi_replaces_cv);
+    STRUCTY_PRINTF("- quantizer_scale: %u\n", inst->quantizer_scale);
+    STRUCTY_PRINTF("- fine_quantization_enabled: %u\n", inst->fine_quantization_enabled);
+    STRUCTY_PRINTF("- castor_pitch_smoothing: %u\n", inst->castor_pitch_smoothing);
+    STRUCTY_PRINTF("- pollux_pitch_smoothing: %u\n", inst->pollux_pitch_smoothing);
+    {
+        char fix16buf[13];
+        fix16_to_str(inst->pitch_smoothing_min_cutoff, fix16buf, 2);
+        STRUCTY_PRINTF("- pitch_smoothing_min_cutoff: %s\n", fix16buf);
+    }
+    {
+        char fix16buf[13];
+        fix16_to_str(inst->pitch_smoothing_sensitivity, fix16buf, 2);
+        STRUCTY_PRINTF("- pitch_smoothing_sensitivity: %s\n", fix16buf);
+    }
 }
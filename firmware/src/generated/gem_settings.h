@@ -9,7 +9,7 @@
 
 #include "fix16.h"
 
-#define GEMSETTINGS_PACKED_SIZE 80
+#define GEMSETTINGS_PACKED_SIZE 97
 
 struct GemSettings {
     /* The ADC's internal gain correction register. */
@@ -87,6 +87,53 @@ struct GemSettings {
     Enables or disables quantization when Castor is in "Coarse" mode
      */
     bool quantization_enabled;
+    /*
+    The USB MIDI channel (1 to 16) whose notes and pitch bend control Castor's
+    pitch, or 0 to ignore MIDI.
+     */
+    uint8_t castor_midi_channel;
+    /*
+    The USB MIDI channel (1 to 16) whose notes and pitch bend control Pollux's
+    pitch, or 0 to ignore MIDI.
+     */
+    uint8_t pollux_midi_channel;
+    /*
+    Full-scale MIDI pitch bend in semitones.
+     */
+    uint8_t midi_pitch_bend_range;
+    /*
+    If enabled, held MIDI notes replace the pitch CV. Otherwise they
+    transpose the pitch relative to C4.
+     */
+    bool midi_replaces_cv;
+    /*
+    The notes used for quantization, one bit per semitone starting with C in
+    the lowest bit. For example, 4095 (0xFFF) is chromatic and 2741 (0xAB5)
+    is C major.
+     */
+    uint16_t quantizer_scale;
+    /*
+    Enables or disables quantizing the pitch CV when in "Fine" mode
+     */
+    bool fine_quantization_enabled;
+    /*
+    Enables or disables smoothing Castor's pitch CV
+     */
+    bool castor_pitch_smoothing;
+    /*
+    Enables or disables smoothing Pollux's pitch CV
+     */
+    bool pollux_pitch_smoothing;
+    /*
+    The pitch CV smoothing filter's cutoff (in Hz) when the CV is steady.
+    Lower values remove more jitter.
+     */
+    fix16_t pitch_smoothing_min_cutoff;
+    /*
+    How much the pitch CV smoothing filter's cutoff rises (in Hz) for each
+    volt per second that the CV changes. Higher values reduce lag.
+     */
+    fix16_t pitch_smoothing_sensitivity;
 };
 
 void GemSettings_init(struct GemSettings* inst);
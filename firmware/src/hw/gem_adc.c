@@ -117,6 +117,11 @@ void gem_adc_init_input(const struct GemADCInput* input) {
 }
 
 uint16_t gem_adc_read_sync(const struct GemADCInput* input) {
+    gem_adc_select_input_sync(input);
+    return gem_adc_sample_sync();
+}
+
+void gem_adc_select_input_sync(const struct GemADCInput* input) {
     /* Stop channel scanning, we need exclusive control over the ADC. */
     gem_adc_stop_scanning();
 
@@ -128,6 +133,14 @@ uint16_t gem_adc_read_sync(const struct GemADCInput* input) {
     ADC->INPUTCTRL.bit.MUXPOS = input->ain;
     while (ADC->STATUS.bit.SYNCBUSY) {};
 
+    /*
+        Throw away the first result - the datasheet recommends doing that
+        since the first conversion for a new configuration will be incorrect.
+    */
+    gem_adc_sample_sync();
+}
+
+uint16_t gem_adc_sample_sync() {
     /* Start the ADC using a software trigger. */
     ADC->SWTRIG.bit.START = 1;
 
@@ -137,15 +150,6 @@ uint16_t gem_adc_read_sync(const struct GemADCInput* input) {
     /* Clear the flag. */
     ADC->INTFLAG.reg = ADC_INTFLAG_RESRDY;
 
-    /*
-        Throw away the first result and measure again - the datasheet
-        recommends doing that since the first conversion for a new
-        configuration will be incorrect.
-    */
-    ADC->SWTRIG.bit.START = 1;
-    while (ADC->INTFLAG.bit.RESRDY == 0) {};
-    ADC->INTFLAG.reg = ADC_INTFLAG_RESRDY;
-
     return ADC->RESULT.reg;
 }
 
@@ -156,6 +160,9 @@ void gem_adc_start_scanning(const struct GemADCInput* inputs, size_t num_inputs,
     results_ready_ = false;
     results_ = results;
 
+    /* Discard any result left over from before scanning was (re)started. */
+    ADC->INTFLAG.reg = ADC_INTFLAG_RESRDY;
+
     /* Enable ADC interrupts and the "result ready" interrupt */
     NVIC_SetPriority(ADC_IRQn, 1);
     NVIC_EnableIRQ(ADC_IRQn);
@@ -51,6 +51,14 @@ void gem_adc_init_input(const struct GemADCInput* const input);
 
 uint16_t gem_adc_read_sync(const struct GemADCInput* input);
 
+/*
+    Stops channel scanning and switches the ADC to the given input so that
+    gem_adc_sample_sync() can take several readings without re-selecting it
+    each time.
+*/
+void gem_adc_select_input_sync(const struct GemADCInput* input);
+uint16_t gem_adc_sample_sync();
+
 /*
     Start scanning input channels using the ADC's result ready interrupt.
     The results array will be continously updated with new ADC readings.
@@ -0,0 +1,74 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#include "gem_fw_swap.h"
+#include "sam.h"
+#include "wntr_ramfunc.h"
+
+/* Macros & defs */
+
+#define NVM_MEMORY ((volatile uint16_t*)FLASH_ADDR)
+#define ROW_SIZE (NVMCTRL_PAGE_SIZE * NVMCTRL_ROW_PAGES)
+
+/* Forward declarations */
+
+static void wait_ready_() RAMFUNC;
+
+/* Public functions */
+
+/*
+    This can't call wntr_nvm_erase_row() or wntr_nvm_write_page() because
+    they live in flash and might be erased before they're needed again, so it
+    drives the NVM controller directly. The copy loops use volatile accesses
+    so the compiler doesn't turn them into a call to memcpy() in flash.
+*/
+void RAMFUNC gem_fw_swap_and_reset(uint32_t staging_base, uint32_t app_base, size_t len) {
+    __disable_irq();
+
+    /* The NVM cache could hold stale copies of the old application. */
+    NVMCTRL->CTRLB.reg |= NVMCTRL_CTRLB_CACHEDIS;
+
+    volatile const uint16_t* src = (volatile const uint16_t*)(staging_base);
+
+    for (uint32_t row = 0; row < len; row += ROW_SIZE) {
+        uint32_t row_addr = app_base + row;
+
+        wait_ready_();
+        NVMCTRL->STATUS.reg = NVMCTRL_STATUS_MASK;
+        NVMCTRL->ADDR.reg = row_addr / 2;
+        NVMCTRL->CTRLA.reg = NVMCTRL_CTRLA_CMD_ER | NVMCTRL_CTRLA_CMDEX_KEY;
+
+        for (uint32_t page = 0; page < ROW_SIZE; page += NVMCTRL_PAGE_SIZE) {
+            uint32_t page_addr = row_addr + page;
+
+            wait_ready_();
+            NVMCTRL->CTRLA.reg = NVMCTRL_CTRLA_CMD_PBC | NVMCTRL_CTRLA_CMDEX_KEY;
+            wait_ready_();
+            NVMCTRL->STATUS.reg = NVMCTRL_STATUS_MASK;
+
+            uint32_t word = (page_addr - app_base) / 2;
+            for (uint32_t i = 0; i < NVMCTRL_PAGE_SIZE / 2; i++) { NVM_MEMORY[page_addr / 2 + i] = src[word + i]; }
+
+            NVMCTRL->ADDR.reg = page_addr / 2;
+            NVMCTRL->CTRLA.reg = NVMCTRL_CTRLA_CMD_WP | NVMCTRL_CTRLA_CMDEX_KEY;
+        }
+    }
+
+    wait_ready_();
+
+    /* Same as NVIC_SystemReset(), which isn't guaranteed to be inlined. */
+    __DSB();
+    SCB->AIRCR = (0x5FA << SCB_AIRCR_VECTKEY_Pos) | SCB_AIRCR_SYSRESETREQ_Msk;
+    __DSB();
+
+    while (1) {}
+}
+
+/* Private functions */
+
+static void wait_ready_() {
+    while (!NVMCTRL->INTFLAG.bit.READY) {};
+}
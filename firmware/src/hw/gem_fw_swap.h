@@ -0,0 +1,23 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+/*
+    Copies a verified firmware image from the staging region over the running
+    application and resets into it, see gem_fw_update.h.
+
+    This erases the code that's currently running, so it runs entirely from
+    RAM with interrupts disabled and never returns. If power is lost part of
+    the way through the application is left incomplete, but the bootloader
+    isn't touched, so double-tapping reset still enters the UF2 bootloader
+    to recover.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+void gem_fw_swap_and_reset(uint32_t staging_base, uint32_t app_base, size_t len) __attribute__((__noreturn__));
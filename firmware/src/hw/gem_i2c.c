@@ -6,7 +6,8 @@
 
 #include "gem_i2c.h"
 #include "gem_config.h"
-#include "printf.h"
+#include "gem_log.h"
+#include "wntr_delay.h"
 #include "wntr_gpio.h"
 
 #define BUSSTATE_UNKNOWN 0
@@ -14,6 +15,19 @@
 #define BUSSTATE_OWNER 2
 #define BUSSTATE_BUSY 3
 
+/* Number of SCL pulses sent when trying to get a stuck device to release SDA. */
+#define RECOVERY_CLOCK_PULSES 9
+/* Half of an SCL period at 100kHz. */
+#define RECOVERY_HALF_PERIOD_US 5
+
+/* Forward declarations */
+
+static uint32_t calculate_baud_(const struct GemI2CConfig* cfg);
+static uint32_t calculate_hs_baud_(const struct GemI2CConfig* cfg);
+static RAMFUNC enum GemI2CResult
+write_(const struct GemI2CConfig* cfg, uint8_t address, uint8_t* data, size_t len);
+static void recover_bus_(const struct GemI2CConfig* cfg);
+
 void gem_i2c_init(const struct GemI2CConfig* cfg) {
     /* Enable the APB clock for SERCOM. */
     PM->APBCMASK.reg |= cfg->apbcmask;
@@ -39,8 +53,11 @@ void gem_i2c_init(const struct GemI2CConfig* cfg) {
     while (cfg->sercom->I2CM.SYNCBUSY.bit.SWRST || cfg->sercom->I2CM.CTRLA.bit.SWRST) {};
 
     cfg->sercom->I2CM.CTRLA.reg = (
-        // 0 is standard/fast mode 100 & 400kHz
-        SERCOM_I2CM_CTRLA_SPEED(0) |
+        // 0 is standard/fast mode 100 & 400kHz, 1 is fast-mode plus 1MHz,
+        // 2 is high-speed mode 3.4MHz.
+        SERCOM_I2CM_CTRLA_SPEED(cfg->speed) |
+        // High-speed mode requires clock stretching after the ACK bit.
+        (cfg->speed == GEM_I2C_SPEED_HIGH ? SERCOM_I2CM_CTRLA_SCLSM : 0) |
         // Hold SDA low for 300-600ns
         SERCOM_I2CM_CTRLA_SDAHOLD(0) |
         // work as master
@@ -50,15 +67,16 @@ void gem_i2c_init(const struct GemI2CConfig* cfg) {
     cfg->sercom->I2CM.CTRLB.reg = SERCOM_I2CM_CTRLB_SMEN | SERCOM_I2CM_CTRLB_QCEN;
     while (cfg->sercom->I2CM.SYNCBUSY.bit.SYSOP) {};
 
-    /* Set baudrate.
-        this is from Arduino:
-            https://github.com/arduino/ArduinoCore-samd/blob/master/cores/arduino/SERCOM.cpp#L461
-    */
-    uint32_t baudrate = cfg->baudrate;      // Hz
-    uint32_t clock_speed = cfg->gclk_freq;  // Hz
-    uint32_t rise_time = cfg->rise_time;    // ns
-    cfg->sercom->I2CM.BAUD.bit.BAUD =
-        clock_speed / (2 * baudrate) - 5 - (((clock_speed / 1000000) * rise_time) / (2 * 1000));
+    /* Set baudrate. */
+    uint32_t baud = SERCOM_I2CM_BAUD_BAUD(calculate_baud_(cfg));
+
+    /* In high-speed mode BAUD is only used for the master code, the rest of
+       the transfer uses HSBAUD. */
+    if (cfg->speed == GEM_I2C_SPEED_HIGH) {
+        baud |= SERCOM_I2CM_BAUD_HSBAUD(calculate_hs_baud_(cfg));
+    }
+
+    cfg->sercom->I2CM.BAUD.reg = baud;
     while (cfg->sercom->I2CM.SYNCBUSY.bit.SYSOP) {};
 
     /* Enable the SERCOM. */
@@ -71,6 +89,59 @@ void gem_i2c_init(const struct GemI2CConfig* cfg) {
 }
 
 enum GemI2CResult gem_i2c_write(const struct GemI2CConfig* cfg, uint8_t address, uint8_t* data, size_t len) {
+    enum GemI2CResult result = write_(cfg, address, data, len);
+
+    /* If the bus is stuck then dropping the write isn't great, since the
+       DAC won't be updated until the bus happens to free itself. Instead,
+       try to get the bus back and try again. */
+    if (result == GEM_I2C_RESULT_ERR_BUSSTATE) {
+        recover_bus_(cfg);
+        result = write_(cfg, address, data, len);
+    }
+
+    return result;
+}
+
+/* Private functions */
+
+static uint32_t calculate_baud_(const struct GemI2CConfig* cfg) {
+    /* This is from Arduino:
+        https://github.com/arduino/ArduinoCore-samd/blob/master/cores/arduino/SERCOM.cpp#L461
+    */
+    uint32_t baudrate = cfg->baudrate;      // Hz
+    uint32_t clock_speed = cfg->gclk_freq;  // Hz
+    uint32_t rise_time = cfg->rise_time;    // ns
+    int32_t baud = (int32_t)(clock_speed / (2 * baudrate)) - 5 -
+                   (int32_t)(((clock_speed / 1000000) * rise_time) / (2 * 1000));
+
+    /* This happens if the GCLK is too slow for the requested speed. */
+    if (baud < 0) {
+        GEM_LOG("I2C baudrate %lu is too fast for a %lu Hz clock!\n", baudrate, clock_speed);
+        return 0;
+    }
+
+    return (uint32_t)(baud);
+}
+
+static uint32_t calculate_hs_baud_(const struct GemI2CConfig* cfg) {
+    /* High-speed mode ignores the rise time, see "Clock Generation" in the
+       SERCOM I2C section of the datasheet. */
+    if (cfg->hs_baudrate == 0) {
+        GEM_LOG("I2C high-speed mode needs hs_baudrate to be set!\n");
+        return 0;
+    }
+
+    int32_t hsbaud = (int32_t)(cfg->gclk_freq / (2 * cfg->hs_baudrate)) - 1;
+
+    if (hsbaud < 0) {
+        GEM_LOG("I2C baudrate %lu is too fast for a %lu Hz clock!\n", cfg->hs_baudrate, cfg->gclk_freq);
+        return 0;
+    }
+
+    return (uint32_t)(hsbaud);
+}
+
+static enum GemI2CResult write_(const struct GemI2CConfig* cfg, uint8_t address, uint8_t* data, size_t len) {
     /* Before trying to write, check to see if the bus is busy, if it is,
        bail.
     */
@@ -78,8 +149,10 @@ enum GemI2CResult gem_i2c_write(const struct GemI2CConfig* cfg, uint8_t address,
         return GEM_I2C_RESULT_ERR_BUSSTATE;
     }
 
-    /* Address + write flag. */
-    cfg->sercom->I2CM.ADDR.bit.ADDR = (address << 0x1ul) | 0;
+    /* Address + write flag. In high-speed mode the HS bit makes the SERCOM
+       send the master code before the address. */
+    cfg->sercom->I2CM.ADDR.reg = SERCOM_I2CM_ADDR_ADDR((address << 0x1ul) | 0) |
+                                 (cfg->speed == GEM_I2C_SPEED_HIGH ? SERCOM_I2CM_ADDR_HS : 0);
 
     /* This can hang forever, so put a timeout on it. */
     size_t w = 0;
@@ -91,7 +164,7 @@ enum GemI2CResult gem_i2c_write(const struct GemI2CConfig* cfg, uint8_t address,
 
 #ifdef DEBUG
     if (w == cfg->wait_timeout) {
-        printf("I2C timeout hit!");
+        GEM_LOG("I2C timeout hit!");
     }
 #endif
 
@@ -128,3 +201,45 @@ enum GemI2CResult gem_i2c_write(const struct GemI2CConfig* cfg, uint8_t address,
 
     return GEM_I2C_RESULT_SUCCESS;
 }
+
+static void recover_bus_(const struct GemI2CConfig* cfg) {
+    /* Disable the SERCOM and take control of the pins. PAD0 is SDA and
+       PAD1 is SCL. Both are driven like open-drain outputs: they're either
+       driven low or left floating so the pull-ups bring them high. */
+    cfg->sercom->I2CM.CTRLA.bit.ENABLE = 0;
+    while (cfg->sercom->I2CM.SYNCBUSY.bit.ENABLE) {};
+
+    struct WntrGPIOPin sda = cfg->pad0_pin;
+    struct WntrGPIOPin scl = cfg->pad1_pin;
+    PORT->Group[sda.port].PINCFG[sda.pin].bit.PMUXEN = 0;
+    PORT->Group[scl.port].PINCFG[scl.pin].bit.PMUXEN = 0;
+    WntrGPIOPin_set_as_input(sda, false);
+    WntrGPIOPin_set_as_input(scl, false);
+    WntrGPIOPin_set(sda, false);
+    WntrGPIOPin_set(scl, false);
+
+    /* If a device was reset or interrupted in the middle of a transfer it
+       may still be holding SDA low waiting for more clocks. Clock it until it
+       lets go, which takes at most one byte + ACK. */
+    for (size_t i = 0; i < RECOVERY_CLOCK_PULSES && !WntrGPIOPin_get(sda); i++) {
+        WntrGPIOPin_set_as_output(scl);
+        wntr_delay_us(RECOVERY_HALF_PERIOD_US);
+        WntrGPIOPin_set_as_input(scl, false);
+        wntr_delay_us(RECOVERY_HALF_PERIOD_US);
+    }
+
+    /* Send a STOP condition (SDA rising while SCL is high) so that every
+       device on the bus goes back to idle. */
+    WntrGPIOPin_set_as_output(scl);
+    WntrGPIOPin_set_as_output(sda);
+    wntr_delay_us(RECOVERY_HALF_PERIOD_US);
+    WntrGPIOPin_set_as_input(scl, false);
+    wntr_delay_us(RECOVERY_HALF_PERIOD_US);
+    WntrGPIOPin_set_as_input(sda, false);
+    wntr_delay_us(RECOVERY_HALF_PERIOD_US);
+
+    GEM_LOG("I2C bus recovered, SDA is %s.\n", WntrGPIOPin_get(sda) ? "high" : "still low");
+
+    /* Reset the SERCOM and give it the pins back. */
+    gem_i2c_init(cfg);
+}
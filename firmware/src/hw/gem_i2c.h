@@ -14,10 +14,29 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+enum GemI2CSpeed {
+    /* Standard and fast mode, up to 400kHz. */
+    GEM_I2C_SPEED_FAST = 0,
+    /* Fast-mode plus, up to 1MHz. */
+    GEM_I2C_SPEED_FAST_PLUS = 1,
+    /*
+        High-speed mode, up to 3.4MHz. Each transfer starts with the master
+        code sent at `baudrate` before switching to `hs_baudrate`.
+    */
+    GEM_I2C_SPEED_HIGH = 2,
+};
+
+/*
+    Note that the faster speeds need a faster GCLK than the usual 8MHz one,
+    for example, high-speed mode needs at least ~24MHz for a 3.4MHz clock.
+*/
 struct GemI2CConfig {
     uint32_t gclk;
     uint32_t gclk_freq;
+    enum GemI2CSpeed speed;
     uint32_t baudrate;
+    /* Only used by GEM_I2C_SPEED_HIGH, which requires it. */
+    uint32_t hs_baudrate;
     uint32_t rise_time;
     uint32_t wait_timeout;
     Sercom* sercom;
@@ -37,4 +56,10 @@ enum GemI2CResult {
 
 void gem_i2c_init(const struct GemI2CConfig* cfg);
 
+/*
+    Writes the data to the device at the given address. If the bus is stuck
+    (for example, a device is holding SDA low after a reset in the middle of
+    a transfer) this recovers the bus and tries again once before giving up
+    with GEM_I2C_RESULT_ERR_BUSSTATE.
+*/
 RAMFUNC enum GemI2CResult gem_i2c_write(const struct GemI2CConfig* cfg, uint8_t address, uint8_t* data, size_t len);
@@ -8,13 +8,23 @@
 #include "gem_config.h"
 #include "wntr_ramfunc.h"
 
+/* Macros & defs */
+
+/* The DMA channel used for streaming periods into TCC1. */
+#define STREAM_DMA_CHANNEL 0
+
 /* Forward declarations */
 static void setup_tcc_(Tcc* tcc, size_t wo, const struct WntrGPIOPin pin);
+static void setup_dmac_();
 
 /* Static globals */
 
 static gem_pulseout_ovf_callback ovf_callback_;
 
+/* The DMA controller expects these to be 128-bit aligned. */
+static DmacDescriptor dma_descriptors_[STREAM_DMA_CHANNEL + 1] __attribute__((aligned(16)));
+static DmacDescriptor dma_writeback_[STREAM_DMA_CHANNEL + 1] __attribute__((aligned(16)));
+
 /* Public functions */
 
 void gem_pulseout_init(const struct GemPulseOutConfig* po, gem_pulseout_ovf_callback ovf_callback) {
@@ -61,6 +71,61 @@ void gem_pulseout_set_period(const struct GemPulseOutConfig* po, uint8_t channel
     }
 }
 
+void gem_pulseout_set_compare(const struct GemPulseOutConfig* po, uint8_t channel, uint32_t compare) {
+    switch (channel) {
+        case 0:
+            TCC0->CCB[po->tcc0_wo % 4].reg = compare;
+            break;
+
+        case 1:
+            TCC1->CCB[po->tcc1_wo % 4].reg = compare;
+            break;
+
+        default:
+            break;
+    }
+}
+
+void gem_pulseout_start_period_stream(const uint32_t* periods, size_t len) {
+    setup_dmac_();
+
+    /* Reset the channel. */
+    DMAC->CHID.reg = DMAC_CHID_ID(STREAM_DMA_CHANNEL);
+    DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+    DMAC->CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+    while (DMAC->CHCTRLA.reg & DMAC_CHCTRLA_SWRST) {};
+
+    /* Transfer one word each time TCC0 overflows. */
+    DMAC->CHCTRLB.reg = DMAC_CHCTRLB_LVL(0) | DMAC_CHCTRLB_TRIGSRC(TCC0_DMAC_ID_OVF) | DMAC_CHCTRLB_TRIGACT_BEAT;
+
+    /* Configure the transfer descriptor.
+        - The source address increments through the table, and the DMA
+          controller expects the address of the *end* of the table when
+          incrementing.
+        - The destination is TCC1's buffered period register, so the new
+          period takes effect cleanly at TCC1's next update.
+        - The descriptor points at itself so that the table repeats forever.
+    */
+    DmacDescriptor* descriptor = &dma_descriptors_[STREAM_DMA_CHANNEL];
+    descriptor->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_WORD | DMAC_BTCTRL_SRCINC;
+    descriptor->BTCNT.reg = len;
+    descriptor->SRCADDR.reg = (uint32_t)(periods + len);
+    descriptor->DSTADDR.reg = (uint32_t)(&TCC1->PERB.reg);
+    descriptor->DESCADDR.reg = (uint32_t)(descriptor);
+
+    DMAC->CHCTRLA.reg |= DMAC_CHCTRLA_ENABLE;
+}
+
+void gem_pulseout_stop_period_stream() {
+    DMAC->CHID.reg = DMAC_CHID_ID(STREAM_DMA_CHANNEL);
+    DMAC->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+    while (DMAC->CHCTRLA.reg & DMAC_CHCTRLA_ENABLE) {};
+
+    /* Discard any buffered period so that it doesn't clobber the next period
+       set with gem_pulseout_set_period(). */
+    TCC1->STATUS.reg = TCC_STATUS_PERBV;
+}
+
 /* Interrupt handlers */
 
 void RAMFUNC TCC0_Handler(void) {
@@ -106,3 +171,21 @@ static void setup_tcc_(Tcc* tcc, size_t wo, const struct WntrGPIOPin pin) {
     tcc->CTRLA.reg |= (TCC_CTRLA_ENABLE);
     while (tcc->SYNCBUSY.bit.ENABLE) {};
 }
+
+static void setup_dmac_() {
+    if (DMAC->CTRL.bit.DMAENABLE) {
+        return;
+    }
+
+    /* Enable the AHB & APB clocks for the DMA controller. */
+    PM->AHBMASK.reg |= PM_AHBMASK_DMAC;
+    PM->APBBMASK.reg |= PM_APBBMASK_DMAC;
+
+    /* The DMA controller isn't reset here since the startup code configures
+       its quality of service settings. */
+
+    /* Tell the DMA controller where to find descriptors and enable it. */
+    DMAC->BASEADDR.reg = (uint32_t)(dma_descriptors_);
+    DMAC->WRBADDR.reg = (uint32_t)(dma_writeback_);
+    DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xF);
+}
@@ -14,6 +14,7 @@
 #include "wntr_gpio.h"
 #include "wntr_ramfunc.h"
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 struct GemPulseOutConfig {
@@ -29,6 +30,21 @@ typedef void (*gem_pulseout_ovf_callback)(uint8_t inst);
 
 void gem_pulseout_init(const struct GemPulseOutConfig* po, gem_pulseout_ovf_callback ovf_callback);
 void gem_pulseout_set_period(const struct GemPulseOutConfig* po, uint8_t channel, uint32_t period) RAMFUNC;
+void gem_pulseout_set_compare(const struct GemPulseOutConfig* po, uint8_t channel, uint32_t compare) RAMFUNC;
+
+/*
+    Streams a table of period values into TCC1 (channel 1) using DMA. One
+    value is transferred each time TCC0 (channel 0) overflows and the table
+    repeats until stopped. This allows channel 1's frequency to be modulated
+    at audio rates without any CPU work per cycle.
+
+    The table must stay valid until gem_pulseout_stop_period_stream() is
+    called, but its contents can be changed at any time. Since the compare
+    value isn't streamed, it should be kept below the table's smallest
+    period using gem_pulseout_set_compare().
+*/
+void gem_pulseout_start_period_stream(const uint32_t* periods, size_t len);
+void gem_pulseout_stop_period_stream();
 
 inline static uint32_t gem_pulseout_frequency_to_period(const struct GemPulseOutConfig* po, uint32_t freq_millihertz) {
     return (((po->gclk_freq * 100) / freq_millihertz) - 1);
@@ -0,0 +1,71 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#include "gem_boot_profile.h"
+#include "gem_log.h"
+#include "wntr_ticks.h"
+
+#ifdef __arm__
+#include "sam.h"
+#endif
+
+/* Static variables */
+
+static uint32_t timestamps_[GEM_BOOT_PHASE_COUNT];
+
+static const char* const phase_names_[GEM_BOOT_PHASE_COUNT] = {
+    "main",
+    "settings",
+    "ramp table",
+    "dac",
+    "adc",
+    "outputs",
+    "usb",
+    "leds",
+    "sysex",
+    "first update",
+};
+
+/* Public functions */
+
+void gem_boot_profile_mark(enum GemBootPhase phase) { timestamps_[phase] = gem_boot_profile_now(); }
+
+uint32_t gem_boot_profile_time(enum GemBootPhase phase) { return timestamps_[phase]; }
+
+uint32_t gem_boot_profile_now() {
+#ifdef __arm__
+    // wntr_ticks() only counts milliseconds, so use the SysTick counter to
+    // find out how far into the current millisecond it is. SysTick counts
+    // down from LOAD and reloads each time the millisecond count increases,
+    // so read it again if the count changed in the middle.
+    uint32_t ms;
+    uint32_t count;
+    do {
+        ms = wntr_ticks();
+        count = SysTick->VAL;
+    } while (ms != wntr_ticks());
+
+    uint32_t load = SysTick->LOAD;
+    return ms * 1000 + ((load - count) * 1000) / (load + 1);
+#else
+    return wntr_ticks() * 1000;
+#endif
+}
+
+void gem_boot_profile_print() {
+    uint32_t previous = 0;
+    for (size_t i = 0; i < GEM_BOOT_PHASE_COUNT; i++) {
+        if (timestamps_[i] == 0) {
+            continue;
+        }
+        GEM_LOG(
+            "Boot: %s at %lu us (+%lu us)\n",
+            phase_names_[i],
+            (unsigned long)(timestamps_[i]),
+            (unsigned long)(timestamps_[i] - previous));
+        previous = timestamps_[i];
+    }
+}
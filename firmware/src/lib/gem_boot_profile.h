@@ -0,0 +1,54 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+/*
+    Boot phase timestamps.
+
+    Each phase is marked with the number of microseconds since the clocks
+    were set up in SystemInit(), so it's easy to see where start-up time goes
+    and how long it takes from power-on until the outputs are running.
+*/
+
+#include <stdint.h>
+
+/* Phases are listed in the order that init_() reaches them. */
+enum GemBootPhase {
+    /* main() was called. */
+    GEM_BOOT_PHASE_MAIN = 0,
+    /* User settings were loaded from NVM. */
+    GEM_BOOT_PHASE_SETTINGS = 1,
+    /* Ramp table was loaded from NVM. */
+    GEM_BOOT_PHASE_RAMP_TABLE = 2,
+    /* I2C and the external DAC are ready. */
+    GEM_BOOT_PHASE_DAC = 3,
+    /* The ADC is scanning the inputs. */
+    GEM_BOOT_PHASE_ADC = 4,
+    /* The oscillators are configured and the TCC outputs are running. */
+    GEM_BOOT_PHASE_OUTPUTS = 5,
+    /* USB was initialized, enumeration happens later in the main loop. */
+    GEM_BOOT_PHASE_USB = 6,
+    /* SPI, the Dotstars, and the LED animation are ready. */
+    GEM_BOOT_PHASE_LEDS = 7,
+    /* SysEx commands are registered, init_() is finished. */
+    GEM_BOOT_PHASE_SYSEX = 8,
+    /* The oscillator task updated the outputs for the first time. */
+    GEM_BOOT_PHASE_FIRST_UPDATE = 9,
+    GEM_BOOT_PHASE_COUNT,
+};
+
+/* Records the current time for the given phase. */
+void gem_boot_profile_mark(enum GemBootPhase phase);
+
+/* Returns when the phase was reached in microseconds, or 0 if it hasn't been. */
+uint32_t gem_boot_profile_time(enum GemBootPhase phase);
+
+/* Returns the number of microseconds since SystemInit(). */
+uint32_t gem_boot_profile_now();
+
+/* Logs each phase's timestamp and how long it took. */
+void gem_boot_profile_print();
@@ -0,0 +1,22 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#include "gem_crc32.h"
+
+/* Reversed representation of the polynomial 0x04C11DB7. */
+#define CRC32_POLYNOMIAL 0xEDB88320
+
+uint32_t gem_crc32(uint32_t crc, const uint8_t* data, size_t len) {
+    // This is the bitwise version which is slower than a table-driven one,
+    // but it's only used on small amounts of data and doesn't cost 1kB of
+    // flash for the table.
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (uint8_t b = 0; b < 8; b++) { crc = (crc >> 1) ^ (CRC32_POLYNOMIAL & -(crc & 1)); }
+    }
+    return ~crc;
+}
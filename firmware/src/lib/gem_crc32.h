@@ -0,0 +1,20 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+    Standard (IEEE 802.3) CRC-32 used to check data stored in NVM or sent
+    over SysEx.
+
+    This matches zlib's crc32(), including how it's chained: start with a `crc`
+    of 0 and pass the previous result to continue over more data. That means
+    Python's `zlib.crc32()` can be used to check the result on the host.
+*/
+uint32_t gem_crc32(uint32_t crc, const uint8_t* data, size_t len);
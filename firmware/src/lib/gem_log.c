@@ -0,0 +1,134 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#include "gem_log.h"
+#include "wntr_assert.h"
+#include <stdbool.h>
+
+#ifdef __arm__
+#include "SEGGER_RTT.h"
+#endif
+
+/* RTT channel 0 is used by printf. */
+#define RTT_CHANNEL 1
+#define RTT_BUFFER_SIZE 128
+#define DRAIN_CHUNK_SIZE 32
+
+/* Static variables */
+
+static uint8_t buffer_[GEM_LOG_BUFFER_SIZE];
+static size_t head_ = 0;
+static size_t count_ = 0;
+static uint32_t dropped_ = 0;
+
+#ifdef __arm__
+static uint8_t rtt_buffer_[RTT_BUFFER_SIZE];
+static bool rtt_configured_ = false;
+#endif
+
+/* Forward declarations */
+
+static bool write_record_(uint16_t id, const uint32_t* args, uint8_t argc);
+static void push_(uint8_t byte);
+
+/* Public functions */
+
+void gem_log_write(uint16_t id, const uint32_t* args, uint8_t argc) {
+    WNTR_ASSERT(argc <= GEM_LOG_MAX_ARGS);
+
+    // Let the host know that messages were lost before writing anything new,
+    // otherwise it'd look like messages were just missing.
+    if (dropped_ > 0) {
+        if (!write_record_(GEM_LOG_DROPPED_ID, &dropped_, 1)) {
+            dropped_++;
+            return;
+        }
+        dropped_ = 0;
+    }
+
+    if (!write_record_(id, args, argc)) {
+        dropped_++;
+    }
+}
+
+size_t gem_log_read(uint8_t* dst, size_t len) {
+    // Only whole records are copied so that the host never sees a partial
+    // record, even if the buffer fills up between reads.
+    size_t tail = (head_ + GEM_LOG_BUFFER_SIZE - count_) % GEM_LOG_BUFFER_SIZE;
+    size_t copied = 0;
+
+    while (copied < count_) {
+        uint8_t argc = buffer_[(tail + copied + 2) % GEM_LOG_BUFFER_SIZE];
+        size_t record_len = GEM_LOG_RECORD_HEADER_SIZE + argc * 4;
+        if (copied + record_len > len) {
+            break;
+        }
+        for (size_t i = 0; i < record_len; i++) {
+            dst[copied + i] = buffer_[(tail + copied + i) % GEM_LOG_BUFFER_SIZE];
+        }
+        copied += record_len;
+    }
+
+    count_ -= copied;
+    return copied;
+}
+
+void gem_log_drain() {
+#ifdef __arm__
+    if (!rtt_configured_) {
+        SEGGER_RTT_ConfigUpBuffer(
+            RTT_CHANNEL, "GemLog", rtt_buffer_, sizeof(rtt_buffer_), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+        rtt_configured_ = true;
+    }
+
+    if (count_ == 0) {
+        return;
+    }
+
+    // Only take as much as RTT has room for. If the host isn't reading then
+    // the records stay here, and once the buffer is full new messages are
+    // counted as dropped.
+    unsigned available = SEGGER_RTT_GetAvailWriteSpace(RTT_CHANNEL);
+    uint8_t chunk[DRAIN_CHUNK_SIZE];
+    size_t len = gem_log_read(chunk, available < sizeof(chunk) ? available : sizeof(chunk));
+    if (len > 0) {
+        SEGGER_RTT_Write(RTT_CHANNEL, chunk, len);
+    }
+#endif
+}
+
+void gem_log_reset() {
+    head_ = 0;
+    count_ = 0;
+    dropped_ = 0;
+}
+
+/* Private functions */
+
+static bool write_record_(uint16_t id, const uint32_t* args, uint8_t argc) {
+    size_t record_len = GEM_LOG_RECORD_HEADER_SIZE + argc * 4;
+    if (count_ + record_len > GEM_LOG_BUFFER_SIZE) {
+        return false;
+    }
+
+    push_(id & 0xFF);
+    push_(id >> 8);
+    push_(argc);
+    for (uint8_t i = 0; i < argc; i++) {
+        push_(args[i] & 0xFF);
+        push_((args[i] >> 8) & 0xFF);
+        push_((args[i] >> 16) & 0xFF);
+        push_((args[i] >> 24) & 0xFF);
+    }
+
+    return true;
+}
+
+static void push_(uint8_t byte) {
+    buffer_[head_] = byte;
+    head_ = (head_ + 1) % GEM_LOG_BUFFER_SIZE;
+    count_++;
+}
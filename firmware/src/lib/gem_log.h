@@ -0,0 +1,93 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+/*
+    Tokenized logging.
+
+    Formatting strings with printf on the SAM D21 takes much longer than
+    most of the events being logged. GEM_LOG() instead records a message ID
+    and the raw arguments into a small RAM ring buffer, and gem_log_drain()
+    copies the buffer out to RTT channel 1 when the main loop is idle. The
+    device never formats anything, scripts/gem_log_decode.py rebuilds the
+    text on the host.
+
+    Format strings are placed in the `.gem_log` section. The linker script
+    puts that section at address 0 and doesn't load it onto the device, so
+    each string's address is a small ID and the strings don't take up any
+    flash. The decoder reads them back from the firmware's ELF file.
+
+    Each record in the buffer is:
+
+        ID(2) ARGC(1) ARGS(4 * ARGC)
+
+    All values are little-endian. Arguments are stored as 32-bit values, so
+    `%s` arguments must be strings in flash. The decoder looks them up in
+    the ELF file too.
+
+    On the host (the tests and the simulator) GEM_LOG() is just printf().
+
+    GEM_LOG() is not safe to call from interrupt handlers.
+*/
+
+#include "printf.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define GEM_LOG_BUFFER_SIZE 256
+#define GEM_LOG_MAX_ARGS 6
+#define GEM_LOG_RECORD_HEADER_SIZE 3
+
+/* Reserved ID for the record written after messages were dropped, its argument is how many. */
+#define GEM_LOG_DROPPED_ID 0xFFFF
+
+/*
+    Records a message ID and its arguments. Use GEM_LOG() instead of
+    calling this directly. If the buffer is full the record is dropped and
+    a "dropped messages" record is written once there's room again.
+*/
+void gem_log_write(uint16_t id, const uint32_t* args, uint8_t argc);
+
+/* Copies up to `len` bytes of whole records out of the buffer. Returns the number of bytes copied. */
+size_t gem_log_read(uint8_t* dst, size_t len);
+
+/* Copies as much of the buffer as fits into RTT channel 1. Called from the main loop when idle. */
+void gem_log_drain();
+
+/* Resets the buffer, only used by tests. */
+void gem_log_reset();
+
+#ifdef __arm__
+
+#define GEM_LOG(fmt, ...)                                                                                              \
+    do {                                                                                                               \
+        static const char _gem_log_fmt[] __attribute__((section(".gem_log"), used)) = fmt;                            \
+        const uint32_t _gem_log_args[] = {0 GEM_LOG_MAP_(GEM_LOG_NARGS_(__VA_ARGS__), ##__VA_ARGS__)};                 \
+        gem_log_write((uint16_t)((uintptr_t)(_gem_log_fmt)), _gem_log_args + 1, GEM_LOG_NARGS_(__VA_ARGS__));        \
+    } while (0)
+
+#else
+
+#define GEM_LOG(fmt, ...) printf(fmt, ##__VA_ARGS__)
+
+#endif
+
+/* Helpers for GEM_LOG(), they convert each argument to a uint32_t. */
+
+#define GEM_LOG_NARGS_(...) GEM_LOG_NARGS_IMPL_(0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define GEM_LOG_NARGS_IMPL_(_0, _1, _2, _3, _4, _5, _6, N, ...) N
+#define GEM_LOG_CONCAT_(a, b) GEM_LOG_CONCAT_IMPL_(a, b)
+#define GEM_LOG_CONCAT_IMPL_(a, b) a##b
+#define GEM_LOG_ARG_(x) , (uint32_t)((uintptr_t)(x))
+#define GEM_LOG_MAP_(n, ...) GEM_LOG_CONCAT_(GEM_LOG_MAP_, n)(__VA_ARGS__)
+#define GEM_LOG_MAP_0()
+#define GEM_LOG_MAP_1(a) GEM_LOG_ARG_(a)
+#define GEM_LOG_MAP_2(a, ...) GEM_LOG_ARG_(a) GEM_LOG_MAP_1(__VA_ARGS__)
+#define GEM_LOG_MAP_3(a, ...) GEM_LOG_ARG_(a) GEM_LOG_MAP_2(__VA_ARGS__)
+#define GEM_LOG_MAP_4(a, ...) GEM_LOG_ARG_(a) GEM_LOG_MAP_3(__VA_ARGS__)
+#define GEM_LOG_MAP_5(a, ...) GEM_LOG_ARG_(a) GEM_LOG_MAP_4(__VA_ARGS__)
+#define GEM_LOG_MAP_6(a, ...) GEM_LOG_ARG_(a) GEM_LOG_MAP_5(__VA_ARGS__)
@@ -0,0 +1,53 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#include "gem_memory.h"
+
+#ifdef __arm__
+#include "sam.h"
+
+/* Leave the words just below the stack pointer alone, they belong to the caller. */
+#define PAINT_MARGIN 16
+
+/* Defined in the linker script. */
+extern uint32_t _srelocate;
+extern uint32_t _ezero;
+extern uint32_t _sstack;
+extern uint32_t _estack;
+#endif
+
+/* Public functions */
+
+void gem_memory_paint_stack() {
+#ifdef __arm__
+    uint32_t* stack_pointer = (uint32_t*)(__get_MSP());
+    gem_memory_paint(&_sstack, stack_pointer - PAINT_MARGIN);
+#endif
+}
+
+void gem_memory_usage(struct GemMemoryUsage* usage) {
+#ifdef __arm__
+    usage->ram_size = HMCRAMC0_SIZE;
+    usage->static_size = (uint32_t)(&_ezero) - (uint32_t)(&_srelocate);
+    usage->stack_size = (uint32_t)(&_estack) - (uint32_t)(&_sstack);
+    usage->stack_high_water = gem_memory_used(&_sstack, &_estack);
+#else
+    usage->ram_size = 0;
+    usage->static_size = 0;
+    usage->stack_size = 0;
+    usage->stack_high_water = 0;
+#endif
+}
+
+void gem_memory_paint(uint32_t* start, uint32_t* end) {
+    for (uint32_t* word = start; word < end; word++) { *word = GEM_MEMORY_PAINT; }
+}
+
+size_t gem_memory_used(const uint32_t* start, const uint32_t* end) {
+    const uint32_t* word = start;
+    while (word < end && *word == GEM_MEMORY_PAINT) { word++; }
+    return (size_t)(end - word) * sizeof(uint32_t);
+}
@@ -0,0 +1,52 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+/*
+    Runtime RAM usage.
+
+    -Wstack-usage only checks each function's own frame, it can't tell how
+    deep a chain of calls, such as a SysEx handler writing to NVM, actually
+    goes. So the stack is painted with a known pattern at boot and later
+    scanned to find how much of it has ever been used, the stack's
+    "high-water mark".
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GEM_MEMORY_PAINT 0xDEADBEEF
+
+struct GemMemoryUsage {
+    /* Total RAM. */
+    uint32_t ram_size;
+    /* RAM used by static variables (.relocate and .bss). */
+    uint32_t static_size;
+    /* Space reserved for the stack. */
+    uint32_t stack_size;
+    /* The most stack that's been used since boot. */
+    uint32_t stack_high_water;
+};
+
+/*
+    Paints the unused part of the stack. Call this as early as possible in
+    main(), before interrupts are enabled.
+*/
+void gem_memory_paint_stack();
+
+/* Measures RAM usage. On the host everything is 0. */
+void gem_memory_usage(struct GemMemoryUsage* usage);
+
+/* Fills the words from `start` up to `end` with GEM_MEMORY_PAINT. */
+void gem_memory_paint(uint32_t* start, uint32_t* end);
+
+/*
+    Returns how many bytes at the top of the region from `start` to `end`
+    have been used. Stacks grow down, so this scans up from `start` until it
+    finds a word that isn't painted.
+*/
+size_t gem_memory_used(const uint32_t* start, const uint32_t* end);
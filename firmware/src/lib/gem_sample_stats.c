@@ -0,0 +1,69 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#include "gem_sample_stats.h"
+#include "wntr_assert.h"
+
+/* Forward declarations */
+
+static fix16_t divide_to_fix16_(uint64_t numerator, uint64_t denominator);
+
+/* Public functions */
+
+void GemSampleStats_init(struct GemSampleStats* stats) {
+    stats->count = 0;
+    stats->min = UINT16_MAX;
+    stats->max = 0;
+    stats->sum = 0;
+    stats->sum_of_squares = 0;
+}
+
+void GemSampleStats_add(struct GemSampleStats* stats, uint16_t sample) {
+    WNTR_ASSERT(stats->count < GEM_SAMPLE_STATS_MAX_COUNT);
+
+    stats->count++;
+    stats->sum += sample;
+    stats->sum_of_squares += (uint32_t)(sample) * (uint32_t)(sample);
+    if (sample < stats->min) {
+        stats->min = sample;
+    }
+    if (sample > stats->max) {
+        stats->max = sample;
+    }
+}
+
+fix16_t GemSampleStats_mean(const struct GemSampleStats* stats) {
+    if (stats->count == 0) {
+        return 0;
+    }
+    return divide_to_fix16_(stats->sum, stats->count);
+}
+
+fix16_t GemSampleStats_variance(const struct GemSampleStats* stats) {
+    if (stats->count == 0) {
+        return 0;
+    }
+
+    // var = (n * Σx² - (Σx)²) / n², which avoids dividing until the very end.
+    uint64_t n = stats->count;
+    uint64_t sum = stats->sum;
+    return divide_to_fix16_(n * stats->sum_of_squares - sum * sum, n * n);
+}
+
+/* Private functions */
+
+static fix16_t divide_to_fix16_(uint64_t numerator, uint64_t denominator) {
+    // The integer and fractional parts are calculated separately so that
+    // shifting the numerator can't overflow.
+    uint64_t integer = numerator / denominator;
+    uint64_t remainder = numerator % denominator;
+
+    if (integer > (uint64_t)(fix16_maximum >> 16)) {
+        return fix16_maximum;
+    }
+
+    return (fix16_t)((integer << 16) + (remainder << 16) / denominator);
+}
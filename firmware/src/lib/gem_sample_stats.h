@@ -0,0 +1,39 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+#include "fix16.h"
+#include <stdint.h>
+
+/*
+    Running statistics over a set of ADC samples. This lets the firmware
+    summarize many measurements on the device instead of sending each one
+    to the host.
+
+    The sums are kept as integers so that the results are exact. Keeping the
+    count at or below GEM_SAMPLE_STATS_MAX_COUNT guarantees the sums can't
+    overflow even for full 16-bit samples.
+*/
+
+#define GEM_SAMPLE_STATS_MAX_COUNT 4096
+
+struct GemSampleStats {
+    uint16_t count;
+    uint16_t min;
+    uint16_t max;
+    uint32_t sum;
+    uint64_t sum_of_squares;
+};
+
+void GemSampleStats_init(struct GemSampleStats* stats);
+void GemSampleStats_add(struct GemSampleStats* stats, uint16_t sample);
+
+/* Mean of the samples, saturated to the range of fix16. */
+fix16_t GemSampleStats_mean(const struct GemSampleStats* stats);
+
+/* Population variance of the samples, saturated to the range of fix16. */
+fix16_t GemSampleStats_variance(const struct GemSampleStats* stats);
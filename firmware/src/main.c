@@ -6,8 +6,14 @@
 
 #include "fix16.h"
 #include "gem.h"
-#include "printf.h"
+#include "gem_boot_profile.h"
+#include "gem_log.h"
+#include "gem_memory.h"
+#include "gem_midi_pitch.h"
+#include "gem_trace.h"
 #include "sam.h"
+#include "tusb.h"
+#include "wntr_midi_tx.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -37,6 +43,12 @@ static RAMFUNC void oscillator_task_();
 static RAMFUNC void monitor_task_();
 static RAMFUNC void pulse_ovf_callback_(uint8_t inst);
 static RAMFUNC void update_dac_();
+static void start_audio_fm_();
+static void apply_settings_();
+static void apply_pending_settings_();
+static void record_midi_latency_(struct GemMIDIPitch* midi_pitch);
+static void reset_midi_pitch_();
+static void settings_changed_callback_();
 static wntr_periodic_waveform_function lfo_waveshape_setting_to_func_(uint8_t n);
 
 /* Configuration */
@@ -77,7 +89,9 @@ static struct KnobsState tweak_knobs_ = {
 
 /* State */
 
+/* The settings in use, a copy of gem_settings_cache taken between frames. */
 static struct GemSettings settings_;
+static bool settings_pending_ = false;
 static struct {
     wntr_periodic_waveform_function functions[2];
     fix16_t frequencies[2];
@@ -89,6 +103,11 @@ static struct GemOscillator castor_;
 static struct GemOscillator pollux_;
 static struct GemOscillatorInputs castor_inputs_;
 static struct GemOscillatorInputs pollux_inputs_;
+static struct GemFMTable audio_fm_table_;
+static struct GemQuantizer quantizer_;
+static struct GemPitchSmoothing pitch_smoothing_;
+static struct GemMIDIPitch castor_midi_;
+static struct GemMIDIPitch pollux_midi_;
 static enum GemMode mode_ = GEM_MODE_NORMAL;
 static bool tweaking_ = false;
 
@@ -97,6 +116,8 @@ static bool tweaking_ = false;
 static uint32_t animation_time_ = 0;
 static uint32_t sample_time_ = 0;
 static uint32_t idle_cycles_ = 0;
+static uint16_t midi_rx_peak_depth_ = 0;
+static uint16_t midi_latency_max_ = 0;
 
 /*
     Main, where all things happen.
@@ -105,9 +126,15 @@ static uint32_t idle_cycles_ = 0;
     are expected to be behave and yield time to other tasks.
 */
 int main(void) {
+    // Paint the stack before anything else so that its high-water mark can
+    // be measured over SysEx.
+    gem_memory_paint_stack();
+    gem_boot_profile_mark(GEM_BOOT_PHASE_MAIN);
+
     init_();
 
     uint32_t last_sample_time = wntr_ticks();
+    bool first_update = true;
 
     while (1) {
         wntr_usb_task();
@@ -115,10 +142,13 @@ int main(void) {
         digital_input_task_();
         lfo_task_();
 
-        // The LED animation task internally ensures that it only runs once
-        // every few milliseconds. See GEM_ANIMATION_INTERVAL.
-        uint32_t animation_start_time = wntr_ticks();
-        if (gem_led_animation_step(dotstar_cfg_)) {
+        // The LED animation only draws a frame once every few milliseconds,
+        // see GEM_ANIMATION_INTERVAL. Only time and trace the loops that do.
+        if (gem_led_animation_due()) {
+            uint32_t animation_start_time = wntr_ticks();
+            gem_trace_begin(GEM_TRACE_REGION_LED_ANIMATION);
+            gem_led_animation_step(dotstar_cfg_);
+            gem_trace_end(GEM_TRACE_REGION_LED_ANIMATION);
             animation_time_ = wntr_ticks() - animation_start_time;
         }
 
@@ -127,15 +157,43 @@ int main(void) {
         // constantly scanning in the background, so that gives the USB, MIDI,
         // and LED animation tasks time to run between oscillator updates.
         if (gem_adc_results_ready()) {
+            // Settings written over SysEx are applied here, before any of
+            // this frame's tasks run, so that the whole frame sees a single
+            // consistent set of settings.
+            if (settings_pending_) {
+                apply_pending_settings_();
+            }
+
             sample_time_ = (uint16_t)(wntr_ticks() - last_sample_time);
             last_sample_time = wntr_ticks();
+
+            gem_trace_begin(GEM_TRACE_REGION_ANALOG_INPUT);
             analog_input_task_();
+            gem_trace_end(GEM_TRACE_REGION_ANALOG_INPUT);
+
+            gem_trace_begin(GEM_TRACE_REGION_OSCILLATOR);
             oscillator_task_();
+            gem_trace_end(GEM_TRACE_REGION_OSCILLATOR);
+
+            if (first_update) {
+                first_update = false;
+                gem_boot_profile_mark(GEM_BOOT_PHASE_FIRST_UPDATE);
+                gem_boot_profile_print();
+            }
+
             monitor_task_();
             idle_cycles_ = 0;
         } else {
             idle_cycles_++;
+
+            // Log messages are only sent to the host when there's nothing
+            // else to do.
+            gem_log_drain();
         }
+
+        // Responses and monitor updates are queued as they're sent and
+        // written to USB together once per loop.
+        wntr_midi_flush();
     }
 
     return 0;
@@ -183,16 +241,11 @@ static void init_() {
         led_cfg_ = &GEM_II_LED_CFG;
     }
 
-    // Tell the world who we are and how we got here. :)
-    printf("Hello, I am Gemini.\n - hardware: rev%u\n - firmware: %s\n", board_revision_, wntr_build_info_string());
-
-    // Gemini uses a pseudo-random number generator for the LED animation.
-    // To keep things simple, it just uses its serial number as the seed.
-    // If it needs to be more fancy in the future it could be changed to read
-    // a floating ADC input and use that as the seed.
-    uint8_t serial_number[WNTR_SERIAL_NUMBER_LEN];
-    wntr_serial_number(serial_number);
-    wntr_random_init(*((uint32_t*)(serial_number)));
+    // The rest of init_() is ordered so that the oscillators start making
+    // sound as soon as possible after power-on: only what's needed to run
+    // the outputs is set up first, then everything else (USB, LEDs, and
+    // SysEx) is set up afterwards. Each phase is timestamped so that the
+    // boot time can be checked, see gem_boot_profile.h.
 
     //
     // Load persistent configuration stored in non-volatile RAM
@@ -200,39 +253,24 @@ static void init_() {
 
     // Gemini stores the user configurable settings in NVM so they have to be
     // explicitly loaded.
-    GemSettings_load(&settings_);
-    GemSettings_print(&settings_);
+    gem_settings_cache_load();
+    settings_ = gem_settings_cache;
+    gem_boot_profile_mark(GEM_BOOT_PHASE_SETTINGS);
 
     // Gemini also stores a ramp table in NVM. This table is used to
     // compensate for amplitude loss in the ramp waveform as frequency
     // increases.
     gem_ramp_table_load();
+    gem_boot_profile_mark(GEM_BOOT_PHASE_RAMP_TABLE);
 
     //
-    // Peripheral setup
+    // Peripherals needed for the outputs
     //
 
-    // Gemini uses USB MIDI for editing settings and factory configuration.
-    wntr_usb_init();
-
     // Gemini uses i2c to communicate with the external DAC.
     gem_i2c_init(i2c_cfg_);
     gem_mcp_4728_init(i2c_cfg_);
-
-    // Gemini uses SPI to communicate with the Dotstar LEDs.
-    gem_spi_init(spi_cfg_);
-
-    //
-    // Driver configuration
-    //
-
-    /* Register SysEx commands used for factory setup. */
-    gem_sysex_init(board_revision_, adc_inputs_, i2c_cfg_, &pulse_cfg_);
-
-    /* Enable the Dotstar driver and LED animation. */
-    gem_dotstar_init(settings_.led_brightness);
-    gem_led_animation_init(*led_cfg_);
-    gem_led_animation_set_mode(mode_);
+    gem_boot_profile_mark(GEM_BOOT_PHASE_DAC);
 
     // Set up the SAMD21's ADC.
     //
@@ -246,6 +284,7 @@ static void init_() {
     // while waiting for new measurements for all the channels.
     for (size_t i = 0; i < GEM_IN_COUNT; i++) { gem_adc_init_input(&(adc_inputs_[i])); }
     gem_adc_start_scanning(adc_inputs_, GEM_IN_COUNT, adc_results_);
+    gem_boot_profile_mark(GEM_BOOT_PHASE_ADC);
 
     // The WntrButton helper is used for the panel button so Gemini can check
     // if it's tapped or held.
@@ -257,75 +296,94 @@ static void init_() {
     // Oscillator configuration and initialization.
     //
 
-    // Gemini has an internal low-frequency oscillator that can be used to
-    // modulate the pitch and pulse width of the primary oscillators.
-    lfo_settings_.functions[0] = lfo_waveshape_setting_to_func_(settings_.lfo_1_waveshape);
-    lfo_settings_.functions[1] = lfo_waveshape_setting_to_func_(settings_.lfo_2_waveshape);
-    lfo_settings_.frequencies[0] = settings_.lfo_1_frequency;
-    lfo_settings_.frequencies[1] = fix16_mul(settings_.lfo_1_frequency, settings_.lfo_2_frequency_ratio);
-    lfo_settings_.factors[0] = settings_.lfo_1_factor;
-    lfo_settings_.factors[1] = settings_.lfo_2_factor;
-    lfo_settings_.phases[0] = F16(0);
-    lfo_settings_.phases[1] = F16(0);
-    WntrMixedPeriodicWaveform_init(
-        &lfo_,
-        2,
-        lfo_settings_.functions,
-        lfo_settings_.frequencies,
-        lfo_settings_.factors,
-        lfo_settings_.phases,
-        wntr_ticks());
-
     // Gemini has two oscillators - Castor & Pollux. For the most part they're
     // completely independent: they each have their own pitch and pulse width
     // inputs, their own pitch knob range configuration, and their own
     // dedicated outputs.
     //
-    // They share a small amount of common configuration: the ADC error
-    // calibration data and pitch knob non-linearity setting.
-    gem_oscillator_init(
-        (struct WntrErrorCorrection){.offset = settings_.cv_offset_error, .gain = settings_.cv_gain_error},
-        settings_.pitch_knob_nonlinearity);
-
+    // The parts of their configuration that come from the user settings are
+    // filled in by apply_settings_() below.
     castor_ = (struct GemOscillator){
         .number = 0,
-        .pitch_offset = settings_.base_cv_offset,
         .pitch_cv_min = osc_input_cfg_->pitch_cv_min,
         .pitch_cv_max = osc_input_cfg_->pitch_cv_max,
-        .lfo_pitch_factor = settings_.chorus_max_intensity,
-        .pitch_knob_min = settings_.castor_knob_min,
-        .pitch_knob_max = settings_.castor_knob_max,
-        .pulse_width_bitmask = settings_.pulse_width_bitmask,
         .can_follow = false,
-        .zero_detection_enabled = settings_.zero_detection_enabled,
-        .zero_detection_threshold = settings_.zero_detection_threshold,
-        .quantization_enabled = settings_.quantization_enabled,
     };
-    GemOscillator_init(&castor_);
 
+    // If Pollux doesn't have any pitch CV input it'll follow Castor's
+    // pitch. C&PI detects lack of pitch CV input by checking if Pollux's
+    // pitch CV is near zero. C&PII has a switched jack, but still does
+    // the near zero check to follow Castor when both pitch inputs are
+    // unpatched.
     pollux_ = (struct GemOscillator){
         .number = 1,
-        .pitch_offset = settings_.base_cv_offset,
         .pitch_cv_min = osc_input_cfg_->pitch_cv_min,
         .pitch_cv_max = osc_input_cfg_->pitch_cv_max,
-        .lfo_pitch_factor = settings_.chorus_max_intensity,
-        .pitch_knob_min = settings_.pollux_knob_min,
-        .pitch_knob_max = settings_.pollux_knob_max,
-        .pulse_width_bitmask = settings_.pulse_width_bitmask,
-        // If Pollux doesn't have any pitch CV input it'll follow Castor's
-        // pitch. C&PI detects lack of pitch CV input by checking if Pollux's
-        // pitch CV is near zero. C&PII has a switched jack, but still does
-        // the near zero check to follow Castor when both pitch inputs are
-        // unpatched.
-        .zero_detection_enabled = settings_.zero_detection_enabled,
-        .zero_detection_threshold = settings_.zero_detection_threshold,
     };
+
+    apply_settings_();
+
+    GemOscillator_init(&castor_);
     GemOscillator_init(&pollux_);
 
+    // Gemini has an internal low-frequency oscillator that can be used to
+    // modulate the pitch and pulse width of the primary oscillators. The
+    // waveform keeps pointers to lfo_settings_, so changing the settings
+    // later takes effect on the next step.
+    lfo_settings_.phases[0] = F16(0);
+    lfo_settings_.phases[1] = F16(0);
+    WntrMixedPeriodicWaveform_init(
+        &lfo_,
+        2,
+        lfo_settings_.functions,
+        lfo_settings_.frequencies,
+        lfo_settings_.factors,
+        lfo_settings_.phases,
+        wntr_ticks());
+
+    // In audio FM mode, Pollux's period is modulated by a sine wave that's
+    // stepped each time Castor's timer overflows.
+    GemFMTable_init(&audio_fm_table_, wntr_sine, GEM_AUDIO_FM_TABLE_LEN);
+
     // Configure the SAMD21's TCC peripheral to output the square waves needed
     // by the oscillators' ramp core.
-    pulse_cfg_.gclk_freq = settings_.osc8m_freq;
     gem_pulseout_init(&pulse_cfg_, pulse_ovf_callback_);
+    gem_boot_profile_mark(GEM_BOOT_PHASE_OUTPUTS);
+
+    //
+    // Everything else
+    //
+
+    // Gemini uses USB MIDI for editing settings and factory configuration.
+    // This only starts the USB peripheral, enumeration happens as the main
+    // loop calls wntr_usb_task().
+    wntr_usb_init();
+    gem_boot_profile_mark(GEM_BOOT_PHASE_USB);
+
+    // Gemini uses a pseudo-random number generator for the LED animation.
+    // To keep things simple, it just uses its serial number as the seed.
+    // If it needs to be more fancy in the future it could be changed to read
+    // a floating ADC input and use that as the seed.
+    uint8_t serial_number[WNTR_SERIAL_NUMBER_LEN];
+    wntr_serial_number(serial_number);
+    wntr_random_init(*((uint32_t*)(serial_number)));
+
+    // Gemini uses SPI to communicate with the Dotstar LEDs.
+    gem_spi_init(spi_cfg_);
+
+    /* Enable the Dotstar driver and LED animation. */
+    gem_dotstar_init(settings_.led_brightness);
+    gem_led_animation_init(*led_cfg_);
+    gem_led_animation_set_mode(mode_);
+    gem_boot_profile_mark(GEM_BOOT_PHASE_LEDS);
+
+    /* Register SysEx commands used for factory setup. */
+    gem_sysex_init(board_revision_, adc_inputs_, i2c_cfg_, &pulse_cfg_);
+    gem_sysex_set_settings_callback(settings_changed_callback_);
+    gem_boot_profile_mark(GEM_BOOT_PHASE_SYSEX);
+
+    // Tell the world who we are and how we got here. :)
+    GEM_LOG("Hello, I am Gemini.\n - hardware: rev%u\n - firmware: %s\n", board_revision_, wntr_build_info_string());
 }
 
 /*
@@ -340,8 +398,17 @@ static RAMFUNC void digital_input_task_() {
 
     // If the button was just tapped the change to the next mode.
     if (WntrButton_tapped(&button_)) {
+        enum GemMode last_mode = mode_;
         mode_ = (mode_ + 1) % GEM_MODE_COUNT;
         gem_led_animation_set_mode(mode_);
+
+        // Audio FM mode hands Pollux's period over to the DMA controller, so
+        // the period stream has to be started and stopped with the mode.
+        if (mode_ == GEM_MODE_AUDIO_FM) {
+            start_audio_fm_();
+        } else if (last_mode == GEM_MODE_AUDIO_FM) {
+            gem_pulseout_stop_period_stream();
+        }
     }
 
     // If we just entered tweak mode, clear all of the tweak knobs latches
@@ -455,6 +522,8 @@ static RAMFUNC void oscillator_task_() {
     castor_inputs_.tweak_lfo_knob_code = tweak_knobs_.lfo;
     castor_inputs_.reference_pitch = F16(0);
     castor_inputs_.lfo_amplitude = lfo_.amplitude;
+    castor_inputs_.midi_active = GemMIDIPitch_active(&castor_midi_);
+    castor_inputs_.midi_pitch = GemMIDIPitch_volts(&castor_midi_);
 
     GemOscillator_update(&castor_, castor_inputs_);
 
@@ -469,6 +538,8 @@ static RAMFUNC void oscillator_task_() {
     pollux_inputs_.tweak_lfo_knob_code = tweak_knobs_.lfo;
     pollux_inputs_.reference_pitch = castor_.pitch;
     pollux_inputs_.lfo_amplitude = lfo_.amplitude;
+    pollux_inputs_.midi_active = GemMIDIPitch_active(&pollux_midi_);
+    pollux_inputs_.midi_pitch = GemMIDIPitch_volts(&pollux_midi_);
 
     GemOscillator_update(&pollux_, pollux_inputs_);
 
@@ -476,6 +547,14 @@ static RAMFUNC void oscillator_task_() {
     GemOscillator_post_update(&pulse_cfg_, &castor_);
     GemOscillator_post_update(&pulse_cfg_, &pollux_);
 
+    // In audio FM mode, Pollux's period is streamed into its timer by the DMA
+    // controller. Instead of setting the period directly, the period table is
+    // regenerated whenever Pollux's pitch or modulation depth changes.
+    bool audio_fm = mode_ == GEM_MODE_AUDIO_FM;
+    if (audio_fm && GemFMTable_generate(&audio_fm_table_, pollux_.pulseout_period, pollux_.fm_depth)) {
+        gem_pulseout_set_compare(&pulse_cfg_, 1, audio_fm_table_.min_period / 2);
+    }
+
     // Update the timers with their new values calculated from their
     // oscillator's pitch.
     //
@@ -484,9 +563,14 @@ static RAMFUNC void oscillator_task_() {
     // disabled while Gemini modifies the timer configuration.
     __disable_irq();
     gem_pulseout_set_period(&pulse_cfg_, 0, castor_.pulseout_period);
-    gem_pulseout_set_period(&pulse_cfg_, 1, pollux_.pulseout_period);
+    if (!audio_fm) {
+        gem_pulseout_set_period(&pulse_cfg_, 1, pollux_.pulseout_period);
+    }
     __enable_irq();
 
+    record_midi_latency_(&castor_midi_);
+    record_midi_latency_(&pollux_midi_);
+
     update_dac_();
 }
 
@@ -537,10 +621,22 @@ static RAMFUNC void monitor_task_() {
 
         .loop_time = loop_time,
         .animation_time = (uint16_t)(animation_time_),
-        .sample_time = (uint16_t)(idle_cycles_)};
+        .sample_time = (uint16_t)(idle_cycles_),
+
+        .dac_skipped_writes = gem_mcp_4728_stats()->skipped_writes,
+        .dac_partial_writes = gem_mcp_4728_stats()->partial_writes,
+
+        .midi_rx_peak_depth = midi_rx_peak_depth_,
+        .midi_rx_dropped = wntr_midi_rx_stats()->dropped_sysex,
+        .midi_tx_dropped = wntr_midi_tx_stats()->dropped_messages,
+        .midi_latency = midi_latency_max_};
 
     gem_sysex_send_monitor_update(&monitor_update);
 
+    // The peak queue depth and latency are reported per update.
+    midi_rx_peak_depth_ = 0;
+    midi_latency_max_ = 0;
+
     last_loop_time_ = wntr_ticks();
 }
 
@@ -548,15 +644,62 @@ static RAMFUNC void monitor_task_() {
     Handles incoming MIDI messages and dispatches them to the SysEx handlers.
 */
 static void midi_task_() {
+    size_t pending = wntr_midi_rx_pending();
+    if (pending > midi_rx_peak_depth_) {
+        midi_rx_peak_depth_ = pending;
+    }
+
     struct WntrMIDIMessage msg = {};
-    if (!wntr_midi_receive(&msg)) {
+    for (size_t n = 0; n < GEM_MIDI_PACKET_BUDGET && wntr_midi_rx_pending() > 0; n++) {
+        // Leave the rest for the next loop iteration once the oscillator
+        // task has something to do, but always make some progress.
+        if (n > 0 && gem_adc_results_ready()) {
+            break;
+        }
+        if (!wntr_midi_receive(&msg)) {
+            continue;
+        }
+        if (msg.code_index == MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE) {
+            wntr_midi_dispatch_sysex();
+        } else {
+            // Notes and pitch bend are applied by the next oscillator update.
+            uint32_t now = gem_boot_profile_now();
+            GemMIDIPitch_handle(&castor_midi_, &msg, now);
+            GemMIDIPitch_handle(&pollux_midi_, &msg, now);
+        }
+    }
+}
+
+/*
+    Measures how long it took from receiving a MIDI note or pitch bend to
+    updating the timer's period. The oscillator task runs as soon as the
+    next set of ADC readings is ready and the MIDI task yields to it, so this
+    should stay within about one frame.
+*/
+static void record_midi_latency_(struct GemMIDIPitch* midi_pitch) {
+    if (midi_pitch->changed_at == 0) {
         return;
     }
-    if (msg.code_index == MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE) {
-        wntr_midi_dispatch_sysex();
+
+    uint32_t latency = gem_boot_profile_now() - midi_pitch->changed_at;
+    midi_pitch->changed_at = 0;
+
+    if (latency > UINT16_MAX) {
+        latency = UINT16_MAX;
+    }
+    if (latency > midi_latency_max_) {
+        midi_latency_max_ = latency;
     }
 }
 
+/*
+    Forgets any held notes and pitch bend and picks up the MIDI settings.
+*/
+static void reset_midi_pitch_() {
+    GemMIDIPitch_init(&castor_midi_, settings_.castor_midi_channel, settings_.midi_pitch_bend_range);
+    GemMIDIPitch_init(&pollux_midi_, settings_.pollux_midi_channel, settings_.midi_pitch_bend_range);
+}
+
 /*
     This is called when the TCC peripheral controlling Castor overflows its
     counter. This is used to reset the TCC controlling Pollux to achieve the
@@ -602,6 +745,116 @@ static inline __attribute__((always_inline)) void update_dac_() {
     }
 }
 
+/*
+    Derives the LED, LFO, and oscillator configuration from settings_.
+
+    This is called once during init_() and again whenever new settings are
+    written over SysEx. It only changes configuration, the oscillators' and
+    LFO's running state is left alone so the outputs don't glitch.
+*/
+static void apply_settings_() {
+    gem_dotstar_set_brightness(settings_.led_brightness);
+
+    lfo_settings_.functions[0] = lfo_waveshape_setting_to_func_(settings_.lfo_1_waveshape);
+    lfo_settings_.functions[1] = lfo_waveshape_setting_to_func_(settings_.lfo_2_waveshape);
+    lfo_settings_.frequencies[0] = settings_.lfo_1_frequency;
+    lfo_settings_.frequencies[1] = fix16_mul(settings_.lfo_1_frequency, settings_.lfo_2_frequency_ratio);
+    lfo_settings_.factors[0] = settings_.lfo_1_factor;
+    lfo_settings_.factors[1] = settings_.lfo_2_factor;
+
+    // Castor and Pollux share a small amount of common configuration: the
+    // ADC error calibration data and pitch knob non-linearity setting.
+    gem_oscillator_init(
+        (struct WntrErrorCorrection){.offset = settings_.cv_offset_error, .gain = settings_.cv_gain_error},
+        settings_.pitch_knob_nonlinearity);
+
+    castor_.pitch_offset = settings_.base_cv_offset;
+    castor_.lfo_pitch_factor = settings_.chorus_max_intensity;
+    castor_.pitch_knob_min = settings_.castor_knob_min;
+    castor_.pitch_knob_max = settings_.castor_knob_max;
+    castor_.pulse_width_bitmask = settings_.pulse_width_bitmask;
+    castor_.zero_detection_enabled = settings_.zero_detection_enabled;
+    castor_.zero_detection_threshold = settings_.zero_detection_threshold;
+    castor_.quantization_enabled = settings_.quantization_enabled;
+    castor_.fine_quantization_enabled = settings_.fine_quantization_enabled;
+    castor_.quantizer = &quantizer_;
+
+    pollux_.pitch_offset = settings_.base_cv_offset;
+    pollux_.lfo_pitch_factor = settings_.chorus_max_intensity;
+    pollux_.pitch_knob_min = settings_.pollux_knob_min;
+    pollux_.pitch_knob_max = settings_.pollux_knob_max;
+    pollux_.pulse_width_bitmask = settings_.pulse_width_bitmask;
+    pollux_.zero_detection_enabled = settings_.zero_detection_enabled;
+    pollux_.zero_detection_threshold = settings_.zero_detection_threshold;
+    pollux_.fine_quantization_enabled = settings_.fine_quantization_enabled;
+    pollux_.quantizer = &quantizer_;
+
+    GemQuantizer_init(&quantizer_, settings_.quantizer_scale);
+
+    castor_.pitch_smoothing_enabled = settings_.castor_pitch_smoothing;
+    castor_.pitch_smoothing = &pitch_smoothing_;
+    pollux_.pitch_smoothing_enabled = settings_.pollux_pitch_smoothing;
+    pollux_.pitch_smoothing = &pitch_smoothing_;
+
+    GemPitchSmoothing_init(
+        &pitch_smoothing_, settings_.pitch_smoothing_min_cutoff, settings_.pitch_smoothing_sensitivity);
+
+    castor_.midi_replaces_cv = settings_.midi_replaces_cv;
+    pollux_.midi_replaces_cv = settings_.midi_replaces_cv;
+    // Re-initializing forgets held notes, so only do it when the MIDI
+    // settings actually changed. Otherwise a note held on the old channel
+    // would never see its note off.
+    if (castor_midi_.channel != settings_.castor_midi_channel ||
+        pollux_midi_.channel != settings_.pollux_midi_channel ||
+        castor_midi_.bend_range != settings_.midi_pitch_bend_range) {
+        reset_midi_pitch_();
+    }
+
+    pulse_cfg_.gclk_freq = settings_.osc8m_freq;
+}
+
+/*
+    Replaces settings_ with the settings written over SysEx and applies them.
+*/
+static void apply_pending_settings_() {
+    bool adc_corr_changed = gem_settings_cache.adc_gain_corr != settings_.adc_gain_corr ||
+                            gem_settings_cache.adc_offset_corr != settings_.adc_offset_corr;
+
+    settings_ = gem_settings_cache;
+    settings_pending_ = false;
+
+    apply_settings_();
+
+    // Changing the ADC's error correction requires briefly disabling the
+    // ADC, which cancels the conversion in progress. Channel scanning has to
+    // be restarted afterwards, so only do this if the correction changed.
+    if (adc_corr_changed) {
+        gem_adc_stop_scanning();
+        gem_adc_set_error_correction(settings_.adc_gain_corr, settings_.adc_offset_corr);
+        gem_adc_start_scanning(adc_inputs_, GEM_IN_COUNT, adc_results_);
+    }
+}
+
+/*
+    Called by the SysEx handler when new settings are written to
+    gem_settings_cache. The settings are applied by the main loop between
+    frames.
+*/
+static void settings_changed_callback_() {
+    settings_pending_ = true;
+}
+
+/*
+    Hands Pollux's period over to the DMA controller for audio-rate FM.
+*/
+static void start_audio_fm_() {
+    // The table is filled before starting the stream so that the timer never
+    // sees an empty table.
+    GemFMTable_generate(&audio_fm_table_, pollux_.pulseout_period, pollux_.fm_depth);
+    gem_pulseout_set_compare(&pulse_cfg_, 1, audio_fm_table_.min_period / 2);
+    gem_pulseout_start_period_stream(audio_fm_table_.periods, audio_fm_table_.len);
+}
+
 static wntr_periodic_waveform_function lfo_waveshape_setting_to_func_(uint8_t n) {
     switch (n) {
         case 0:
@@ -616,3 +869,9 @@ static wntr_periodic_waveform_function lfo_waveshape_setting_to_func_(uint8_t n)
             return wntr_triangle;
     }
 }
+
+/*
+    Called by TinyUSB when the host goes away. Nothing will release the notes
+    that were being held, so drop them.
+*/
+void tud_umount_cb(void) { reset_midi_pitch_(); }
@@ -18,15 +18,37 @@ PROGRAM = "gemini-firmware-test"
 
 SRCS = [
     "../tests/**/*.c",
+    "../src/drivers/gem_mcp4728.c",
+    "../src/gem_fm_table.c",
+    "../src/gem_fw_update.c",
+    "../src/gem_led_animation.c",
+    "../src/gem_midi_pitch.c",
+    "../src/gem_quantizer.c",
+    "../src/gem_nvm_journal.c",
     "../src/gem_oscillator.c",
+    "../src/gem_pitch_smoothing.c",
+    "../src/generated/gem_led_animation_tables.c",
     "../src/generated/gem_ramp_table_data.c",
     "../src/gem_ramp_table_lookup.c",
+    "../src/gem_ramp_table_transfer.c",
+    "../src/lib/gem_crc32.c",
+    "../src/lib/gem_log.c",
+    "../src/lib/gem_memory.c",
+    "../src/lib/gem_sample_stats.c",
+    "../third_party/libwinter/teeth.c",
     "../third_party/libwinter/wntr_assert.c",
     "../third_party/libwinter/wntr_bezier.c",
+    "../third_party/libwinter/wntr_colorspace.c",
     "../third_party/libwinter/wntr_error_correction.c",
+    "../third_party/libwinter/wntr_midi_core.c",
+    "../third_party/libwinter/wntr_midi_tx.c",
+    "../third_party/libwinter/wntr_nvm_write.c",
+    "../third_party/libwinter/wntr_sysex_stream.c",
     "../third_party/libfixmath/fix16.c",
+    "../third_party/libfixmath/fix16_sqrt.c",
     "../third_party/libfixmath/fix16_str.c",
     "../third_party/libfixmath/fix16_exp.c",
+    "../third_party/libfixmath/fix16_trig.c",
     "../third_party/munit/munit.c",
 ]
 
@@ -121,8 +143,17 @@ def main():
         formatter_class=argparse.ArgumentDefaultsHelpFormatter
     )
 
+    parser.add_argument(
+        "--benchmarks",
+        action="store_true",
+        help="Include the benchmarks, which time things instead of testing them.",
+    )
+
     args = parser.parse_args()
 
+    if args.benchmarks:
+        DEFINES["GEM_TEST_BENCHMARKS"] = 1
+
     generate_build()
 
     print("Created build.ninja")
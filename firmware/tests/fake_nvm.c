@@ -0,0 +1,56 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#include "fake_nvm.h"
+#include "munit.h"
+#include <string.h>
+
+uint8_t fake_nvm_flash[FAKE_NVM_SIZE];
+struct FakeNVMStats fake_nvm_stats;
+static int32_t writes_until_failure_ = -1;
+
+static size_t offset_(uint32_t addr, size_t len) {
+    munit_assert_uint32(addr, >=, FAKE_NVM_BASE);
+    munit_assert_uint32(addr + len, <=, FAKE_NVM_BASE + FAKE_NVM_SIZE);
+    return addr - FAKE_NVM_BASE;
+}
+
+void fake_nvm_reset() {
+    memset(fake_nvm_flash, 0xFF, FAKE_NVM_SIZE);
+    fake_nvm_reset_stats();
+    writes_until_failure_ = -1;
+}
+
+void fake_nvm_reset_stats() { memset(&fake_nvm_stats, 0, sizeof(fake_nvm_stats)); }
+
+void fake_nvm_fail_after(int32_t page_writes) { writes_until_failure_ = page_writes; }
+
+void wntr_nvm_read(uint32_t src, uint8_t* buf, size_t len) { memcpy(buf, fake_nvm_flash + offset_(src, len), len); }
+
+void wntr_nvm_erase_row(uint32_t addr) {
+    munit_assert_uint32(addr % WNTR_NVM_ROW_SIZE, ==, 0);
+    size_t offset = offset_(addr, WNTR_NVM_ROW_SIZE);
+    memset(fake_nvm_flash + offset, 0xFF, WNTR_NVM_ROW_SIZE);
+    fake_nvm_stats.row_erases[offset / WNTR_NVM_ROW_SIZE]++;
+    fake_nvm_stats.total_erases++;
+}
+
+void wntr_nvm_write_page(uint32_t dst, const uint8_t* buf, size_t len) {
+    munit_assert_uint32(dst % WNTR_NVM_PAGE_SIZE, ==, 0);
+    munit_assert_size(len, <=, WNTR_NVM_PAGE_SIZE);
+    size_t offset = offset_(dst, len);
+
+    if (writes_until_failure_ == 0) {
+        return;
+    }
+    if (writes_until_failure_ > 0) {
+        writes_until_failure_--;
+    }
+
+    /* Programming can only change bits from 1 to 0. */
+    for (size_t i = 0; i < len; i++) { fake_nvm_flash[offset + i] &= buf[i]; }
+    fake_nvm_stats.page_writes++;
+}
@@ -0,0 +1,48 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+/*
+    A host model of the SAM D21's NVM used to test code that uses wntr_nvm.
+    This replaces the hardware-specific functions, wntr_nvm_write() from
+    libwinter is used as-is on top of it.
+
+    Like real flash, erasing a row sets it to 0xFF and programming a page can
+    only clear bits. Erases and page writes are counted so that tests can
+    check how much wear an operation causes.
+*/
+
+#include "wntr_nvm.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Arbitrary row-aligned address for the model, matches the real NVM block. */
+#define FAKE_NVM_BASE 0x3F800
+#define FAKE_NVM_SIZE 0x800
+#define FAKE_NVM_ROWS (FAKE_NVM_SIZE / WNTR_NVM_ROW_SIZE)
+
+struct FakeNVMStats {
+    uint32_t row_erases[FAKE_NVM_ROWS];
+    uint32_t total_erases;
+    uint32_t page_writes;
+};
+
+extern uint8_t fake_nvm_flash[FAKE_NVM_SIZE];
+extern struct FakeNVMStats fake_nvm_stats;
+
+/* Erases the whole model and clears the stats. */
+void fake_nvm_reset();
+
+/* Clears the stats without changing the model's contents. */
+void fake_nvm_reset_stats();
+
+/*
+    Simulates losing power after the given number of page writes. Page
+    writes after that are silently dropped. Pass -1 to disable.
+*/
+void fake_nvm_fail_after(int32_t page_writes);
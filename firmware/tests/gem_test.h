@@ -72,3 +72,19 @@ extern MunitSuite test_midi_core_suite;
 extern MunitSuite test_voice_params_suite;
 extern MunitSuite test_bezier_suite;
 extern MunitSuite test_oscillator_suite;
+extern MunitSuite test_fm_table_suite;
+extern MunitSuite test_fw_update_suite;
+extern MunitSuite test_led_animation_suite;
+extern MunitSuite test_mcp4728_suite;
+extern MunitSuite test_nvm_journal_suite;
+extern MunitSuite test_nvm_suite;
+extern MunitSuite test_sample_stats_suite;
+extern MunitSuite test_quantizer_suite;
+extern MunitSuite test_pitch_smoothing_suite;
+extern MunitSuite test_ramp_table_transfer_suite;
+extern MunitSuite test_log_suite;
+extern MunitSuite test_memory_suite;
+extern MunitSuite test_midi_pitch_suite;
+extern MunitSuite test_midi_rx_suite;
+extern MunitSuite test_midi_tx_suite;
+extern MunitSuite test_sysex_stream_suite;
@@ -10,7 +10,25 @@ MunitSuite meta_suite = {.prefix = "gemini: ", .iterations = 1};
 
 int main(int argc, char* argv[MUNIT_ARRAY_PARAM(argc + 1)]) {
     MunitSuite suites[] = {
-        test_voice_params_suite, test_oscillator_suite, {.prefix = NULL}};
+        test_voice_params_suite,
+        test_oscillator_suite,
+        test_fm_table_suite,
+        test_fw_update_suite,
+        test_led_animation_suite,
+        test_mcp4728_suite,
+        test_nvm_journal_suite,
+        test_nvm_suite,
+        test_sample_stats_suite,
+        test_quantizer_suite,
+        test_pitch_smoothing_suite,
+        test_ramp_table_transfer_suite,
+        test_log_suite,
+        test_memory_suite,
+        test_midi_pitch_suite,
+        test_midi_rx_suite,
+        test_midi_tx_suite,
+        test_sysex_stream_suite,
+        {.prefix = NULL}};
     meta_suite.suites = suites;
     return munit_suite_main(&meta_suite, (void*)"gemini", argc, argv);
 }
@@ -14,3 +14,8 @@
 #define GEM_PULSE_WIDTH_MAX (4095)
 #define GEM_PULSE_WIDTH_MOD_MAX (2048)
 #define GEM_FM_DEADZONE F16(0.00)
+#define GEM_AUDIO_FM_MAX_DEPTH F16(1.0)
+#define GEM_QUANTIZER_HYSTERESIS F16(0.2 / 12.0)
+#define GEM_ANIMATION_INTERVAL 48
+#define GEM_PITCH_SMOOTHING_RATE 5000
+#define GEM_PITCH_SMOOTHING_RATE_CUTOFF F16(10.0)
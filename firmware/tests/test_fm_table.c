@@ -0,0 +1,109 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+/* Tests for src/gem_fm_table.c */
+
+#include "fix16.h"
+#include "gem_fm_table.h"
+#include "gem_test.h"
+#include "wntr_waveforms.h"
+
+static struct GemFMTable table;
+
+TEST_CASE_BEGIN(no_depth)
+    GemFMTable_init(&table, wntr_sine, 16);
+
+    // Scenario:
+    // - No modulation depth
+    //
+    // Every entry should be the carrier's period.
+    munit_assert_true(GemFMTable_generate(&table, 30425, F16(0)));
+
+    for (size_t i = 0; i < table.len; i++) { munit_assert_uint32(table.periods[i], ==, 30425); }
+    munit_assert_uint32(table.min_period, ==, 30425);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(sine_one_octave)
+    GemFMTable_init(&table, wntr_sine, 16);
+
+    // Scenario:
+    // - One octave of modulation depth
+    //
+    // The peak of the sine (a quarter of the way through the table) should be
+    // one octave up, so half the period. The trough should be one octave
+    // down, so double the period. The zero crossings should be the carrier,
+    // within the accuracy of fix16_sin().
+    GemFMTable_generate(&table, 30000, F16(1.0));
+
+    munit_assert_uint32(table.periods[0], ==, 30000);
+    munit_assert_uint32(table.periods[4], >=, 15000 - 30);
+    munit_assert_uint32(table.periods[4], <=, 15000 + 30);
+    munit_assert_uint32(table.periods[8], >=, 30000 - 150);
+    munit_assert_uint32(table.periods[8], <=, 30000 + 150);
+    munit_assert_uint32(table.periods[12], >=, 60000 - 120);
+    munit_assert_uint32(table.periods[12], <=, 60000 + 120);
+
+    munit_assert_uint32(table.min_period, ==, table.periods[4]);
+
+    // The rising half of the sine should shorten the period monotonically.
+    for (size_t i = 1; i <= 4; i++) { munit_assert_uint32(table.periods[i], <, table.periods[i - 1]); }
+TEST_CASE_END
+
+TEST_CASE_BEGIN(square_alternates)
+    GemFMTable_init(&table, wntr_square, 2);
+
+    // Scenario:
+    // - A two entry square table, which alternates Pollux's period on each
+    //   of Castor's cycles.
+    GemFMTable_generate(&table, 20000, F16(0.5));
+
+    munit_assert_size(table.len, ==, 2);
+    munit_assert_uint32(table.periods[0], <, 20000);
+    munit_assert_uint32(table.periods[1], >, 20000);
+
+    // Half an octave up and down.
+    munit_assert_uint32(table.periods[0], >=, 14142 - 20);
+    munit_assert_uint32(table.periods[0], <=, 14142 + 20);
+    munit_assert_uint32(table.periods[1], >=, 28284 - 40);
+    munit_assert_uint32(table.periods[1], <=, 28284 + 40);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(skips_unchanged)
+    GemFMTable_init(&table, wntr_sine, 8);
+
+    munit_assert_true(GemFMTable_generate(&table, 10000, F16(0.25)));
+    munit_assert_false(GemFMTable_generate(&table, 10000, F16(0.25)));
+    munit_assert_true(GemFMTable_generate(&table, 10001, F16(0.25)));
+    munit_assert_true(GemFMTable_generate(&table, 10001, F16(0.5)));
+TEST_CASE_END
+
+TEST_CASE_BEGIN(clamps_to_timer_range)
+    GemFMTable_init(&table, wntr_square, 2);
+
+    // Scenario:
+    // - A very low carrier with deep modulation.
+    //
+    // The lower half of the table would overflow the 24-bit timer.
+    GemFMTable_generate(&table, 0xC00000, F16(1.0));
+
+    munit_assert_uint32(table.periods[1], ==, GEM_FM_TABLE_MAX_PERIOD);
+    munit_assert_uint32(table.periods[0], <, 0xC00000);
+TEST_CASE_END
+
+static MunitTest test_suite_tests[] = {
+    {.name = "no depth", .test = test_no_depth},
+    {.name = "sine with one octave depth", .test = test_sine_one_octave},
+    {.name = "square alternates", .test = test_square_alternates},
+    {.name = "skips unchanged inputs", .test = test_skips_unchanged},
+    {.name = "clamps to timer range", .test = test_clamps_to_timer_range},
+    {.test = NULL},
+};
+
+MunitSuite test_fm_table_suite = {
+    .prefix = "fm table: ",
+    .tests = test_suite_tests,
+    .iterations = 1,
+};
@@ -0,0 +1,246 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+/* Tests for src/gem_fw_update.c */
+
+#include "fake_nvm.h"
+#include "gem_crc32.h"
+#include "gem_fw_update.h"
+#include "gem_test.h"
+#include "wntr_pack.h"
+#include <string.h>
+
+/* The whole fake NVM is the staging region, so images are small. */
+#define APP_BASE 0x2000
+#define IMAGE_LEN 1000
+
+static struct GemFwUpdate update;
+static uint8_t image[FAKE_NVM_SIZE];
+
+/* Fills the image with data that starts with a valid vector table. */
+static void make_image(size_t len) {
+    for (size_t i = 0; i < len; i++) { image[i] = (uint8_t)(i * 7 + 3); }
+
+    uint32_t initial_sp = 0x20008000;
+    uint32_t reset_handler = APP_BASE + 0x41;
+    memcpy(image, &initial_sp, 4);
+    memcpy(image + 4, &reset_handler, 4);
+}
+
+static enum GemFwUpdateResult begin(uint32_t len, uint32_t crc) {
+    uint8_t buf[GEM_FW_UPDATE_BEGIN_SIZE];
+    WNTR_PACK_32(len, buf, 0);
+    WNTR_PACK_32(crc, buf, 4);
+    return GemFwUpdate_begin(&update, buf, sizeof(buf));
+}
+
+static size_t pack_chunk(uint32_t offset, size_t data_len, uint8_t* buf) {
+    WNTR_PACK_32(offset, buf, 0);
+    memcpy(buf + 4, image + offset, data_len);
+    uint32_t crc = gem_crc32(0, buf, 4 + data_len);
+    WNTR_PACK_32(crc, buf, 4 + data_len);
+    return GEM_FW_UPDATE_CHUNK_SIZE(data_len);
+}
+
+static enum GemFwUpdateResult write_chunk(uint32_t offset, size_t data_len) {
+    uint8_t buf[GEM_FW_UPDATE_CHUNK_MAX_SIZE];
+    size_t len = pack_chunk(offset, data_len, buf);
+    return GemFwUpdate_write_chunk(&update, buf, len);
+}
+
+/* Sends the whole image in chunks of `chunk_len` bytes. */
+static void send_image(size_t len, size_t chunk_len) {
+    for (size_t offset = 0; offset < len; offset += chunk_len) {
+        size_t count = len - offset < chunk_len ? len - offset : chunk_len;
+        munit_assert_int(write_chunk(offset, count), ==, GEM_FW_UPDATE_OK);
+    }
+}
+
+static void setup() {
+    fake_nvm_reset();
+    // Start from flash that isn't erased, like a staging region holding an
+    // older update.
+    memset(fake_nvm_flash, 0x5A, FAKE_NVM_SIZE);
+    GemFwUpdate_init(&update, FAKE_NVM_BASE, FAKE_NVM_SIZE, APP_BASE);
+}
+
+TEST_CASE_BEGIN(streams_image)
+    setup();
+    make_image(IMAGE_LEN);
+
+    munit_assert_int(begin(IMAGE_LEN, gem_crc32(0, image, IMAGE_LEN)), ==, GEM_FW_UPDATE_OK);
+    send_image(IMAGE_LEN, GEM_FW_UPDATE_CHUNK_MAX_DATA);
+    munit_assert_false(GemFwUpdate_ready(&update));
+
+    munit_assert_int(GemFwUpdate_finish(&update), ==, GEM_FW_UPDATE_OK);
+    munit_assert_true(GemFwUpdate_ready(&update));
+    munit_assert_memory_equal(IMAGE_LEN, fake_nvm_flash, image);
+
+    // Each row is erased once and each page is programmed once, including
+    // the partial page at the end.
+    munit_assert_uint32(fake_nvm_stats.total_erases, ==, (IMAGE_LEN + WNTR_NVM_ROW_SIZE - 1) / WNTR_NVM_ROW_SIZE);
+    munit_assert_uint32(fake_nvm_stats.page_writes, ==, (IMAGE_LEN + WNTR_NVM_PAGE_SIZE - 1) / WNTR_NVM_PAGE_SIZE);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(odd_chunk_sizes)
+    setup();
+    make_image(IMAGE_LEN);
+
+    // Chunks don't have to line up with pages.
+    munit_assert_int(begin(IMAGE_LEN, gem_crc32(0, image, IMAGE_LEN)), ==, GEM_FW_UPDATE_OK);
+    send_image(IMAGE_LEN, 27);
+    munit_assert_int(GemFwUpdate_finish(&update), ==, GEM_FW_UPDATE_OK);
+    munit_assert_memory_equal(IMAGE_LEN, fake_nvm_flash, image);
+    munit_assert_uint32(fake_nvm_stats.page_writes, ==, (IMAGE_LEN + WNTR_NVM_PAGE_SIZE - 1) / WNTR_NVM_PAGE_SIZE);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(rejects_bad_chunks)
+    setup();
+    make_image(IMAGE_LEN);
+    munit_assert_int(begin(IMAGE_LEN, gem_crc32(0, image, IMAGE_LEN)), ==, GEM_FW_UPDATE_OK);
+    munit_assert_int(write_chunk(0, 64), ==, GEM_FW_UPDATE_OK);
+
+    // Corrupted chunks are rejected and can be sent again.
+    uint8_t buf[GEM_FW_UPDATE_CHUNK_MAX_SIZE];
+    size_t len = pack_chunk(64, 64, buf);
+    buf[10] ^= 0x01;
+    munit_assert_int(GemFwUpdate_write_chunk(&update, buf, len), ==, GEM_FW_UPDATE_ERR_CRC);
+    munit_assert_int(GemFwUpdate_write_chunk(&update, buf, 4), ==, GEM_FW_UPDATE_ERR_LENGTH);
+    munit_assert_int(
+        GemFwUpdate_write_chunk(&update, buf, GEM_FW_UPDATE_CHUNK_MAX_SIZE + 1), ==, GEM_FW_UPDATE_ERR_LENGTH);
+
+    // Chunks have to arrive in order.
+    munit_assert_int(write_chunk(128, 64), ==, GEM_FW_UPDATE_ERR_OFFSET);
+
+    // Re-sending the chunk that was just accepted doesn't program it again.
+    uint32_t page_writes = fake_nvm_stats.page_writes;
+    munit_assert_int(write_chunk(0, 64), ==, GEM_FW_UPDATE_OK);
+    munit_assert_uint32(fake_nvm_stats.page_writes, ==, page_writes);
+
+    send_image(IMAGE_LEN - 64, 64);
+    munit_assert_int(GemFwUpdate_finish(&update), ==, GEM_FW_UPDATE_ERR_LENGTH);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(resend_after_lost_response)
+    setup();
+    make_image(IMAGE_LEN);
+    munit_assert_int(begin(IMAGE_LEN, gem_crc32(0, image, IMAGE_LEN)), ==, GEM_FW_UPDATE_OK);
+
+    for (size_t offset = 0; offset < IMAGE_LEN; offset += 40) {
+        size_t count = IMAGE_LEN - offset < 40 ? IMAGE_LEN - offset : 40;
+        munit_assert_int(write_chunk(offset, count), ==, GEM_FW_UPDATE_OK);
+        munit_assert_int(write_chunk(offset, count), ==, GEM_FW_UPDATE_OK);
+    }
+
+    munit_assert_int(GemFwUpdate_finish(&update), ==, GEM_FW_UPDATE_OK);
+    munit_assert_memory_equal(IMAGE_LEN, fake_nvm_flash, image);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(chunk_past_end)
+    setup();
+    make_image(128);
+    munit_assert_int(begin(100, gem_crc32(0, image, 100)), ==, GEM_FW_UPDATE_OK);
+    munit_assert_int(write_chunk(0, 64), ==, GEM_FW_UPDATE_OK);
+    munit_assert_int(write_chunk(64, 64), ==, GEM_FW_UPDATE_ERR_RANGE);
+    munit_assert_int(write_chunk(64, 36), ==, GEM_FW_UPDATE_OK);
+    munit_assert_int(GemFwUpdate_finish(&update), ==, GEM_FW_UPDATE_OK);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(requires_begin)
+    setup();
+    make_image(IMAGE_LEN);
+
+    munit_assert_int(write_chunk(0, 64), ==, GEM_FW_UPDATE_ERR_STATE);
+    munit_assert_int(GemFwUpdate_finish(&update), ==, GEM_FW_UPDATE_ERR_STATE);
+
+    // Images have to fit in the staging region.
+    munit_assert_int(begin(FAKE_NVM_SIZE + 1, 0), ==, GEM_FW_UPDATE_ERR_RANGE);
+    munit_assert_int(begin(4, 0), ==, GEM_FW_UPDATE_ERR_RANGE);
+    munit_assert_int(write_chunk(0, 64), ==, GEM_FW_UPDATE_ERR_STATE);
+
+    uint8_t buf[4] = {};
+    munit_assert_int(GemFwUpdate_begin(&update, buf, sizeof(buf)), ==, GEM_FW_UPDATE_ERR_LENGTH);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(image_crc_mismatch)
+    setup();
+    make_image(IMAGE_LEN);
+
+    munit_assert_int(begin(IMAGE_LEN, gem_crc32(0, image, IMAGE_LEN) ^ 1), ==, GEM_FW_UPDATE_OK);
+    send_image(IMAGE_LEN, 64);
+    munit_assert_int(GemFwUpdate_finish(&update), ==, GEM_FW_UPDATE_ERR_IMAGE_CRC);
+    munit_assert_false(GemFwUpdate_ready(&update));
+
+    // A failed update has to start over.
+    munit_assert_int(GemFwUpdate_finish(&update), ==, GEM_FW_UPDATE_ERR_STATE);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(power_loss_while_programming)
+    setup();
+    make_image(IMAGE_LEN);
+
+    // Pages that don't get programmed are caught by reading the image back.
+    munit_assert_int(begin(IMAGE_LEN, gem_crc32(0, image, IMAGE_LEN)), ==, GEM_FW_UPDATE_OK);
+    fake_nvm_fail_after(5);
+    send_image(IMAGE_LEN, 64);
+    munit_assert_int(GemFwUpdate_finish(&update), ==, GEM_FW_UPDATE_ERR_IMAGE_CRC);
+    munit_assert_false(GemFwUpdate_ready(&update));
+
+    // Starting over works once power is back.
+    fake_nvm_fail_after(-1);
+    munit_assert_int(begin(IMAGE_LEN, gem_crc32(0, image, IMAGE_LEN)), ==, GEM_FW_UPDATE_OK);
+    send_image(IMAGE_LEN, 64);
+    munit_assert_int(GemFwUpdate_finish(&update), ==, GEM_FW_UPDATE_OK);
+    munit_assert_memory_equal(IMAGE_LEN, fake_nvm_flash, image);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(bad_vector_table)
+    setup();
+
+    // Reset handler outside of the image.
+    make_image(IMAGE_LEN);
+    uint32_t reset_handler = APP_BASE + IMAGE_LEN + 1;
+    memcpy(image + 4, &reset_handler, 4);
+    munit_assert_int(begin(IMAGE_LEN, gem_crc32(0, image, IMAGE_LEN)), ==, GEM_FW_UPDATE_OK);
+    send_image(IMAGE_LEN, 64);
+    munit_assert_int(GemFwUpdate_finish(&update), ==, GEM_FW_UPDATE_ERR_VECTOR_TABLE);
+    munit_assert_false(GemFwUpdate_ready(&update));
+
+    // Reset handler without the Thumb bit.
+    make_image(IMAGE_LEN);
+    reset_handler = APP_BASE + 0x40;
+    memcpy(image + 4, &reset_handler, 4);
+    munit_assert_int(begin(IMAGE_LEN, gem_crc32(0, image, IMAGE_LEN)), ==, GEM_FW_UPDATE_OK);
+    send_image(IMAGE_LEN, 64);
+    munit_assert_int(GemFwUpdate_finish(&update), ==, GEM_FW_UPDATE_ERR_VECTOR_TABLE);
+
+    // Stack pointer outside of SRAM, for example, an image that isn't
+    // firmware at all.
+    make_image(IMAGE_LEN);
+    memset(image, 0xFF, 4);
+    munit_assert_int(begin(IMAGE_LEN, gem_crc32(0, image, IMAGE_LEN)), ==, GEM_FW_UPDATE_OK);
+    send_image(IMAGE_LEN, 64);
+    munit_assert_int(GemFwUpdate_finish(&update), ==, GEM_FW_UPDATE_ERR_VECTOR_TABLE);
+TEST_CASE_END
+
+static MunitTest test_suite_tests[] = {
+    {.name = "streams image", .test = test_streams_image},
+    {.name = "odd chunk sizes", .test = test_odd_chunk_sizes},
+    {.name = "rejects bad chunks", .test = test_rejects_bad_chunks},
+    {.name = "resend after lost response", .test = test_resend_after_lost_response},
+    {.name = "chunk past end", .test = test_chunk_past_end},
+    {.name = "requires begin", .test = test_requires_begin},
+    {.name = "image crc mismatch", .test = test_image_crc_mismatch},
+    {.name = "power loss while programming", .test = test_power_loss_while_programming},
+    {.name = "bad vector table", .test = test_bad_vector_table},
+    {.test = NULL},
+};
+
+MunitSuite test_fw_update_suite = {
+    .prefix = "fw update: ",
+    .tests = test_suite_tests,
+    .iterations = 1,
+};
@@ -0,0 +1,395 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+/*
+    Tests for src/gem_led_animation.c
+
+    These render frames with both the animation and a reference copy of the
+    original animation code, which called fix16_sin() and
+    wntr_colorspace_hsv_to_rgb() for every LED, and check that they look the
+    same.
+*/
+
+#include "fix16.h"
+#include "gem_config.h"
+#include "gem_led_animation.h"
+#include "gem_test.h"
+#include "wntr_colorspace.h"
+#include "wntr_waveforms.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define LED_COUNT 8
+#define FRAMES 800
+/* Largest allowed difference in any color channel. */
+#define TOLERANCE 4
+
+#define MIN(a, b) (a < b ? a : b)
+#define MAX(a, b) (a < b ? b : a)
+#define MINMAX(x, lo, hi) (MIN(hi, MAX(lo, x)))
+
+static const struct GemLEDCfg led_cfg = {
+    .hue_offsets = {0, 8169, 16338, 24508, 32677, 40846, 49016, 57185},
+    .vertical_pos_index = {0, 7, 1, 2, 6, 3, 5, 4},
+    .lfo_tweak_led = 0,
+    .pitch_a_tweak_led = 7,
+    .pitch_b_tweak_led = 1,
+    .pwm_a_led = 5,
+    .pwm_b_led = 3,
+    .fm_a_led = 7,
+    .fm_b_led = 1,
+};
+
+static const struct GemDotstarCfg dotstar = {.count = LED_COUNT};
+
+/* Fakes for the Dotstar driver, ticks, and random numbers. */
+
+static uint32_t leds[LED_COUNT];
+static uint32_t fake_ticks;
+static uint32_t random_frame;
+static uint32_t random_calls;
+
+void gem_dotstar_set32(size_t n, uint32_t color) { leds[n] = color; }
+
+void gem_dotstar_update(const struct GemDotstarCfg* cfg) { (void)cfg; }
+
+uint32_t wntr_ticks() { return fake_ticks; }
+
+/*
+    Returns either 0, which always spawns a sparkle, or a number that can't
+    spawn one for any spawn rate with either the original `% spawn_rate`
+    check or the new threshold, so that both implementations sparkle the
+    same LEDs.
+*/
+uint32_t wntr_random32() {
+    random_calls++;
+    return (random_frame * 7 + random_calls * 13) % 61 == 0 ? 0 : UINT32_MAX - 1;
+}
+
+/* The original animation code, drawing into ref_leds. */
+
+static uint32_t ref_leds[LED_COUNT];
+static enum GemMode ref_mode;
+static uint32_t ref_last_update;
+static fix16_t ref_phase_a;
+static uint32_t ref_hue_accum;
+static uint8_t ref_sparkles[LED_COUNT];
+static bool ref_transitioning;
+static fix16_t ref_phase_sparkle;
+
+static void ref_set_mode(enum GemMode mode) {
+    ref_mode = mode;
+    ref_phase_a = F16(0);
+    ref_transitioning = true;
+    switch (mode) {
+        case GEM_MODE_NORMAL:
+            ref_hue_accum = 13107;
+            break;
+        case GEM_MODE_LFO_FM:
+            ref_hue_accum = 21845;
+            break;
+        case GEM_MODE_LFO_PWM:
+            ref_hue_accum = 39321;
+            break;
+        case GEM_MODE_HARD_SYNC:
+            ref_hue_accum = 52428;
+            break;
+        case GEM_MODE_AUDIO_FM:
+            ref_hue_accum = 6553;
+            break;
+        default:
+            break;
+    }
+}
+
+static fix16_t ref_noise(fix16_t phase) {
+    return fix16_add(wntr_triangle(phase << 2), wntr_triangle(fix16_mul(fix16_pi, phase)));
+}
+
+static void ref_step_transition(uint32_t delta) {
+    const fix16_t duration = F16(1200);
+    const fix16_t dotstar_count_f16 = fix16_from_int(LED_COUNT);
+    const fix16_t overlap = F16(0.25);
+    const fix16_t max_phase = fix16_add(F16(1.1), overlap);
+    const fix16_t interval = fix16_div(F16(1), dotstar_count_f16);
+    const fix16_t scale = fix16_div(F16(1), fix16_add(interval, overlap));
+
+    ref_phase_a += fix16_div(fix16_from_int(delta), duration);
+
+    if (ref_phase_a > max_phase) {
+        ref_transitioning = false;
+        return;
+    }
+
+    for (size_t i = 0; i < LED_COUNT; i++) {
+        fix16_t offset = fix16_div(fix16_from_int(i), dotstar_count_f16);
+        fix16_t factor = fix16_mul(fix16_sub(ref_phase_a, offset), scale);
+        uint8_t v = (uint8_t)MINMAX((fix16_to_int(fix16_mul(F16(255), factor))), 0, 255);
+        ref_leds[led_cfg.vertical_pos_index[LED_COUNT - 1 - i]] =
+            wntr_colorspace_hsv_to_rgb(ref_hue_accum, 255, 255 - v);
+    }
+}
+
+static void ref_step_sparkles(uint32_t delta) {
+    uint32_t spawn_rate = 500 - fix16_to_int(fix16_mul(gem_led_inputs.lfo_gain, F16(400)));
+    uint8_t decay_step = (uint8_t)(fix16_to_int(fix16_mul(fix16_from_int(delta), F16(0.2))));
+
+    ref_phase_sparkle += fix16_div(fix16_from_int(delta), F16(800.0));
+    fix16_t flicker_amount = ref_noise(ref_phase_sparkle);
+
+    for (size_t i = 0; i < LED_COUNT; i++) {
+        if (ref_sparkles[i] == 0 && wntr_random32() % spawn_rate == 0)
+            ref_sparkles[i] = 255;
+
+        if (ref_sparkles[i] == 0) {
+            continue;
+        }
+
+        uint16_t hue = (ref_hue_accum + led_cfg.hue_offsets[i]) % UINT16_MAX;
+        uint8_t sat = (uint8_t)MINMAX(-100 + (255 - ref_sparkles[i]), 0, 255);
+        int32_t val = MIN(ref_sparkles[i] * 3, 255);
+        val += fix16_to_int(fix16_mul(flicker_amount, F16(25)));
+        val = MINMAX(val, 0, 255);
+
+        ref_leds[i] = wntr_colorspace_hsv_to_rgb(hue, sat, (uint8_t)val);
+
+        if (ref_sparkles[i] <= decay_step)
+            ref_sparkles[i] = 0;
+        else
+            ref_sparkles[i] -= decay_step;
+    }
+}
+
+static void ref_step_normal(uint32_t delta) {
+    ref_phase_a += fix16_div(fix16_from_int(delta), F16(2200.0));
+    if (ref_phase_a > F16(1.0))
+        ref_phase_a = fix16_sub(ref_phase_a, F16(1.0));
+
+    ref_hue_accum += delta * 5;
+
+    for (size_t i = 0; i < LED_COUNT; i++) {
+        fix16_t phase_offset = fix16_div(fix16_from_int(i), fix16_from_int(LED_COUNT));
+        fix16_t sin_a = wntr_sine_normalized(ref_phase_a + phase_offset);
+        uint8_t value = 20 + fix16_to_int(fix16_mul(sin_a, F16(235)));
+        uint16_t hue =
+            ref_mode == GEM_MODE_HARD_SYNC ? ref_hue_accum : (ref_hue_accum + led_cfg.hue_offsets[i]) % UINT16_MAX;
+        ref_leds[i] = wntr_colorspace_hsv_to_rgb(hue, 255, value);
+    }
+
+    if (ref_mode == GEM_MODE_LFO_PWM || ref_mode == GEM_MODE_LFO_FM) {
+        uint8_t val = 127 + fix16_to_int(fix16_mul(F16(127), gem_led_inputs.lfo_amplitude));
+        uint16_t hue_a = (49151 * gem_led_inputs.lfo_mod_a) >> 12;
+        uint16_t hue_b = (49151 * gem_led_inputs.lfo_mod_b) >> 12;
+        bool pwm = ref_mode == GEM_MODE_LFO_PWM;
+        ref_leds[pwm ? led_cfg.pwm_a_led : led_cfg.fm_a_led] = wntr_colorspace_hsv_to_rgb(hue_a, 255, val);
+        ref_leds[pwm ? led_cfg.pwm_b_led : led_cfg.fm_b_led] = wntr_colorspace_hsv_to_rgb(hue_b, 255, val);
+    }
+}
+
+static void ref_step_calibration(uint32_t ticks) {
+    fix16_t sinv = wntr_sine_normalized(fix16_div(fix16_from_int(ticks / 2), F16(2000.0)));
+    uint8_t value = fix16_to_int(fix16_mul(F16(255.0), sinv));
+    for (uint8_t i = 0; i < LED_COUNT; i++) {
+        ref_leds[i] = i % 2 == 0 ? wntr_colorspace_hsv_to_rgb(50000, 255, value)
+                                 : wntr_colorspace_hsv_to_rgb(10000, 255, 255 - value);
+    }
+}
+
+static uint32_t ref_pitch_tweak_color(uint16_t pitch_tweak) {
+    if (pitch_tweak == UINT16_MAX) {
+        return wntr_colorspace_hsv_to_rgb(0, 255, 0);
+    } else if (pitch_tweak < 2048) {
+        return wntr_colorspace_hsv_to_rgb(49016, 255, 255 - (pitch_tweak >> 3));
+    } else {
+        return wntr_colorspace_hsv_to_rgb(0, 255, (pitch_tweak - 2048) >> 3);
+    }
+}
+
+static void ref_step_tweak() {
+    for (uint8_t i = 0; i < LED_COUNT; i++) { ref_leds[i] = 0; }
+
+    uint8_t lfo_val = 127 + fix16_to_int(fix16_mul(F16(127), gem_led_inputs.lfo_amplitude));
+    ref_leds[led_cfg.lfo_tweak_led] = wntr_colorspace_hsv_to_rgb(49016, 255, lfo_val);
+    ref_leds[led_cfg.pitch_a_tweak_led] = ref_pitch_tweak_color(gem_led_inputs.pitch_tweak_a);
+    ref_leds[led_cfg.pitch_b_tweak_led] = ref_pitch_tweak_color(gem_led_inputs.pitch_tweak_b);
+}
+
+static bool ref_step() {
+    uint32_t delta = fake_ticks - ref_last_update;
+    if (delta < GEM_ANIMATION_INTERVAL) {
+        return false;
+    }
+    ref_last_update = fake_ticks;
+
+    if (ref_transitioning) {
+        ref_step_transition(delta);
+    } else if (gem_led_inputs.tweaking) {
+        ref_step_tweak();
+    } else if (ref_mode == GEM_MODE_CALIBRATION) {
+        ref_step_calibration(fake_ticks);
+    } else {
+        ref_step_normal(delta);
+        ref_step_sparkles(delta);
+    }
+    return true;
+}
+
+/* Helpers */
+
+static void start(enum GemMode mode) {
+    fake_ticks = 1000;
+    memset(leds, 0, sizeof(leds));
+    memset(ref_leds, 0, sizeof(ref_leds));
+
+    gem_led_animation_init(led_cfg);
+    gem_led_animation_set_mode(mode);
+    ref_last_update = fake_ticks;
+    ref_set_mode(mode);
+}
+
+/* Moves the inputs around so that each frame is a little different. */
+static void set_inputs(uint32_t frame) {
+    fix16_t lfo = wntr_sine(fix16_div(fix16_from_int(frame), F16(37.0)));
+    gem_led_inputs.lfo_amplitude = lfo;
+    gem_led_inputs.lfo_gain = fix16_div(fix16_from_int(frame % 100), F16(100.0));
+    gem_led_inputs.lfo_mod_a = (frame * 53) % 4096;
+    gem_led_inputs.lfo_mod_b = (frame * 97) % 4096;
+    gem_led_inputs.pitch_tweak_a = frame % 50 == 0 ? UINT16_MAX : (frame * 31) % 4096;
+    gem_led_inputs.pitch_tweak_b = (frame * 71) % 4096;
+}
+
+static int channel_diff(uint32_t a, uint32_t b, int shift) {
+    return abs((int)((a >> shift) & 0xFF) - (int)((b >> shift) & 0xFF));
+}
+
+static void render_and_compare(enum GemMode mode, bool tweaking) {
+    start(mode);
+
+    int max_diff = 0;
+    for (uint32_t frame = 0; frame < FRAMES; frame++) {
+        // Frames don't always land exactly on the interval.
+        fake_ticks += GEM_ANIMATION_INTERVAL + (frame * 5) % 16;
+        set_inputs(frame);
+        gem_led_inputs.tweaking = tweaking && frame > FRAMES / 2;
+
+        random_frame = frame;
+        random_calls = 0;
+        munit_assert_true(gem_led_animation_step(&dotstar));
+
+        random_calls = 0;
+        munit_assert_true(ref_step());
+
+        for (size_t i = 0; i < LED_COUNT; i++) {
+            for (int shift = 0; shift <= 16; shift += 8) {
+                int diff = channel_diff(leds[i], ref_leds[i], shift);
+                if (diff > TOLERANCE) {
+                    munit_errorf(
+                        "frame %u LED %zu: %06x != %06x",
+                        (unsigned)(frame),
+                        i,
+                        (unsigned)(leds[i]),
+                        (unsigned)(ref_leds[i]));
+                }
+                max_diff = MAX(max_diff, diff);
+            }
+        }
+    }
+
+    gem_led_inputs.tweaking = false;
+    munit_logf(MUNIT_LOG_INFO, "max difference: %i", max_diff);
+}
+
+/* Tests */
+
+TEST_CASE_BEGIN(matches_reference_normal)
+    render_and_compare(GEM_MODE_NORMAL, false);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(matches_reference_lfo_fm)
+    render_and_compare(GEM_MODE_LFO_FM, false);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(matches_reference_lfo_pwm)
+    render_and_compare(GEM_MODE_LFO_PWM, false);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(matches_reference_hard_sync)
+    render_and_compare(GEM_MODE_HARD_SYNC, false);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(matches_reference_audio_fm)
+    render_and_compare(GEM_MODE_AUDIO_FM, false);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(matches_reference_calibration)
+    render_and_compare(GEM_MODE_CALIBRATION, false);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(matches_reference_tweak)
+    render_and_compare(GEM_MODE_NORMAL, true);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(due_matches_step)
+    start(GEM_MODE_NORMAL);
+    uint32_t drawn = 0;
+    for (uint32_t frame = 0; frame < 100; frame++) {
+        fake_ticks += frame % 7;
+        bool due = gem_led_animation_due();
+        munit_assert_int(due, ==, gem_led_animation_step(&dotstar));
+        munit_assert_false(gem_led_animation_due());
+        drawn += due;
+    }
+    munit_assert_uint32(drawn, >, 0);
+TEST_CASE_END
+
+#ifdef GEM_TEST_BENCHMARKS
+
+/*
+    Timing only, built with `--benchmarks`: renders the same frames with the
+    reference and the table-driven animation.
+*/
+
+#define BENCHMARK_FRAMES 20000
+
+TEST_CASE_BEGIN(benchmark_reference_frames)
+    start(GEM_MODE_NORMAL);
+    for (uint32_t frame = 0; frame < BENCHMARK_FRAMES; frame++) {
+        fake_ticks += GEM_ANIMATION_INTERVAL;
+        ref_step();
+    }
+TEST_CASE_END
+
+TEST_CASE_BEGIN(benchmark_table_frames)
+    start(GEM_MODE_NORMAL);
+    for (uint32_t frame = 0; frame < BENCHMARK_FRAMES; frame++) {
+        fake_ticks += GEM_ANIMATION_INTERVAL;
+        gem_led_animation_step(&dotstar);
+    }
+TEST_CASE_END
+
+#endif
+
+static MunitTest test_suite_tests[] = {
+    {.name = "matches reference normal", .test = test_matches_reference_normal},
+    {.name = "matches reference lfo fm", .test = test_matches_reference_lfo_fm},
+    {.name = "matches reference lfo pwm", .test = test_matches_reference_lfo_pwm},
+    {.name = "matches reference hard sync", .test = test_matches_reference_hard_sync},
+    {.name = "matches reference audio fm", .test = test_matches_reference_audio_fm},
+    {.name = "matches reference calibration", .test = test_matches_reference_calibration},
+    {.name = "matches reference tweak", .test = test_matches_reference_tweak},
+    {.name = "due matches step", .test = test_due_matches_step},
+#ifdef GEM_TEST_BENCHMARKS
+    {.name = "benchmark reference frames", .test = test_benchmark_reference_frames},
+    {.name = "benchmark table frames", .test = test_benchmark_table_frames},
+#endif
+    {.test = NULL},
+};
+
+MunitSuite test_led_animation_suite = {
+    .prefix = "led animation: ",
+    .tests = test_suite_tests,
+    .iterations = 1,
+};
@@ -0,0 +1,98 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+/* Tests for src/lib/gem_log.c */
+
+#include "gem_log.h"
+#include "gem_test.h"
+
+static void write_record(uint16_t id, uint8_t argc) {
+    uint32_t args[GEM_LOG_MAX_ARGS];
+    for (uint8_t i = 0; i < argc; i++) { args[i] = 0x01020304 * (i + 1); }
+    gem_log_write(id, args, argc);
+}
+
+TEST_CASE_BEGIN(log_write_and_read)
+    gem_log_reset();
+
+    write_record(0x1234, 0);
+    write_record(0x0040, 2);
+
+    uint8_t buf[64];
+    munit_assert_size(gem_log_read(buf, sizeof(buf)), ==, 3 + 3 + 8);
+
+    // Records are little-endian: ID(2) ARGC(1) ARGS(4 * ARGC)
+    const uint8_t expected[] = {
+        0x34, 0x12, 0x00, 0x40, 0x00, 0x02, 0x04, 0x03, 0x02, 0x01, 0x08, 0x06, 0x04, 0x02};
+    munit_assert_memory_equal(sizeof(expected), buf, expected);
+
+    // Everything's been read.
+    munit_assert_size(gem_log_read(buf, sizeof(buf)), ==, 0);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(reads_whole_records)
+    gem_log_reset();
+
+    write_record(1, 1);
+    write_record(2, 1);
+
+    // There's only room for one and a half records, so only one is read and
+    // the other stays in the buffer.
+    uint8_t buf[10];
+    munit_assert_size(gem_log_read(buf, sizeof(buf)), ==, 7);
+    munit_assert_uint8(buf[0], ==, 1);
+    munit_assert_size(gem_log_read(buf, sizeof(buf)), ==, 7);
+    munit_assert_uint8(buf[0], ==, 2);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(drops_when_full)
+    gem_log_reset();
+
+    // Fill the buffer, the last few of these won't fit.
+    size_t record_len = GEM_LOG_RECORD_HEADER_SIZE + 4;
+    size_t fits = GEM_LOG_BUFFER_SIZE / record_len;
+    for (size_t i = 0; i < fits + 3; i++) { write_record((uint16_t)(i), 1); }
+
+    uint8_t buf[GEM_LOG_BUFFER_SIZE];
+    munit_assert_size(gem_log_read(buf, sizeof(buf)), ==, fits * record_len);
+
+    // The next message is preceded by a record saying how many were dropped.
+    write_record(0x55, 0);
+    munit_assert_size(gem_log_read(buf, sizeof(buf)), ==, record_len + 3);
+
+    const uint8_t expected[] = {0xFF, 0xFF, 0x01, 0x03, 0x00, 0x00, 0x00, 0x55, 0x00, 0x00};
+    munit_assert_memory_equal(sizeof(expected), buf, expected);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(log_wraps_around)
+    gem_log_reset();
+
+    // Keep writing and reading so that records end up split across the end
+    // of the buffer.
+    uint8_t buf[32];
+    for (size_t i = 0; i < GEM_LOG_BUFFER_SIZE; i++) {
+        write_record((uint16_t)(i), 3);
+        munit_assert_size(gem_log_read(buf, sizeof(buf)), ==, 15);
+        munit_assert_uint16(buf[0] | buf[1] << 8, ==, i);
+        munit_assert_uint8(buf[2], ==, 3);
+        munit_assert_uint8(buf[11], ==, 0x0C);
+        munit_assert_uint8(buf[14], ==, 0x03);
+    }
+TEST_CASE_END
+
+static MunitTest test_suite_tests[] = {
+    {.name = "write and read", .test = test_log_write_and_read},
+    {.name = "reads whole records", .test = test_reads_whole_records},
+    {.name = "drops when full", .test = test_drops_when_full},
+    {.name = "wraps around", .test = test_log_wraps_around},
+    {.test = NULL},
+};
+
+MunitSuite test_log_suite = {
+    .prefix = "log: ",
+    .tests = test_suite_tests,
+    .iterations = 1,
+};
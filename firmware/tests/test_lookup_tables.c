@@ -10,8 +10,10 @@
 #include "gem_config.h"
 #include "gem_ramp_table.h"
 #include "gem_test.h"
+#include <math.h>
 
 TEST_CASE_BEGIN(lowest)
+    gem_ramp_table_update_interpolation();
     uint16_t ramp_cv = gem_ramp_table_lookup(0, F16(0.0));
     munit_assert_uint16(ramp_cv, ==, gem_ramp_table[0].castor_ramp_cv);
 
@@ -20,6 +22,7 @@ TEST_CASE_BEGIN(lowest)
 TEST_CASE_END
 
 TEST_CASE_BEGIN(lerp_between_2_and_3)
+    gem_ramp_table_update_interpolation();
     uint16_t ramp_cv = gem_ramp_table_lookup(0, F16(2.2));
 
     // This test currently depends on the tables having specific values.
@@ -28,6 +31,7 @@ TEST_CASE_BEGIN(lerp_between_2_and_3)
 TEST_CASE_END
 
 TEST_CASE_BEGIN(sweep)
+    gem_ramp_table_update_interpolation();
     uint16_t last_ramp_cv = 0;
 
     for (fix16_t i = F16(0); i < F16(7.0); i = fix16_add(i, F16(0.02))) {
@@ -42,10 +46,95 @@ TEST_CASE_BEGIN(sweep)
     }
 TEST_CASE_END
 
+TEST_CASE_BEGIN(passes_through_entries)
+    gem_ramp_table_update_interpolation();
+
+    for (size_t i = 0; i < gem_ramp_table_len; i++) {
+        munit_assert_uint32(gem_ramp_table_lookup(0, gem_ramp_table[i].pitch_cv), ==, gem_ramp_table[i].castor_ramp_cv);
+        munit_assert_uint32(gem_ramp_table_lookup(1, gem_ramp_table[i].pitch_cv), ==, gem_ramp_table[i].pollux_ramp_cv);
+    }
+
+    // Past either end is flat.
+    munit_assert_uint32(gem_ramp_table_lookup(0, F16(-1.0)), ==, gem_ramp_table[0].castor_ramp_cv);
+    munit_assert_uint32(
+        gem_ramp_table_lookup(0, F16(10.0)), ==, gem_ramp_table[gem_ramp_table_len - 1].castor_ramp_cv);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(monotonic)
+    gem_ramp_table_update_interpolation();
+
+    for (uint8_t osc = 0; osc < 2; osc++) {
+        uint32_t last_ramp_cv = 0;
+        for (fix16_t i = F16(-0.5); i < F16(7.5); i += 7) {
+            uint32_t ramp_cv = gem_ramp_table_lookup(osc, i);
+            munit_assert_uint32(ramp_cv, >=, last_ramp_cv);
+            munit_assert_uint32(ramp_cv, <=, 4095);
+            last_ramp_cv = ramp_cv;
+        }
+    }
+TEST_CASE_END
+
+TEST_CASE_BEGIN(closer_than_lerp)
+    gem_ramp_table_update_interpolation();
+
+    // The charge voltage needed is proportional to frequency, so between
+    // entries it should follow an exponential curve. The last few entries
+    // flatten out at the top of the DAC's range, so they're skipped.
+    double cubic_error = 0;
+    double lerp_error = 0;
+    size_t count = 0;
+
+    for (size_t i = 0; i < gem_ramp_table_len - 4; i++) {
+        const struct GemRampTableEntry* low = &gem_ramp_table[i];
+        const struct GemRampTableEntry* high = &gem_ramp_table[i + 1];
+
+        for (int step = 1; step < 32; step++) {
+            fix16_t pitch_cv = low->pitch_cv + (high->pitch_cv - low->pitch_cv) * step / 32;
+            double t = (double)(pitch_cv - low->pitch_cv) / (high->pitch_cv - low->pitch_cv);
+
+            double expected = low->castor_ramp_cv * pow((double)(high->castor_ramp_cv) / low->castor_ramp_cv, t);
+            // Rounded down like the linear interpolation this replaced.
+            double lerped = floor(low->castor_ramp_cv + t * (high->castor_ramp_cv - low->castor_ramp_cv));
+            double actual = gem_ramp_table_lookup(0, pitch_cv);
+
+            // Relative error, since that's how much the amplitude is off.
+            cubic_error += fabs(actual - expected) / expected;
+            lerp_error += fabs(lerped - expected) / expected;
+            count++;
+        }
+    }
+
+    cubic_error /= count;
+    lerp_error /= count;
+    munit_assert_double(cubic_error, <, lerp_error / 2);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(table_changes)
+    gem_ramp_table_update_interpolation();
+    uint16_t original = gem_ramp_table[5].castor_ramp_cv;
+
+    // Flattening part of the table is followed once the interpolation is
+    // updated, without overshooting the flat part.
+    gem_ramp_table[5].castor_ramp_cv = gem_ramp_table[4].castor_ramp_cv;
+    gem_ramp_table_update_interpolation();
+
+    munit_assert_uint32(gem_ramp_table_lookup(0, F16(2.2)), ==, gem_ramp_table[4].castor_ramp_cv);
+    munit_assert_uint32(gem_ramp_table_lookup(0, F16(2.5)), ==, gem_ramp_table[5].castor_ramp_cv);
+    munit_assert_uint32(gem_ramp_table_lookup(0, F16(2.7)), >=, gem_ramp_table[5].castor_ramp_cv);
+    munit_assert_uint32(gem_ramp_table_lookup(0, F16(2.7)), <=, gem_ramp_table[6].castor_ramp_cv);
+
+    gem_ramp_table[5].castor_ramp_cv = original;
+    gem_ramp_table_update_interpolation();
+TEST_CASE_END
+
 static MunitTest test_suite_tests[] = {
     {.name = "lowest", .test = test_lowest},
     {.name = "lerp between 2 -> 3 volts", .test = test_lerp_between_2_and_3},
     {.name = "sweep across range", .test = test_sweep},
+    {.name = "passes through entries", .test = test_passes_through_entries},
+    {.name = "monotonic", .test = test_monotonic},
+    {.name = "closer than lerp", .test = test_closer_than_lerp},
+    {.name = "table changes", .test = test_table_changes},
     {.test = NULL},
 };
 
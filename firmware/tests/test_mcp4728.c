@@ -0,0 +1,145 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+/* Tests for src/drivers/gem_mcp4728.c */
+
+#include "gem_mcp4728.h"
+#include "gem_test.h"
+#include <string.h>
+
+/* Fake I2C bus that records the last transaction. */
+
+static const struct GemI2CConfig i2c = {};
+static uint8_t last_write[16];
+static size_t last_write_len;
+static size_t write_count;
+static enum GemI2CResult next_result;
+
+enum GemI2CResult gem_i2c_write(const struct GemI2CConfig* cfg, uint8_t address, uint8_t* data, size_t len) {
+    (void)cfg;
+    (void)address;
+    munit_assert_size(len, <=, sizeof(last_write));
+    memcpy(last_write, data, len);
+    last_write_len = len;
+    write_count++;
+    return next_result;
+}
+
+static void reset_bus() {
+    next_result = GEM_I2C_RESULT_SUCCESS;
+    gem_mcp_4728_init(&i2c);
+    write_count = 0;
+    last_write_len = 0;
+}
+
+static enum GemI2CResult write_values(uint16_t a, uint16_t b, uint16_t c, uint16_t d) {
+    return gem_mcp_4728_write_channels(
+        &i2c,
+        (struct GemMCP4278Channel){.value = a},
+        (struct GemMCP4278Channel){.value = b},
+        (struct GemMCP4278Channel){.value = c},
+        (struct GemMCP4278Channel){.value = d});
+}
+
+TEST_CASE_BEGIN(first_write_is_full)
+    reset_bus();
+
+    // Nothing is known about the DAC's state after init, so every channel
+    // must be written.
+    write_values(0x123, 0x456, 0x789, 0xABC);
+
+    munit_assert_size(write_count, ==, 1);
+    munit_assert_size(last_write_len, ==, 8);
+    const uint8_t expected[] = {0x01, 0x23, 0x04, 0x56, 0x07, 0x89, 0x0A, 0xBC};
+    munit_assert_memory_equal(8, last_write, expected);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(skips_unchanged_writes)
+    reset_bus();
+    const struct GemMCP4728Stats* stats = gem_mcp_4728_stats();
+
+    write_values(1, 2, 3, 4);
+    uint32_t skipped = stats->skipped_writes;
+
+    write_values(1, 2, 3, 4);
+    write_values(1, 2, 3, 4);
+
+    munit_assert_size(write_count, ==, 1);
+    munit_assert_uint32(stats->skipped_writes, ==, skipped + 2);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(partial_write)
+    reset_bus();
+    const struct GemMCP4728Stats* stats = gem_mcp_4728_stats();
+
+    write_values(1, 2, 3, 4);
+    uint32_t partial = stats->partial_writes;
+
+    // Only channel C changed, so only it should be sent using a multi-write.
+    write_values(1, 2, 0xFED, 4);
+
+    munit_assert_size(write_count, ==, 2);
+    munit_assert_size(last_write_len, ==, 3);
+    const uint8_t expected_c[] = {0x40 | (2 << 1), 0x0F, 0xED};
+    munit_assert_memory_equal(3, last_write, expected_c);
+    munit_assert_uint32(stats->partial_writes, ==, partial + 1);
+
+    // Channels A & D changed.
+    write_values(5, 2, 0xFED, 6);
+
+    munit_assert_size(last_write_len, ==, 6);
+    const uint8_t expected_ad[] = {0x40 | (0 << 1), 0x00, 0x05, 0x40 | (3 << 1), 0x00, 0x06};
+    munit_assert_memory_equal(6, last_write, expected_ad);
+
+    // Three channels changed, which is cheaper to send as a fast write.
+    write_values(7, 8, 9, 6);
+
+    munit_assert_size(last_write_len, ==, 8);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(retries_after_error)
+    reset_bus();
+
+    write_values(1, 2, 3, 4);
+
+    // If the DAC doesn't acknowledge the write then the next write must not
+    // be skipped.
+    next_result = GEM_I2C_RESULT_ERR_DATA_NACK;
+    munit_assert_int(write_values(1, 2, 3, 5), ==, GEM_I2C_RESULT_ERR_DATA_NACK);
+
+    next_result = GEM_I2C_RESULT_SUCCESS;
+    write_values(1, 2, 3, 5);
+
+    munit_assert_size(write_count, ==, 3);
+    munit_assert_size(last_write_len, ==, 8);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(probe_skips_eeprom)
+    next_result = GEM_I2C_RESULT_SUCCESS;
+    write_count = 0;
+    gem_mcp_4728_init(&i2c);
+
+    // Probing shouldn't use the single write command, since that also
+    // programs the channel's EEPROM and makes the DAC busy while booting.
+    munit_assert_size(write_count, ==, 1);
+    munit_assert_size(last_write_len, ==, 3);
+    munit_assert_uint8(last_write[0], ==, 0x40);
+TEST_CASE_END
+
+static MunitTest test_suite_tests[] = {
+    {.name = "first write is full", .test = test_first_write_is_full},
+    {.name = "skips unchanged", .test = test_skips_unchanged_writes},
+    {.name = "partial write", .test = test_partial_write},
+    {.name = "retries after error", .test = test_retries_after_error},
+    {.name = "probe skips eeprom", .test = test_probe_skips_eeprom},
+    {.test = NULL},
+};
+
+MunitSuite test_mcp4728_suite = {
+    .prefix = "mcp4728: ",
+    .tests = test_suite_tests,
+    .iterations = 1,
+};
@@ -0,0 +1,50 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+/* Tests for src/lib/gem_memory.c */
+
+#include "gem_memory.h"
+#include "gem_test.h"
+
+static uint32_t stack[64];
+
+TEST_CASE_BEGIN(unused_stack)
+    gem_memory_paint(stack, stack + ARRAY_LEN(stack));
+    munit_assert_size(gem_memory_used(stack, stack + ARRAY_LEN(stack)), ==, 0);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(high_water_mark)
+    gem_memory_paint(stack, stack + ARRAY_LEN(stack));
+
+    // The stack grows down from the end, so using the top 10 words should
+    // show up as 40 bytes used.
+    for (size_t i = 54; i < 64; i++) { stack[i] = 0; }
+    munit_assert_size(gem_memory_used(stack, stack + ARRAY_LEN(stack)), ==, 40);
+
+    // A deeper call that's since returned still counts, even if some of
+    // the words it used happen to be left alone.
+    stack[20] = 0;
+    munit_assert_size(gem_memory_used(stack, stack + ARRAY_LEN(stack)), ==, 44 * 4);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(overflowed_stack)
+    gem_memory_paint(stack, stack + ARRAY_LEN(stack));
+    stack[0] = 0;
+    munit_assert_size(gem_memory_used(stack, stack + ARRAY_LEN(stack)), ==, sizeof(stack));
+TEST_CASE_END
+
+static MunitTest test_suite_tests[] = {
+    {.name = "unused stack", .test = test_unused_stack},
+    {.name = "high water mark", .test = test_high_water_mark},
+    {.name = "overflowed stack", .test = test_overflowed_stack},
+    {.test = NULL},
+};
+
+MunitSuite test_memory_suite = {
+    .prefix = "memory: ",
+    .tests = test_suite_tests,
+    .iterations = 1,
+};
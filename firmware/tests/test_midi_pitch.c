@@ -0,0 +1,170 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+/* Tests for src/gem_midi_pitch.c */
+
+#include "gem_midi_pitch.h"
+#include "gem_test.h"
+
+static struct WntrMIDIMessage note_on(uint8_t channel, uint8_t note, uint8_t velocity) {
+    return (struct WntrMIDIMessage){
+        .code_index = MIDI_CODE_INDEX_NOTE_ON, .status = 0x90 | (channel - 1), .data_0 = note, .data_1 = velocity};
+}
+
+static struct WntrMIDIMessage note_off(uint8_t channel, uint8_t note) {
+    return (struct WntrMIDIMessage){
+        .code_index = MIDI_CODE_INDEX_NOTE_OFF, .status = 0x80 | (channel - 1), .data_0 = note, .data_1 = 0};
+}
+
+static struct WntrMIDIMessage pitch_bend(uint8_t channel, uint16_t value) {
+    return (struct WntrMIDIMessage){
+        .code_index = MIDI_CODE_INDEX_PITCH_BEND,
+        .status = 0xE0 | (channel - 1),
+        .data_0 = value & 0x7F,
+        .data_1 = value >> 7};
+}
+
+TEST_CASE_BEGIN(note_to_volts)
+    struct GemMIDIPitch midi_pitch;
+    GemMIDIPitch_init(&midi_pitch, 1, 2);
+
+    munit_assert_false(GemMIDIPitch_active(&midi_pitch));
+
+    struct WntrMIDIMessage msg = note_on(1, 60, 100);
+    munit_assert_true(GemMIDIPitch_handle(&midi_pitch, &msg, 1000));
+    munit_assert_true(GemMIDIPitch_active(&midi_pitch));
+    munit_assert_uint32(midi_pitch.changed_at, ==, 1000);
+
+    // C4 is 4 V with C0 at 0 V.
+    ASSERT_FIX16_CLOSE(GemMIDIPitch_volts(&midi_pitch), F16(4.0), 0.0001);
+
+    msg = note_on(1, 69, 100);
+    GemMIDIPitch_handle(&midi_pitch, &msg, 1000);
+    ASSERT_FIX16_CLOSE(GemMIDIPitch_volts(&midi_pitch), F16(4.75), 0.0001);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(ignores_other_channels)
+    struct GemMIDIPitch midi_pitch;
+    GemMIDIPitch_init(&midi_pitch, 3, 2);
+
+    struct WntrMIDIMessage msg = note_on(1, 60, 100);
+    munit_assert_false(GemMIDIPitch_handle(&midi_pitch, &msg, 1000));
+    munit_assert_false(GemMIDIPitch_active(&midi_pitch));
+
+    msg = note_on(3, 60, 100);
+    munit_assert_true(GemMIDIPitch_handle(&midi_pitch, &msg, 1000));
+
+    // Channel 0 turns MIDI off.
+    GemMIDIPitch_init(&midi_pitch, 0, 2);
+    munit_assert_false(GemMIDIPitch_handle(&midi_pitch, &msg, 1000));
+TEST_CASE_END
+
+TEST_CASE_BEGIN(changing_settings_releases_notes)
+    struct GemMIDIPitch midi_pitch;
+    GemMIDIPitch_init(&midi_pitch, 1, 2);
+
+    struct WntrMIDIMessage msg = note_on(1, 60, 100);
+    GemMIDIPitch_handle(&midi_pitch, &msg, 1000);
+    munit_assert_true(GemMIDIPitch_active(&midi_pitch));
+
+    // Turning MIDI off stops the held note from overriding CV even if the
+    // state wasn't reset.
+    midi_pitch.channel = 0;
+    munit_assert_false(GemMIDIPitch_active(&midi_pitch));
+
+    // Applying new settings forgets the held note, since its note off will
+    // never be received on the new channel.
+    midi_pitch.channel = 1;
+    GemMIDIPitch_init(&midi_pitch, 2, 2);
+    munit_assert_false(GemMIDIPitch_active(&midi_pitch));
+    ASSERT_FIX16_CLOSE(GemMIDIPitch_volts(&midi_pitch), F16(0), 0.0001);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(last_note_priority)
+    struct GemMIDIPitch midi_pitch;
+    GemMIDIPitch_init(&midi_pitch, 1, 2);
+
+    struct WntrMIDIMessage msg = note_on(1, 48, 100);
+    GemMIDIPitch_handle(&midi_pitch, &msg, 1000);
+    msg = note_on(1, 52, 100);
+    GemMIDIPitch_handle(&midi_pitch, &msg, 1000);
+    msg = note_on(1, 55, 100);
+    GemMIDIPitch_handle(&midi_pitch, &msg, 1000);
+    ASSERT_FIX16_CLOSE(GemMIDIPitch_volts(&midi_pitch), fix16_from_dbl((55 - 12) / 12.0), 0.0001);
+
+    // Releasing a note that isn't the newest doesn't change the pitch.
+    midi_pitch.changed_at = 0;
+    msg = note_off(1, 52);
+    munit_assert_false(GemMIDIPitch_handle(&midi_pitch, &msg, 2000));
+    munit_assert_uint32(midi_pitch.changed_at, ==, 0);
+
+    // Releasing the newest goes back to the last one still held, note on
+    // with zero velocity counts as a release.
+    msg = note_on(1, 55, 0);
+    munit_assert_true(GemMIDIPitch_handle(&midi_pitch, &msg, 3000));
+    ASSERT_FIX16_CLOSE(GemMIDIPitch_volts(&midi_pitch), F16(3.0), 0.0001);
+
+    msg = note_off(1, 48);
+    GemMIDIPitch_handle(&midi_pitch, &msg, 4000);
+    munit_assert_false(GemMIDIPitch_active(&midi_pitch));
+TEST_CASE_END
+
+TEST_CASE_BEGIN(too_many_notes)
+    struct GemMIDIPitch midi_pitch;
+    GemMIDIPitch_init(&midi_pitch, 1, 2);
+
+    for (uint8_t note = 40; note < 40 + GEM_MIDI_PITCH_MAX_NOTES + 4; note++) {
+        struct WntrMIDIMessage msg = note_on(1, note, 100);
+        GemMIDIPitch_handle(&midi_pitch, &msg, 1000);
+    }
+    munit_assert_uint8(midi_pitch.note_count, ==, GEM_MIDI_PITCH_MAX_NOTES);
+
+    // All notes off.
+    struct WntrMIDIMessage msg = {
+        .code_index = MIDI_CODE_INDEX_CONTROL_CHANGE, .status = 0xB0, .data_0 = 123, .data_1 = 0};
+    munit_assert_true(GemMIDIPitch_handle(&midi_pitch, &msg, 1000));
+    munit_assert_false(GemMIDIPitch_active(&midi_pitch));
+TEST_CASE_END
+
+TEST_CASE_BEGIN(pitch_bend)
+    struct GemMIDIPitch midi_pitch;
+    GemMIDIPitch_init(&midi_pitch, 1, 12);
+
+    struct WntrMIDIMessage msg = note_on(1, 60, 100);
+    GemMIDIPitch_handle(&midi_pitch, &msg, 1000);
+
+    // Full scale up is an octave with a 12 semitone range.
+    msg = pitch_bend(1, 16383);
+    munit_assert_true(GemMIDIPitch_handle(&midi_pitch, &msg, 1000));
+    ASSERT_FIX16_CLOSE(GemMIDIPitch_volts(&midi_pitch), F16(5.0), 0.001);
+
+    msg = pitch_bend(1, 0);
+    GemMIDIPitch_handle(&midi_pitch, &msg, 1000);
+    ASSERT_FIX16_CLOSE(GemMIDIPitch_volts(&midi_pitch), F16(3.0), 0.001);
+
+    msg = pitch_bend(1, 8192);
+    GemMIDIPitch_handle(&midi_pitch, &msg, 1000);
+    ASSERT_FIX16_CLOSE(GemMIDIPitch_volts(&midi_pitch), F16(4.0), 0.0001);
+
+    // Re-sending the same value isn't a change.
+    munit_assert_false(GemMIDIPitch_handle(&midi_pitch, &msg, 1000));
+TEST_CASE_END
+
+static MunitTest test_suite_tests[] = {
+    {.name = "note to volts", .test = test_note_to_volts},
+    {.name = "ignores other channels", .test = test_ignores_other_channels},
+    {.name = "changing settings releases notes", .test = test_changing_settings_releases_notes},
+    {.name = "last note priority", .test = test_last_note_priority},
+    {.name = "too many notes", .test = test_too_many_notes},
+    {.name = "pitch bend", .test = test_pitch_bend},
+    {.test = NULL},
+};
+
+MunitSuite test_midi_pitch_suite = {
+    .prefix = "midi pitch: ",
+    .tests = test_suite_tests,
+    .iterations = 1,
+};
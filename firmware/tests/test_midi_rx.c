@@ -0,0 +1,168 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+/* Tests for receiving messages with third_party/libwinter/wntr_midi_core.c */
+
+#include "gem_test.h"
+#include "tusb.h"
+#include "wntr_midi_core.h"
+#include "wntr_sysex_stream.h"
+#include <string.h>
+
+#define RX_FIFO_SIZE 128
+
+/* Fake TinyUSB MIDI receive FIFO, see test_midi_tx.c for the transmit side. */
+
+static uint8_t rx_fifo[RX_FIFO_SIZE * 4];
+static size_t rx_fifo_read;
+static size_t rx_fifo_len;
+
+uint32_t tud_midi_n_available(uint8_t itf, uint8_t cable_num) {
+    (void)itf;
+    (void)cable_num;
+    return rx_fifo_len - rx_fifo_read;
+}
+
+bool tud_midi_n_packet_read(uint8_t itf, uint8_t packet[4]) {
+    (void)itf;
+    if (rx_fifo_read == rx_fifo_len) {
+        return false;
+    }
+    memcpy(packet, rx_fifo + rx_fifo_read, 4);
+    rx_fifo_read += 4;
+    return true;
+}
+
+static bool fake_rx_packet(const uint8_t packet[4]) {
+    munit_assert_size(rx_fifo_len + 4, <=, sizeof(rx_fifo));
+    memcpy(rx_fifo + rx_fifo_len, packet, 4);
+    rx_fifo_len += 4;
+    return true;
+}
+
+static void fake_rx_reset() {
+    rx_fifo_read = 0;
+    rx_fifo_len = 0;
+}
+
+static void fake_rx_sysex(const uint8_t* payload, size_t len) {
+    struct WntrSysExStream stream;
+    WntrSysExStream_start(&stream, fake_rx_packet);
+    WntrSysExStream_write(&stream, payload, len);
+    WntrSysExStream_end(&stream);
+}
+
+TEST_CASE_BEGIN(sysex_split_across_calls)
+    fake_rx_reset();
+
+    const uint8_t payload[] = {0x77, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+    const uint8_t note_on[4] = {MIDI_CODE_INDEX_NOTE_ON, 0x90, 60, 100};
+    fake_rx_sysex(payload, sizeof(payload));
+    fake_rx_packet(note_on);
+
+    // Each call only reads one packet, so the SysEx message only shows up
+    // once its last packet has been read.
+    struct WntrMIDIMessage msg = {};
+    munit_assert_size(wntr_midi_rx_pending(), ==, 4);
+    munit_assert_false(wntr_midi_receive(&msg));
+    munit_assert_false(wntr_midi_receive(&msg));
+    munit_assert_true(wntr_midi_receive(&msg));
+    munit_assert_uint8(msg.code_index, ==, MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE);
+    munit_assert_size(wntr_midi_sysex_len(), ==, sizeof(payload));
+    munit_assert_memory_equal(sizeof(payload), wntr_midi_sysex_data(), payload);
+
+    munit_assert_true(wntr_midi_receive(&msg));
+    munit_assert_uint8(msg.code_index, ==, MIDI_CODE_INDEX_NOTE_ON);
+    munit_assert_uint8(msg.data_0, ==, 60);
+
+    munit_assert_size(wntr_midi_rx_pending(), ==, 0);
+    munit_assert_false(wntr_midi_receive(&msg));
+TEST_CASE_END
+
+TEST_CASE_BEGIN(sysex_every_length)
+    uint8_t payload[20];
+    for (size_t i = 0; i < sizeof(payload); i++) { payload[i] = i + 1; }
+
+    for (size_t len = 0; len <= sizeof(payload); len++) {
+        fake_rx_reset();
+        fake_rx_sysex(payload, len);
+
+        struct WntrMIDIMessage msg = {};
+        size_t messages = 0;
+        while (wntr_midi_rx_pending()) {
+            if (wntr_midi_receive(&msg)) {
+                messages++;
+            }
+        }
+
+        munit_assert_size(messages, ==, 1);
+        munit_assert_uint8(msg.code_index, ==, MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE);
+        munit_assert_size(wntr_midi_sysex_len(), ==, len);
+        munit_assert_memory_equal(len, wntr_midi_sysex_data(), payload);
+    }
+TEST_CASE_END
+
+TEST_CASE_BEGIN(sysex_too_long_is_dropped)
+    fake_rx_reset();
+
+    uint8_t payload[200] = {};
+    const uint8_t short_payload[] = {0x77, 0x02};
+    fake_rx_sysex(payload, sizeof(payload));
+    fake_rx_sysex(short_payload, sizeof(short_payload));
+
+    uint32_t dropped_before = wntr_midi_rx_stats()->dropped_sysex;
+    struct WntrMIDIMessage msg = {};
+    size_t messages = 0;
+    while (wntr_midi_rx_pending()) {
+        if (wntr_midi_receive(&msg)) {
+            messages++;
+        }
+    }
+
+    // Only the second message is received.
+    munit_assert_size(messages, ==, 1);
+    munit_assert_size(wntr_midi_sysex_len(), ==, sizeof(short_payload));
+    munit_assert_memory_equal(sizeof(short_payload), wntr_midi_sysex_data(), short_payload);
+    munit_assert_uint32(wntr_midi_rx_stats()->dropped_sysex - dropped_before, ==, 1);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(sysex_interrupted_is_dropped)
+    fake_rx_reset();
+
+    // The start of a message that never ends, then a whole message.
+    const uint8_t start[4] = {MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE, 0xF0, 0x77, 0x01};
+    const uint8_t payload[] = {0x77, 0x02, 0x03};
+    fake_rx_packet(start);
+    fake_rx_sysex(payload, sizeof(payload));
+
+    uint32_t dropped_before = wntr_midi_rx_stats()->dropped_sysex;
+    struct WntrMIDIMessage msg = {};
+    size_t messages = 0;
+    while (wntr_midi_rx_pending()) {
+        if (wntr_midi_receive(&msg)) {
+            messages++;
+        }
+    }
+
+    munit_assert_size(messages, ==, 1);
+    munit_assert_size(wntr_midi_sysex_len(), ==, sizeof(payload));
+    munit_assert_memory_equal(sizeof(payload), wntr_midi_sysex_data(), payload);
+    munit_assert_uint32(wntr_midi_rx_stats()->dropped_sysex - dropped_before, ==, 1);
+TEST_CASE_END
+
+static MunitTest test_suite_tests[] = {
+    {.name = "sysex split across calls", .test = test_sysex_split_across_calls},
+    {.name = "sysex every length", .test = test_sysex_every_length},
+    {.name = "sysex too long is dropped", .test = test_sysex_too_long_is_dropped},
+    {.name = "sysex interrupted is dropped", .test = test_sysex_interrupted_is_dropped},
+    {.test = NULL},
+};
+
+MunitSuite test_midi_rx_suite = {
+    .prefix = "midi rx: ",
+    .tests = test_suite_tests,
+    .iterations = 1,
+};
@@ -0,0 +1,211 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+/* Tests for third_party/libwinter/wntr_midi_tx.c */
+
+#include "gem_test.h"
+#include "tusb.h"
+#include "wntr_midi_core.h"
+#include "wntr_midi_tx.h"
+#include "wntr_sysex_stream.h"
+#include <string.h>
+
+#define FIFO_MAX_SIZE 1024
+
+/* Fake TinyUSB MIDI FIFO, the host reads from it whenever fake_host_read() is called. */
+
+static uint8_t fifo[FIFO_MAX_SIZE];
+static size_t fifo_len;
+static size_t fifo_size;
+static bool mounted;
+static size_t write_calls;
+
+/* Everything the host has read so far. */
+static uint8_t host[64 * 1024];
+static size_t host_len;
+
+bool tud_midi_n_mounted(uint8_t itf) {
+    (void)itf;
+    return mounted;
+}
+
+uint32_t tud_midi_n_packet_write_n_available(uint8_t itf) {
+    (void)itf;
+    return mounted ? (fifo_size - fifo_len) & ~3u : 0;
+}
+
+uint32_t tud_midi_n_packet_write_n(uint8_t itf, uint8_t const packets[], uint32_t n_bytes) {
+    munit_assert_uint32(n_bytes % 4, ==, 0);
+    uint32_t count = tud_midi_n_packet_write_n_available(itf);
+    count = count < n_bytes ? count : n_bytes;
+    memcpy(fifo + fifo_len, packets, count);
+    fifo_len += count;
+    write_calls++;
+    return count;
+}
+
+static void fake_host_read() {
+    munit_assert_size(host_len + fifo_len, <=, sizeof(host));
+    memcpy(host + host_len, fifo, fifo_len);
+    host_len += fifo_len;
+    fifo_len = 0;
+}
+
+static void fake_usb_reset(size_t size) {
+    mounted = true;
+    fifo_size = FIFO_MAX_SIZE;
+    // Throw away anything left over from other tests.
+    wntr_midi_tx_flush();
+    fifo_len = 0;
+    fifo_size = size;
+    host_len = 0;
+    write_calls = 0;
+}
+
+static bool send_sysex(const uint8_t* payload, size_t len) {
+    if (!wntr_midi_tx_reserve(WNTR_SYSEX_STREAM_PACKET_COUNT(len))) {
+        return false;
+    }
+    struct WntrSysExStream stream;
+    WntrSysExStream_start(&stream, wntr_midi_tx_packet);
+    WntrSysExStream_write(&stream, payload, len);
+    WntrSysExStream_end(&stream);
+    return true;
+}
+
+/*
+    Checks that the host received only whole messages and returns how many,
+    each message's first data byte must be its length.
+*/
+static size_t count_host_messages() {
+    size_t messages = 0;
+    size_t message_len = 0;
+    size_t message_start = 0;
+    bool in_message = false;
+
+    munit_assert_size(host_len % 4, ==, 0);
+
+    for (size_t i = 0; i < host_len; i += 4) {
+        const uint8_t* packet = host + i;
+        uint8_t code_index = packet[0] & 0xF;
+
+        if (!in_message) {
+            // Short messages fit entirely in an end packet.
+            munit_assert_uint8(code_index, >=, MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE);
+            munit_assert_uint8(code_index, <=, MIDI_CODE_INDEX_SYSEX_END_THREE_BYTE);
+            munit_assert_uint8(packet[1], ==, 0xF0);
+            in_message = true;
+            message_len = 0;
+            message_start = i;
+        }
+
+        if (code_index == MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE) {
+            message_len += 3;
+            continue;
+        }
+
+        size_t count = code_index - MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE;
+        munit_assert_uint8(packet[count], ==, 0xF7);
+        message_len += count;
+
+        // The start and end bytes are not part of the message's length.
+        munit_assert_size(message_len - 2, ==, host[message_start + 2]);
+
+        in_message = false;
+        messages++;
+    }
+
+    munit_assert_false(in_message);
+    return messages;
+}
+
+TEST_CASE_BEGIN(batches_whole_endpoint_packets)
+    fake_usb_reset(FIFO_MAX_SIZE);
+
+    // Ten bytes, start and end make four packets per message.
+    uint8_t payload[10] = {10};
+    for (size_t i = 0; i < 12; i++) { munit_assert_true(send_sysex(payload, sizeof(payload))); }
+
+    // Nothing is written until the batch fills up, and then it's written all at once.
+    munit_assert_size(write_calls, ==, 48 / (WNTR_MIDI_TX_BATCH_SIZE / 4));
+    munit_assert_size(fifo_len, ==, 48 / (WNTR_MIDI_TX_BATCH_SIZE / 4) * WNTR_MIDI_TX_BATCH_SIZE);
+    munit_assert_size(wntr_midi_tx_pending(), ==, 48 % (WNTR_MIDI_TX_BATCH_SIZE / 4));
+
+    wntr_midi_tx_flush();
+    fake_host_read();
+    munit_assert_size(wntr_midi_tx_pending(), ==, 0);
+    munit_assert_size(count_host_messages(), ==, 12);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(back_pressure_drops_whole_messages)
+    fake_usb_reset(128);
+
+    uint8_t payload[100];
+    size_t sent = 0;
+    size_t dropped = 0;
+    uint32_t dropped_before = wntr_midi_tx_stats()->dropped_messages;
+
+    for (size_t n = 0; n < 500; n++) {
+        size_t len = munit_rand_int_range(1, sizeof(payload));
+        munit_rand_memory(len, payload);
+        for (size_t i = 0; i < len; i++) { payload[i] &= 0x7F; }
+        payload[0] = len;
+
+        if (send_sysex(payload, len)) {
+            sent++;
+        } else {
+            dropped++;
+        }
+
+        // The host only reads now and then, so the FIFO fills up.
+        if (munit_rand_int_range(0, 4) == 0) {
+            fake_host_read();
+        }
+        if (munit_rand_int_range(0, 2) == 0) {
+            wntr_midi_tx_flush();
+        }
+    }
+
+    while (wntr_midi_tx_pending()) {
+        wntr_midi_tx_flush();
+        fake_host_read();
+    }
+    fake_host_read();
+
+    munit_assert_size(dropped, >, 0);
+    munit_assert_size(wntr_midi_tx_stats()->dropped_messages - dropped_before, ==, dropped);
+    munit_assert_size(count_host_messages(), ==, sent);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(unmounted_discards_batch)
+    fake_usb_reset(FIFO_MAX_SIZE);
+
+    uint8_t payload[4] = {4};
+    mounted = false;
+    munit_assert_true(send_sysex(payload, sizeof(payload)));
+    munit_assert_size(wntr_midi_tx_pending(), ==, 2);
+
+    wntr_midi_tx_flush();
+    munit_assert_size(wntr_midi_tx_pending(), ==, 0);
+
+    mounted = true;
+    wntr_midi_tx_flush();
+    fake_host_read();
+    munit_assert_size(host_len, ==, 0);
+TEST_CASE_END
+
+static MunitTest test_suite_tests[] = {
+    {.name = "batches whole endpoint packets", .test = test_batches_whole_endpoint_packets},
+    {.name = "back pressure drops whole messages", .test = test_back_pressure_drops_whole_messages},
+    {.name = "unmounted discards batch", .test = test_unmounted_discards_batch},
+    {.test = NULL},
+};
+
+MunitSuite test_midi_tx_suite = {
+    .prefix = "midi tx: ",
+    .tests = test_suite_tests,
+    .iterations = 1,
+};
@@ -0,0 +1,135 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+/* Tests for third_party/libwinter/wntr_nvm_write.c */
+
+#include "fake_nvm.h"
+#include "gem_test.h"
+#include <string.h>
+
+#define LUT_ADDR (FAKE_NVM_BASE + FAKE_NVM_SIZE - 512)
+#define LUT_OFFSET (FAKE_NVM_SIZE - 512)
+#define LUT_FIRST_ROW (LUT_OFFSET / WNTR_NVM_ROW_SIZE)
+
+static uint8_t table[512];
+
+static void fill_table(uint8_t seed) {
+    for (size_t i = 0; i < sizeof(table); i++) { table[i] = (uint8_t)(seed + i * 7); }
+}
+
+TEST_CASE_BEGIN(first_write)
+    fake_nvm_reset();
+    fill_table(1);
+
+    // Writing to blank flash only ever clears bits, so no erase is needed.
+    wntr_nvm_write(LUT_ADDR, table, sizeof(table));
+
+    munit_assert_memory_equal(sizeof(table), fake_nvm_flash + LUT_OFFSET, table);
+    munit_assert_uint32(fake_nvm_stats.total_erases, ==, 0);
+    munit_assert_uint32(fake_nvm_stats.page_writes, ==, sizeof(table) / WNTR_NVM_PAGE_SIZE);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(unchanged_write)
+    fake_nvm_reset();
+    fill_table(1);
+    wntr_nvm_write(LUT_ADDR, table, sizeof(table));
+
+    // Writing the same data again, like re-running calibration with the same
+    // result, shouldn't touch the flash at all.
+    fake_nvm_reset_stats();
+    wntr_nvm_write(LUT_ADDR, table, sizeof(table));
+
+    munit_assert_uint32(fake_nvm_stats.total_erases, ==, 0);
+    munit_assert_uint32(fake_nvm_stats.page_writes, ==, 0);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(clear_bits_without_erase)
+    fake_nvm_reset();
+    fill_table(1);
+    table[100] = 0xFF;
+    wntr_nvm_write(LUT_ADDR, table, sizeof(table));
+
+    // Only clears bits, so the changed page can be programmed as-is.
+    fake_nvm_reset_stats();
+    table[100] = 0x0F;
+    wntr_nvm_write(LUT_ADDR, table, sizeof(table));
+
+    munit_assert_memory_equal(sizeof(table), fake_nvm_flash + LUT_OFFSET, table);
+    munit_assert_uint32(fake_nvm_stats.total_erases, ==, 0);
+    munit_assert_uint32(fake_nvm_stats.page_writes, ==, 1);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(set_bits_with_erase)
+    fake_nvm_reset();
+    fill_table(1);
+    table[300] = 0x00;
+    wntr_nvm_write(LUT_ADDR, table, sizeof(table));
+
+    // Setting bits requires erasing, but only the row that changed.
+    fake_nvm_reset_stats();
+    table[300] = 0x80;
+    wntr_nvm_write(LUT_ADDR, table, sizeof(table));
+
+    munit_assert_memory_equal(sizeof(table), fake_nvm_flash + LUT_OFFSET, table);
+    munit_assert_uint32(fake_nvm_stats.total_erases, ==, 1);
+    munit_assert_uint32(fake_nvm_stats.row_erases[LUT_FIRST_ROW + 1], ==, 1);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(partial_row_write)
+    fake_nvm_reset();
+    fill_table(1);
+    wntr_nvm_write(LUT_ADDR, table, sizeof(table));
+
+    // Writing a few bytes in the middle of a row that needs an erase has to
+    // keep the rest of the row intact.
+    uint8_t patch[3] = {0xFF, 0xFF, 0xFF};
+    wntr_nvm_write(LUT_ADDR + 62, patch, sizeof(patch));
+    memcpy(table + 62, patch, sizeof(patch));
+
+    munit_assert_memory_equal(sizeof(table), fake_nvm_flash + LUT_OFFSET, table);
+    munit_assert_uint32(fake_nvm_stats.total_erases, ==, 1);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(erase_blank)
+    fake_nvm_reset();
+
+    // Erasing a table that's already erased, like the factory setup script
+    // does, is a no-op.
+    memset(table, 0xFF, sizeof(table));
+    wntr_nvm_write(LUT_ADDR, table, sizeof(table));
+
+    munit_assert_uint32(fake_nvm_stats.total_erases, ==, 0);
+    munit_assert_uint32(fake_nvm_stats.page_writes, ==, 0);
+
+    // Erasing a written table only needs the erases, since the blank pages
+    // don't need to be written back.
+    fill_table(1);
+    wntr_nvm_write(LUT_ADDR, table, sizeof(table));
+    fake_nvm_reset_stats();
+
+    memset(table, 0xFF, sizeof(table));
+    wntr_nvm_write(LUT_ADDR, table, sizeof(table));
+
+    munit_assert_memory_equal(sizeof(table), fake_nvm_flash + LUT_OFFSET, table);
+    munit_assert_uint32(fake_nvm_stats.total_erases, ==, 2);
+    munit_assert_uint32(fake_nvm_stats.page_writes, ==, 0);
+TEST_CASE_END
+
+static MunitTest test_suite_tests[] = {
+    {.name = "first write", .test = test_first_write},
+    {.name = "unchanged write", .test = test_unchanged_write},
+    {.name = "clear bits without erase", .test = test_clear_bits_without_erase},
+    {.name = "set bits with erase", .test = test_set_bits_with_erase},
+    {.name = "partial row write", .test = test_partial_row_write},
+    {.name = "erase blank", .test = test_erase_blank},
+    {.test = NULL},
+};
+
+MunitSuite test_nvm_suite = {
+    .prefix = "nvm: ",
+    .tests = test_suite_tests,
+    .iterations = 1,
+};
@@ -0,0 +1,192 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+/* Tests for src/gem_nvm_journal.c */
+
+#include "fake_nvm.h"
+#include "gem_nvm_journal.h"
+#include "gem_test.h"
+#include <string.h>
+
+/* Same layout as the settings journal: four rows with two records each. */
+#define JOURNAL_LEN (WNTR_NVM_ROW_SIZE * 4)
+#define RECORD_SIZE (WNTR_NVM_PAGE_SIZE * 2)
+#define SLOT_COUNT (JOURNAL_LEN / RECORD_SIZE)
+
+static struct GemNVMJournal journal;
+
+static void make_payload(uint8_t* buf, uint8_t n) {
+    for (size_t i = 0; i < 81; i++) { buf[i] = (uint8_t)(n + i); }
+}
+
+static void assert_newest(uint8_t n) {
+    uint8_t expected[81];
+    uint8_t actual[81];
+    make_payload(expected, n);
+
+    munit_assert_true(GemNVMJournal_read(&journal, actual, 81));
+    munit_assert_memory_equal(81, actual, expected);
+}
+
+static void append(uint8_t n) {
+    uint8_t buf[81];
+    make_payload(buf, n);
+    munit_assert_true(GemNVMJournal_append(&journal, buf, 81));
+}
+
+TEST_CASE_BEGIN(empty)
+    fake_nvm_reset();
+    GemNVMJournal_init(&journal, FAKE_NVM_BASE, JOURNAL_LEN, RECORD_SIZE);
+
+    uint8_t buf[81];
+    munit_assert_false(GemNVMJournal_read(&journal, buf, 81));
+    munit_assert_size(GemNVMJournal_payload_size(&journal), ==, RECORD_SIZE - 8);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(append_and_reload)
+    fake_nvm_reset();
+    GemNVMJournal_init(&journal, FAKE_NVM_BASE, JOURNAL_LEN, RECORD_SIZE);
+
+    append(1);
+    assert_newest(1);
+    append(2);
+    assert_newest(2);
+
+    // Re-initializing is the same as rebooting, it should find the newest
+    // record.
+    GemNVMJournal_init(&journal, FAKE_NVM_BASE, JOURNAL_LEN, RECORD_SIZE);
+    assert_newest(2);
+
+    // Nothing should've been erased since the journal started out blank.
+    munit_assert_uint32(fake_nvm_stats.total_erases, ==, 0);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(wraps_around)
+    fake_nvm_reset();
+    GemNVMJournal_init(&journal, FAKE_NVM_BASE, JOURNAL_LEN, RECORD_SIZE);
+
+    // Go around the journal a few times, rebooting in between some of the
+    // saves.
+    for (uint8_t n = 0; n < SLOT_COUNT * 3 + 3; n++) {
+        append(n);
+        if (n % 5 == 0) {
+            GemNVMJournal_init(&journal, FAKE_NVM_BASE, JOURNAL_LEN, RECORD_SIZE);
+        }
+        assert_newest(n);
+    }
+
+    GemNVMJournal_init(&journal, FAKE_NVM_BASE, JOURNAL_LEN, RECORD_SIZE);
+    assert_newest(SLOT_COUNT * 3 + 2);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(spreads_wear)
+    fake_nvm_reset();
+    GemNVMJournal_init(&journal, FAKE_NVM_BASE, JOURNAL_LEN, RECORD_SIZE);
+
+    const size_t saves = 200;
+    for (size_t n = 0; n < saves; n++) { append((uint8_t)(n)); }
+
+    // A row is only erased when the journal wraps back around to it, so every
+    // row is erased about the same number of times and there's only one
+    // erase for each row's worth of records.
+    uint32_t expected_per_row = saves / SLOT_COUNT;
+    for (size_t row = 0; row < JOURNAL_LEN / WNTR_NVM_ROW_SIZE; row++) {
+        munit_assert_uint32(fake_nvm_stats.row_erases[row], <=, expected_per_row);
+    }
+    munit_assert_uint32(fake_nvm_stats.total_erases, <=, saves / (WNTR_NVM_ROW_SIZE / RECORD_SIZE));
+
+    // Compare that with re-writing the same location every time, which
+    // erases the same row on every save after the first.
+    fake_nvm_reset();
+    uint8_t buf[81];
+    for (size_t n = 0; n < saves; n++) {
+        make_payload(buf, (uint8_t)(n));
+        wntr_nvm_write(FAKE_NVM_BASE, buf, 81);
+    }
+    munit_assert_uint32(fake_nvm_stats.row_erases[0], ==, saves - 1);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(ignores_partial_record)
+    fake_nvm_reset();
+    GemNVMJournal_init(&journal, FAKE_NVM_BASE, JOURNAL_LEN, RECORD_SIZE);
+
+    append(1);
+
+    // Lose power halfway through writing the next record.
+    fake_nvm_fail_after(1);
+    uint8_t buf[81];
+    make_payload(buf, 2);
+    munit_assert_false(GemNVMJournal_append(&journal, buf, 81));
+    fake_nvm_fail_after(-1);
+
+    // After rebooting the half-written record should be ignored.
+    GemNVMJournal_init(&journal, FAKE_NVM_BASE, JOURNAL_LEN, RECORD_SIZE);
+    assert_newest(1);
+
+    // The next save has to skip the half-written slot, but it must not erase
+    // the row that contains the newest good record to do so.
+    fake_nvm_reset_stats();
+    append(3);
+    assert_newest(3);
+    munit_assert_uint32(fake_nvm_stats.row_erases[0], ==, 0);
+
+    GemNVMJournal_init(&journal, FAKE_NVM_BASE, JOURNAL_LEN, RECORD_SIZE);
+    assert_newest(3);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(ignores_corrupt_record)
+    fake_nvm_reset();
+    GemNVMJournal_init(&journal, FAKE_NVM_BASE, JOURNAL_LEN, RECORD_SIZE);
+
+    append(1);
+    append(2);
+
+    // Flip a bit in the newest record's payload.
+    fake_nvm_flash[RECORD_SIZE + 10] ^= 0x01;
+
+    GemNVMJournal_init(&journal, FAKE_NVM_BASE, JOURNAL_LEN, RECORD_SIZE);
+    assert_newest(1);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(erase)
+    fake_nvm_reset();
+    GemNVMJournal_init(&journal, FAKE_NVM_BASE, JOURNAL_LEN, RECORD_SIZE);
+
+    append(1);
+    append(2);
+    append(3);
+
+    fake_nvm_reset_stats();
+    GemNVMJournal_erase(&journal);
+
+    // Only the rows that have records in them need to be erased.
+    munit_assert_uint32(fake_nvm_stats.total_erases, ==, 2);
+
+    uint8_t buf[81];
+    munit_assert_false(GemNVMJournal_read(&journal, buf, 81));
+    GemNVMJournal_init(&journal, FAKE_NVM_BASE, JOURNAL_LEN, RECORD_SIZE);
+    munit_assert_false(GemNVMJournal_read(&journal, buf, 81));
+
+    append(4);
+    assert_newest(4);
+TEST_CASE_END
+
+static MunitTest test_suite_tests[] = {
+    {.name = "empty", .test = test_empty},
+    {.name = "append and reload", .test = test_append_and_reload},
+    {.name = "wraps around", .test = test_wraps_around},
+    {.name = "spreads wear", .test = test_spreads_wear},
+    {.name = "ignores partial record", .test = test_ignores_partial_record},
+    {.name = "ignores corrupt record", .test = test_ignores_corrupt_record},
+    {.name = "erase", .test = test_erase},
+    {.test = NULL},
+};
+
+MunitSuite test_nvm_journal_suite = {
+    .prefix = "nvm journal: ",
+    .tests = test_suite_tests,
+    .iterations = 1,
+};
@@ -17,6 +17,7 @@
 #include <math.h>
 
 const struct WntrErrorCorrection error_correction = {.offset = F16(0), .gain = F16(1)};
+static struct GemQuantizer chromatic;
 struct GemOscillator osc = {
     .number = 0,
     .pitch_offset = F16(1.0),
@@ -30,10 +31,12 @@ struct GemOscillator osc = {
     .zero_detection_enabled = true,
     .zero_detection_threshold = 10,
     .quantization_enabled = true,
+    .quantizer = &chromatic,
 };
 
 TEST_CASE_BEGIN(coarse_pitch)
     gem_oscillator_init(error_correction, F16(0.6));
+    GemQuantizer_init(&chromatic, GEM_QUANTIZER_CHROMATIC);
     GemOscillator_init(&osc);
 
     struct GemOscillatorInputs inputs = {
@@ -467,6 +470,52 @@ TEST_CASE_BEGIN(hard_sync_mode)
     ASSERT_FIX16_CLOSE(osc.pitch, F16(5.5), 0.01);
 TEST_CASE_END
 
+TEST_CASE_BEGIN(audio_fm_mode)
+    gem_oscillator_init(error_correction, F16(0.6));
+    GemOscillator_init(&osc);
+
+    osc.number = 1;  // Pollux
+
+    struct GemOscillatorInputs inputs = {
+        .mode = GEM_MODE_AUDIO_FM,
+        .pitch_cv_code = 2048,
+        .pitch_knob_code = 2048,
+        .tweak_pitch_knob_code = UINT16_MAX,
+        .tweak_pulse_knob_code = UINT16_MAX,
+        .lfo_amplitude = F16(1.0),
+    };
+
+    // Scenario:
+    // - Pulse knob dead center
+    //
+    // The pitch itself shouldn't be modulated by the LFO, instead, the audio
+    // FM depth should be half of the maximum.
+    inputs.pulse_knob_code = 2048;
+
+    GemOscillator_update(&osc, inputs);
+    ASSERT_FIX16_CLOSE(osc.pitch, F16(4.0), 0.01);
+    ASSERT_FIX16_CLOSE(osc.fm_depth, F16(0.5), 0.01);
+
+    // Scenario:
+    // - Pulse knob fully CCW
+    //
+    // There should be no modulation.
+    inputs.pulse_knob_code = 0;
+
+    GemOscillator_update(&osc, inputs);
+    munit_assert_int32(osc.fm_depth, ==, F16(0));
+
+    // Scenario:
+    // - Castor in audio FM mode
+    //
+    // Only Pollux is modulated.
+    osc.number = 0;
+    inputs.pulse_knob_code = 4095;
+
+    GemOscillator_update(&osc, inputs);
+    munit_assert_int32(osc.fm_depth, ==, F16(0));
+TEST_CASE_END
+
 
 #define PERIOD_TO_FREQ(v) (8000000.0 / (1.0 * ((double)(v) + 1.0)))
 
@@ -491,16 +540,229 @@ TEST_CASE_BEGIN(cv_pitch_period_conversion)
     printf("\n");
 TEST_CASE_END
 
+TEST_CASE_BEGIN(batch_matches_scalar)
+    // Each voice gets a different calibration, knob position, and mode so
+    // that every voice takes a different path through the update.
+    enum { VOICES = 8 };
+    struct GemOscillator oscillators[VOICES];
+    struct GemOscillatorInputs inputs[VOICES];
+    struct GemOscillatorCalibration calibrations[VOICES];
+
+    for (size_t i = 0; i < VOICES; i++) {
+        oscillators[i] = osc;
+        oscillators[i].number = i % 2;
+        oscillators[i].pitch_offset = fix16_from_dbl(0.9 + 0.03 * i);
+        GemOscillator_init(&oscillators[i]);
+
+        inputs[i] = (struct GemOscillatorInputs){
+            .mode = i % 4 == 3 ? GEM_MODE_LFO_PWM : GEM_MODE_NORMAL,
+            .pitch_cv_code = i < 2 ? 4095 : 1000 + 300 * i,
+            .pitch_knob_code = 500 * i,
+            .pulse_knob_code = 200 * i,
+            .lfo_knob_code = 4095,
+            .tweak_pitch_knob_code = UINT16_MAX,
+            .tweak_pulse_knob_code = UINT16_MAX,
+            .reference_pitch = F16(2.0),
+            .lfo_amplitude = F16(0.5),
+        };
+
+        calibrations[i] = (struct GemOscillatorCalibration){
+            .pitch_cv_adc_errors = {.offset = fix16_from_int(i * 3), .gain = fix16_from_dbl(0.98 + 0.005 * i)},
+            .pitch_knob_nonlinearity = fix16_from_dbl(0.1 * i),
+        };
+    }
+
+    struct GemOscillatorBatch batch = {
+        .count = VOICES,
+        .oscillators = oscillators,
+        .inputs = inputs,
+        .calibrations = calibrations,
+    };
+    GemOscillatorBatch_update(&batch);
+
+    for (size_t i = 0; i < VOICES; i++) {
+        struct GemOscillator expected = oscillators[i];
+        GemOscillator_init(&expected);
+        gem_oscillator_init(calibrations[i].pitch_cv_adc_errors, calibrations[i].pitch_knob_nonlinearity);
+        GemOscillator_update(&expected, inputs[i]);
+
+        munit_assert_int32(oscillators[i].pitch, ==, expected.pitch);
+        munit_assert_uint16(oscillators[i].pulse_width, ==, expected.pulse_width);
+        munit_assert_int(oscillators[i].pitch_behavior, ==, expected.pitch_behavior);
+    }
+TEST_CASE_END
+
+TEST_CASE_BEGIN(midi_pitch)
+    gem_oscillator_init(error_correction, F16(0.6));
+    GemOscillator_init(&osc);
+
+    struct GemOscillator midi_osc = osc;
+    midi_osc.midi_replaces_cv = true;
+
+    struct GemOscillatorInputs inputs = {
+        .mode = GEM_MODE_NORMAL,
+        .tweak_pitch_knob_code = UINT16_MAX,
+        .midi_active = true,
+        .midi_pitch = F16(2.5),
+    };
+
+    // Scenario:
+    // - Nothing connected to pitch CV in, which would normally be "coarse".
+    // - Pitch knob dead center.
+    // - A MIDI note is held and replaces the pitch CV.
+    //
+    // The MIDI note is the absolute pitch, so the base offset isn't added.
+    inputs.pitch_cv_code = 4095;
+    inputs.pitch_knob_code = 2048;
+
+    GemOscillator_update(&midi_osc, inputs);
+    munit_assert_int(midi_osc.pitch_behavior, ==, GEM_PITCH_MIDI);
+    ASSERT_FIX16_CLOSE(midi_osc.pitch, F16(2.5), 0.01);
+
+    // Scenario:
+    // - Same as above except the pitch knob is fully CW.
+    //
+    // The knob still tunes the note.
+    inputs.pitch_knob_code = 4095;
+
+    GemOscillator_update(&midi_osc, inputs);
+    ASSERT_FIX16_CLOSE(midi_osc.pitch, F16(3.5), 0.01);
+
+    // Scenario:
+    // - Pitch CV at middle of the range (3.0V) and the knob centered.
+    // - MIDI transposes instead of replacing the pitch CV.
+    //
+    // This should be the "fine" pitch plus the note's distance from C4.
+    midi_osc.midi_replaces_cv = false;
+    inputs.pitch_cv_code = 2048;
+    inputs.pitch_knob_code = 2048;
+    inputs.midi_pitch = F16(4.5);
+
+    GemOscillator_update(&midi_osc, inputs);
+    munit_assert_int(midi_osc.pitch_behavior, ==, GEM_PITCH_FINE);
+    ASSERT_FIX16_CLOSE(midi_osc.pitch, F16(4.5), 0.01);
+
+    // Scenario:
+    // - Same as above but the note was released.
+    inputs.midi_active = false;
+
+    GemOscillator_update(&midi_osc, inputs);
+    ASSERT_FIX16_CLOSE(midi_osc.pitch, F16(4.0), 0.01);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(fine_pitch_quantized)
+    gem_oscillator_init(error_correction, F16(0.6));
+    GemOscillator_init(&osc);
+
+    struct GemQuantizer major;
+    GemQuantizer_init(&major, GEM_QUANTIZER_MAJOR);
+
+    struct GemOscillator quantized_osc = osc;
+    quantized_osc.fine_quantization_enabled = true;
+    quantized_osc.quantizer = &major;
+
+    struct GemOscillatorInputs inputs = {
+        .mode = GEM_MODE_NORMAL,
+        .tweak_pitch_knob_code = UINT16_MAX,
+    };
+
+    // Scenario:
+    // - Pitch CV a little above C3 (the codes are inverted, so lower codes
+    //   are higher voltages)
+    // - Pitch knob dead center
+    //
+    // This should quantize the CV to C3 plus the base offset.
+    inputs.pitch_cv_code = 2048 - 4;
+    inputs.pitch_knob_code = 2048;
+
+    GemOscillator_update(&quantized_osc, inputs);
+    munit_assert_int(quantized_osc.pitch_behavior, ==, GEM_PITCH_FINE);
+    ASSERT_FIX16_CLOSE(quantized_osc.pitch, F16(4.0), 0.001);
+
+    // Scenario:
+    // - Pitch CV between C# and D, at about 3.13V.
+    //
+    // C# isn't in the scale, so this should be D.
+    inputs.pitch_cv_code = 1957;
+
+    GemOscillator_update(&quantized_osc, inputs);
+    ASSERT_FIX16_CLOSE(quantized_osc.pitch, F16(4.0 + 2.0 / 12), 0.001);
+
+    // Scenario:
+    // - Pitch knob fully CW.
+    //
+    // The knob isn't quantized, so it tunes the quantized note up an octave.
+    inputs.pitch_knob_code = 4095;
+
+    GemOscillator_update(&quantized_osc, inputs);
+    ASSERT_FIX16_CLOSE(quantized_osc.pitch, F16(5.0 + 2.0 / 12), 0.001);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(fine_pitch_smoothed)
+    gem_oscillator_init(error_correction, F16(0.6));
+    GemOscillator_init(&osc);
+
+    struct GemPitchSmoothing smoothing;
+    GemPitchSmoothing_init(&smoothing, F16(10.0), F16(10.0));
+
+    struct GemOscillator smoothed_osc = osc;
+    smoothed_osc.pitch_smoothing_enabled = true;
+    smoothed_osc.pitch_smoothing = &smoothing;
+
+    struct GemOscillatorInputs inputs = {
+        .mode = GEM_MODE_NORMAL,
+        .pitch_cv_code = 2048,
+        .pitch_knob_code = 2048,
+        .tweak_pitch_knob_code = UINT16_MAX,
+    };
+
+    // Scenario:
+    // - Pitch CV around the middle of the range, jittering by a couple of
+    //   codes.
+    //
+    // The first update isn't smoothed, after that the jitter is mostly
+    // removed. Each code is almost 2 cents.
+    GemOscillator_update(&smoothed_osc, inputs);
+    munit_assert_int(smoothed_osc.pitch_behavior, ==, GEM_PITCH_FINE);
+    fix16_t steady_pitch = smoothed_osc.pitch;
+
+    for (int i = 0; i < 2000; i++) {
+        inputs.pitch_cv_code = 2048 + (i % 2 ? 2 : -2);
+        GemOscillator_update(&smoothed_osc, inputs);
+    }
+    ASSERT_FIX16_CLOSE(smoothed_osc.pitch, steady_pitch, 0.5 / 1200.0);
+
+    // Scenario:
+    // - Pitch CV unpatched.
+    //
+    // Castor switches to coarse mode and the smoothing starts over once the
+    // CV is patched again.
+    inputs.pitch_cv_code = 4095;
+    GemOscillator_update(&smoothed_osc, inputs);
+    munit_assert_int(smoothed_osc.pitch_behavior, ==, GEM_PITCH_COARSE);
+    munit_assert_false(smoothed_osc.pitch_smoother.primed);
+
+    inputs.pitch_cv_code = 1024;
+    GemOscillator_update(&smoothed_osc, inputs);
+    GemOscillator_update(&osc, inputs);
+    munit_assert_int32(smoothed_osc.pitch, ==, osc.pitch);
+TEST_CASE_END
+
 static MunitTest test_suite_tests[] = {
     {.name = "coarse pitch", .test = test_coarse_pitch},
     {.name = "follow pitch", .test = test_follow_pitch},
     {.name = "fine pitch", .test = test_fine_pitch},
+    {.name = "fine pitch quantized", .test = test_fine_pitch_quantized},
+    {.name = "fine pitch smoothed", .test = test_fine_pitch_smoothed},
+    {.name = "midi pitch", .test = test_midi_pitch},
     {.name = "extra fine pitch", .test = test_extra_fine_pitch},
     {.name = "normal mode lfo fm", .test = test_normal_mode_lfo_fm},
     {.name = "pwm mode", .test = test_pwm_mode},
     {.name = "fm mode", .test = test_fm_mode},
     {.name = "hard sync", .test = test_hard_sync_mode},
+    {.name = "audio fm", .test = test_audio_fm_mode},
     {.name = "cv/pitch/period conversion", .test = test_cv_pitch_period_conversion},
+    {.name = "batch matches scalar", .test = test_batch_matches_scalar},
     {.test = NULL},
 };
 
@@ -0,0 +1,149 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+/* Tests for src/gem_pitch_smoothing.c */
+
+#include "gem_config.h"
+#include "gem_pitch_smoothing.h"
+#include "gem_test.h"
+#include <math.h>
+
+#define CENT (1.0 / 1200.0)
+
+/* A straightforward floating-point 1 euro filter to compare against. */
+struct ReferenceSmoother {
+    bool primed;
+    double last_input;
+    double value;
+    double rate;
+};
+
+static double reference_alpha(double cutoff) {
+    double r = 2.0 * M_PI * cutoff / GEM_PITCH_SMOOTHING_RATE;
+    return r / (r + 1.0);
+}
+
+static double reference_step(struct ReferenceSmoother* smoother, double min_cutoff, double sensitivity, double input) {
+    if (!smoother->primed) {
+        smoother->primed = true;
+        smoother->last_input = input;
+        smoother->value = input;
+        smoother->rate = 0;
+        return input;
+    }
+
+    double rate_alpha = reference_alpha(fix16_to_dbl(GEM_PITCH_SMOOTHING_RATE_CUTOFF));
+    smoother->rate += rate_alpha * ((input - smoother->last_input) - smoother->rate);
+    smoother->last_input = input;
+
+    double cutoff = min_cutoff + sensitivity * fabs(smoother->rate) * GEM_PITCH_SMOOTHING_RATE;
+    cutoff = fmin(cutoff, GEM_PITCH_SMOOTHING_MAX_CUTOFF);
+    smoother->value += reference_alpha(cutoff) * (input - smoother->value);
+    return smoother->value;
+}
+
+TEST_CASE_BEGIN(first_step_passes_through)
+    struct GemPitchSmoothing smoothing;
+    GemPitchSmoothing_init(&smoothing, F16(1.0), F16(10.0));
+
+    struct GemPitchSmoother smoother;
+    GemPitchSmoother_reset(&smoother);
+    munit_assert_int32(GemPitchSmoother_step(&smoother, &smoothing, F16(3.25)), ==, F16(3.25));
+
+    // Same after a reset, even though the input moved a long way.
+    GemPitchSmoother_reset(&smoother);
+    munit_assert_int32(GemPitchSmoother_step(&smoother, &smoothing, F16(-0.5)), ==, F16(-0.5));
+TEST_CASE_END
+
+TEST_CASE_BEGIN(removes_jitter)
+    struct GemPitchSmoothing smoothing;
+    GemPitchSmoothing_init(&smoothing, F16(10.0), F16(10.0));
+
+    struct GemPitchSmoother smoother;
+    GemPitchSmoother_reset(&smoother);
+
+    // About ±3 cents of jitter around 2 V.
+    fix16_t jitter = F16(3 * CENT);
+    fix16_t max_error = 0;
+    for (int i = 0; i < GEM_PITCH_SMOOTHING_RATE; i++) {
+        fix16_t input = F16(2.0) + (i % 3 - 1) * jitter;
+        fix16_t output = GemPitchSmoother_step(&smoother, &smoothing, input);
+        if (i > GEM_PITCH_SMOOTHING_RATE / 2) {
+            max_error = fix16_max(max_error, fix16_abs(output - F16(2.0)));
+        }
+    }
+
+    munit_assert_int32(max_error, <, F16(0.5 * CENT));
+TEST_CASE_END
+
+TEST_CASE_BEGIN(steps_quickly)
+    struct GemPitchSmoothing adaptive;
+    GemPitchSmoothing_init(&adaptive, F16(10.0), F16(10.0));
+    struct GemPitchSmoothing fixed;
+    GemPitchSmoothing_init(&fixed, F16(10.0), F16(0.0));
+
+    struct GemPitchSmoother adaptive_smoother;
+    struct GemPitchSmoother fixed_smoother;
+    GemPitchSmoother_reset(&adaptive_smoother);
+    GemPitchSmoother_reset(&fixed_smoother);
+
+    for (int i = 0; i < 100; i++) {
+        GemPitchSmoother_step(&adaptive_smoother, &adaptive, F16(2.0));
+        GemPitchSmoother_step(&fixed_smoother, &fixed, F16(2.0));
+    }
+
+    // Jumping an octave, 10 ms later the adaptive filter has caught up but
+    // a plain low-pass filter with the same minimum cutoff hasn't.
+    fix16_t adaptive_output = 0;
+    fix16_t fixed_output = 0;
+    for (int i = 0; i < GEM_PITCH_SMOOTHING_RATE / 100; i++) {
+        adaptive_output = GemPitchSmoother_step(&adaptive_smoother, &adaptive, F16(3.0));
+        fixed_output = GemPitchSmoother_step(&fixed_smoother, &fixed, F16(3.0));
+    }
+
+    ASSERT_FIX16_CLOSE(adaptive_output, F16(3.0), CENT);
+    munit_assert_int32(fixed_output, <, F16(2.5));
+TEST_CASE_END
+
+TEST_CASE_BEGIN(matches_reference)
+    const double settings[][2] = {{10.0, 0.0}, {1.0, 10.0}, {10.0, 10.0}, {50.0, 40.0}};
+
+    for (size_t s = 0; s < sizeof(settings) / sizeof(settings[0]); s++) {
+        struct GemPitchSmoothing smoothing;
+        GemPitchSmoothing_init(&smoothing, fix16_from_dbl(settings[s][0]), fix16_from_dbl(settings[s][1]));
+
+        struct GemPitchSmoother smoother;
+        GemPitchSmoother_reset(&smoother);
+        struct ReferenceSmoother reference = {};
+
+        // A slow sine with steps and a little jitter on top.
+        for (int i = 0; i < GEM_PITCH_SMOOTHING_RATE; i++) {
+            fix16_t input = fix16_from_dbl(
+                2.0 + sin(i * 2.0 * M_PI / GEM_PITCH_SMOOTHING_RATE) + (i / 1000) * 0.25 + (i % 2) * 0.002);
+
+            fix16_t output = GemPitchSmoother_step(&smoother, &smoothing, input);
+            double expected = reference_step(&reference, settings[s][0], settings[s][1], fix16_to_dbl(input));
+
+            // The filter coefficients are rounded to fix16_t, so the output
+            // can move at a very slightly different speed.
+            ASSERT_FIX16_CLOSE(output, fix16_from_dbl(expected), 2 * CENT);
+        }
+    }
+TEST_CASE_END
+
+static MunitTest test_suite_tests[] = {
+    {.name = "first step passes through", .test = test_first_step_passes_through},
+    {.name = "removes jitter", .test = test_removes_jitter},
+    {.name = "steps quickly", .test = test_steps_quickly},
+    {.name = "matches reference", .test = test_matches_reference},
+    {.test = NULL},
+};
+
+MunitSuite test_pitch_smoothing_suite = {
+    .prefix = "pitch smoothing: ",
+    .tests = test_suite_tests,
+    .iterations = 1,
+};
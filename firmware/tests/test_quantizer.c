@@ -0,0 +1,126 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+/* Tests for src/gem_quantizer.c */
+
+#include "fix16.h"
+#include "gem_quantizer.h"
+#include "gem_test.h"
+#include <math.h>
+
+static struct GemQuantizer quantizer;
+
+/* Finds the nearest note in the scale the slow way. */
+static double nearest_note(uint16_t scale, double pitch) {
+    double nearest = 0;
+    double nearest_distance = INFINITY;
+    int octave = (int)floor(pitch);
+
+    for (int note = (octave - 1) * 12; note < (octave + 2) * 12; note++) {
+        if (!(scale & (1 << (((note % 12) + 12) % 12)))) {
+            continue;
+        }
+        double distance = fabs(note / 12.0 - pitch);
+        if (distance < nearest_distance) {
+            nearest = note / 12.0;
+            nearest_distance = distance;
+        }
+    }
+
+    return nearest;
+}
+
+TEST_CASE_BEGIN(chromatic)
+    GemQuantizer_init(&quantizer, GEM_QUANTIZER_CHROMATIC);
+
+    ASSERT_FIX16_CLOSE(GemQuantizer_quantize(&quantizer, F16(3.0)), F16(3.0), 0.0001);
+    ASSERT_FIX16_CLOSE(GemQuantizer_quantize(&quantizer, F16(3.0 + 0.4 / 12)), F16(3.0), 0.0001);
+    ASSERT_FIX16_CLOSE(GemQuantizer_quantize(&quantizer, F16(3.0 + 0.6 / 12)), F16(3.0 + 1.0 / 12), 0.0001);
+
+    // Just below the next octave rounds up to it.
+    ASSERT_FIX16_CLOSE(GemQuantizer_quantize(&quantizer, F16(3.99)), F16(4.0), 0.0001);
+
+    // An empty scale is the same as chromatic.
+    GemQuantizer_init(&quantizer, 0);
+    ASSERT_FIX16_CLOSE(GemQuantizer_quantize(&quantizer, F16(1.0 + 4.4 / 12)), F16(1.0 + 4.0 / 12), 0.0001);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(major)
+    GemQuantizer_init(&quantizer, GEM_QUANTIZER_MAJOR);
+
+    // C# is between C and D, so it rounds up like the chromatic quantizer.
+    ASSERT_FIX16_CLOSE(GemQuantizer_quantize(&quantizer, F16(2.0 + 0.9 / 12)), F16(2.0), 0.0001);
+    ASSERT_FIX16_CLOSE(GemQuantizer_quantize(&quantizer, F16(2.0 + 1.1 / 12)), F16(2.0 + 2.0 / 12), 0.0001);
+
+    // E & F are only a semitone apart.
+    ASSERT_FIX16_CLOSE(GemQuantizer_quantize(&quantizer, F16(2.0 + 4.4 / 12)), F16(2.0 + 4.0 / 12), 0.0001);
+    ASSERT_FIX16_CLOSE(GemQuantizer_quantize(&quantizer, F16(2.0 + 4.6 / 12)), F16(2.0 + 5.0 / 12), 0.0001);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(every_scale_matches_search)
+    // Compares the table against searching the scale for every possible
+    // scale, with pitches stepping across a few octaves including negative
+    // pitches. The pitches are never exactly halfway between two notes
+    // since the search and the table break ties differently.
+    for (uint16_t scale = 1; scale <= GEM_QUANTIZER_CHROMATIC; scale++) {
+        GemQuantizer_init(&quantizer, scale);
+
+        for (int i = 0; i < 120; i++) {
+            double semitones = i * 0.3 + 0.05;
+            fix16_t pitch = fix16_from_dbl(-1.0 + semitones / 12);
+            double expected = nearest_note(scale, fix16_to_dbl(pitch));
+            ASSERT_FIX16_CLOSE(GemQuantizer_quantize(&quantizer, pitch), fix16_from_dbl(expected), 0.0001);
+        }
+    }
+TEST_CASE_END
+
+TEST_CASE_BEGIN(hysteresis)
+    GemQuantizer_init(&quantizer, GEM_QUANTIZER_CHROMATIC);
+
+    fix16_t hysteresis = F16(0.2 / 12);
+    fix16_t previous = F16(3.0);
+
+    // Scenario:
+    // - Pitch wiggles just above and below the halfway point between C & C#.
+    //
+    // It should stay on C the whole time.
+    fix16_t wiggles[] = {F16(3.0 + 0.45 / 12), F16(3.0 + 0.55 / 12), F16(3.0 + 0.65 / 12), F16(3.0 + 0.5 / 12)};
+    for (size_t i = 0; i < sizeof(wiggles) / sizeof(wiggles[0]); i++) {
+        previous = GemQuantizer_quantize_hysteresis(&quantizer, wiggles[i], previous, hysteresis);
+        ASSERT_FIX16_CLOSE(previous, F16(3.0), 0.0001);
+    }
+
+    // Scenario:
+    // - Pitch moves clearly past the halfway point.
+    //
+    // It should move to C#, and then stay there when the pitch comes back
+    // a little.
+    previous = GemQuantizer_quantize_hysteresis(&quantizer, F16(3.0 + 0.75 / 12), previous, hysteresis);
+    ASSERT_FIX16_CLOSE(previous, F16(3.0 + 1.0 / 12), 0.0001);
+    previous = GemQuantizer_quantize_hysteresis(&quantizer, F16(3.0 + 0.4 / 12), previous, hysteresis);
+    ASSERT_FIX16_CLOSE(previous, F16(3.0 + 1.0 / 12), 0.0001);
+
+    // Scenario:
+    // - Pitch jumps far away.
+    //
+    // Hysteresis doesn't matter, it goes straight to the nearest note.
+    previous = GemQuantizer_quantize_hysteresis(&quantizer, F16(5.0 + 6.9 / 12), previous, hysteresis);
+    ASSERT_FIX16_CLOSE(previous, F16(5.0 + 7.0 / 12), 0.0001);
+TEST_CASE_END
+
+static MunitTest test_suite_tests[] = {
+    {.name = "chromatic", .test = test_chromatic},
+    {.name = "major", .test = test_major},
+    {.name = "every scale matches search", .test = test_every_scale_matches_search},
+    {.name = "hysteresis", .test = test_hysteresis},
+    {.test = NULL},
+};
+
+MunitSuite test_quantizer_suite = {
+    .prefix = "quantizer: ",
+    .tests = test_suite_tests,
+    .iterations = 1,
+};
@@ -0,0 +1,131 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+/* Tests for src/gem_ramp_table_transfer.c */
+
+#include "gem_ramp_table_transfer.h"
+#include "gem_test.h"
+#include "teeth.h"
+#include <string.h>
+
+#define TABLE_LEN 20
+
+static struct GemRampTableEntry source[TABLE_LEN];
+static struct GemRampTableEntry dest[TABLE_LEN];
+
+static void fill_tables() {
+    for (size_t i = 0; i < TABLE_LEN; i++) {
+        source[i] = (struct GemRampTableEntry){.castor_ramp_cv = 100 + i * 37, .pollux_ramp_cv = 4000 - i * 41};
+        dest[i] = (struct GemRampTableEntry){};
+    }
+}
+
+TEST_CASE_BEGIN(known_chunk)
+    const struct GemRampTableEntry table[] = {
+        {.castor_ramp_cv = 0x0123, .pollux_ramp_cv = 0x0456},
+        {.castor_ramp_cv = 0x0789, .pollux_ramp_cv = 0x0ABC},
+    };
+    uint8_t buf[GEM_RAMP_TABLE_CHUNK_MAX_SIZE];
+
+    // The CRC must match zlib.crc32() so that libgemini can check it.
+    size_t len = gem_ramp_table_pack_chunk(table, 2, 0, 2, buf);
+    const uint8_t expected[] = {0x00, 0x02, 0x01, 0x23, 0x04, 0x56, 0x07, 0x89, 0x0A, 0xBC, 0x98, 0x4A, 0x14, 0x89};
+
+    munit_assert_size(len, ==, sizeof(expected));
+    munit_assert_memory_equal(sizeof(expected), buf, expected);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(round_trip)
+    fill_tables();
+
+    // Send the whole table a chunk at a time, through teeth encoding just like
+    // it would be over SysEx.
+    for (uint8_t start = 0; start < TABLE_LEN; start += GEM_RAMP_TABLE_CHUNK_MAX_ENTRIES) {
+        uint8_t chunk[GEM_RAMP_TABLE_CHUNK_MAX_SIZE];
+        uint8_t encoded[TEETH_ENCODED_LENGTH(GEM_RAMP_TABLE_CHUNK_MAX_SIZE)];
+        uint8_t decoded[TEETH_DECODED_LENGTH(TEETH_ENCODED_LENGTH(GEM_RAMP_TABLE_CHUNK_MAX_SIZE))];
+
+        size_t chunk_len =
+            gem_ramp_table_pack_chunk(source, TABLE_LEN, start, GEM_RAMP_TABLE_CHUNK_MAX_ENTRIES, chunk);
+        teeth_encode(chunk, chunk_len, encoded);
+        size_t decoded_len = teeth_decode(encoded, TEETH_ENCODED_LENGTH(chunk_len), decoded);
+
+        munit_assert_size(decoded_len, ==, chunk_len);
+        munit_assert_int(
+            gem_ramp_table_unpack_chunk(dest, TABLE_LEN, decoded, decoded_len), ==, GEM_RAMP_TABLE_CHUNK_OK);
+    }
+
+    munit_assert_memory_equal(sizeof(source), dest, source);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(pack_limits_count)
+    fill_tables();
+    uint8_t buf[GEM_RAMP_TABLE_CHUNK_MAX_SIZE];
+
+    // Asking for more than is left in the table only returns what's there.
+    size_t len = gem_ramp_table_pack_chunk(source, TABLE_LEN, TABLE_LEN - 3, 10, buf);
+    munit_assert_uint8(buf[1], ==, 3);
+    munit_assert_size(len, ==, GEM_RAMP_TABLE_CHUNK_SIZE(3));
+
+    // Same for more than fits in a chunk.
+    len = gem_ramp_table_pack_chunk(source, TABLE_LEN, 0, 255, buf);
+    munit_assert_uint8(buf[1], ==, GEM_RAMP_TABLE_CHUNK_MAX_ENTRIES);
+
+    // Reading past the end gives an empty chunk.
+    len = gem_ramp_table_pack_chunk(source, TABLE_LEN, TABLE_LEN, 4, buf);
+    munit_assert_uint8(buf[1], ==, 0);
+    munit_assert_size(len, ==, GEM_RAMP_TABLE_CHUNK_SIZE(0));
+TEST_CASE_END
+
+TEST_CASE_BEGIN(rejects_bad_crc)
+    fill_tables();
+    uint8_t buf[GEM_RAMP_TABLE_CHUNK_MAX_SIZE];
+    size_t len = gem_ramp_table_pack_chunk(source, TABLE_LEN, 0, 4, buf);
+
+    buf[5] ^= 0x10;
+
+    munit_assert_int(gem_ramp_table_unpack_chunk(dest, TABLE_LEN, buf, len), ==, GEM_RAMP_TABLE_CHUNK_ERR_CRC);
+
+    // The table must not be touched.
+    const struct GemRampTableEntry empty[TABLE_LEN] = {};
+    munit_assert_memory_equal(sizeof(dest), dest, empty);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(rejects_bad_length)
+    fill_tables();
+    uint8_t buf[GEM_RAMP_TABLE_CHUNK_MAX_SIZE];
+    size_t len = gem_ramp_table_pack_chunk(source, TABLE_LEN, 0, 4, buf);
+
+    munit_assert_int(gem_ramp_table_unpack_chunk(dest, TABLE_LEN, buf, len - 1), ==, GEM_RAMP_TABLE_CHUNK_ERR_LENGTH);
+    munit_assert_int(gem_ramp_table_unpack_chunk(dest, TABLE_LEN, buf, 3), ==, GEM_RAMP_TABLE_CHUNK_ERR_LENGTH);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(rejects_out_of_range)
+    fill_tables();
+    uint8_t buf[GEM_RAMP_TABLE_CHUNK_MAX_SIZE];
+
+    // A valid chunk for a bigger table.
+    size_t len = gem_ramp_table_pack_chunk(source, TABLE_LEN, TABLE_LEN - 4, 4, buf);
+
+    munit_assert_int(
+        gem_ramp_table_unpack_chunk(dest, TABLE_LEN - 2, buf, len), ==, GEM_RAMP_TABLE_CHUNK_ERR_RANGE);
+TEST_CASE_END
+
+static MunitTest test_suite_tests[] = {
+    {.name = "known chunk", .test = test_known_chunk},
+    {.name = "round trip", .test = test_round_trip},
+    {.name = "pack limits count", .test = test_pack_limits_count},
+    {.name = "rejects bad crc", .test = test_rejects_bad_crc},
+    {.name = "rejects bad length", .test = test_rejects_bad_length},
+    {.name = "rejects out of range", .test = test_rejects_out_of_range},
+    {.test = NULL},
+};
+
+MunitSuite test_ramp_table_transfer_suite = {
+    .prefix = "ramp table transfer: ",
+    .tests = test_suite_tests,
+    .iterations = 1,
+};
@@ -0,0 +1,83 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+/* Tests for src/lib/gem_sample_stats.c */
+
+#include "gem_sample_stats.h"
+#include "gem_test.h"
+
+TEST_CASE_BEGIN(constant_samples)
+    struct GemSampleStats stats;
+    GemSampleStats_init(&stats);
+    for (size_t i = 0; i < 64; i++) { GemSampleStats_add(&stats, 2048); }
+
+    munit_assert_int32(GemSampleStats_mean(&stats), ==, F16(2048));
+    munit_assert_int32(GemSampleStats_variance(&stats), ==, 0);
+    munit_assert_uint16(stats.min, ==, 2048);
+    munit_assert_uint16(stats.max, ==, 2048);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(mean_and_variance)
+    struct GemSampleStats stats;
+    GemSampleStats_init(&stats);
+
+    // Mean is 5, population variance is 4.
+    const uint16_t samples[] = {2, 4, 4, 4, 5, 5, 7, 9};
+    for (size_t i = 0; i < ARRAY_LEN(samples); i++) { GemSampleStats_add(&stats, samples[i]); }
+
+    munit_assert_int32(GemSampleStats_mean(&stats), ==, F16(5));
+    munit_assert_int32(GemSampleStats_variance(&stats), ==, F16(4));
+    munit_assert_uint16(stats.min, ==, 2);
+    munit_assert_uint16(stats.max, ==, 9);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(fractional_mean)
+    struct GemSampleStats stats;
+    GemSampleStats_init(&stats);
+    GemSampleStats_add(&stats, 1000);
+    GemSampleStats_add(&stats, 1001);
+
+    munit_assert_int32(GemSampleStats_mean(&stats), ==, F16(1000.5));
+    munit_assert_int32(GemSampleStats_variance(&stats), ==, F16(0.25));
+TEST_CASE_END
+
+TEST_CASE_BEGIN(max_sample_count)
+    struct GemSampleStats stats;
+    GemSampleStats_init(&stats);
+
+    // The worst case for 12-bit readings: half at each end of the range.
+    for (size_t i = 0; i < GEM_SAMPLE_STATS_MAX_COUNT; i++) { GemSampleStats_add(&stats, i % 2 ? 4095 : 0); }
+
+    munit_assert_int32(GemSampleStats_mean(&stats), ==, F16(2047.5));
+    munit_assert_uint16(stats.min, ==, 0);
+    munit_assert_uint16(stats.max, ==, 4095);
+
+    // The variance (2047.5²) doesn't fit in a fix16, so it saturates.
+    munit_assert_int32(GemSampleStats_variance(&stats), ==, fix16_maximum);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(no_samples)
+    struct GemSampleStats stats;
+    GemSampleStats_init(&stats);
+
+    munit_assert_int32(GemSampleStats_mean(&stats), ==, 0);
+    munit_assert_int32(GemSampleStats_variance(&stats), ==, 0);
+TEST_CASE_END
+
+static MunitTest test_suite_tests[] = {
+    {.name = "constant", .test = test_constant_samples},
+    {.name = "mean and variance", .test = test_mean_and_variance},
+    {.name = "fractional mean", .test = test_fractional_mean},
+    {.name = "max count", .test = test_max_sample_count},
+    {.name = "no samples", .test = test_no_samples},
+    {.test = NULL},
+};
+
+MunitSuite test_sample_stats_suite = {
+    .prefix = "sample stats: ",
+    .tests = test_suite_tests,
+    .iterations = 1,
+};
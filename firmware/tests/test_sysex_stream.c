@@ -0,0 +1,229 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+/* Tests for third_party/libwinter/wntr_sysex_stream.c */
+
+#include "gem_test.h"
+#include "teeth.h"
+#include "wntr_midi_core.h"
+#include "wntr_sysex_stream.h"
+#include <string.h>
+
+#define MAX_DATA_LEN 200
+#define MAX_MESSAGE_LEN (2 + 2 + TEETH_ENCODED_LENGTH(MAX_DATA_LEN))
+
+/* Fake USB-MIDI endpoint that reassembles the message from the packets. */
+
+static uint8_t received[MAX_MESSAGE_LEN];
+static size_t received_len;
+static size_t packet_count;
+static bool message_ended;
+
+static bool write_packet(const uint8_t packet[4]) {
+    uint8_t code_index = packet[0] & 0xF;
+    size_t count = 3;
+
+    munit_assert_false(message_ended);
+    packet_count++;
+
+    if (code_index == MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE) {
+        // Only the start and end bytes are allowed to have the high bit set.
+        for (size_t i = 1; i < 4; i++) {
+            if (received_len + i == 1) {
+                munit_assert_uint8(packet[i], ==, 0xF0);
+            } else {
+                munit_assert_uint8(packet[i], <, 0x80);
+            }
+        }
+    } else {
+        munit_assert_uint8(code_index, >=, MIDI_CODE_INDEX_SYSEX_END_ONE_BYTE);
+        munit_assert_uint8(code_index, <=, MIDI_CODE_INDEX_SYSEX_END_THREE_BYTE);
+        count = code_index - MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE;
+        munit_assert_uint8(packet[count], ==, 0xF7);
+        // Unused bytes must be zero.
+        for (size_t i = count + 1; i < 4; i++) { munit_assert_uint8(packet[i], ==, 0); }
+        message_ended = true;
+    }
+
+    munit_assert_size(received_len + count, <=, sizeof(received));
+    memcpy(received + received_len, packet + 1, count);
+    received_len += count;
+    return true;
+}
+
+static void reset_endpoint() {
+    received_len = 0;
+    packet_count = 0;
+    message_ended = false;
+}
+
+TEST_CASE_BEGIN(raw_message)
+    const uint8_t payload[] = {0x77, 0x01, 0x02, 0x03, 0x04};
+
+    // Framing shifts the data by one, so try every remainder.
+    for (size_t len = 0; len <= sizeof(payload); len++) {
+        reset_endpoint();
+
+        struct WntrSysExStream stream;
+        WntrSysExStream_start(&stream, write_packet);
+        WntrSysExStream_write(&stream, payload, len);
+        WntrSysExStream_end(&stream);
+
+        munit_assert_true(message_ended);
+        munit_assert_size(received_len, ==, len + 2);
+        munit_assert_uint8(received[0], ==, 0xF0);
+        munit_assert_memory_equal(len, received + 1, payload);
+        munit_assert_size(packet_count, ==, (len + 2 + 2) / 3);
+    }
+TEST_CASE_END
+
+TEST_CASE_BEGIN(encode_group_matches_teeth_encode)
+    uint8_t src[4];
+    uint8_t expected[5];
+    uint8_t actual[5];
+
+    for (size_t n = 0; n < 10000; n++) {
+        munit_rand_memory(sizeof(src), src);
+        size_t len = 1 + munit_rand_int_range(0, 3);
+
+        teeth_encode(src, len, expected);
+        teeth_encode_group(src, len, actual);
+
+        munit_assert_memory_equal(5, actual, expected);
+    }
+TEST_CASE_END
+
+TEST_CASE_BEGIN(teeth_round_trip_fuzz)
+    const uint8_t header[2] = {0x77, 0x10};
+    uint8_t payload[MAX_DATA_LEN];
+    uint8_t expected_encoded[TEETH_ENCODED_LENGTH(MAX_DATA_LEN)];
+    uint8_t decoded[TEETH_DECODED_LENGTH(TEETH_ENCODED_LENGTH(MAX_DATA_LEN))];
+
+    for (size_t n = 0; n < 2000; n++) {
+        size_t len = munit_rand_int_range(0, MAX_DATA_LEN);
+        munit_rand_memory(len, payload);
+        reset_endpoint();
+
+        struct WntrSysExStream stream;
+        WntrSysExStream_start(&stream, write_packet);
+        WntrSysExStream_write(&stream, header, 2);
+        WntrSysExStream_write_teeth(&stream, payload, len);
+        WntrSysExStream_end(&stream);
+
+        size_t encoded_len = TEETH_ENCODED_LENGTH(len);
+        munit_assert_true(message_ended);
+        munit_assert_size(received_len, ==, 1 + 2 + encoded_len + 1);
+        munit_assert_memory_equal(2, received + 1, header);
+
+        // The stream must produce exactly what teeth_encode() does, so the
+        // host's decoder doesn't need to change.
+        teeth_encode(payload, len, expected_encoded);
+        munit_assert_memory_equal(encoded_len, received + 3, expected_encoded);
+
+        size_t decoded_len = teeth_decode(received + 3, encoded_len, decoded);
+        munit_assert_size(decoded_len, ==, len);
+        munit_assert_memory_equal(len, decoded, payload);
+    }
+TEST_CASE_END
+
+TEST_CASE_BEGIN(teeth_valid)
+    uint8_t payload[13];
+    uint8_t encoded[TEETH_ENCODED_LENGTH(13)];
+    munit_rand_memory(sizeof(payload), payload);
+    teeth_encode(payload, sizeof(payload), encoded);
+
+    munit_assert_true(teeth_valid(encoded, sizeof(encoded)));
+    munit_assert_true(teeth_valid(encoded, 0));
+
+    // Partial groups.
+    munit_assert_false(teeth_valid(encoded, sizeof(encoded) - 1));
+    munit_assert_false(teeth_valid(encoded, 3));
+
+    // Headers claiming more than 4 bytes.
+    encoded[5] = (encoded[5] & 0xF) | 0x50;
+    munit_assert_false(teeth_valid(encoded, sizeof(encoded)));
+    encoded[5] = (encoded[5] & 0xF) | 0x70;
+    munit_assert_false(teeth_valid(encoded, sizeof(encoded)));
+TEST_CASE_END
+
+#ifdef GEM_TEST_BENCHMARKS
+
+/*
+    These don't check anything, compare the run times of the two benchmarks
+    to see how much faster streaming is than the buffered path. They're only
+    built with `python3 configure.py --benchmarks`.
+*/
+
+#define BENCHMARK_ITERATIONS 20000
+
+static bool count_packet(const uint8_t packet[4]) {
+    (void)packet;
+    packet_count++;
+    return true;
+}
+
+/*
+    The way responses were sent before streaming: teeth encode into a buffer,
+    then split the buffer into packets.
+*/
+static void send_buffered(const uint8_t* header, const uint8_t* data, size_t len) {
+    uint8_t message[MAX_MESSAGE_LEN];
+    size_t message_len = 2 + TEETH_ENCODED_LENGTH(len);
+    message[0] = header[0];
+    message[1] = header[1];
+    teeth_encode(data, len, message + 2);
+
+    struct WntrSysExStream stream;
+    WntrSysExStream_start(&stream, count_packet);
+    WntrSysExStream_write(&stream, message, message_len);
+    WntrSysExStream_end(&stream);
+}
+
+TEST_CASE_BEGIN(benchmark_buffered)
+    const uint8_t header[2] = {0x77, 0x10};
+    uint8_t payload[64];
+    munit_rand_memory(sizeof(payload), payload);
+
+    packet_count = 0;
+    for (size_t n = 0; n < BENCHMARK_ITERATIONS; n++) { send_buffered(header, payload, sizeof(payload)); }
+    munit_assert_size(packet_count, >, 0);
+TEST_CASE_END
+
+TEST_CASE_BEGIN(benchmark_streamed)
+    const uint8_t header[2] = {0x77, 0x10};
+    uint8_t payload[64];
+    munit_rand_memory(sizeof(payload), payload);
+
+    packet_count = 0;
+    for (size_t n = 0; n < BENCHMARK_ITERATIONS; n++) {
+        struct WntrSysExStream stream;
+        WntrSysExStream_start(&stream, count_packet);
+        WntrSysExStream_write(&stream, header, 2);
+        WntrSysExStream_write_teeth(&stream, payload, sizeof(payload));
+        WntrSysExStream_end(&stream);
+    }
+    munit_assert_size(packet_count, >, 0);
+TEST_CASE_END
+
+#endif
+
+static MunitTest test_suite_tests[] = {
+    {.name = "raw message", .test = test_raw_message},
+    {.name = "encode group matches teeth_encode", .test = test_encode_group_matches_teeth_encode},
+    {.name = "teeth round trip fuzz", .test = test_teeth_round_trip_fuzz},
+    {.name = "teeth valid", .test = test_teeth_valid},
+#ifdef GEM_TEST_BENCHMARKS
+    {.name = "benchmark buffered", .test = test_benchmark_buffered},
+    {.name = "benchmark streamed", .test = test_benchmark_streamed},
+#endif
+    {.test = NULL},
+};
+
+MunitSuite test_sysex_stream_suite = {
+    .prefix = "sysex stream: ",
+    .tests = test_suite_tests,
+    .iterations = 1,
+};
@@ -8,11 +8,6 @@
 #include "assert.h"
 #include "sam.h"
 
-#ifndef WNTR_MTB_SIZE
-/* The number of entries the MTB packet buffer can hold at a time. */
-#define WNTR_MTB_SIZE 128
-#endif
-
 /* The length, in bytes, of the MTB packet buffer. */
 #define MTB_LENGTH (WNTR_MTB_SIZE * sizeof(uint32_t))
 
@@ -65,6 +60,9 @@ __attribute__((__aligned__(WNTR_MTB_SIZE * sizeof(uint32_t)))) uint32_t mtb[WNTR
 void wntr_mtb_init() {}
 void wntr_mtb_enable() {}
 void wntr_mtb_disable() {}
+void wntr_mtb_capture_start() {}
+size_t wntr_mtb_capture_stop() { return 0; }
+const uint32_t* wntr_mtb_buffer() { return NULL; }
 
 #else
 
@@ -142,4 +140,32 @@ void wntr_mtb_disable() { MTB->MASTER.bit.EN = 0; }
 
 void wntr_mtb_enable() { MTB->MASTER.bit.EN = 1; }
 
+void wntr_mtb_capture_start() {
+    MTB->MASTER.bit.EN = 0;
+
+    /*
+        Start at the beginning of the buffer and set the watermark to the last
+        packet in the buffer. With AUTOSTOP set, the MTB clears MASTER.EN once
+        POSITION reaches the watermark instead of wrapping around and
+        overwriting the start of the capture.
+    */
+    uint32_t mtb_offset_addr = (uint32_t)(mtb)-MTB->BASE.reg;
+    MTB->POSITION.reg = mtb_offset_addr & 0xFFFFFFF8;
+    MTB->FLOW.reg = ((mtb_offset_addr + MTB_LENGTH - 8) & 0xFFFFFFF8) | MTB_FLOW_AUTOSTOP;
+
+    uint32_t mask = __builtin_ctz(MTB_LENGTH) - 4;
+    MTB->MASTER.bit.MASK = mask;
+    MTB->MASTER.bit.EN = 1;
+}
+
+size_t wntr_mtb_capture_stop() {
+    MTB->MASTER.bit.EN = 0;
+
+    uint32_t mtb_offset_addr = (uint32_t)(mtb)-MTB->BASE.reg;
+    uint32_t position = MTB->POSITION.reg & MTB_POSITION_POINTER_Msk;
+    return ((position - mtb_offset_addr) & (MTB_LENGTH - 1)) / 8;
+}
+
+const uint32_t* wntr_mtb_buffer() { return mtb; }
+
 #endif
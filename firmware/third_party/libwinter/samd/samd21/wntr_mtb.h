@@ -23,6 +23,14 @@
     * https://github.com/adafruit/gdb-micro-trace-buffer
 */
 
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef WNTR_MTB_SIZE
+/* The number of 32-bit words the MTB packet buffer can hold. Each packet is two words. */
+#define WNTR_MTB_SIZE 128
+#endif
+
 /*
     Initializes the Micro Trace Buffer and enables it.
 */
@@ -35,3 +43,23 @@ void wntr_mtb_init();
 */
 void wntr_mtb_disable();
 void wntr_mtb_enable();
+
+/*
+    Starts a one-shot capture. Unlike wntr_mtb_init(), the MTB starts at the
+    beginning of the buffer and stops once it's full instead of wrapping
+    around, so the buffer holds the first packets after this call in order.
+*/
+void wntr_mtb_capture_start();
+
+/*
+    Stops tracing and returns the number of packets captured since
+    wntr_mtb_capture_start(). Returns 0 if the MTB is disabled.
+
+    The MTB stays stopped so the capture can be read, call wntr_mtb_init()
+    afterwards to go back to continuous tracing. Otherwise there's no trace
+    for wntr_assert or the hardfault handler to show.
+*/
+size_t wntr_mtb_capture_stop();
+
+/* The MTB packet buffer. Each packet is a source address followed by a destination address. */
+const uint32_t* wntr_mtb_buffer();
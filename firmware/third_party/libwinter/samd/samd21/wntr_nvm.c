@@ -5,18 +5,18 @@
 */
 
 #include "wntr_nvm.h"
+#include "assert.h"
 #include "sam.h"
 
 #define NVM_MEMORY ((volatile uint16_t*)FLASH_ADDR)
 
-/* Private forward declarations. */
-
-static void erase_row(uint32_t addr);
-static void write_page(uint32_t dst, uint8_t* buf, size_t len);
+static_assert(WNTR_NVM_PAGE_SIZE == NVMCTRL_PAGE_SIZE, "WNTR_NVM_PAGE_SIZE must match the device.");
+static_assert(WNTR_NVM_ROW_SIZE == NVMCTRL_PAGE_SIZE * NVMCTRL_ROW_PAGES, "WNTR_NVM_ROW_SIZE must match the device.");
 
 /* Public functions. */
 
-/* These routines are largely adapted from ASF4's hal_nvmctrl.c. */
+/* These routines are largely adapted from ASF4's hal_nvmctrl.c. wntr_nvm_write()
+   is implemented on top of these in wntr_nvm_write.c. */
 
 void wntr_nvm_read(uint32_t src, uint8_t* buf, size_t len) {
     uint32_t nvm_address = src / 2;
@@ -50,49 +50,7 @@ void wntr_nvm_read(uint32_t src, uint8_t* buf, size_t len) {
     }
 }
 
-void wntr_nvm_write(uint32_t dst, const uint8_t* buf, size_t len) {
-    uint8_t tmp_buffer[NVMCTRL_ROW_PAGES][NVMCTRL_PAGE_SIZE];
-    uint32_t row_start_addr, row_end_addr;
-    uint32_t i, j, k;
-    uint32_t wr_start_addr = dst;
-
-    do {
-        row_start_addr = wr_start_addr & ~((NVMCTRL_PAGE_SIZE * NVMCTRL_ROW_PAGES) - 1);
-        row_end_addr = row_start_addr + NVMCTRL_ROW_PAGES * NVMCTRL_PAGE_SIZE - 1;
-
-        /* store the erase data into temp buffer before write */
-        for (i = 0; i < NVMCTRL_ROW_PAGES; i++) {
-            wntr_nvm_read(row_start_addr + i * NVMCTRL_PAGE_SIZE, tmp_buffer[i], NVMCTRL_PAGE_SIZE);
-        }
-
-        /* temp buffer update */
-        j = (wr_start_addr - row_start_addr) / NVMCTRL_PAGE_SIZE;
-        k = wr_start_addr - row_start_addr - j * NVMCTRL_PAGE_SIZE;
-        while ((wr_start_addr <= row_end_addr) && (len > 0)) {
-            tmp_buffer[j][k] = *buf;
-            k = (k + 1) % NVMCTRL_PAGE_SIZE;
-            if (0 == k) {
-                j++;
-            }
-            wr_start_addr++;
-            buf++;
-            len--;
-        }
-
-        /* erase row before write */
-        erase_row(row_start_addr);
-
-        /* write buffer to flash */
-        for (i = 0; i < NVMCTRL_ROW_PAGES; i++) {
-            write_page(row_start_addr + i * NVMCTRL_PAGE_SIZE, tmp_buffer[i], NVMCTRL_PAGE_SIZE);
-        }
-
-    } while (row_end_addr < (wr_start_addr + len - 1));
-}
-
-/* Private functions. */
-
-static void erase_row(uint32_t addr) {
+void wntr_nvm_erase_row(uint32_t addr) {
     /* Wait until the NVM is free. */
     while (!NVMCTRL->INTFLAG.bit.READY) {};
 
@@ -104,7 +62,7 @@ static void erase_row(uint32_t addr) {
     NVMCTRL->CTRLA.reg = NVMCTRL_CTRLA_CMD_ER | NVMCTRL_CTRLA_CMDEX_KEY;
 }
 
-static void write_page(uint32_t dst, uint8_t* buf, size_t len) {
+void wntr_nvm_write_page(uint32_t dst, const uint8_t* buf, size_t len) {
     uint32_t nvm_address = dst / 2;
     uint16_t i, data;
 
@@ -120,8 +78,11 @@ static void write_page(uint32_t dst, uint8_t* buf, size_t len) {
 
     for (i = 0; i < len; i += 2) {
         data = buf[i];
-        if (i < NVMCTRL_PAGE_SIZE - 1) {
+        /* Bits left as 1 aren't programmed, so pad a trailing odd byte with 0xFF. */
+        if (i < len - 1) {
             data |= (buf[i + 1] << 8);
+        } else {
+            data |= 0xFF00;
         }
         NVM_MEMORY[nvm_address++] = data;  // NOLINT(clang-analyzer-core.NullDereference)
     }
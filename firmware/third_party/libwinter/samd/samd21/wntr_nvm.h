@@ -11,6 +11,26 @@
 #include <stddef.h>
 #include <stdint.h>
 
+/* The smallest unit of flash that can be written. */
+#define WNTR_NVM_PAGE_SIZE 64
+/* The smallest unit of flash that can be erased. */
+#define WNTR_NVM_ROW_SIZE (WNTR_NVM_PAGE_SIZE * 4)
+
 void wntr_nvm_read(uint32_t src, uint8_t* buf, size_t len);
 
+/*
+    Writes any number of bytes to any address. Rows that wouldn't change are
+    skipped and rows where bits only need to go from 1 to 0 are programmed
+    without an erase. Otherwise, the row is read, erased, and re-written.
+*/
 void wntr_nvm_write(uint32_t dst, const uint8_t* buf, size_t len);
+
+/* Erases the row starting at `addr`, setting every byte to 0xFF. */
+void wntr_nvm_erase_row(uint32_t addr);
+
+/*
+    Writes up to a page of data starting at the page-aligned address `dst`
+    without erasing it first. Programming can only clear bits, so the page
+    should normally be erased.
+*/
+void wntr_nvm_write_page(uint32_t dst, const uint8_t* buf, size_t len);
@@ -62,6 +62,48 @@ size_t teeth_encode(const uint8_t* src, size_t src_len, uint8_t* dst) {
     return dst_idx + 1;
 }
 
+void teeth_encode_group(const uint8_t* src, size_t src_len, uint8_t dst[5]) {
+    // Load the group as a little-endian word so that all four bytes can be
+    // handled at once instead of one at a time.
+    uint32_t word = src[0];
+    if (src_len > 1) {
+        word |= (uint32_t)(src[1]) << 8;
+    }
+    if (src_len > 2) {
+        word |= (uint32_t)(src[2]) << 16;
+    }
+    if (src_len > 3) {
+        word |= (uint32_t)(src[3]) << 24;
+    }
+
+    // Gather each byte's high bit into the header's lower nibble. After
+    // masking, byte n's high bit is at bit 8n and multiplying by this
+    // constant moves it to bit 27 - n. None of the shifted copies overlap so
+    // nothing carries into the result.
+    uint32_t high_bits = (word >> 7) & 0x01010101;
+    dst[0] = (uint8_t)(src_len << 4) | (uint8_t)(((high_bits * 0x08040201) >> 24) & 0xF);
+
+    word &= 0x7F7F7F7F;
+    dst[1] = word & 0xFF;
+    dst[2] = (word >> 8) & 0xFF;
+    dst[3] = (word >> 16) & 0xFF;
+    dst[4] = word >> 24;
+}
+
+bool teeth_valid(const uint8_t* src, size_t src_len) {
+    if (src_len % 5 != 0) {
+        return false;
+    }
+
+    for (size_t src_idx = 0; src_idx < src_len; src_idx += 5) {
+        if (src[src_idx] >> 4 > 4) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 size_t teeth_decode(const uint8_t* src, size_t src_len, uint8_t* dst) {
     // assert(src_len % 5 == 0);
     size_t src_idx = 0;
@@ -46,6 +46,7 @@ one more byte than usual to encode so it's an *overbyte*...
 
 */
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -53,4 +54,19 @@ one more byte than usual to encode so it's an *overbyte*...
 #define TEETH_DECODED_LENGTH(src_len) (src_len / 5 * 4)
 
 size_t teeth_encode(const uint8_t* src, size_t src_len, uint8_t* dst);
+
+/*
+    Encodes a single group of up to 4 bytes into 5 bytes. This is used to
+    encode data as it's streamed out, see wntr_sysex_stream.h. Unused bytes
+    in the group are set to 0, same as teeth_encode().
+*/
+void teeth_encode_group(const uint8_t* src, size_t src_len, uint8_t dst[5]);
 size_t teeth_decode(const uint8_t* src, size_t src_len, uint8_t* dst);
+
+/*
+    Checks that untrusted data is whole 5 byte groups whose headers claim at
+    most 4 bytes each. teeth_decode() trusts the headers, so only data that
+    passes this is guaranteed to decode into TEETH_DECODED_LENGTH(src_len)
+    bytes.
+*/
+bool teeth_valid(const uint8_t* src, size_t src_len);
@@ -7,29 +7,31 @@
 #include "wntr_midi_core.h"
 #include "class/midi/midi_device.h"
 #include "printf.h"
+#include "teeth.h"
 #include "tusb.h"
-#include "wntr_ticks.h"
+#include "wntr_midi_tx.h"
+#include "wntr_sysex_stream.h"
 #include <stdbool.h>
 #include <stdint.h>
 
 /* Macros & definitions */
 
 #define SYSEX_BUF_SIZE 128
-#define SYSEX_TIMEOUT 100 /* Milliseconds */
 #define SYSEX_START_BYTE 0xF0
-#define SYSEX_END_BYTE 0xF7
 
 /* Static variables */
 
 static uint8_t sysex_data_[SYSEX_BUF_SIZE];
 static size_t sysex_data_len_;
+static size_t sysex_index_;
+static bool sysex_in_progress_;
+static bool sysex_overflow_;
+static struct WntrMIDIRxStats rx_stats_;
 
 /* Private forward declarations. */
 
 static bool midi_read(struct WntrMIDIMessage* msg);
-static void consume_sysex();
-static bool sysex_iterator_next(const uint8_t* data, size_t len, size_t* head, uint8_t* dst);
-static size_t sysex_iterator_remaining(size_t len, size_t head);
+static bool receive_sysex_(struct WntrMIDIMessage* msg);
 
 /* Public functions. */
 
@@ -38,64 +40,74 @@ bool wntr_midi_receive(struct WntrMIDIMessage* msg) {
         return false;
     }
 
-    if (msg->code_index == MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE) {
-        consume_sysex(msg);
-        msg->code_index = MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE;
-        msg->status = 0;
-        msg->data_0 = 0;
-        msg->data_1 = 0;
-    }
+    rx_stats_.packets++;
 
-    return true;
+    switch (msg->code_index) {
+        case MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE:
+            return receive_sysex_(msg);
+
+        /* The one byte end code index is also used for single byte system common messages. */
+        case MIDI_CODE_INDEX_SYSEX_END_ONE_BYTE:
+        case MIDI_CODE_INDEX_SYSEX_END_TWO_BYTE:
+        case MIDI_CODE_INDEX_SYSEX_END_THREE_BYTE:
+            if (sysex_in_progress_ || msg->status == SYSEX_START_BYTE) {
+                return receive_sysex_(msg);
+            }
+            return true;
+
+        default:
+            return true;
+    }
 }
 
-void wntr_midi_send(const struct WntrMIDIMessage* msg) {
+size_t wntr_midi_rx_pending() { return tud_midi_available() / 4; }
+
+const struct WntrMIDIRxStats* wntr_midi_rx_stats() { return &rx_stats_; }
+
+bool wntr_midi_send(const struct WntrMIDIMessage* msg) {
+    if (!wntr_midi_tx_reserve(1)) {
+        return false;
+    }
+
     uint8_t packet[] = {0, 0, 0, 0};
     packet[0] = msg->cable << 4 | msg->code_index;
     packet[1] = msg->status;
     packet[2] = msg->data_0;
     packet[3] = msg->data_1;
-    tud_midi_packet_write(packet);
+    return wntr_midi_tx_packet(packet);
 }
 
 size_t wntr_midi_sysex_len() { return sysex_data_len_; }
 
 const uint8_t* wntr_midi_sysex_data() { return sysex_data_; }
 
-void wntr_midi_send_sysex(const uint8_t* data, size_t len) {
-    size_t head = 0;
-    while (true) {
-        uint8_t packet[] = {0, 0, 0, 0};
-        size_t remaining = sysex_iterator_remaining(len, head);
-        if (remaining > 3) {
-            packet[0] = MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE;
-            sysex_iterator_next(data, len, &head, packet + 1);
-            sysex_iterator_next(data, len, &head, packet + 2);
-            sysex_iterator_next(data, len, &head, packet + 3);
-            tud_midi_packet_write(packet);
-            continue;
-        } else if (remaining == 3) {
-            packet[0] = MIDI_CODE_INDEX_SYSEX_END_THREE_BYTE;
-            sysex_iterator_next(data, len, &head, packet + 1);
-            sysex_iterator_next(data, len, &head, packet + 2);
-            sysex_iterator_next(data, len, &head, packet + 3);
-            tud_midi_packet_write(packet);
-            return;
-        } else if (remaining == 2) {
-            packet[0] = MIDI_CODE_INDEX_SYSEX_END_TWO_BYTE;
-            sysex_iterator_next(data, len, &head, packet + 1);
-            sysex_iterator_next(data, len, &head, packet + 2);
-            tud_midi_packet_write(packet);
-            return;
-        } else if (remaining == 1) {
-            packet[0] = MIDI_CODE_INDEX_SYSEX_END_ONE_BYTE;
-            sysex_iterator_next(data, len, &head, packet + 1);
-            tud_midi_packet_write(packet);
-            return;
-        }
-    };
+bool wntr_midi_send_sysex(const uint8_t* data, size_t len) {
+    if (!wntr_midi_tx_reserve(WNTR_SYSEX_STREAM_PACKET_COUNT(len))) {
+        return false;
+    }
+
+    struct WntrSysExStream stream;
+    WntrSysExStream_start(&stream, wntr_midi_tx_packet);
+    WntrSysExStream_write(&stream, data, len);
+    WntrSysExStream_end(&stream);
+    return true;
+}
+
+bool wntr_midi_send_sysex_teeth(const uint8_t* header, size_t header_len, const uint8_t* data, size_t len) {
+    if (!wntr_midi_tx_reserve(WNTR_SYSEX_STREAM_PACKET_COUNT(header_len + TEETH_ENCODED_LENGTH(len)))) {
+        return false;
+    }
+
+    struct WntrSysExStream stream;
+    WntrSysExStream_start(&stream, wntr_midi_tx_packet);
+    WntrSysExStream_write(&stream, header, header_len);
+    WntrSysExStream_write_teeth(&stream, data, len);
+    WntrSysExStream_end(&stream);
+    return true;
 }
 
+void wntr_midi_flush() { wntr_midi_tx_flush(); }
+
 /* Private functions */
 
 static bool midi_read(struct WntrMIDIMessage* msg) {
@@ -113,108 +125,52 @@ static bool midi_read(struct WntrMIDIMessage* msg) {
     return true;
 };
 
-static void consume_sysex(struct WntrMIDIMessage* msg) {
-    /* Start message has 3 of the sysex bytes, skip the first (0xF0). */
-    sysex_data_[0] = msg->data_0;
-    sysex_data_[1] = msg->data_1;
-    size_t data_index = 2;
-
-    while (true) {
-        /* Wait until we get a message, but fail out if it doesn't arrive in time. */
-        uint32_t start_ticks = wntr_ticks();
-        bool timeout = true;
-        while (wntr_ticks() < start_ticks + SYSEX_TIMEOUT) {
-            /*
-                Call tud_task() to keep USB data flowing, otherwise, this
-                won't recieve any data that isn't already in the USB buffer
-                before the loop started.
-            */
-            tud_task();
-            if (midi_read(msg)) {
-                timeout = false;
-                break;
-            }
-        }
-
-        if (timeout) {
-            goto timeout_fail;
-        }
-
-        switch (msg->code_index) {
-            case MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE:
-                sysex_data_[data_index++] = msg->status;
-                sysex_data_[data_index++] = msg->data_0;
-                sysex_data_[data_index++] = msg->data_1;
-                break;
-
-            case MIDI_CODE_INDEX_SYSEX_END_THREE_BYTE:
-                sysex_data_[data_index++] = msg->status;
-                sysex_data_[data_index++] = msg->data_0;
-                /* Ignore last byte (0xF7) */
-                goto exit;
-
-            case MIDI_CODE_INDEX_SYSEX_END_TWO_BYTE:
-                sysex_data_[data_index++] = msg->status;
-                /* Ignore last byte (0xF7) */
-                goto exit;
-
-            case MIDI_CODE_INDEX_SYSEX_END_ONE_BYTE:
-                /* Ignore last byte (0xF7) */
-                goto exit;
-
-            default:
-                goto exit;
+static bool receive_sysex_(struct WntrMIDIMessage* msg) {
+    const uint8_t bytes[3] = {msg->status, msg->data_0, msg->data_1};
+    bool end = msg->code_index != MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE;
+    /* The end packet's last byte is the end byte (0xF7), which isn't kept. */
+    size_t count = end ? msg->code_index - MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE - 1 : 3;
+    size_t i = 0;
+
+    if (bytes[0] == SYSEX_START_BYTE) {
+        /* A new message started before the last one ended. */
+        if (sysex_in_progress_) {
+            rx_stats_.dropped_sysex++;
         }
+        sysex_in_progress_ = true;
+        sysex_overflow_ = false;
+        sysex_index_ = 0;
+        /* Skip the start byte (0xF0). */
+        i = 1;
+    } else if (!sysex_in_progress_) {
+        /* The start of this message was missed, so ignore the rest of it. */
+        return false;
     }
 
-exit:
-    sysex_data_len_ = data_index;
-    return;
-
-timeout_fail:
-    printf("Timed out while waiting for SysEx.\n");
-    sysex_data_len_ = 0;
-    printf("Received %zu bytes before timeout:\n", data_index);
-    for (size_t i = 0; i < data_index; i++) {
-        printf("0x%02x ", sysex_data_[i]);
-        if (i > 16) {
-            printf("... (%zu more)", data_index - i);
+    for (; i < count; i++) {
+        if (sysex_index_ == SYSEX_BUF_SIZE) {
+            sysex_overflow_ = true;
             break;
         }
+        sysex_data_[sysex_index_++] = bytes[i];
     }
-    printf("\n");
-    return;
-}
 
-/*
-    This is an iterator that's used to wrap sysex messages with the MIDI SysEx
-    start byte and end byte without having to allocate more memory.
+    if (!end) {
+        return false;
+    }
 
-    It's roughly equivalent to this Python generator:
+    sysex_in_progress_ = false;
 
-    def sysex_generator(data):
-        yield MIDI_SYSEX_START_BYTE
-        for b in data:
-            yield b
-        yield MIDI_SYSEX_START_BYTE
-*/
-static bool sysex_iterator_next(const uint8_t* data, size_t len, size_t* head, uint8_t* dst) {
-    if (*head == 0) {
-        (*dst) = (uint8_t)SYSEX_START_BYTE;
-        (*head)++;
-        return true;
-    }
-    if (*head == len + 1) {
-        (*dst) = (uint8_t)SYSEX_END_BYTE;
-        (*head)++;
-        return true;
-    }
-    if (*head > len + 1) {
+    if (sysex_overflow_) {
+        printf("Dropped SysEx message longer than %u bytes.\n", SYSEX_BUF_SIZE);
+        rx_stats_.dropped_sysex++;
         return false;
     }
-    (*dst) = data[(*head) - 1];
-    (*head)++;
+
+    sysex_data_len_ = sysex_index_;
+    msg->code_index = MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE;
+    msg->status = 0;
+    msg->data_0 = 0;
+    msg->data_1 = 0;
     return true;
 }
-
-static size_t sysex_iterator_remaining(size_t len, size_t head) { return len + 2 - head; }
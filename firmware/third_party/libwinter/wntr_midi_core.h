@@ -41,20 +41,41 @@ struct WntrMIDIMessage {
     uint8_t data_1;
 };
 
+struct WntrMIDIRxStats {
+    /* USB-MIDI packets received. */
+    uint32_t packets;
+    /* SysEx messages dropped because they were too long or never ended. */
+    uint32_t dropped_sysex;
+};
+
 /* Receive a MIDI message.
 
-Copies the received message into the given `msg`. If the message received was
-a sysex message, this function will consume all messages until the end of the
-sysex. Check for this by checking `msg->code_index == MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE`.
+Reads at most one USB-MIDI packet and copies the received message into the
+given `msg`. SysEx messages span several packets, so they're collected as
+they arrive and this only returns true once the whole message has been
+received. Check for this by checking `msg->code_index == MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE`.
 You can then fetch the sysex data and len using `wntr_midi_sysex_data()` and
 `wntr_midi_sysex_len()`.
 
+This never waits for packets, so call it in a loop while
+`wntr_midi_rx_pending()` is non-zero to drain everything that's arrived.
+
 Returns: true if a message was received, false otherwise.
 */
 bool wntr_midi_receive(struct WntrMIDIMessage* msg);
 
-/* Send a MIDI message. */
-void wntr_midi_send(const struct WntrMIDIMessage* msg);
+/* The number of USB-MIDI packets waiting to be received. */
+size_t wntr_midi_rx_pending();
+
+const struct WntrMIDIRxStats* wntr_midi_rx_stats();
+
+/* Send a MIDI message.
+
+Messages are queued and sent by `wntr_midi_flush()`, see wntr_midi_tx.h.
+
+Returns: false if there wasn't room for the message and it was dropped.
+*/
+bool wntr_midi_send(const struct WntrMIDIMessage* msg);
 
 /* The length of the last recieved sysex message. */
 size_t wntr_midi_sysex_len();
@@ -66,4 +87,20 @@ Note that this is only guarenteed to be valid until the next call to
 
 */
 const uint8_t* wntr_midi_sysex_data();
-void wntr_midi_send_sysex(const uint8_t* data, size_t len);
+
+/* Send a sysex message, `data` shouldn't include the start and end bytes.
+
+The whole message is dropped rather than truncated if there isn't room for it,
+in which case this returns false.
+*/
+bool wntr_midi_send_sysex(const uint8_t* data, size_t len);
+
+/* Send a sysex message made up of `header` followed by teeth encoded `data`.
+
+The message is streamed out without buffering the encoded data, see
+wntr_sysex_stream.h.
+*/
+bool wntr_midi_send_sysex_teeth(const uint8_t* header, size_t header_len, const uint8_t* data, size_t len);
+
+/* Write queued messages out to USB, call this once per main loop. */
+void wntr_midi_flush();
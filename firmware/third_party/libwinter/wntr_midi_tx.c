@@ -0,0 +1,79 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#include "wntr_midi_tx.h"
+#include "tusb.h"
+#include <string.h>
+
+/* Static variables */
+
+static uint8_t batch_[WNTR_MIDI_TX_BATCH_SIZE];
+static size_t batch_len_;
+static struct WntrMIDITxStats stats_;
+
+/* Public functions */
+
+bool wntr_midi_tx_reserve(size_t packet_count) {
+    size_t needed = packet_count * 4;
+
+    if (needed > sizeof(batch_) - batch_len_ + tud_midi_packet_write_n_available()) {
+        // Maybe the host has read enough since the last flush.
+        wntr_midi_tx_flush();
+    }
+
+    if (needed > sizeof(batch_) - batch_len_ + tud_midi_packet_write_n_available()) {
+        stats_.dropped_messages++;
+        return false;
+    }
+
+    return true;
+}
+
+bool wntr_midi_tx_packet(const uint8_t packet[4]) {
+    // The last flush couldn't write anything, try again.
+    if (batch_len_ == sizeof(batch_)) {
+        wntr_midi_tx_flush();
+        if (batch_len_ == sizeof(batch_)) {
+            return false;
+        }
+    }
+
+    memcpy(batch_ + batch_len_, packet, 4);
+    batch_len_ += 4;
+    stats_.packets++;
+
+    if (batch_len_ == sizeof(batch_)) {
+        wntr_midi_tx_flush();
+    }
+
+    return true;
+}
+
+void wntr_midi_tx_flush() {
+    if (batch_len_ == 0) {
+        return;
+    }
+
+    if (!tud_midi_mounted()) {
+        batch_len_ = 0;
+        return;
+    }
+
+    size_t written = tud_midi_packet_write_n(batch_, batch_len_);
+    if (written == 0) {
+        return;
+    }
+
+    stats_.writes++;
+
+    // Keep whatever didn't fit for next time.
+    batch_len_ -= written;
+    memmove(batch_, batch_ + written, batch_len_);
+}
+
+size_t wntr_midi_tx_pending() { return batch_len_ / 4; }
+
+const struct WntrMIDITxStats* wntr_midi_tx_stats() { return &stats_; }
@@ -0,0 +1,67 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+/*
+    Batched USB-MIDI transmit.
+
+    Writing each event packet to TinyUSB on its own means a trip through its
+    FIFO bookkeeping and an attempt to start a transfer for every four bytes.
+    Instead, packets are collected into a batch the size of a full-speed bulk
+    endpoint packet and written to TinyUSB's FIFO together, either when the
+    batch fills up or when wntr_midi_tx_flush() is called from the main loop.
+
+    Messages are never truncated when the host isn't keeping up: callers
+    reserve room for the whole message up front with wntr_midi_tx_reserve()
+    and drop it if there isn't enough. This never blocks.
+
+    This relies on tud_midi_n_packet_write_n() and its _available()
+    counterpart, which are a local patch to the vendored TinyUSB.
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* One full-speed bulk endpoint packet, or 16 USB-MIDI event packets. */
+#define WNTR_MIDI_TX_BATCH_SIZE 64
+
+struct WntrMIDITxStats {
+    /* Event packets written into the batch. */
+    uint32_t packets;
+    /* Writes into TinyUSB's FIFO. */
+    uint32_t writes;
+    /* Messages that were dropped because there wasn't room for them. */
+    uint32_t dropped_messages;
+};
+
+/*
+    Checks that there's room for `packet_count` event packets. If there isn't,
+    this counts the message as dropped and returns false. The host reads from
+    TinyUSB's FIFO in the background, so room is never taken away once it's
+    reserved.
+*/
+bool wntr_midi_tx_reserve(size_t packet_count);
+
+/*
+    Adds an event packet to the batch, this matches wntr_midi_packet_writer
+    so it can be used with WntrSysExStream. Returns false if there's no room,
+    which only happens if the room wasn't reserved.
+*/
+bool wntr_midi_tx_packet(const uint8_t packet[4]);
+
+/*
+    Writes as much of the batch into TinyUSB's FIFO as will fit. Call this
+    once per main loop. If the host isn't connected the batch is discarded
+    so that stale messages aren't sent when it connects.
+*/
+void wntr_midi_tx_flush();
+
+/* Number of event packets waiting in the batch. */
+size_t wntr_midi_tx_pending();
+
+const struct WntrMIDITxStats* wntr_midi_tx_stats();
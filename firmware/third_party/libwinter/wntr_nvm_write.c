@@ -0,0 +1,86 @@
+/*
+    Copyright (c) 2021 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+/*
+    Hardware-independent implementation of wntr_nvm_write() built on top of
+    the platform's wntr_nvm_read(), wntr_nvm_erase_row(), and
+    wntr_nvm_write_page().
+*/
+
+#include "wntr_nvm.h"
+#include <stdbool.h>
+
+#define ROW_PAGES (WNTR_NVM_ROW_SIZE / WNTR_NVM_PAGE_SIZE)
+
+void wntr_nvm_write(uint32_t dst, const uint8_t* buf, size_t len) {
+    uint8_t row[WNTR_NVM_ROW_SIZE];
+    uint8_t page[WNTR_NVM_PAGE_SIZE];
+
+    while (len > 0) {
+        uint32_t row_addr = dst & ~(WNTR_NVM_ROW_SIZE - 1);
+        size_t start = dst - row_addr;
+        size_t count = WNTR_NVM_ROW_SIZE - start < len ? WNTR_NVM_ROW_SIZE - start : len;
+
+        wntr_nvm_read(row_addr, row, WNTR_NVM_ROW_SIZE);
+
+        /* Figure out which pages actually change and whether any bit needs
+           to go from 0 to 1, which is the only thing that needs an erase. */
+        uint8_t dirty_pages = 0;
+        bool needs_erase = false;
+
+        for (size_t i = 0; i < count; i++) {
+            uint8_t old_val = row[start + i];
+            uint8_t new_val = buf[i];
+            if (old_val != new_val) {
+                dirty_pages |= 1 << ((start + i) / WNTR_NVM_PAGE_SIZE);
+                if ((old_val & new_val) != new_val) {
+                    needs_erase = true;
+                }
+            }
+        }
+
+        if (needs_erase) {
+            /* Merge the new data with the rest of the row, erase it, and
+               write back every page that isn't blank. */
+            for (size_t i = 0; i < count; i++) { row[start + i] = buf[i]; }
+
+            wntr_nvm_erase_row(row_addr);
+
+            for (size_t p = 0; p < ROW_PAGES; p++) {
+                const uint8_t* page_data = row + p * WNTR_NVM_PAGE_SIZE;
+                bool blank = true;
+                for (size_t i = 0; i < WNTR_NVM_PAGE_SIZE; i++) {
+                    if (page_data[i] != 0xFF) {
+                        blank = false;
+                        break;
+                    }
+                }
+                if (!blank) {
+                    wntr_nvm_write_page(row_addr + p * WNTR_NVM_PAGE_SIZE, page_data, WNTR_NVM_PAGE_SIZE);
+                }
+            }
+        } else if (dirty_pages) {
+            /* Bits only need to be cleared, which can be done by programming
+               the changed pages without an erase. Bytes that didn't change
+               are left as 0xFF so that their cells aren't programmed again. */
+            for (size_t p = 0; p < ROW_PAGES; p++) {
+                if (!(dirty_pages & (1 << p))) {
+                    continue;
+                }
+                for (size_t i = 0; i < WNTR_NVM_PAGE_SIZE; i++) {
+                    size_t offset = p * WNTR_NVM_PAGE_SIZE + i;
+                    bool in_write = offset >= start && offset < start + count;
+                    page[i] = in_write && buf[offset - start] != row[offset] ? buf[offset - start] : 0xFF;
+                }
+                wntr_nvm_write_page(row_addr + p * WNTR_NVM_PAGE_SIZE, page, WNTR_NVM_PAGE_SIZE);
+            }
+        }
+
+        dst += count;
+        buf += count;
+        len -= count;
+    }
+}
@@ -0,0 +1,89 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#include "wntr_sysex_stream.h"
+#include "teeth.h"
+#include "wntr_midi_core.h"
+
+#define SYSEX_START_BYTE 0xF0
+#define SYSEX_END_BYTE 0xF7
+
+/* Forward declarations */
+
+static void push_(struct WntrSysExStream* stream, uint8_t byte);
+
+/* Public functions */
+
+void WntrSysExStream_start(struct WntrSysExStream* stream, wntr_midi_packet_writer write_packet) {
+    stream->write_packet = write_packet;
+    stream->packet[0] = 0;
+    stream->packet[1] = 0;
+    stream->packet[2] = 0;
+    stream->packet[3] = 0;
+    stream->count = 0;
+    push_(stream, SYSEX_START_BYTE);
+}
+
+void WntrSysExStream_write(struct WntrSysExStream* stream, const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len; i++) { push_(stream, data[i]); }
+}
+
+void WntrSysExStream_write_teeth(struct WntrSysExStream* stream, const uint8_t* data, size_t len) {
+    size_t i = 0;
+
+    // Three groups encode to exactly five packets' worth of bytes, so while
+    // the current packet is empty they can be written straight out as whole
+    // packets. This is the usual case since the SysEx start byte, identifier,
+    // and command fill the first packet.
+    if (stream->count == 0) {
+        uint8_t encoded[15];
+        uint8_t packet[4] = {MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE, 0, 0, 0};
+
+        for (; i + 12 <= len; i += 12) {
+            teeth_encode_group(data + i, 4, encoded);
+            teeth_encode_group(data + i + 4, 4, encoded + 5);
+            teeth_encode_group(data + i + 8, 4, encoded + 10);
+
+            for (size_t j = 0; j < 15; j += 3) {
+                packet[1] = encoded[j];
+                packet[2] = encoded[j + 1];
+                packet[3] = encoded[j + 2];
+                stream->write_packet(packet);
+            }
+        }
+    }
+
+    uint8_t group[5];
+    for (; i < len; i += 4) {
+        teeth_encode_group(data + i, len - i < 4 ? len - i : 4, group);
+        for (size_t j = 0; j < 5; j++) { push_(stream, group[j]); }
+    }
+}
+
+void WntrSysExStream_end(struct WntrSysExStream* stream) {
+    // The end byte always goes in the last packet and the packet's code index
+    // says how many bytes of it are used.
+    stream->packet[1 + stream->count] = SYSEX_END_BYTE;
+    stream->packet[0] = MIDI_CODE_INDEX_SYSEX_END_ONE_BYTE + stream->count;
+    stream->write_packet(stream->packet);
+    stream->count = 0;
+}
+
+/* Private functions */
+
+static void push_(struct WntrSysExStream* stream, uint8_t byte) {
+    stream->packet[1 + stream->count] = byte;
+    stream->count++;
+
+    if (stream->count == 3) {
+        stream->packet[0] = MIDI_CODE_INDEX_SYSEX_START_OR_CONTINUE;
+        stream->write_packet(stream->packet);
+        stream->packet[1] = 0;
+        stream->packet[2] = 0;
+        stream->packet[3] = 0;
+        stream->count = 0;
+    }
+}
@@ -0,0 +1,55 @@
+/*
+    Copyright (c) 2023 Alethea Katherine Flowers.
+    Published under the standard MIT License.
+    Full text available at: https://opensource.org/licenses/MIT
+*/
+
+#pragma once
+
+/*
+    Streams a SysEx message straight into USB-MIDI event packets.
+
+    USB-MIDI carries SysEx three bytes at a time in four byte packets, so
+    rather than building the whole message in a buffer and then splitting it
+    up, bytes are added to the current packet and each packet is written out
+    as soon as it's full. Teeth encoded data is encoded a group at a time
+    as it's added, so it's never buffered either.
+
+    Usage:
+
+        struct WntrSysExStream stream;
+        WntrSysExStream_start(&stream, tud_midi_packet_write);
+        WntrSysExStream_write(&stream, header, 2);
+        WntrSysExStream_write_teeth(&stream, data, len);
+        WntrSysExStream_end(&stream);
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+    Number of event packets needed for a message with `len` bytes between the
+    SysEx start and end bytes.
+*/
+#define WNTR_SYSEX_STREAM_PACKET_COUNT(len) (((len) + 2 + 2) / 3)
+
+typedef bool (*wntr_midi_packet_writer)(const uint8_t packet[4]);
+
+struct WntrSysExStream {
+    wntr_midi_packet_writer write_packet;
+    uint8_t packet[4];
+    uint8_t count;
+};
+
+/* Starts a new message, this writes the SysEx start byte (0xF0). */
+void WntrSysExStream_start(struct WntrSysExStream* stream, wntr_midi_packet_writer write_packet);
+
+/* Adds bytes to the message as-is, they must all be 7-bit values. */
+void WntrSysExStream_write(struct WntrSysExStream* stream, const uint8_t* data, size_t len);
+
+/* Adds teeth encoded data to the message, see teeth.h. */
+void WntrSysExStream_write_teeth(struct WntrSysExStream* stream, const uint8_t* data, size_t len);
+
+/* Ends the message with the SysEx end byte (0xF7) and writes the last packet. */
+void WntrSysExStream_end(struct WntrSysExStream* stream);
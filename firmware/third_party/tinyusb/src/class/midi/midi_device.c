@@ -332,6 +332,29 @@ bool tud_midi_n_packet_write(uint8_t itf, uint8_t const packet[4]) {
     return true;
 }
 
+// Local patch (Gemini): tud_midi_n_packet_write_n() and
+// tud_midi_n_packet_write_n_available() are backported from upstream TinyUSB
+// for libwinter's wntr_midi_tx.c. Carry them forward when upgrading TinyUSB,
+// or drop them once the upstream version is vendored.
+uint32_t tud_midi_n_packet_write_n(uint8_t itf, uint8_t const packets[], uint32_t n_bytes) {
+    midid_interface_t* midi = &_midid_itf[itf];
+    TU_VERIFY(midi->itf_num, 0);
+
+    // Only write whole packets.
+    uint32_t const n_bytes4 = tu_min32(n_bytes, tu_fifo_remaining(&midi->tx_ff)) & 0xFFFFFFFC;
+    uint32_t const n_written = tu_fifo_write_n(&midi->tx_ff, packets, n_bytes4);
+    write_flush(midi);
+
+    return n_written;
+}
+
+uint32_t tud_midi_n_packet_write_n_available(uint8_t itf) {
+    midid_interface_t* midi = &_midid_itf[itf];
+    TU_VERIFY(midi->itf_num, 0);
+    return tu_fifo_remaining(&midi->tx_ff) & 0xFFFFFFFC;
+}
+// End of local patch (Gemini).
+
 //--------------------------------------------------------------------+
 // USBD Driver API
 //--------------------------------------------------------------------+
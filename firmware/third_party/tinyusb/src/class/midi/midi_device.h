@@ -75,6 +75,17 @@ bool     tud_midi_n_packet_read  (uint8_t itf, uint8_t packet[4]);
 // Write event packet            (4 bytes)
 bool     tud_midi_n_packet_write (uint8_t itf, uint8_t const packet[4]);
 
+// Local patch (Gemini): the packet_write_n functions below are backported
+// from upstream TinyUSB for libwinter's wntr_midi_tx.c, see midi_device.c.
+
+// Write multiple event packets, only whole packets are written. Returns the number of bytes written.
+uint32_t tud_midi_n_packet_write_n (uint8_t itf, uint8_t const packets[], uint32_t n_bytes);
+
+// Get the number of bytes of whole packets that can be written
+uint32_t tud_midi_n_packet_write_n_available (uint8_t itf);
+
+// End of local patch (Gemini).
+
 //--------------------------------------------------------------------+
 // Application API (Single Interface)
 //--------------------------------------------------------------------+
@@ -86,6 +97,8 @@ static inline uint32_t tud_midi_stream_write (uint8_t cable_num, uint8_t const*
 
 static inline bool     tud_midi_packet_read  (uint8_t packet[4]);
 static inline bool     tud_midi_packet_write (uint8_t const packet[4]);
+static inline uint32_t tud_midi_packet_write_n (uint8_t const packets[], uint32_t n_bytes); // Local patch (Gemini)
+static inline uint32_t tud_midi_packet_write_n_available (void);       // Local patch (Gemini)
 
 //------------- Deprecated API name  -------------//
 // TODO remove after 0.10.0 release
@@ -154,6 +167,17 @@ static inline bool tud_midi_packet_write (uint8_t const packet[4])
   return tud_midi_n_packet_write(0, packet);
 }
 
+// Local patch (Gemini), see tud_midi_n_packet_write_n().
+static inline uint32_t tud_midi_packet_write_n (uint8_t const packets[], uint32_t n_bytes)
+{
+  return tud_midi_n_packet_write_n(0, packets, n_bytes);
+}
+
+static inline uint32_t tud_midi_packet_write_n_available (void)
+{
+  return tud_midi_n_packet_write_n_available(0);
+}
+
 //--------------------------------------------------------------------+
 // Internal Class Driver API
 //--------------------------------------------------------------------+
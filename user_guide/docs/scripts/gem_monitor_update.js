@@ -4,7 +4,7 @@
 import Struct from "./structy.js";
 
 class GemMonitorUpdate extends Struct {
-  static _pack_string = "B?HHHHHHHHBiHIHHHHHHHiBiHIHHHH";
+  static _pack_string = "B?HHHHHHHHBiHIHHHHHHHiBiHIHHHHIIHIIH";
   static _fields = [
     { name: "mode", kind: "uint8", default: 0 },
     { name: "tweaking", kind: "bool", default: false },
@@ -36,9 +36,15 @@ class GemMonitorUpdate extends Struct {
     { name: "loop_time", kind: "uint16", default: 0 },
     { name: "animation_time", kind: "uint16", default: 0 },
     { name: "sample_time", kind: "uint16", default: 0 },
+    { name: "dac_skipped_writes", kind: "uint32", default: 0 },
+    { name: "dac_partial_writes", kind: "uint32", default: 0 },
+    { name: "midi_rx_peak_depth", kind: "uint16", default: 0 },
+    { name: "midi_rx_dropped", kind: "uint32", default: 0 },
+    { name: "midi_tx_dropped", kind: "uint32", default: 0 },
+    { name: "midi_latency", kind: "uint16", default: 0 },
   ];
 
-  static packed_size = 66;
+  static packed_size = 86;
 
   constructor(values = {}) {
     super(values);
@@ -4,7 +4,7 @@
 import Struct from "./structy.js";
 
 class GemSettings extends Struct {
-  static _pack_string = "HhHiiiiiiiiiiH??iiiBBiiHI??";
+  static _pack_string = "HhHiiiiiiiiiiH??iiiBBiiHI??BBB?H???ii";
   static _fields = [
     { name: "adc_gain_corr", kind: "uint16", default: 2048 },
     { name: "adc_offset_corr", kind: "int16", default: 0 },
@@ -33,9 +33,19 @@ class GemSettings extends Struct {
     { name: "osc8m_freq", kind: "uint32", default: 8000000 },
     { name: "zero_detection_enabled", kind: "bool", default: true },
     { name: "quantization_enabled", kind: "bool", default: true },
+    { name: "castor_midi_channel", kind: "uint8", default: 0 },
+    { name: "pollux_midi_channel", kind: "uint8", default: 0 },
+    { name: "midi_pitch_bend_range", kind: "uint8", default: 2 },
+    { name: "midi_replaces_cv", kind: "bool", default: true },
+    { name: "quantizer_scale", kind: "uint16", default: 4095 },
+    { name: "fine_quantization_enabled", kind: "bool", default: false },
+    { name: "castor_pitch_smoothing", kind: "bool", default: false },
+    { name: "pollux_pitch_smoothing", kind: "bool", default: false },
+    { name: "pitch_smoothing_min_cutoff", kind: "fix16", default: 10.0 },
+    { name: "pitch_smoothing_sensitivity", kind: "fix16", default: 10.0 },
   ];
 
-  static packed_size = 80;
+  static packed_size = 97;
 
   constructor(values = {}) {
     super(values);
@@ -59,7 +59,12 @@ export default class Gemini {
         midi_message.set([0xf0, 0x77, 0x19]);
         midi_message.set(encoded_data, 3);
         midi_message[midi_message.length - 1] = 0xf7;
-        await this.midi.transact(midi_message);
+        const response = await this.midi.transact(midi_message);
+
+        /* Newer firmware applies the settings immediately and says so in
+           the ack, older firmware needs to be reset. */
+        const applied = strip_response(response);
+        return applied.length > 0 && applied[0] === 1;
     }
 
     async soft_reset() {
@@ -218,8 +218,10 @@ $on(ui.save_btn, "click", async function () {
     ui.save_btn.innerText = "Saving...";
     console.log("Saving settings", settings);
 
-    await gemini.save_settings(settings);
-    gemini.soft_reset();
+    const applied = await gemini.save_settings(settings);
+    if (!applied) {
+        gemini.soft_reset();
+    }
 
     ui.save_btn.classList.remove("is-primary");
     ui.save_btn.classList.add("is-success");